@@ -42,6 +42,10 @@ static mps_gen_param_s testChain[genCOUNT] = {
 
 
 static mps_arena_t arena;
+static mps_cards_t cards;
+static const char *barrierName[] = { /* how stores are tracked */
+  "protection", "cards", "soft-dirty"
+};
 static mps_ap_t ap;
 static mps_addr_t exactRoots[exactRootsCOUNT];
 static mps_addr_t ambigRoots[ambigRootsCOUNT];
@@ -91,6 +95,115 @@ static void report(void)
 }
 
 
+/* check_pauses -- check the pause statistics are consistent */
+
+static void check_pauses(void)
+{
+  static const char *kindName[MPS_PAUSE_KIND_LIMIT] = {
+    "poll", "flip", "access", "finalize"
+  };
+  mps_window_stats_s windows[8];
+  mps_pause_stats_s stats;
+  mps_pause_kind_t kind;
+  size_t i, n, sum;
+  double mmu;
+
+  for (i = 1; i < MPS_PAUSE_BUCKETS; ++i)
+    Insist(mps_pause_bucket_limit(i - 1) < mps_pause_bucket_limit(i));
+
+  for (kind = 0; kind < MPS_PAUSE_KIND_LIMIT; ++kind) {
+    mps_arena_pause_stats(&stats, arena, kind);
+    sum = 0;
+    n = 0;
+    for (i = 0; i < MPS_PAUSE_BUCKETS; ++i) {
+      sum += stats.bucket[i];
+      if (stats.bucket[i] > 0)
+        n = i;
+    }
+    Insist(sum == stats.count);
+    Insist(stats.max <= stats.total);
+    Insist(n == MPS_PAUSE_BUCKETS - 1
+           || stats.max <= mps_pause_bucket_limit(n));
+    printf("%s pauses: %lu, total %g s, longest %g s\n", kindName[kind],
+           (unsigned long)stats.count, stats.total, stats.max);
+  }
+  mps_arena_pause_stats(&stats, arena, MPS_PAUSE_FLIP);
+  Insist(stats.count > 0);
+
+  mmu = mps_arena_mmu(arena);
+  Insist(0.0 <= mmu && mmu <= 1.0);
+  n = mps_arena_window_stats(windows, NELEMS(windows), arena);
+  Insist(n <= NELEMS(windows));
+  for (i = 0; i < n; ++i) {
+    Insist(windows[i].length > 0.0);
+    Insist(windows[i].alloc_rate >= 0.0);
+    Insist(mmu <= windows[i].utilization && windows[i].utilization <= 1.0);
+  }
+  printf("mmu %g over %lu recent windows\n", mmu, (unsigned long)n);
+
+  mps_arena_pause_stats_reset(arena);
+  mps_arena_pause_stats(&stats, arena, MPS_PAUSE_FLIP);
+  Insist(stats.count == 0);
+  Insist(mps_arena_window_stats(windows, NELEMS(windows), arena) == 0);
+}
+
+
+/* Client collection policy
+ *
+ * Delegates to the default decisions, checking the estimates passed
+ * in, and condemns only the nursery every other time.
+ */
+
+typedef struct policy_count_s {
+  size_t start, condemn, poll;
+} policy_count_s;
+
+static void check_info(const mps_policy_info_s *info)
+{
+  Insist(info->step_time >= 0.0);
+  Insist(info->collection_rate > 0.0);
+  Insist(info->world_time > 0.0);
+  Insist(info->world_since >= 0.0);
+  Insist(info->chain != NULL || info->chain_deferral > 0.0);
+  Insist(info->pause_time >= 0.0);
+}
+
+static mps_bool_t policy_start(mps_bool_t *world_io, mps_chain_t *chain_io,
+                               mps_arena_t a, const mps_policy_info_s *info,
+                               void *closure)
+{
+  policy_count_s *count = closure;
+  Insist(a == arena);
+  check_info(info);
+  Insist(info->world_allowed || !*world_io);
+  Insist(*chain_io == NULL || *chain_io == info->chain);
+  ++ count->start;
+  return *world_io || *chain_io != NULL;
+}
+
+static size_t policy_condemn(mps_arena_t a, mps_chain_t chain, size_t top,
+                             const mps_policy_info_s *info, void *closure)
+{
+  policy_count_s *count = closure;
+  Insist(a == arena);
+  Insist(chain != NULL);
+  Insist(top < genCOUNT);
+  check_info(info);
+  ++ count->condemn;
+  return count->condemn % 2 == 0 ? 0 : top;
+}
+
+static double policy_poll(mps_arena_t a, const mps_policy_info_s *info,
+                          void *closure)
+{
+  policy_count_s *count = closure;
+  Insist(a == arena);
+  check_info(info);
+  ++ count->poll;
+  return info->pause_time;
+}
+
+
 /* make -- create one new object */
 
 static mps_addr_t make(size_t rootsCount)
@@ -117,6 +230,63 @@ static mps_addr_t make(size_t rootsCount)
 }
 
 
+/* test_single_access -- check barrier hits on single objects
+ *
+ * Starts a collection, so that the object in exactRoots[0] is copied
+ * to a grey, protected segment, then loads and stores through it.  On
+ * x86-64 the tracer handles barrier hits on register loads and stores
+ * by scanning just the object and emulating the faulting instruction
+ * (see design.mps.trace.single-access).  A store of an immediate isn't
+ * emulated, so the last hit scans the whole segment.  Either way the
+ * mutator must see the values that were there, and the values it
+ * stored.
+ */
+
+static void test_single_access(void)
+{
+  mps_word_t obj, ref;
+  volatile mps_word_t *slots;
+  volatile mps_word_t word; /* so that loads are MOVs, not compares */
+
+  mps_arena_park(arena);
+  die(make_dylan_vector(&ref, ap, 1), "make_dylan_vector");
+  DYLAN_VECTOR_SLOT(ref, 0) = DYLAN_INT(42);
+  die(make_dylan_vector(&obj, ap, 4), "make_dylan_vector");
+  DYLAN_VECTOR_SLOT(obj, 0) = ref;
+  exactRoots[0] = (mps_addr_t)obj;
+  die(mps_arena_start_collect(arena), "mps_arena_start_collect");
+
+  slots = exactRoots[0];
+  word = slots[2];                      /* load from slot 0 */
+  ref = word;
+  word = ((volatile mps_word_t *)ref)[2];
+  Insist(word == DYLAN_INT(42));
+  slots[4] = ref;                       /* store to slot 2 */
+  word = slots[4];
+  Insist(word == ref);
+
+#if defined(MPS_ARCH_I6)
+  if (arena->busyTraces != TraceSetEMPTY) {
+    /* Still collecting, so the accesses above were barrier hits. */
+    Seg seg;
+    Insist(SegOfAddr(&seg, arena, (Addr)exactRoots[0]));
+    Insist(SegSingleAccesses(seg) > 0);
+  }
+#endif
+
+  slots[3] = DYLAN_INT(7);              /* store immediate to slot 1 */
+  Insist(slots[3] == DYLAN_INT(7));
+
+  mps_arena_park(arena);
+  slots = exactRoots[0];
+  Insist(dylan_check(exactRoots[0]));
+  Insist(slots[3] == DYLAN_INT(7));
+  Insist(slots[2] == slots[4]);
+  Insist(DYLAN_VECTOR_SLOT(slots[4], 0) == DYLAN_INT(42));
+  mps_arena_release(arena);
+}
+
+
 /* test_stepper -- stepping function for walk */
 
 static void test_stepper(mps_addr_t object, mps_fmt_t fmt, mps_pool_t pool,
@@ -171,6 +341,9 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
   /* create an ap, and leave it busy */
   die(mps_reserve(&busy_init, busy_ap, 64), "mps_reserve busy");
 
+  if (pool_class == mps_class_amc())
+    test_single_access();
+
   nCollsStart = 0;
   nCollsDone = 0;
   collections = 0;
@@ -265,8 +438,8 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
         cdie(dylan_check(exactRoots[i]), "dying root check");
       exactRoots[i] = make(roots_count);
       if (exactRoots[(exactRootsCOUNT-1) - i] != objNULL)
-        dylan_write(exactRoots[(exactRootsCOUNT-1) - i],
-                    exactRoots, exactRootsCOUNT);
+        dylan_write_barrier(cards, exactRoots[(exactRootsCOUNT-1) - i],
+                            exactRoots, exactRootsCOUNT);
     } else {
       i = (r >> 1) % ambigRootsCOUNT;
       ambigRoots[(ambigRootsCOUNT-1) - i] = make(roots_count);
@@ -300,28 +473,61 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
 
 int main(int argc, char *argv[])
 {
-  size_t i, grainSize;
+  size_t i, grainSize, gcThreads;
+  unsigned barrier;
+  mps_bool_t fixPrefetch;
   mps_thr_t thread;
+  mps_policy_t policy;
+  mps_policy_info_s info;
+  policy_count_s count = {0, 0, 0};
 
   testlib_init(argc, argv);
 
   scale = (size_t)1 << (rnd() % 6);
   for (i = 0; i < genCOUNT; ++i) testChain[i].mps_capacity *= scale;
   grainSize = rnd_grain(scale * testArenaSIZE);
-  printf("Picked scale=%lu grainSize=%lu\n", (unsigned long)scale, (unsigned long)grainSize);
+  gcThreads = 1 + rnd() % 4;
+  barrier = (unsigned)(rnd() % 3);
+  fixPrefetch = rnd() % 2;
+  printf("Picked scale=%lu grainSize=%lu gcThreads=%lu barrier=%s"
+         " fixPrefetch=%d\n",
+         (unsigned long)scale, (unsigned long)grainSize,
+         (unsigned long)gcThreads, barrierName[barrier], (int)fixPrefetch);
 
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, scale * testArenaSIZE);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, grainSize);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_GC_THREADS, gcThreads);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_CARD_MARKING, barrier == 1);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SOFT_DIRTY, barrier == 2);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_FIX_PREFETCH, fixPrefetch);
     die(mps_arena_create_k(&arena, mps_arena_class_vm(), args), "arena_create");
   } MPS_ARGS_END(args);
+  cards = mps_arena_cards(arena);
   mps_message_type_enable(arena, mps_message_type_gc());
   mps_message_type_enable(arena, mps_message_type_gc_start());
   die(mps_thread_reg(&thread, arena), "thread_reg");
   test(mps_class_amc(), exactRootsCOUNT);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_POLICY_START, policy_start);
+    MPS_ARGS_ADD(args, MPS_KEY_POLICY_CONDEMN, policy_condemn);
+    MPS_ARGS_ADD(args, MPS_KEY_POLICY_POLL, policy_poll);
+    MPS_ARGS_ADD(args, MPS_KEY_POLICY_CLOSURE, &count);
+    die(mps_policy_create_k(&policy, arena, args), "policy_create");
+  } MPS_ARGS_END(args);
   test(mps_class_amcz(), 0);
+  mps_arena_policy_info(&info, arena);
+  check_info(&info);
+  Insist(info.pause_time == mps_arena_pause_time(arena));
+  mps_policy_destroy(policy);
+  printf("policy calls: start %lu, condemn %lu, poll %lu\n",
+         (unsigned long)count.start, (unsigned long)count.condemn,
+         (unsigned long)count.poll);
+  Insist(count.start > 0 && count.condemn > 0 && count.poll > 0);
   mps_thread_dereg(thread);
   report();
+  check_pauses();
   mps_arena_destroy(arena);
 
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
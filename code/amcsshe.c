@@ -37,12 +37,19 @@
 static mps_gen_param_s testChain[genCOUNT] = {
   { gen1SIZE, 0.85 }, { gen2SIZE, 0.45 } };
 
+/* testBounds -- bounds on the capacities as they adapt */
+
+static mps_gen_bounds_s testBounds[genCOUNT] = {
+  { gen1SIZE / 2, gen1SIZE * 4 }, { gen2SIZE / 2, gen2SIZE * 4 } };
+
 
 /* objNULL needs to be odd so that it's ignored in exactRoots. */
 #define objNULL           ((mps_addr_t)MPS_WORD_CONST(0xDECEA5ED))
 
 
 static mps_pool_t pool;
+static mps_chain_t chain;
+static unsigned long nRetunes;
 static mps_ap_t ap;
 static mps_addr_t exactRoots[exactRootsCOUNT];
 static mps_addr_t ambigRoots[ambigRootsCOUNT];
@@ -92,6 +99,24 @@ static void report(mps_arena_t arena)
 
     mps_message_discard(arena, message);
   }
+
+  while (mps_message_get(&message, arena, mps_message_type_gen_retune())) {
+    mps_gen_retune_s retune;
+
+    mps_message_gen_retune(&retune, arena, message);
+    Insist(retune.chain == chain);
+    Insist(retune.gen < genCOUNT);
+    Insist(retune.old_capacity != retune.new_capacity);
+    Insist(testBounds[retune.gen].mps_min_capacity <= retune.new_capacity);
+    Insist(retune.new_capacity <= testBounds[retune.gen].mps_max_capacity);
+    Insist(0.0 <= retune.mortality && retune.mortality <= 1.0);
+    printf("\nGeneration %lu retuned from %lu kB to %lu kB\n",
+           (unsigned long)retune.gen, (unsigned long)retune.old_capacity,
+           (unsigned long)retune.new_capacity);
+    ++ nRetunes;
+
+    mps_message_discard(arena, message);
+  }
 }
 
 
@@ -101,7 +126,6 @@ static void *test(mps_arena_t arena, mps_pool_class_t pool_class,
                   size_t roots_count)
 {
   mps_fmt_t format;
-  mps_chain_t chain;
   mps_root_t exactRoot, ambigRoot, bogusRoot;
   unsigned long objs; size_t i;
   mps_word_t collections, rampSwitch;
@@ -112,6 +136,7 @@ static void *test(mps_arena_t arena, mps_pool_class_t pool_class,
 
   die(EnsureHeaderFormat(&format, arena), "fmt_create");
   die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
+  mps_chain_adapt(chain, genCOUNT, testBounds);
 
   die(mps_pool_create(&pool, arena, pool_class, format, chain),
       "pool_create(amc)");
@@ -234,6 +259,12 @@ static void *test(mps_arena_t arena, mps_pool_class_t pool_class,
   mps_root_destroy(bogusRoot);
   mps_pool_destroy(pool);
   mps_chain_destroy(chain);
+  {
+    /* Destroying the chain discards its pending retune messages. */
+    mps_message_t message;
+    Insist(!mps_message_get(&message, arena, mps_message_type_gen_retune()));
+  }
+  report(arena);
   mps_fmt_destroy(format);
   mps_arena_release(arena);
 
@@ -254,10 +285,13 @@ int main(int argc, char *argv[])
     die(mps_arena_create_k(&arena, mps_arena_class_vm(), args), "arena_create");
   } MPS_ARGS_END(args);
   mps_message_type_enable(arena, mps_message_type_gc());
+  mps_message_type_enable(arena, mps_message_type_gen_retune());
   die(mps_thread_reg(&thread, arena), "thread_reg");
   test(arena, mps_class_amc(), exactRootsCOUNT);
   test(arena, mps_class_amcz(), 0);
   mps_thread_dereg(thread);
+  printf("%lu retunes\n", nRetunes);
+  Insist(nRetunes > 0);
   mps_arena_destroy(arena);
 
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
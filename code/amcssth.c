@@ -7,7 +7,8 @@
  * The main thread parks the arena half way through the test case and
  * runs mps_arena_formatted_objects_walk(). This checks that walking
  * works while the other threads continue to allocate in the
- * background.
+ * background. The other threads sometimes park themselves with
+ * mps_thread_park() while they are not using the heap.
  */
 
 #include "fmtdy.h"
@@ -32,6 +33,7 @@
 #define collectionsCOUNT  37
 #define rampSIZE          9
 #define initTestFREQ      6000
+#define kidDEPTH          500
 
 /* testChain -- generation parameters for the test */
 
@@ -117,6 +119,106 @@ typedef struct closure_s {
   size_t roots_count;
 } closure_s, *closure_t;
 
+static void kid_churn(closure_t cl, mps_ap_t ap,
+                      mps_thr_t thread1, mps_thr_t thread2)
+{
+  while(mps_collections(arena) < collectionsCOUNT) {
+    churn(ap, cl->roots_count);
+    if (rnd() % 16 == 0) {
+      /* Park the thread while doing some work that doesn't touch the
+       * heap, so that flips find it parked -- see
+       * <design/thread-manager/#impl.ix.park>. Parking only one
+       * registration checks that the other is still suspended. */
+      size_t j, spin = rnd() % 1000;
+      mps_thread_park(thread1);
+      if (spin & 1)
+        mps_thread_park(thread2);
+      for (j = 0; j < spin; ++j)
+        (void)rnd();
+      if (spin & 1)
+        mps_thread_unpark(thread2);
+      mps_thread_unpark(thread1);
+    }
+  }
+}
+
+/* scribble -- overwrite the stack below the caller
+ *
+ * As a blocking system call might.
+ */
+
+ATTRIBUTE_NOINLINE
+static void scribble(void)
+{
+  volatile mps_word_t junk[256];
+  size_t i;
+  for (i = 0; i < NELEMS(junk); ++i)
+    junk[i] = 0;
+}
+
+/* kid_park -- hold references only in locals across a park
+ *
+ * The objects are referenced only from this frame, so probably from
+ * callee-save registers that mps_thread_park saves in its own frame
+ * before it reuses them, and then the blocking call overwrites that.
+ * The thread stays parked until two more collections have finished,
+ * so at least one of them condemns the objects and scans the parked
+ * thread.  See <design/thread-manager/#impl.ix.park.copy>.
+ */
+
+static void kid_park(closure_t cl, mps_thr_t thread)
+{
+  mps_ap_t ap;
+  mps_word_t *obj1, *obj2, *obj3, *obj4, *obj5, *obj6;
+  mps_word_t length, start;
+
+  /* Allocate from an allocation point of our own, and destroy it, so
+     that the objects aren't in a buffered segment. */
+  die(mps_ap_create(&ap, cl->pool, mps_rank_exact()), "BufferCreate(park)");
+  obj1 = make(ap, cl->roots_count);
+  obj2 = make(ap, cl->roots_count);
+  obj3 = make(ap, cl->roots_count);
+  obj4 = make(ap, cl->roots_count);
+  obj5 = make(ap, cl->roots_count);
+  obj6 = make(ap, cl->roots_count);
+  mps_ap_destroy(ap);
+  length = obj1[1] ^ obj2[1] ^ obj3[1] ^ obj4[1] ^ obj5[1] ^ obj6[1];
+  start = collections;
+
+  mps_thread_park(thread);
+  while (*(volatile mps_word_t *)&collections < start + 2
+         && start + 2 <= collectionsCOUNT)
+    scribble();
+  mps_thread_unpark(thread);
+
+  cdie(dylan_check(obj1) && dylan_check(obj2) && dylan_check(obj3)
+       && dylan_check(obj4) && dylan_check(obj5) && dylan_check(obj6),
+       "parked object check");
+  cdie((obj1[1] ^ obj2[1] ^ obj3[1] ^ obj4[1] ^ obj5[1] ^ obj6[1]) == length,
+       "parked object check");
+}
+
+/* kid_deep -- churn from deep in the stack
+ *
+ * Each frame keeps an object alive that nothing else refers to. The
+ * frames don't change while the thread churns, so with soft-dirty
+ * pages they are mostly not rescanned -- see
+ * <design/root/#stack.mark>. It must not be inlined into kid_thread,
+ * or the top frame's object might be above the marker.
+ */
+
+ATTRIBUTE_NOINLINE
+static void kid_deep(closure_t cl, mps_ap_t ap,
+                     mps_thr_t thread1, mps_thr_t thread2, size_t depth)
+{
+  mps_addr_t volatile obj = make(ap, cl->roots_count);
+  if (depth > 0)
+    kid_deep(cl, ap, thread1, thread2, depth - 1);
+  else
+    kid_churn(cl, ap, thread1, thread2);
+  cdie(dylan_check(obj), "deep object check");
+}
+
 static void *kid_thread(void *arg)
 {
   void *marker = &marker;
@@ -134,9 +236,8 @@ static void *kid_thread(void *arg)
       "root_create");
 
   die(mps_ap_create(&ap, cl->pool, mps_rank_exact()), "BufferCreate(fooey)");
-  while(mps_collections(arena) < collectionsCOUNT) {
-    churn(ap, cl->roots_count);
-  }
+  kid_park(cl, thread1);
+  kid_deep(cl, ap, thread1, thread2, kidDEPTH);
   mps_ap_destroy(ap);
 
   mps_root_destroy(reg_root);
@@ -281,6 +382,9 @@ static void test_arena(void)
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, rnd_grain(testArenaSIZE));
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_BACKGROUND, rnd() % 2);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SOFT_DIRTY, rnd() % 2);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_GC_THREADS, 1 + rnd() % 4);
     die(mps_arena_create_k(&arena, mps_arena_class_vm(), args), "arena_create");
   } MPS_ARGS_END(args);
   mps_message_type_enable(arena, mps_message_type_gc());
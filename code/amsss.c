@@ -35,6 +35,10 @@ static mps_gen_param_s testChain[1] = { { 160, 0.90 } };
 
 
 static mps_arena_t arena;
+static mps_cards_t cards;
+static const char *barrierName[] = { /* how stores are tracked */
+  "protection", "cards", "soft-dirty"
+};
 static mps_ap_t ap;
 static mps_addr_t exactRoots[exactRootsCOUNT];
 static mps_addr_t ambigRoots[ambigRootsCOUNT];
@@ -161,8 +165,8 @@ static void test_pool(mps_pool_class_t pool_class, mps_arg_s args[],
         cdie(dylan_check(exactRoots[i]), "dying root check");
       exactRoots[i] = make();
       if (exactRoots[(exactRootsCOUNT-1) - i] != objNULL)
-        dylan_write(exactRoots[(exactRootsCOUNT-1) - i],
-                    exactRoots, exactRootsCOUNT);
+        dylan_write_barrier(cards, exactRoots[(exactRootsCOUNT-1) - i],
+                            exactRoots, exactRootsCOUNT);
     } else {
       i = (r >> 1) % ambigRootsCOUNT;
       ambigRoots[(ambigRootsCOUNT-1) - i] = make();
@@ -198,17 +202,24 @@ static void test_pool(mps_pool_class_t pool_class, mps_arg_s args[],
 int main(int argc, char *argv[])
 {
   int i;
+  unsigned barrier;
   mps_thr_t thread;
   mps_fmt_t format;
   mps_chain_t chain;
 
   testlib_init(argc, argv);
 
+  barrier = (unsigned)(rnd() % 3);
+  printf("Picked barrier=%s\n", barrierName[barrier]);
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, rnd_grain(testArenaSIZE));
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_GC_THREADS, 1 + rnd() % 4);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_CARD_MARKING, barrier == 1);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SOFT_DIRTY, barrier == 2);
     die(mps_arena_create_k(&arena, mps_arena_class_vm(), args), "arena_create");
   } MPS_ARGS_END(args);
+  cards = mps_arena_cards(arena);
 
   mps_message_type_enable(arena, mps_message_type_gc_start());
   mps_message_type_enable(arena, mps_message_type_gc());
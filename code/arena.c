@@ -45,6 +45,7 @@ static void arenaFreeLandFinish(Arena arena);
 static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args);
 static void ArenaAbsFinish(Inst inst);
 static Res ArenaAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth);
+static void arenaWindowInit(Arena arena, Clock now);
 
 
 static void ArenaNoFree(Addr base, Size size, Pool pool)
@@ -180,6 +181,32 @@ Bool ArenaCheck(Arena arena)
   CHECKL(arena->committed <= arena->commitLimit);
   CHECKL(arena->spareCommitted <= arena->committed);
   CHECKL(0.0 <= arena->pauseTime);
+  CHECKL(arena->gcThreads >= 1);
+  if (arena->workers != NULL)
+    CHECKD_NOSIG(Workers, arena->workers);
+  if (arena->traceBatch != NULL)
+    CHECKL(arena->workers != NULL);
+  CHECKL(BoolCheck(arena->backgroundCollect));
+  if (arena->background != NULL)
+    CHECKD_NOSIG(Background, arena->background);
+  CHECKL(BoolCheck(arena->cardMarking));
+  CHECKL(arena->cardsStruct.stripe != NULL);
+  CHECKL(arena->cardNoneStripe == &arena->cardNone);
+  CHECKL(arena->cardMarking
+         || arena->cardsStruct.stripe == &arena->cardNoneStripe);
+  CHECKL((arena->cardsMany == NULL)
+         == (arena->cardsStruct.stripe == &arena->cardNoneStripe));
+  CHECKL(BoolCheck(arena->softDirty));
+  CHECKL(!(arena->cardMarking && arena->softDirty));
+  CHECKL(BoolCheck(arena->fixPrefetch));
+  CHECKL(arena->pressure == NULL || FUNCHECK(arena->pressure));
+  /* nothing to check for pressureClosure or pressureRead */
+  CHECKL(BoolCheck(arena->underPressure));
+  CHECKL(arena->pressure != NULL || !arena->underPressure);
+  CHECKL(!arena->underPressure || arena->spareCommitLimit == 0);
+  CHECKL(arena->windowPaused >= 0.0);
+  CHECKL(arena->windowCount <= ARENA_WINDOW_COUNT);
+  CHECKL(arena->windowNext < ARENA_WINDOW_COUNT);
 
   CHECKL(arena->zoneShift == ZoneShiftUNSET
          || ShiftCheck(arena->zoneShift));
@@ -225,7 +252,15 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   Size commitLimit = ARENA_DEFAULT_COMMIT_LIMIT;
   Size spareCommitLimit = ARENA_DEFAULT_SPARE_COMMIT_LIMIT;
   double pauseTime = ARENA_DEFAULT_PAUSE_TIME;
+  Count gcThreads = ARENA_DEFAULT_GC_THREADS;
+  Bool backgroundCollect = ARENA_DEFAULT_BACKGROUND;
+  Bool cardMarking = ARENA_DEFAULT_CARD_MARKING;
+  Bool softDirty = ARENA_DEFAULT_SOFT_DIRTY;
+  Bool fixPrefetch = ARENA_DEFAULT_FIX_PREFETCH;
+  mps_pressure_t pressure = NULL;
+  void *pressureClosure = NULL;
   mps_arg_s arg;
+  Index i;
 
   AVER(arena != NULL);
   AVERT(ArenaGrainSize, grainSize);
@@ -238,6 +273,24 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
     spareCommitLimit = arg.val.size;
   if (ArgPick(&arg, args, MPS_KEY_PAUSE_TIME))
     pauseTime = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_GC_THREADS))
+    gcThreads = arg.val.count;
+  if (gcThreads < 1)
+    return ResPARAM;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_BACKGROUND))
+    backgroundCollect = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_CARD_MARKING))
+    cardMarking = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_SOFT_DIRTY))
+    softDirty = arg.val.b;
+  if (cardMarking && softDirty)
+    return ResPARAM;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_FIX_PREFETCH))
+    fixPrefetch = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_PRESSURE))
+    pressure = arg.val.pressure;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_PRESSURE_CLOSURE))
+    pressureClosure = arg.val.p;
 
   /* Superclass init */
   InstInit(CouldBeA(Inst, arena));
@@ -248,6 +301,33 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   arena->spareCommitted = (Size)0;
   arena->spareCommitLimit = spareCommitLimit;
   arena->pauseTime = pauseTime;
+  arena->gcThreads = gcThreads;
+  arena->workers = NULL;
+  arena->traceBatch = NULL;
+  arena->backgroundCollect = backgroundCollect;
+  arena->background = NULL;
+  arena->cardMarking = cardMarking;
+  /* Until ArenaCardsCreate, all stores mark the same unused card.
+     <design/write-barrier/#card.none> */
+  arena->cardNone = 0;
+  arena->cardNoneStripe = &arena->cardNone;
+  arena->cardsMany = NULL;
+  arena->cardsStruct.stripe = &arena->cardNoneStripe;
+  arena->cardsStruct.stripeShift = 0;
+  arena->cardsStruct.stripeMask = 0;
+  arena->cardsStruct.shift = 0;
+  arena->cardsStruct.mask = 0;
+  /* Fall back to the write barrier if the operating system can't
+     help.  <design/write-barrier/#soft-dirty.fallback> */
+  arena->softDirty = softDirty && ProtDirtySupported();
+  arena->softDirtyEpoch = 0;
+  arena->fixPrefetch = fixPrefetch;
+  ProtDirtyCacheInit(&arena->softDirtyCacheStruct, 0);
+  arena->pressure = pressure;
+  arena->pressureClosure = pressureClosure;
+  arena->pressureRead = 0;     /* read at the first poll */
+  arena->underPressure = FALSE;
+  arena->pressureSpareLimit = spareCommitLimit;
   arena->grainSize = grainSize;
   /* zoneShift must be overridden by arena class init */
   arena->zoneShift = ZoneShiftUNSET;
@@ -261,6 +341,8 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   arena->primary = NULL;
   RingInit(ArenaChunkRing(arena));
   arena->chunkTree = TreeEMPTY;
+  for (i = 0; i < ARENA_CHUNK_INDEX_LENGTH; ++i)
+    arena->chunkIndex[i] = NULL;
   arena->chunkSerial = (Serial)0;
   
   LocusInit(arena);
@@ -269,6 +351,9 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   if (res != ResOK)
     goto failGlobalsInit;
 
+  /* Needs fillMutatorSize from GlobalsInit. <design/arena/#pause> */
+  arenaWindowInit(arena, WallClockNow());
+
   SetClassOfPoly(arena, CLASS(AbstractArena));
   arena->sig = ArenaSig;
   AVERC(Arena, arena);
@@ -308,6 +393,7 @@ failGlobalsInit:
  * exist on all platforms. */
 
 ARG_DEFINE_KEY(VMW3_TOP_DOWN, Bool);
+ARG_DEFINE_KEY(ARENA_HUGE_PAGES, Bool);
 
 
 /* ArenaCreate -- create the arena and call initializers */
@@ -318,6 +404,13 @@ ARG_DEFINE_KEY(ARENA_ZONED, Bool);
 ARG_DEFINE_KEY(COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(SPARE_COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(PAUSE_TIME, double);
+ARG_DEFINE_KEY(ARENA_GC_THREADS, Count);
+ARG_DEFINE_KEY(ARENA_BACKGROUND, Bool);
+ARG_DEFINE_KEY(ARENA_CARD_MARKING, Bool);
+ARG_DEFINE_KEY(ARENA_SOFT_DIRTY, Bool);
+ARG_DEFINE_KEY(ARENA_FIX_PREFETCH, Bool);
+ARG_DEFINE_KEY(ARENA_PRESSURE, Fun);
+ARG_DEFINE_KEY(ARENA_PRESSURE_CLOSURE, Pointer);
 
 static Res arenaFreeLandInit(Arena arena)
 {
@@ -517,6 +610,7 @@ void ControlFinish(Arena arena)
 static Res ArenaAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
 {
   Arena arena = CouldBeA(AbstractArena, inst);
+  PauseKind kind;
   Res res;
 
   if (!TESTC(AbstractArena, arena))
@@ -550,10 +644,23 @@ static Res ArenaAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                "hasFreeLand      $S\n", WriteFYesNo(arena->hasFreeLand),
                "freeZones        $B\n", (WriteFB)arena->freeZones,
                "zoned            $S\n", WriteFYesNo(arena->zoned),
+               "underPressure    $S\n", WriteFYesNo(arena->underPressure),
                NULL);
   if (res != ResOK)
     return res;
 
+  for (kind = 0; kind < PauseKindLIMIT; ++kind) {
+    mps_pause_stats_s *stats = &arena->pauseStats[kind];
+    res = WriteF(stream, depth + 2,
+                 "pauses of kind $U: ", (WriteFU)kind,
+                 "count $U ", (WriteFU)stats->count,
+                 "total $D ", (WriteFD)stats->total,
+                 "max $D\n", (WriteFD)stats->max,
+                 NULL);
+    if (res != ResOK)
+      return res;
+  }
+
   res = WriteF(stream, depth + 2,
                "droppedMessages $U$S\n", (WriteFU)arena->droppedMessages,
                (arena->droppedMessages == 0 ? "" : "  -- MESSAGES DROPPED!"),
@@ -707,6 +814,150 @@ Res ControlDescribe(Arena arena, mps_lib_FILE *stream, Count depth)
 }
 
 
+/* ArenaChunkIndexManyStruct -- sentinel for shared index entries
+ *
+ * Only the address of this structure is used: it marks entries of
+ * the chunk index that map to more than one chunk.  It is never
+ * initialized as a chunk and must not be passed to ChunkCheck.
+ */
+
+ChunkStruct ArenaChunkIndexManyStruct;
+
+
+/* arenaChunkIndexAdd -- add a chunk to the direct-mapped chunk index
+ *
+ * Each entry of the index is NULL if no chunk overlaps any of the
+ * address stripes that map to it, the chunk if exactly one does, and
+ * ArenaChunkIndexMANY otherwise, in which case ChunkOfAddr searches
+ * the chunk tree.
+ *
+ * Adding a chunk only changes entries from NULL to the chunk, or to
+ * ArenaChunkIndexMANY, so collector threads that read the index
+ * without the arena lock never see an entry that loses a chunk, and
+ * the release store ensures that they see the chunk initialized.  See
+ * <design/arena/#chunk.index.parallel>.
+ */
+
+static void arenaChunkIndexAdd(Arena arena, Chunk chunk)
+{
+  Word first, last;
+  Count n;
+  Index i;
+
+  first = (Word)chunk->base >> ARENA_CHUNK_INDEX_SHIFT;
+  last = (Word)AddrSub(chunk->limit, 1) >> ARENA_CHUNK_INDEX_SHIFT;
+  n = (last - first >= ARENA_CHUNK_INDEX_LENGTH)
+    ? ARENA_CHUNK_INDEX_LENGTH : (Count)(last - first + 1);
+  i = ArenaChunkIndexOfAddr(chunk->base);
+  while (n > 0) {
+    if (arena->chunkIndex[i] == NULL)
+      STORE_RELEASE(arena->chunkIndex[i], chunk);
+    else if (arena->chunkIndex[i] != chunk)
+      STORE_RELEASE(arena->chunkIndex[i], ArenaChunkIndexMANY);
+    i = (i + 1) & (ARENA_CHUNK_INDEX_LENGTH - 1);
+    --n;
+  }
+}
+
+
+/* arenaChunkIndexRebuild -- rebuild the chunk index without a chunk
+ *
+ * Chunks are removed rarely, and never while collector threads are
+ * fixing references, so the index is rebuilt from the chunk ring,
+ * leaving out the chunk being removed.  See
+ * <design/arena/#chunk.index.update>.
+ */
+
+static void arenaChunkIndexRebuild(Arena arena, Chunk removed)
+{
+  Ring node, next;
+  Index i;
+
+  for (i = 0; i < ARENA_CHUNK_INDEX_LENGTH; ++i)
+    arena->chunkIndex[i] = NULL;
+
+  RING_FOR(node, ArenaChunkRing(arena), next) {
+    Chunk chunk = RING_ELT(Chunk, arenaRing, node);
+    if (chunk != removed)
+      arenaChunkIndexAdd(arena, chunk);
+  }
+}
+
+
+/* arenaCardsSink -- cards for stripes outside the arena
+ *
+ * The sink follows the shared cards in the same allocation.
+ */
+
+#define arenaCardsSink(arena) ((arena)->cardsMany + CardsSTRIPE)
+
+
+/* arenaCardsAdd -- add a chunk's cards to the stripe index
+ *
+ * Like the chunk index, each entry of the stripe index is the sink
+ * if no chunk overlaps any stripe that maps to it, the chunk's cards
+ * for the stripe if exactly one does, and the arena's shared cards
+ * otherwise.  Only the shared cards can alias.  The sink absorbs marks
+ * for stores outside the arena, and is never read.  A mutator that read
+ * an entry before it became shared may still mark the chunk's own
+ * cards, so ArenaCardsDirty checks both.  See
+ * <design/write-barrier/#card.many>.
+ */
+
+static void arenaCardsAdd(Arena arena, Chunk chunk)
+{
+  unsigned char **stripe = arena->cardsStruct.stripe;
+  Word first, last, s;
+  Index i;
+
+  if (arena->cardsMany == NULL)
+    return; /* not created yet, or card marking is off */
+  AVER(chunk->cards != NULL);
+
+  first = (Word)chunk->base >> ARENA_CARD_STRIPE_SHIFT;
+  last = (Word)AddrSub(chunk->limit, 1) >> ARENA_CARD_STRIPE_SHIFT;
+  if (last - first >= ARENA_CARD_STRIPE_COUNT) {
+    /* The chunk's own stripes alias. */
+    for (i = 0; i < ARENA_CARD_STRIPE_COUNT; ++i)
+      STORE_RELEASE(stripe[i], arena->cardsMany);
+    return;
+  }
+  for (s = first; s <= last; ++s) {
+    unsigned char *cards = chunk->cards + (s - first) * CardsSTRIPE;
+    i = (Index)(s & (ARENA_CARD_STRIPE_COUNT - 1));
+    if (stripe[i] == arenaCardsSink(arena))
+      STORE_RELEASE(stripe[i], cards);
+    else if (stripe[i] != cards)
+      STORE_RELEASE(stripe[i], arena->cardsMany);
+  }
+}
+
+
+/* arenaCardsRemove -- remove a chunk's cards from the stripe index
+ *
+ * Entries for the chunk's own cards revert to the sink.  Shared entries stay
+ * shared, because a mutator may still mark the shared cards for
+ * another chunk.  See <design/write-barrier/#card.many>.
+ */
+
+static void arenaCardsRemove(Arena arena, Chunk chunk)
+{
+  unsigned char **stripe = arena->cardsStruct.stripe;
+  Word first, last, s;
+
+  if (arena->cardsMany == NULL)
+    return;
+
+  first = (Word)chunk->base >> ARENA_CARD_STRIPE_SHIFT;
+  last = (Word)AddrSub(chunk->limit, 1) >> ARENA_CARD_STRIPE_SHIFT;
+  for (s = first; s <= last && s - first < ARENA_CARD_STRIPE_COUNT; ++s) {
+    Index i = (Index)(s & (ARENA_CARD_STRIPE_COUNT - 1));
+    if (stripe[i] == chunk->cards + (s - first) * CardsSTRIPE)
+      stripe[i] = arenaCardsSink(arena);
+  }
+}
+
+
 /* ArenaChunkInsert -- insert chunk into arena's chunk tree and ring,
  * update the total reserved address space, and set the primary chunk
  * if not already set.
@@ -727,6 +978,8 @@ void ArenaChunkInsert(Arena arena, Chunk chunk) {
   TreeBalance(&updatedTree);
   arena->chunkTree = updatedTree;
   RingAppend(ArenaChunkRing(arena), &chunk->arenaRing);
+  arenaChunkIndexAdd(arena, chunk);
+  arenaCardsAdd(arena, chunk);
 
   arena->reserved += ChunkReserved(chunk);
 
@@ -753,6 +1006,9 @@ void ArenaChunkRemoved(Arena arena, Chunk chunk)
   AVER(arena->reserved >= size);
   arena->reserved -= size;
 
+  arenaChunkIndexRebuild(arena, chunk);
+  arenaCardsRemove(arena, chunk);
+
   if (chunk == arena->primary) {
     /* The primary chunk must be the last chunk to be removed. */
     AVER(RingIsSingle(ArenaChunkRing(arena)));
@@ -1196,9 +1452,18 @@ Size ArenaSpareCommitted(Arena arena)
   return arena->spareCommitted;
 }
 
+/* ArenaSpareCommitLimit -- the client's spare commit limit
+ *
+ * Under memory pressure the arena keeps no spare memory, and the
+ * client's limit is kept in pressureSpareLimit until the pressure is
+ * relieved.  See <design/arena/#pressure.spare>.
+ */
+
 Size ArenaSpareCommitLimit(Arena arena)
 {
   AVERT(Arena, arena);
+  if (arena->underPressure)
+    return arena->pressureSpareLimit;
   return arena->spareCommitLimit;
 }
 
@@ -1207,6 +1472,11 @@ void ArenaSetSpareCommitLimit(Arena arena, Size limit)
   AVERT(Arena, arena);
   /* Can't check limit, as all possible values are allowed. */
 
+  if (arena->underPressure) {
+    arena->pressureSpareLimit = limit;
+    EVENT2(SpareCommitLimitSet, arena, limit);
+    return;
+  }
   arena->spareCommitLimit = limit;
   if (arena->spareCommitLimit < arena->spareCommitted) {
     Size excess = arena->spareCommitted - arena->spareCommitLimit;
@@ -1216,6 +1486,51 @@ void ArenaSetSpareCommitLimit(Arena arena, Size limit)
   EVENT2(SpareCommitLimitSet, arena, limit);
 }
 
+
+/* ArenaPressurePoll -- read the memory pressure and respond to it
+ *
+ * Called at the start of each poll, at time now.  Reads the pressure
+ * at most every ARENA_PRESSURE_INTERVAL seconds.  While the arena is
+ * under pressure it keeps no spare committed memory.  Returns TRUE if
+ * the pressure was read and the arena is under pressure, so that the
+ * caller should consider collecting the world.  See
+ * <design/arena/#pressure>.
+ */
+
+Bool ArenaPressurePoll(Arena arena, Clock now)
+{
+  double pressure;
+
+  AVERT(Arena, arena);
+
+  if (arena->pressure == NULL)
+    return FALSE;
+  if (now < arena->pressureRead
+      || (double)(now - arena->pressureRead)
+         < ARENA_PRESSURE_INTERVAL * (double)ClocksPerSec())
+    return FALSE;
+  arena->pressureRead = now;
+
+  /* The pressure function must not call the MPS: the arena is locked. */
+  pressure = (*arena->pressure)(arena->pressureClosure);
+
+  if (!arena->underPressure && pressure >= 1.0) {
+    arena->underPressure = TRUE;
+    arena->pressureSpareLimit = arena->spareCommitLimit;
+    arena->spareCommitLimit = 0;
+  } else if (arena->underPressure && pressure < ARENA_PRESSURE_RELIEF) {
+    arena->underPressure = FALSE;
+    arena->spareCommitLimit = arena->pressureSpareLimit;
+  }
+  EVENT3(ArenaPressure, arena, pressure, BOOLOF(arena->underPressure));
+
+  if (!arena->underPressure)
+    return FALSE;
+  if (arena->spareCommitted > 0)
+    (void)Method(Arena, arena, purgeSpare)(arena, arena->spareCommitted);
+  return TRUE;
+}
+
 double ArenaPauseTime(Arena arena)
 {
   AVERT(Arena, arena);
@@ -1230,6 +1545,231 @@ void ArenaSetPauseTime(Arena arena, double pauseTime)
   EVENT2(PauseTimeSet, arena, pauseTime);
 }
 
+
+/* Pause statistics
+ *
+ * The arena keeps a histogram of the pauses of each kind, and the
+ * allocation rate and mutator utilization over recent windows of
+ * time.  Recording a pause costs a few arithmetic operations and the
+ * two clock readings.  See <design/arena/#pause>.
+ */
+
+#define PauseSUB ((Word)1 << PAUSE_SUB_BUCKET_SHIFT)
+
+
+/* pauseBucket -- histogram bucket for a pause of us microseconds
+ *
+ * Pauses shorter than PauseSUB microseconds have a bucket for each
+ * microsecond.  Above that, each power of two is divided into
+ * PauseSUB buckets, so that a bucket is narrower than 1/PauseSUB of
+ * the pauses it counts.  The last bucket also counts all longer
+ * pauses.
+ */
+
+static Index pauseBucket(double us)
+{
+  Word w;
+  Shift e;
+  Index i;
+
+  if (us >= (double)((Word)1 << (MPS_WORD_WIDTH - 2)))
+    return MPS_PAUSE_BUCKETS - 1;
+  w = (Word)us;
+  if (w < PauseSUB)
+    return (Index)w;
+  e = SizeFloorLog2((Size)w);
+  i = ((Index)(e - PAUSE_SUB_BUCKET_SHIFT + 1) << PAUSE_SUB_BUCKET_SHIFT)
+      + (Index)((w >> (e - PAUSE_SUB_BUCKET_SHIFT)) & (PauseSUB - 1));
+  if (i >= MPS_PAUSE_BUCKETS)
+    i = MPS_PAUSE_BUCKETS - 1;
+  return i;
+}
+
+
+/* PauseBucketLimit -- upper limit of a bucket, in seconds */
+
+double PauseBucketLimit(Index bucket)
+{
+  double limit;
+  Index e;
+
+  AVER(bucket < MPS_PAUSE_BUCKETS);
+
+  if (bucket < PauseSUB)
+    return (double)(bucket + 1) / 1e6;
+  limit = (double)(PauseSUB + (bucket & (PauseSUB - 1)) + 1);
+  for (e = bucket >> PAUSE_SUB_BUCKET_SHIFT; e > 1; --e)
+    limit *= 2.0;
+  return limit / 1e6;
+}
+
+
+/* arenaWindowInit -- forget all pauses and start a new window */
+
+static void arenaWindowInit(Arena arena, Clock now)
+{
+  PauseKind kind;
+  Index i;
+
+  for (kind = 0; kind < PauseKindLIMIT; ++kind) {
+    mps_pause_stats_s *stats = &arena->pauseStats[kind];
+    stats->count = 0;
+    stats->total = 0.0;
+    stats->max = 0.0;
+    for (i = 0; i < MPS_PAUSE_BUCKETS; ++i)
+      stats->bucket[i] = 0;
+  }
+  arena->windowStart = now;
+  arena->windowFill = ArenaGlobals(arena)->fillMutatorSize;
+  arena->windowPaused = 0.0;
+  arena->windowCount = 0;
+  arena->windowNext = 0;
+}
+
+
+/* arenaWindowUpdate -- close the current window if it is long enough
+ *
+ * .pause.window.close: Windows are closed when a pause is recorded or
+ * the statistics are read, so a window may be longer than
+ * ARENA_WINDOW_LENGTH if the arena was idle.  Its figures are
+ * averages over its actual length.
+ */
+
+static void arenaWindowUpdate(Arena arena, Clock now)
+{
+  double fill = ArenaGlobals(arena)->fillMutatorSize;
+  mps_window_stats_s *window;
+  double length;
+
+  if (now < arena->windowStart) {
+    /* The clock wrapped around: start again. */
+    arena->windowStart = now;
+    return;
+  }
+  length = (double)(now - arena->windowStart) / (double)WallClocksPerSec();
+  if (length < ARENA_WINDOW_LENGTH)
+    return;
+
+  window = &arena->window[arena->windowNext];
+  window->length = length;
+  window->alloc_rate = (fill - arena->windowFill) / length;
+  if (arena->windowPaused >= length)
+    window->utilization = 0.0;
+  else
+    window->utilization = 1.0 - arena->windowPaused / length;
+  arena->windowNext = (arena->windowNext + 1) % ARENA_WINDOW_COUNT;
+  if (arena->windowCount < ARENA_WINDOW_COUNT)
+    ++arena->windowCount;
+
+  arena->windowStart = now;
+  arena->windowFill = fill;
+  arena->windowPaused = 0.0;
+}
+
+
+/* ArenaPauseRecord -- record a pause of the mutator
+ *
+ * start and end are times from WallClockNow
+ * <design/arena/#pause.clock>.
+ *
+ * .pause.nested: A flip during a poll in a mutator thread is part of
+ * the poll's pause, so it is counted in the histogram of flips but
+ * not again in the window's pause time.
+ */
+
+void ArenaPauseRecord(Arena arena, PauseKind kind, Clock start, Clock end)
+{
+  mps_pause_stats_s *stats;
+  double length;
+
+  AVERT(Arena, arena);
+  AVER(kind < PauseKindLIMIT);
+
+  if (end < start)
+    end = start;
+  length = (double)(end - start) / (double)WallClocksPerSec();
+
+  stats = &arena->pauseStats[kind];
+  ++stats->count;
+  stats->total += length;
+  if (length > stats->max)
+    stats->max = length;
+  ++stats->bucket[pauseBucket(length * 1e6)];
+
+  if (!(kind == PauseKindFLIP && ArenaGlobals(arena)->insidePoll
+        && arena->background == NULL))
+    arena->windowPaused += length;
+  arenaWindowUpdate(arena, end);
+}
+
+
+/* ArenaPauseStats -- return the histogram of pauses of a kind */
+
+void ArenaPauseStats(mps_pause_stats_s *statsReturn, Arena arena,
+                     PauseKind kind)
+{
+  AVER(statsReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(kind < PauseKindLIMIT);
+
+  *statsReturn = arena->pauseStats[kind];
+}
+
+
+/* ArenaWindowStats -- return figures for recent windows
+ *
+ * Copies the figures for up to count windows, most recent first, and
+ * returns the number copied.
+ */
+
+Count ArenaWindowStats(mps_window_stats_s *statsReturn, Count count,
+                       Arena arena)
+{
+  Index i;
+
+  AVER(statsReturn != NULL || count == 0);
+  AVERT(Arena, arena);
+
+  arenaWindowUpdate(arena, WallClockNow());
+  if (count > arena->windowCount)
+    count = arena->windowCount;
+  for (i = 0; i < count; ++i)
+    statsReturn[i] = arena->window[(arena->windowNext + ARENA_WINDOW_COUNT
+                                    - 1 - i) % ARENA_WINDOW_COUNT];
+  return count;
+}
+
+
+/* ArenaMMU -- minimum mutator utilization over the recent windows
+ *
+ * The windows are consecutive rather than sliding, so this is an
+ * upper bound on the true minimum mutator utilization for windows of
+ * ARENA_WINDOW_LENGTH.
+ */
+
+double ArenaMMU(Arena arena)
+{
+  double mmu = 1.0;
+  Index i;
+
+  AVERT(Arena, arena);
+
+  arenaWindowUpdate(arena, WallClockNow());
+  for (i = 0; i < arena->windowCount; ++i)
+    if (arena->window[i].utilization < mmu)
+      mmu = arena->window[i].utilization;
+  return mmu;
+}
+
+
+/* ArenaPauseStatsReset -- forget all pauses and windows */
+
+void ArenaPauseStatsReset(Arena arena)
+{
+  AVERT(Arena, arena);
+  arenaWindowInit(arena, WallClockNow());
+}
+
 /* Used by arenas which don't use spare committed memory */
 Size ArenaNoPurgeSpare(Arena arena, Size size)
 {
@@ -1359,15 +1899,42 @@ Res ArenaNoExtend(Arena arena, Addr base, Size size)
 }
 
 
-/* ArenaCompact -- respond (or not) to trace reclaim */
+/* ArenaCompact -- respond (or not) to trace reclaim
+ *
+ * trace is the trace being reclaimed, or NULL if the arena is being
+ * compacted in idle time by ArenaReleaseSpare.
+ */
 
 void ArenaCompact(Arena arena, Trace trace)
 {
   AVERT(Arena, arena);
-  AVERT(Trace, trace);
+  AVER(trace == NULL || TESTT(Trace, trace));
   Method(Arena, arena, compact)(arena, trace);
 }
 
+
+/* ArenaReleaseSpare -- return as much memory to the OS as possible
+ *
+ * Purges all spare committed memory and destroys empty chunks.
+ * Returns the decrease in committed memory.  Used in idle time by
+ * ArenaCollectUntil, when no trace is running.
+ */
+
+Size ArenaReleaseSpare(Arena arena)
+{
+  Size committed;
+
+  AVERT(Arena, arena);
+  AVER(arena->busyTraces == TraceSetEMPTY);
+
+  committed = ArenaCommitted(arena);
+  if (arena->spareCommitted > 0)
+    (void)Method(Arena, arena, purgeSpare)(arena, arena->spareCommitted);
+  ArenaCompact(arena, NULL);
+  AVER(ArenaCommitted(arena) <= committed);
+  return committed - ArenaCommitted(arena);
+}
+
 static void ArenaTrivCompact(Arena arena, Trace trace)
 {
   UNUSED(arena);
@@ -1375,6 +1942,292 @@ static void ArenaTrivCompact(Arena arena, Trace trace)
 }
 
 
+/* ArenaCardsCreate -- allocate the stripe index, if card marking
+ *
+ * The chunks' cards are allocated with the chunks, and the stripe
+ * index starts out pointing at the sink.  See
+ * <design/write-barrier/#card.table>.
+ */
+
+Res ArenaCardsCreate(Arena arena)
+{
+  unsigned char **stripe;
+  void *p;
+  Ring node, next;
+  Index i;
+  Res res;
+
+  AVERT(Arena, arena);
+
+  if (!ArenaCardMarking(arena))
+    return ResOK;
+
+  res = ControlAlloc(&p, arena,
+                     ARENA_CARD_STRIPE_COUNT * sizeof(unsigned char *));
+  if (res != ResOK)
+    goto failStripe;
+  stripe = p;
+
+  /* The shared cards and the sink. */
+  res = ControlAlloc(&p, arena, 2 * CardsSTRIPE);
+  if (res != ResOK)
+    goto failMany;
+  (void)AddrSet((Addr)p, 0, 2 * CardsSTRIPE);
+
+  arena->cardsMany = p;
+  for (i = 0; i < ARENA_CARD_STRIPE_COUNT; ++i)
+    stripe[i] = arenaCardsSink(arena);
+  arena->cardsStruct.stripe = stripe;
+  arena->cardsStruct.stripeShift = ARENA_CARD_STRIPE_SHIFT;
+  arena->cardsStruct.stripeMask = ARENA_CARD_STRIPE_COUNT - 1;
+  arena->cardsStruct.shift = ARENA_CARD_SHIFT;
+  arena->cardsStruct.mask = CardsSTRIPE - 1;
+
+  RING_FOR(node, ArenaChunkRing(arena), next)
+    arenaCardsAdd(arena, RING_ELT(Chunk, arenaRing, node));
+  return ResOK;
+
+failMany:
+  ControlFree(arena, stripe,
+              ARENA_CARD_STRIPE_COUNT * sizeof(unsigned char *));
+failStripe:
+  return res;
+}
+
+
+/* ArenaCardsDestroy -- free the stripe index */
+
+void ArenaCardsDestroy(Arena arena)
+{
+  unsigned char **stripe;
+  unsigned char *many;
+
+  AVERT(Arena, arena);
+
+  if (arena->cardsMany == NULL)
+    return;
+
+  stripe = arena->cardsStruct.stripe;
+  many = arena->cardsMany;
+  arena->cardsMany = NULL;
+  arena->cardsStruct.stripe = &arena->cardNoneStripe;
+  arena->cardsStruct.stripeShift = 0;
+  arena->cardsStruct.stripeMask = 0;
+  arena->cardsStruct.shift = 0;
+  arena->cardsStruct.mask = 0;
+  ControlFree(arena, many, 2 * CardsSTRIPE);
+  ControlFree(arena, stripe,
+              ARENA_CARD_STRIPE_COUNT * sizeof(unsigned char *));
+}
+
+
+/* cardsFirstDirty -- find the first dirty card in a range of cards */
+
+static unsigned char *cardsFirstDirty(unsigned char *base,
+                                      unsigned char *limit)
+{
+  unsigned char *card = base;
+  while (card < limit && *(unsigned char volatile *)card == 0)
+    ++card;
+  return card;
+}
+
+
+/* arenaCardsSharedDirty -- is a shared card dirty for a range?
+ *
+ * The range must be in one stripe, and that stripe must be shared.
+ * See <design/write-barrier/#card.many>.
+ */
+
+static Bool arenaCardsSharedDirty(Arena arena, Addr base, Addr limit)
+{
+  Word mask = arena->cardsStruct.mask;
+  unsigned char *many = arena->cardsMany;
+  unsigned char *cardLimit
+    = &many[((Word)AddrSub(limit, 1) >> ARENA_CARD_SHIFT) & mask] + 1;
+
+  return cardsFirstDirty(&many[((Word)base >> ARENA_CARD_SHIFT) & mask],
+                         cardLimit) < cardLimit;
+}
+
+
+/* ArenaCardsFirstDirty -- find the first dirty card in part of a chunk
+ *
+ * Returns TRUE and the base of the first card in [base, limit) that
+ * the mutator may have marked since the cards were last cleared, or
+ * FALSE if there is none.  A card is dirty if either the chunk's own
+ * card or the shared card for a shared stripe is.  Cards alias only
+ * in shared stripes.  .cards: Keep in sync with MPS_WRITE_BARRIER in
+ * <code/mps.h>.
+ */
+
+Bool ArenaCardsFirstDirty(Addr *cardReturn, Arena arena, Chunk chunk,
+                          Addr base, Addr limit)
+{
+  unsigned char **stripe;
+  Addr stripeLimit;
+
+  AVER_CRITICAL(cardReturn != NULL);
+  AVER_CRITICAL(ArenaCardMarking(arena));
+  AVER_CRITICAL(chunk->cards != NULL);
+  AVER_CRITICAL(chunk->base <= base);
+  AVER_CRITICAL(limit <= chunk->limit);
+
+  stripe = arena->cardsStruct.stripe;
+  base = AddrAlignDown(base, (Size)1 << ARENA_CARD_SHIFT);
+  for (; base < limit; base = stripeLimit) {
+    Word s = (Word)base >> ARENA_CARD_STRIPE_SHIFT;
+    unsigned char *cardLimit, *card;
+
+    stripeLimit = (Addr)((s + 1) << ARENA_CARD_STRIPE_SHIFT);
+    if (stripeLimit > limit || stripeLimit == (Addr)0)
+      stripeLimit = limit;
+    cardLimit = ChunkCard(chunk, AddrSub(stripeLimit, 1)) + 1;
+
+    if (stripe[s & (ARENA_CARD_STRIPE_COUNT - 1)] == arena->cardsMany) {
+      /* Shared stripe: visit each card. */
+      for (; base < stripeLimit;
+           base = AddrAdd(base, (Size)1 << ARENA_CARD_SHIFT)) {
+        Addr cardEnd = AddrAdd(base, (Size)1 << ARENA_CARD_SHIFT);
+        if (*(unsigned char volatile *)ChunkCard(chunk, base) != 0
+            || arenaCardsSharedDirty(arena, base, cardEnd)) {
+          *cardReturn = base;
+          return TRUE;
+        }
+      }
+    } else {
+      card = cardsFirstDirty(ChunkCard(chunk, base), cardLimit);
+      if (card < cardLimit) {
+        *cardReturn = AddrAdd(base, AddrOffset(ChunkCard(chunk, base), card)
+                              << ARENA_CARD_SHIFT);
+        return TRUE;
+      }
+    }
+  }
+  return FALSE;
+}
+
+
+/* ArenaCardsDirty -- has the mutator stored into a range since the
+ * cards were last cleared?
+ *
+ * The range must be in one chunk.  See ArenaCardsFirstDirty.
+ */
+
+Bool ArenaCardsDirty(Arena arena, Addr base, Addr limit)
+{
+  Chunk chunk;
+  Addr card;
+  Bool found;
+
+  AVER_CRITICAL(ArenaCardMarking(arena));
+  AVER_CRITICAL(base < limit);
+
+  found = ChunkOfAddr(&chunk, arena, base);
+  AVER_CRITICAL(found);
+  return ArenaCardsFirstDirty(&card, arena, chunk, base, limit);
+}
+
+
+/* ArenaCardsClear -- mark all cards clean
+ *
+ * The mutator must be suspended.  See <design/write-barrier/#card.flip>.
+ */
+
+void ArenaCardsClear(Arena arena)
+{
+  Ring node, next;
+
+  AVERT(Arena, arena);
+  AVER(ArenaCardMarking(arena));
+
+  RING_FOR(node, ArenaChunkRing(arena), next) {
+    Chunk chunk = RING_ELT(Chunk, arenaRing, node);
+    (void)AddrSet((Addr)chunk->cards, 0,
+                  CardsSize(chunk->base, chunk->limit));
+  }
+  if (arena->cardsMany != NULL)
+    (void)AddrSet((Addr)arena->cardsMany, 0, CardsSTRIPE);
+}
+
+
+/* ArenaDirty -- might the mutator have written to a range since the
+ * arena last cleared its dirty state?
+ *
+ * Only for arenas that track dirty memory instead of using the write
+ * barrier.  See <design/write-barrier/#card.scan>.
+ */
+
+Bool ArenaDirty(Arena arena, Addr base, Addr limit)
+{
+  AVER_CRITICAL(ArenaTracksDirty(arena));
+
+  if (ArenaCardMarking(arena))
+    return ArenaCardsDirty(arena, base, limit);
+  return ProtDirty(base, limit, arena->softDirtyEpoch);
+}
+
+
+/* ArenaDirtyCacheInit, ArenaDirtyCached -- ArenaDirty, reading ahead
+ *
+ * While the mutator is suspended, an arena using soft-dirty pages can
+ * read the bits for many segments at once.  ArenaDirtyCacheInit starts
+ * reading afresh, and ArenaDirtyCached is then like ArenaDirty, and
+ * cheapest for ranges in address order.  See
+ * <design/write-barrier/#soft-dirty.cost>.
+ */
+
+void ArenaDirtyCacheInit(Arena arena)
+{
+  AVERT(Arena, arena);
+  AVER(ArenaTracksDirty(arena));
+
+  if (ArenaSoftDirty(arena))
+    ProtDirtyCacheInit(&arena->softDirtyCacheStruct, arena->softDirtyEpoch);
+}
+
+Bool ArenaDirtyCached(Arena arena, Addr base, Addr limit)
+{
+  AVER_CRITICAL(ArenaTracksDirty(arena));
+
+  if (ArenaCardMarking(arena))
+    return ArenaCardsDirty(arena, base, limit);
+  return ProtDirtyCached(&arena->softDirtyCacheStruct, base, limit);
+}
+
+
+/* ArenaDirtyLimit -- where does the written part of a range end?
+ *
+ * Returns the limit of the highest page in [base, limit) that the
+ * mutator may have written since the arena last cleared its dirty
+ * state, or base if there is none.  Only for arenas that use
+ * soft-dirty pages.  See <design/root/#stack.mark.dirty>.
+ */
+
+Addr ArenaDirtyLimit(Arena arena, Addr base, Addr limit)
+{
+  AVER(ArenaSoftDirty(arena));
+  return ProtDirtyLimit(base, limit, arena->softDirtyEpoch);
+}
+
+
+/* ArenaDirtyClear -- forget which memory the mutator has written
+ *
+ * The mutator must be suspended.  See <design/write-barrier/#card.flip>.
+ */
+
+void ArenaDirtyClear(Arena arena)
+{
+  AVERT(Arena, arena);
+  AVER(ArenaTracksDirty(arena));
+
+  if (ArenaCardMarking(arena))
+    ArenaCardsClear(arena);
+  else
+    arena->softDirtyEpoch = ProtDirtyClear();
+}
+
+
 /* Has Addr */
 
 Bool ArenaHasAddr(Arena arena, Addr addr)
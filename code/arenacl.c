@@ -170,6 +170,11 @@ static Res ClientChunkInit(Chunk chunk, BootBlock boot)
     return res;
   chunk->pageTable = p;
 
+  /* Free pages must not appear white to collector threads that read
+     the page table without the arena lock.  See
+     <design/trace/#parallel.fix.chunk>. */
+  (void)mps_lib_memset(p, 0, chunk->pageTablePages << chunk->pageShift);
+
   return ResOK;
 }
 
@@ -512,6 +512,10 @@ static Res vmArenaChunkSize(Size *chunkSizeReturn, VMArena vmArena, Size size)
     pages = chunkSize >> grainShift;
     overhead += SizeAlignUp(BTSize(pages), MPS_PF_ALIGN);
 
+    /* See <code/tract.c#overhead.cards>. */
+    if (ArenaCardMarking(MustBeA(AbstractArena, vmArena)))
+      overhead += SizeAlignUp(CardsSizeMAX(chunkSize), MPS_PF_ALIGN);
+
     /* See .overhead.sa-mapped. */
     overhead += SizeAlignUp(BTSize(pages), MPS_PF_ALIGN);
 
@@ -568,6 +572,11 @@ static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
   if (grainSize < pageSize)
     /* Make it easier to write portable programs by rounding up. */
     grainSize = pageSize;
+  /* The VM picks this keyword too, in VMParamFromArgs. */
+  if (ArgFind(&arg, args, MPS_KEY_ARENA_HUGE_PAGES) && arg.val.b
+      && grainSize < HugePageSize())
+    /* Map and unmap whole huge pages only. See <design/vm/#huge>. */
+    grainSize = HugePageSize();
   AVERT(ArenaGrainSize, grainSize);
 
   if (ArgPick(&arg, args, MPS_KEY_ARENA_SIZE))
@@ -1156,7 +1165,7 @@ static void VMCompact(Arena arena, Trace trace)
 {
   STATISTIC_DECL(Size vmem1)
 
-  AVERT(Trace, trace);
+  AVER(trace == NULL || TESTT(Trace, trace));
 
   STATISTIC(vmem1 = ArenaReserved(arena));
 
@@ -1166,7 +1175,8 @@ static void VMCompact(Arena arena, Trace trace)
   TreeTraverseAndDelete(&arena->chunkTree, vmChunkCompact, arena);
 
   STATISTIC({
-    Size vmem0 = trace->preTraceArenaReserved;
+    /* In idle time there is no trace: see ArenaReleaseSpare. */
+    Size vmem0 = trace != NULL ? trace->preTraceArenaReserved : vmem1;
     Size vmem2 = ArenaReserved(arena);
 
     /* VMCompact event: emit for collections where chunks were gained
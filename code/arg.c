@@ -171,6 +171,29 @@ found:
 }
 
 
+/* ArgFind -- try to find an argument in the argument list by keyword
+ *
+ * Like ArgPick, but leaves the argument in the list, for a keyword
+ * that is also picked later by another module.
+ */
+
+Bool ArgFind(ArgStruct *argOut, ArgList args, Key key) {
+  Index i;
+
+  AVER(argOut != NULL);
+  AVERT(ArgList, args);
+  AVERT(Key, key);
+
+  for (i = 0; args[i].key != MPS_KEY_ARGS_END; ++i)
+    if (args[i].key == key) {
+      AVERT(Arg, &args[i]);
+      *argOut = args[i];
+      return TRUE;
+    }
+  return FALSE;
+}
+
+
 /* ArgRequire -- take a required argument out of the argument list by keyword */
 
 void ArgRequire(ArgStruct *argOut, ArgList args, Key key) {
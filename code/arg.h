@@ -38,6 +38,7 @@ extern Bool ArgCheck(Arg arg);
 extern Bool ArgListCheck(ArgList args);
 
 extern Bool ArgPick(ArgStruct *argOut, ArgList args, Key key);
+extern Bool ArgFind(ArgStruct *argOut, ArgList args, Key key);
 extern void ArgRequire(ArgStruct *argOut, ArgList args, Key key);
 extern void ArgTrivVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs);
 
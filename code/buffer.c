@@ -154,6 +154,7 @@ static Res BufferAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                 "poolLimit $A\n",   (WriteFA)buffer->poolLimit,
                 "alignment $W\n",   (WriteFW)buffer->alignment,
                 "rampCount $U\n",   (WriteFU)buffer->rampCount,
+                "refills $U\n",     (WriteFU)buffer->refills,
                 NULL);
 }
 
@@ -203,6 +204,8 @@ static Res BufferAbsInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
   buffer->ap_s.limit = (mps_addr_t)0;
   buffer->poolLimit = (Addr)0;
   buffer->rampCount = 0;
+  buffer->refills = 0;
+  buffer->refillEpoch = ArenaEpoch(arena);
 
   /* .init.sig-serial: Now the vanilla stuff is initialized, sign the
      buffer and give it a serial number. It can then be safely checked
@@ -555,6 +558,45 @@ void BufferAttach(Buffer buffer, Addr base, Addr limit,
 }
 
 
+/* BufferRefillSize -- how much memory to give a buffer on refill
+ *
+ * Returns the size of the block that a pool should try to give a
+ * buffer that is being refilled with at least size bytes, when the
+ * pool is free to choose.  This starts at the arena grain size, and
+ * doubles with each refill since the last flip, up to
+ * BUFFER_REFILL_SIZE_MAX, so that an allocation point that is
+ * allocating quickly needs to enter the arena less and less often.
+ * See <design/buffer/#refill.size>.
+ */
+
+Size BufferRefillSize(Buffer buffer, Size size)
+{
+  Arena arena;
+  Size refillSize;
+  Index i;
+
+  AVERT(Buffer, buffer);
+  AVER(size > 0);
+
+  arena = BufferArena(buffer);
+  if (buffer->refillEpoch != ArenaEpoch(arena)) {
+    /* The arena has flipped since the last refill: start again. */
+    buffer->refills = 0;
+    buffer->refillEpoch = ArenaEpoch(arena);
+  }
+
+  refillSize = ArenaGrainSize(arena);
+  for (i = 0; i < buffer->refills && refillSize <= BUFFER_REFILL_SIZE_MAX / 2;
+       ++i)
+    refillSize *= 2;
+  ++buffer->refills;
+
+  if (refillSize < size)
+    refillSize = SizeArenaGrains(size, arena);
+  return refillSize;
+}
+
+
 /* BufferFill -- refill an empty buffer
  *
  * BufferFill is entered by the "reserve" operation on a buffer if there
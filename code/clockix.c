@@ -0,0 +1,91 @@
+/* clockix.c: WALL CLOCK FOR POSIX SYSTEMS
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: This is the implementation of WallClockNow for systems
+ * with a POSIX monotonic clock.  See <design/arena/#pause.clock>.
+ *
+ * .monotonic: CLOCK_MONOTONIC keeps counting while the process waits,
+ * unlike the processor time that clock() measures, and it doesn't
+ * jump when the system time is set.
+ *
+ * .units: The clock counts microseconds, the unit of the pause
+ * histograms.  A 32-bit Clock wraps after about 71 minutes, and the
+ * arena ignores a pause that spans the wrap.
+ */
+
+#include "config.h"
+
+#include <time.h> /* see .feature.li in config.h */
+
+#include "mpm.h"
+
+#if !defined(MPS_OS_FR) && !defined(MPS_OS_LI)
+#error "clockix.c is specific to FreeBSD and Linux."
+#endif
+
+SRCID(clockix, "$Id$");
+
+
+/* WallClockNow -- read the monotonic clock */
+
+Clock WallClockNow(void)
+{
+  struct timespec ts;
+  int res;
+
+  res = clock_gettime(CLOCK_MONOTONIC, &ts);
+  AVER(res == 0);
+  return (Clock)ts.tv_sec * 1000000 + (Clock)ts.tv_nsec / 1000;
+}
+
+
+/* WallClocksPerSec -- units of WallClockNow */
+
+Clock WallClocksPerSec(void)
+{
+  return (Clock)1000000;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -318,10 +318,76 @@
 #define LIKELY(exp) ((exp) != 0)
 #endif
 
+/* PREFETCH -- hint that memory will soon be read
+ *
+ * The address need not be valid: prefetching never faults.  See
+ * <https://gcc.gnu.org/onlinedocs/gcc/Other-Builtins.html>.
+ */
+
+#if defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL)
+#define PREFETCH(addr) __builtin_prefetch((void *)(addr))
+#else
+#define PREFETCH(addr) ((void)(addr))
+#endif
+
+/* CALLER_STACK_HOT -- hot end of the caller's stack
+ *
+ * The stack pointer of the function that called the current one, as
+ * it was at the call, or NULL if the compiler can't say.  Registers
+ * that the current function (or anything it calls) saves on the stack
+ * are below this.  __builtin_dwarf_cfa returns the canonical frame
+ * address, which is defined to be this.  See
+ * <http://dwarfstd.org/doc/DWARF4.pdf> section 6.4.
+ */
+
+#if defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL)
+#define CALLER_STACK_HOT() ((Addr)__builtin_dwarf_cfa())
+#else
+#define CALLER_STACK_HOT() NULL
+#endif
+
+/* THREAD_LOCAL -- storage class for a variable per thread
+ *
+ * Left undefined if the compiler has no such storage class, and then
+ * callers must manage without.  See
+ * <https://gcc.gnu.org/onlinedocs/gcc/Thread-Local.html> and
+ * <https://msdn.microsoft.com/en-us/library/9w1sdazb.aspx>.
+ */
+
+#if defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL)
+#define THREAD_LOCAL __thread
+#elif defined(MPS_BUILD_MV)
+#define THREAD_LOCAL __declspec(thread)
+#endif
+
+/* STORE_RELEASE, LOAD_ACQUIRE -- ordered access to a pointer
+ *
+ * A thread that loads a pointer with LOAD_ACQUIRE sees every write
+ * that the storing thread made before its STORE_RELEASE.  Visual C
+ * gives volatile accesses these semantics on x86 and x64.  See
+ * <https://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html>.
+ */
+
+#if defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL)
+#define STORE_RELEASE(lvalue, value) \
+  __atomic_store_n(&(lvalue), (value), __ATOMIC_RELEASE)
+#define LOAD_ACQUIRE(lvalue) __atomic_load_n(&(lvalue), __ATOMIC_ACQUIRE)
+#else
+#define STORE_RELEASE(lvalue, value) \
+  (*(void * volatile *)&(lvalue) = (value))
+#define LOAD_ACQUIRE(lvalue) (*(void * volatile *)&(lvalue))
+#endif
 
-/* Buffer Configuration -- see <code/buffer.c> */
+
+/* Buffer Configuration -- see <code/buffer.c>
+ *
+ * BUFFER_REFILL_SIZE_MAX bounds the size that BufferRefillSize asks
+ * pools for, and so bounds the memory that an allocation point can
+ * leave unused when the arena flips.  See
+ * <design/buffer/#refill.size>. */
 
 #define BUFFER_RANK_DEFAULT (mps_rank_exact())
+#define BUFFER_REFILL_SIZE_MAX ((Size)256 * 1024)
 
 
 /* Format defaults: see <code/format.c> */
@@ -386,6 +452,15 @@
 #define MVFF_ARENA_HIGH_DEFAULT  FALSE
 #define MVFF_FIRST_FIT_DEFAULT   TRUE
 #define MVFF_SPARE_DEFAULT       0.75
+#define MVFF_THREAD_CACHES_DEFAULT ((Count)1)
+
+/* MVFF_CACHE_CLASSES is the number of exact-size free lists in each
+ * of MVFF's thread caches, and MVFF_CACHE_SIZE_MAX is the most memory
+ * each cache may hold.  See
+ * <design/poolmvff/#impl.cache>. */
+
+#define MVFF_CACHE_CLASSES       ((Count)64)
+#define MVFF_CACHE_SIZE_MAX      ((Size)65536)
 
 
 /* Pool MVT Configuration -- see <code/poolmv2.c> */
@@ -425,6 +500,113 @@
 
 #define ARENA_DEFAULT_ZONED     TRUE
 
+/* ARENA_DEFAULT_GC_THREADS is the number of threads that scan grey
+ * segments in parallel, including the thread that is doing the
+ * collection work.  See <design/trace/#parallel>. */
+
+#define ARENA_DEFAULT_GC_THREADS ((Count)1)
+
+/* ARENA_DEFAULT_BACKGROUND says whether the arena does its collection
+ * work on a background thread rather than in the mutator.  See
+ * <design/trace/#background>. */
+
+#define ARENA_DEFAULT_BACKGROUND FALSE
+
+/* ARENA_CHUNK_INDEX_SHIFT and ARENA_CHUNK_INDEX_LENGTH give the size
+ * of the address stripes and the number of entries in the arena's
+ * direct-mapped chunk index, which between them cover 16 GiB of
+ * address space before entries alias.  ARENA_CHUNK_INDEX_LENGTH must
+ * be a power of two.  The index is part of ArenaStruct and so costs
+ * ARENA_CHUNK_INDEX_LENGTH pointers per arena (8 KiB on 64-bit
+ * platforms).  See <design/arena/#chunk.index.size>. */
+
+#define ARENA_CHUNK_INDEX_SHIFT  ((Shift)24)
+#define ARENA_CHUNK_INDEX_LENGTH ((Count)1024)
+
+/* ARENA_DEFAULT_CARD_MARKING says whether the mutator's stores into
+ * segments are tracked by card tables instead of by a write barrier
+ * on the segments.  ARENA_CARD_SHIFT gives the size of a card.  Each
+ * chunk has cards for the address stripes of 1 << ARENA_CARD_STRIPE_SHIFT
+ * bytes that it overlaps, and the arena has a direct-mapped index of
+ * ARENA_CARD_STRIPE_COUNT entries from stripes to cards, which
+ * between them cover 16 GiB of address space before entries are
+ * shared.  ARENA_CARD_STRIPE_COUNT must be a power of two.  See
+ * <design/write-barrier/#card.table>. */
+
+#define ARENA_DEFAULT_CARD_MARKING FALSE
+#define ARENA_CARD_SHIFT         ((Shift)9)
+#define ARENA_CARD_STRIPE_SHIFT  ((Shift)20)
+#define ARENA_CARD_STRIPE_COUNT  ((Count)1 << 14)
+
+/* ARENA_DEFAULT_SOFT_DIRTY says whether the arena asks the operating
+ * system which pages have been written instead of using a write
+ * barrier on the segments.  See <design/write-barrier/#soft-dirty>. */
+
+#define ARENA_DEFAULT_SOFT_DIRTY FALSE
+
+/* ARENA_DEFAULT_FIX_PREFETCH says whether TraceFixArea prefetches the
+ * page table entries of references before fixing them.  It is off by
+ * default because gcbench runs no faster with it.  See
+ * <design/scan/#fix-area.prefetch>. */
+
+#define ARENA_DEFAULT_FIX_PREFETCH FALSE
+
+/* PROT_DIRTY_CACHE_PAGES is the number of pages whose soft-dirty bits
+ * an arena reads ahead at flip, so that it reads the bits for all its
+ * segments with a few large reads rather than one read per segment.
+ * Must be a multiple of MPS_WORD_WIDTH.  See
+ * <design/prot/#if.dirty.cached>. */
+
+#define PROT_DIRTY_CACHE_PAGES ((Count)4096)
+
+/* ARENA_PRESSURE_INTERVAL is the minimum time (in seconds) between
+ * readings of the memory pressure by an arena created with
+ * MPS_KEY_ARENA_PRESSURE.  The arena is under pressure from when the
+ * reading reaches 1.0 until it falls below ARENA_PRESSURE_RELIEF, so
+ * that it doesn't flap.  See <design/arena/#pressure>. */
+
+#define ARENA_PRESSURE_INTERVAL (0.5)
+#define ARENA_PRESSURE_RELIEF (0.75)
+
+/* TRACE_PARALLEL_BATCH is the number of grey segments that are handed
+ * to each collector thread in one step of a parallel trace, and so
+ * TRACE_PARALLEL_BATCH_MAX bounds the number of segments scanned in a
+ * step (and the stack used to scan them). */
+
+#define TRACE_PARALLEL_BATCH     ((Count)4)
+#define TRACE_PARALLEL_BATCH_MAX ((Count)32)
+
+/* TRACE_PARALLEL_EXPOSED is the number of segments, other than the one
+ * being fixed, that a scan on a collector thread may keep exposed
+ * until the end of its batch, such as the segments of AMC's
+ * forwarding buffers.  See <design/trace/#parallel.fix.expose>. */
+
+#define TRACE_PARALLEL_EXPOSED   ((Count)4)
+
+/* WORKERS_STRIPES is the number of stripe locks that collector
+ * threads use to serialize fixes to the same segment.  It must be a
+ * power of two.  See <design/trace/#parallel.fix>. */
+
+#define WORKERS_STRIPES ((Count)64)
+
+/* ARENA_WINDOW_LENGTH is the length (in seconds, as measured by
+ * WallClockNow) of the windows over which the arena measures the
+ * allocation rate and mutator utilization, and ARENA_WINDOW_COUNT is
+ * the number of recent windows it keeps.  PAUSE_SUB_BUCKET_SHIFT is
+ * the logarithm of the number of buckets in each power of two in the
+ * pause histograms.  See <design/arena/#pause>. */
+
+#define ARENA_WINDOW_LENGTH     0.1
+#define ARENA_WINDOW_COUNT      64
+#define PAUSE_SUB_BUCKET_SHIFT  2
+
+/* ROOT_PARALLEL_SIZE is the smallest area root (in bytes) that is
+ * handed to a collector thread at flip.  Smaller area roots are
+ * scanned on the thread doing the collection.  See
+ * <design/root/#parallel>. */
+
+#define ROOT_PARALLEL_SIZE ((Size)1 << 14)
+
 /* ARENA_MINIMUM_COLLECTABLE_SIZE is the minimum size (in bytes) of
  * collectable memory that might be considered worthwhile to run a
  * full garbage collection. */
@@ -449,6 +631,11 @@
 
 #define ARENA_MAX_COLLECT_FRACTION (0.1)
 
+/* ARENA_IDLE_NURSERY_FRACTION is how full a nursery generation must
+ * be before ArenaCollectUntil collects its chain early, in idle time. */
+
+#define ARENA_IDLE_NURSERY_FRACTION (0.5)
+
 /* ArenaDefaultZONESET is the zone set used by LocusPrefDEFAULT.
  *
  * TODO: This is left over from before branches 2014-01-29/mps-chain-zones
@@ -474,6 +661,15 @@
 
 #define VM_ARENA_SIZE_DEFAULT ((Size)1 << 28)
 
+/* VM_PRESSURE_STALL is the percentage of the last ten seconds that
+ * some task must have spent stalled waiting for memory for VMPressure
+ * to report a pressure of 1.0, and VM_PRESSURE_FRACTION is the
+ * fraction of its control group's memory limit that the process must
+ * use to do so.  See <design/vm/#if.pressure>. */
+
+#define VM_PRESSURE_STALL (10.0)
+#define VM_PRESSURE_FRACTION (0.9)
+
 
 /* Locus configuration -- see <code/locus.c> */
 
@@ -481,6 +677,15 @@
  * average computation of the mortality of a generation. */
 #define LocusMortalityALPHA (0.4)
 
+/* Adaptive generation sizing -- see <design/strategy/#policy.gen>.
+ * LocusAdaptPAUSES is the number of pause times that tracing the
+ * survivors of a generation may take.  A retune changes a capacity by
+ * at most a factor of LocusAdaptSTEP, and not at all if the change
+ * would be less than the fraction LocusAdaptHYSTERESIS. */
+#define LocusAdaptPAUSES (10.0)
+#define LocusAdaptSTEP (2.0)
+#define LocusAdaptHYSTERESIS (0.125)
+
 
 /* Stack probe configuration -- see <code/sp*.c> */
 
@@ -505,6 +710,12 @@
 #define VMJunkBYTE ((unsigned char)0xA9)
 #define VMParamSize (sizeof(Word))
 
+/* VMIX_HUGE_PAGE_SIZE is the size of the pages that Linux uses for
+ * transparent huge pages on x86-64, assumed when the kernel doesn't
+ * report it.  See <design/vm/#huge>. */
+
+#define VMIX_HUGE_PAGE_SIZE ((Size)2 * 1024 * 1024)
+
 
 /* .feature.li: Linux feature specification
  *
@@ -519,7 +730,9 @@
  * prmclii3.c  REG_EAX etc.              <ucontext.h>  _GNU_SOURCE
  * prmclii6.c  REG_RAX etc.              <ucontext.h>  _GNU_SOURCE
  * pthrdext.c  sigaction etc.            <signal.h>    _XOPEN_SOURCE
+ * protsdli.c  pread                     <unistd.h>    _XOPEN_SOURCE >= 500
  * vmix.c      MAP_ANON                  <sys/mman.h>  _GNU_SOURCE
+ * vmix.c      madvise, MADV_HUGEPAGE    <sys/mman.h>  _GNU_SOURCE
  *
  * It is not possible to localize these feature specifications around
  * the individual headers: all headers share a common set of features
@@ -617,12 +830,33 @@
 #define PTHREADEXT_SIGRESUME SIGXCPU
 #endif
 
+/* THREAD_PARK_STACK -- most stack copied when a thread parks, in bytes
+ * See <design/thread-manager/#impl.ix.park.copy>
+ */
+#define THREAD_PARK_STACK ((Size)1024)
+
 #endif
 
 
 /* Tracer Configuration -- see <code/trace.c> */
 
-#define TraceLIMIT ((size_t)1)
+/* TraceLIMIT is the number of traces that may run at once. Two
+ * allows a chain (nursery) collection to run while a collection of
+ * the world is in progress. See <design/trace/#multiple>. */
+
+#define TraceLIMIT ((size_t)2)
+
+/* TRACE_FIX_AREA_STRIDE is the number of words that TraceFixArea
+ * tests against the white zones at once.  See <code/trace.c>. */
+
+#define TRACE_FIX_AREA_STRIDE 4
+
+/* TRACE_FIX_PREFETCH_DEPTH is the number of references that
+ * TraceFixArea prefetches before it fixes them.  1 turns off the
+ * look-ahead.  See <design/scan/#fix-area.prefetch>. */
+
+#define TRACE_FIX_PREFETCH_DEPTH 8
+
 /* I count 4 function calls to scan, 10 to copy. */
 #define TraceCopyScanRATIO (1.5)
 
@@ -633,10 +867,26 @@
 
 /* Events
  *
- * EventBufferSIZE is the number of words in the global event buffer.
+ * EventBufferSIZE is the number of bytes in each event buffer.  There
+ * is a buffer for each event kind in each of EVENT_SLOT_COUNT slots,
+ * one of which is shared by threads that don't get a slot of their
+ * own.  Only the shared slot's buffers are static: the others are
+ * mapped when they are first claimed.  See <design/telemetry/#slot>.
+ *
+ * EVENT_SPARE_COUNT is the number of spare buffers that a thread can
+ * swap for a full one, so that it can hand the full one to the writer
+ * thread without waiting.  It must be at most EVENT_SLOT_COUNT times
+ * the number of event kinds.  See <design/telemetry/#slot.flush>.
+ *
+ * EventPackedSIZE is the largest number of bytes of packed events
+ * following each EventPacked event in the telemetry stream.  See
+ * <design/telemetry/#packed>.
  */
 
 #define EventBufferSIZE ((size_t)4096)
+#define EVENT_SLOT_COUNT 16
+#define EVENT_SPARE_COUNT 64
+#define EventPackedSIZE ((size_t)65536)
 #define EventStringLengthMAX ((size_t)255) /* Not including NUL */
 
 
@@ -707,6 +957,22 @@
 #define WB_DEFER_HIT   1  /* boring scans after barrier hit */
 
 
+/* Single access budget
+ *
+ * A read barrier hit on a segment may be handled by scanning only the
+ * object (or reference) that the mutator touched, and emulating the
+ * faulting instruction.  Each segment has a budget of such accesses
+ * between scans of the whole segment, which adapts to the fault rate
+ * observed on that segment.
+ *
+ * See design.mps.trace.single-access.
+ */
+
+#define SINGLE_ACCESS_BITS 8   /* bitfield width for count and budget */
+#define SINGLE_ACCESS_INIT 32  /* budget for a new segment */
+#define SINGLE_ACCESS_MAX  255 /* budget never grows beyond this */
+
+
 #endif /* config_h */
 
 
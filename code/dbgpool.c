@@ -780,6 +780,8 @@ void PoolClassMixInDebug(PoolClass klass)
   klass->init = DebugPoolInit;
   klass->alloc = DebugPoolAlloc;
   klass->free = DebugPoolFree;
+  klass->allocFast = PoolNoAllocFast;
+  klass->freeFast = PoolNoFreeFast;
 }
 
 
@@ -182,7 +182,8 @@ static void wrap(dj_t dj, mps_pool_class_t dummy, const char *name)
 
 /* Wrap a call to a dj benchmark that requires MPS setup */
 
-static void arena_wrap(dj_t dj, mps_pool_class_t pool_class, const char *name)
+static void pool_wrap(dj_t dj, mps_pool_class_t pool_class, const char *name,
+                      mps_arg_s pool_args[])
 {
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
@@ -190,12 +191,30 @@ static void arena_wrap(dj_t dj, mps_pool_class_t pool_class, const char *name)
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
     DJMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
   } MPS_ARGS_END(args);
-  DJMUST(mps_pool_create_k(&pool, arena, pool_class, mps_args_none));
+  DJMUST(mps_pool_create_k(&pool, arena, pool_class, pool_args));
   watch(dj, name);
   mps_pool_destroy(pool);
   mps_arena_destroy(arena);
 }
 
+static void arena_wrap(dj_t dj, mps_pool_class_t pool_class, const char *name)
+{
+  pool_wrap(dj, pool_class, name, mps_args_none);
+}
+
+
+/* Wrap a call to a dj benchmark on an MVFF pool with a thread cache
+   for each thread */
+
+static void mvff_thread_wrap(dj_t dj, mps_pool_class_t pool_class,
+                             const char *name)
+{
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_MVFF_THREAD_CACHES, nthreads);
+    pool_wrap(dj, pool_class, name, args);
+  } MPS_ARGS_END(args);
+}
+
 
 /* Command-line options definitions.  See getopt_long(3). */
 
@@ -232,6 +251,8 @@ static struct {
 } pools[] = {
   {"mvt",   arena_wrap, dj_reserve, mps_class_mvt},
   {"mvff",  arena_wrap, dj_reserve, mps_class_mvff},
+  {"mvffa", arena_wrap, dj_alloc,   mps_class_mvff}, /* mvff with mps_alloc */
+  {"mvfft", mvff_thread_wrap, dj_alloc, mps_class_mvff}, /* mvffa, thread caches */
   {"mv",    arena_wrap, dj_alloc,   mps_class_mv},
   {"mvb",   arena_wrap, dj_reserve, mps_class_mv}, /* mv with buffers */
   {"an",    wrap,       dj_malloc,  dummy_class},
@@ -345,16 +366,19 @@ int main(int argc, char *argv[]) {
               "  -x n, --seed=n\n"
               "    Random number seed (default from entropy).\n"
               "  -z, --arena-unzoned\n"
-              "    Disabled zoned allocation in the arena\n"
+              "    Disabled zoned allocation in the arena\n",
+              pact,
+              rinter,
+              rmax);
+      fprintf(stderr,
               "Tests:\n"
               "  mvt   pool class MVT\n"
               "  mvff  pool class MVFF\n"
+              "  mvffa pool class MVFF with mps_alloc\n"
+              "  mvfft mvffa with a thread cache per thread\n"
               "  mv    pool class MV\n"
               "  mvb   pool class MV with buffers\n"
-              "  an    malloc\n",
-              pact,
-              rinter,
-              rmax);
+              "  an    malloc\n");
       return EXIT_FAILURE;
     }
   argc -= optind;
@@ -18,6 +18,8 @@
 #include "event.h"
 #include "mpsio.h"
 #include "lock.h"
+#include "work.h"
+#include "vm.h"
 
 SRCID(event, "$Id$");
 
@@ -30,118 +32,605 @@ static Bool eventIOInited = FALSE;
 static mps_io_t eventIO;
 static Serial EventInternSerial;
 
-/* Buffers in which events are recorded, from the top down. */
-char EventBuffer[EventKindLIMIT][EventBufferSIZE];
+/* Slots holding the buffers in which events are recorded.  Slot 0 is
+   shared, and its buffers are static so that there is always somewhere
+   to record events.  See <design/telemetry/#slot>. */
+static EventSlotStruct eventSlots[EVENT_SLOT_COUNT];
+static Count eventSlotsUsed = 0;
+static char eventSharedBuffer[EventKindLIMIT * EventBufferSIZE];
+
+/* Address space for the buffers of the other slots and the output
+   buffers, mapped as they are needed.  See
+   <design/telemetry/#slot.buffer>. */
+static VMStruct eventVMStruct;
+static Bool eventVMInited = FALSE;
+static Addr eventVMNext;        /* first unmapped address */
+
+#ifdef THREAD_LOCAL
+/* The current thread's slot, or NULL if it hasn't claimed one. */
+THREAD_LOCAL EventSlot EventThreadSlot = NULL;
+#endif
 
-/* Pointers to last event logged into each buffer. */
-char *EventLast[EventKindLIMIT];
+EventControlSet EventKindControl;       /* Bit set used to control output. */
 
-/* Pointers to the last even written out of each buffer. */
-static char *EventWritten[EventKindLIMIT];
 
-EventControlSet EventKindControl;       /* Bit set used to control output. */
+/* Output buffers, merged from the slots by EventSync and written out
+   by the writer thread.  See <design/telemetry/#sync>. */
+
+#define eventOutSIZE \
+  (EVENT_SLOT_COUNT * EventKindLIMIT * EventBufferSIZE \
+   + sizeof(EventEventClockSyncStruct) + MPS_PF_ALIGN)
+
+typedef struct EventOutStruct {
+  size_t size;                  /* bytes waiting to be written */
+  char *buffer;                 /* eventOutSIZE bytes, or NULL */
+} EventOutStruct, *EventOut;
+
+static EventOutStruct eventOut[2];
+static Index eventOutNext = 0;  /* buffer for the next sync */
+static EventOut eventWriting = NULL; /* buffer given to the writer */
+static Background eventWriter = NULL; /* writer thread, if any */
 
+/* Full buffers handed to the writer thread by EventFlush, and the
+   spare buffers that replace them.  Each full buffer took a spare, so
+   there are never more than EVENT_SPARE_COUNT of them.  The lock
+   protects these and eventWriting once the writer thread exists.  See
+   <design/telemetry/#slot.flush>. */
 
-/* A single event structure output once per buffer flush. */
-static EventEventClockSyncStruct eventClockSyncStruct;
+typedef struct EventFullStruct {
+  char *buffer;                 /* EventBufferSIZE bytes */
+  char *last;                   /* most recent event */
+  char *limit;                  /* end of the events */
+} EventFullStruct, *EventFull;
 
+static Lock eventQueueLock = NULL;
+static EventFullStruct eventFull[EVENT_SPARE_COUNT];
+static Count eventFullCount = 0;
+static char *eventSpare[EVENT_SPARE_COUNT];
+static Count eventSpareCount = 0;
+static EventOutStruct eventFullOut; /* full buffers being written */
 
-/* eventClockSync -- Populate and write the clock sync event. */
+/* Packed events waiting to be written by eventWrite.  See
+   <design/telemetry/#packed>. */
+static EventPackStateStruct eventPackState;
+static Byte eventPacked[EventPackedSIZE];
 
-static Res eventClockSync(void)
+/* Pending events in one buffer of one slot, during EventSync. */
+typedef struct EventRangeStruct {
+  char *next;                   /* most recent event not yet merged */
+  char *limit;                  /* end of the pending events */
+} EventRangeStruct;
+
+static EventRangeStruct eventRanges[EVENT_SLOT_COUNT * EventKindLIMIT];
+
+
+/* eventAlloc -- map memory for event buffers
+ *
+ * The address space for all the buffers is reserved the first time
+ * any are needed, and mapped piecemeal as slots are claimed, the
+ * output buffers are first used, and the writer thread is created
+ * with its spare buffers.  Must be called with the global
+ * recursive lock held.  See <design/telemetry/#slot.buffer>.
+ */
+
+static Res eventAlloc(char **pReturn, size_t size)
 {
+  Addr base, limit;
   Res res;
-  size_t size;
 
-  size= size_tAlignUp(sizeof(eventClockSyncStruct), MPS_PF_ALIGN);
-  eventClockSyncStruct.code = EventEventClockSyncCode;
-  eventClockSyncStruct.size = (EventSize)size;
-  EVENT_CLOCK(eventClockSyncStruct.clock);
-  eventClockSyncStruct.f0 = (Word)mps_clock();
-  res = (Res)mps_io_write(eventIO, (void *)&eventClockSyncStruct, size);
+  AVER(pReturn != NULL);
+  AVER(size > 0);
+
+  if (!eventVMInited) {
+    char vmParams[VMParamSize];
+    Size pageSize = PageSize();
+    Size reserve =
+      (EVENT_SLOT_COUNT - 1)
+        * SizeAlignUp(EventKindLIMIT * EventBufferSIZE, pageSize)
+      + 3 * SizeAlignUp(eventOutSIZE, pageSize)
+      + SizeAlignUp(EVENT_SPARE_COUNT * EventBufferSIZE + LockSize(),
+                    pageSize);
+    res = VMParamFromArgs(vmParams, sizeof vmParams, argsNone);
+    if (res != ResOK)
+      return res;
+    res = VMInit(&eventVMStruct, reserve, pageSize, vmParams);
+    if (res != ResOK)
+      return res;
+    eventVMNext = VMBase(&eventVMStruct);
+    eventVMInited = TRUE;
+  }
+
+  base = eventVMNext;
+  limit = AddrAlignUp(AddrAdd(base, size), VMPageSize(&eventVMStruct));
+  AVER(limit <= VMLimit(&eventVMStruct));
+  res = VMMap(&eventVMStruct, base, limit);
   if (res != ResOK)
-    goto failWrite;
-  
-  res = ResOK;
-failWrite:
-  return res;
+    return res;
+  eventVMNext = limit;
+  *pReturn = (char *)base;
+  return ResOK;
+}
+
+
+/* eventSlotInit -- initialize an event slot with empty buffers */
+
+static void eventSlotInit(EventSlot slot, Bool shared, char *buffers)
+{
+  EventKind kind;
+
+  slot->shared = shared;
+  slot->claimed = TRUE;
+  for (kind = 0; kind < EventKindLIMIT; ++kind) {
+    AVER(slot->last[kind] == NULL);
+    AVER(slot->written[kind] == NULL);
+    slot->buffer[kind] = buffers + kind * EventBufferSIZE;
+    slot->last[kind] = slot->written[kind] =
+      slot->buffer[kind] + EventBufferSIZE;
+  }
 }
 
 
-/* EventFlush -- flush event buffer (perhaps to the event stream) */
+/* EventSlotClaim -- find a slot for the current thread
+ *
+ * Called by EVENT_SLOT the first time a thread writes an event.  The
+ * thread takes a slot released by another thread if there is one, and
+ * otherwise maps the buffers of a new slot.  If all the slots are
+ * taken, or the buffers can't be mapped, the thread uses the shared
+ * slot.
+ */
 
-void EventFlush(EventKind kind)
+EventSlot EventSlotClaim(void)
 {
+  EventSlot slot;
+
   AVER(eventInited);
-  AVER(NONNEGATIVE(kind));
-  AVER(kind < EventKindLIMIT);
 
-  AVER(EventBuffer[kind] <= EventLast[kind]);
-  AVER(EventLast[kind] <= EventWritten[kind]);
-  AVER(EventWritten[kind] <= EventBuffer[kind] + EventBufferSIZE);
+  LockClaimGlobalRecursive();
+#ifdef THREAD_LOCAL
+  {
+    Index i;
+    char *buffers;
+
+    /* Events emitted while mapping the buffers go to the shared slot. */
+    EventThreadSlot = &eventSlots[0];
+
+    slot = NULL;
+    for (i = 1; i < eventSlotsUsed; ++i)
+      if (!eventSlots[i].claimed) {
+        /* Keep any pending events: they are older than the ones the
+           thread will write, so the buffers stay in time order. */
+        slot = &eventSlots[i];
+        slot->claimed = TRUE;
+        break;
+      }
+    if (slot == NULL && eventSlotsUsed < EVENT_SLOT_COUNT
+        && eventAlloc(&buffers, EventKindLIMIT * EventBufferSIZE) == ResOK)
+    {
+      slot = &eventSlots[eventSlotsUsed];
+      eventSlotInit(slot, FALSE, buffers);
+      ++eventSlotsUsed;
+    }
+    if (slot == NULL)
+      slot = &eventSlots[0];
+    EventThreadSlot = slot;
+  }
+#else
+  slot = &eventSlots[0];
+#endif
+  LockReleaseGlobalRecursive();
+
+  return slot;
+}
 
-  /* Send all pending events to the event stream. */
-  EventSync();
 
-  /* Flush the in-memory buffer whether or not we send this buffer, so
-     that we can continue to record recent events. */
-  EventLast[kind] = EventWritten[kind] = EventBuffer[kind] + EventBufferSIZE;
+/* EventSlotRelease -- release the current thread's slot
+ *
+ * Called when a thread deregisters from an arena or a collector thread
+ * exits, so that another thread can claim its slot.  If the thread
+ * writes another event, it claims a slot again.
+ */
+
+void EventSlotRelease(void)
+{
+#ifdef THREAD_LOCAL
+  EventSlot slot = EventThreadSlot;
+
+  if (slot != NULL) {
+    LockClaimGlobalRecursive();
+    if (!slot->shared) {
+      AVER(slot->claimed);
+      slot->claimed = FALSE;
+    }
+    EventThreadSlot = NULL;
+    LockReleaseGlobalRecursive();
+  }
+#endif
 }
 
 
-/* EventSync -- synchronize the event stream with the buffers */
+/* eventClockSync -- Populate and append the clock sync event. */
 
-void EventSync(void)
+static void eventClockSync(EventOut out)
 {
-  EventKind kind;
-  Bool wrote = FALSE;
+  EventEventClockSyncStruct event;
+  size_t size;
 
-  for (kind = 0; kind < EventKindLIMIT; ++kind) {
+  size = size_tAlignUp(sizeof(event), MPS_PF_ALIGN);
+  AVER(out->buffer != NULL);
+  AVER(out->size + size <= eventOutSIZE);
+  event.code = EventEventClockSyncCode;
+  event.size = (EventSize)size;
+  EVENT_CLOCK(event.clock);
+  event.f0 = (Word)mps_clock();
+  (void)mps_lib_memcpy(out->buffer + out->size, &event, sizeof(event));
+  out->size += size;
+}
 
-    /* Is event logging enabled for this kind of event, or are or are we just
-       writing to the buffer for backtraces, cores, and other debugging? */
-    if (BS_IS_MEMBER(EventKindControl, kind)) {
-      size_t size;
-      Res res;
-      
-      AVER(EventBuffer[kind] <= EventLast[kind]);
-      AVER(EventLast[kind] <= EventWritten[kind]);
-      AVER(EventWritten[kind] <= EventBuffer[kind] + EventBufferSIZE);
-
-      size = (size_t)(EventWritten[kind] - EventLast[kind]);
-      if (size > 0) {
-
-        /* Ensure the IO stream is open.  We do this late so that no stream is
-           created if no events are enabled by telemetry control. */
-        if (!eventIOInited) {
-          res = (Res)mps_io_create(&eventIO);
-          if(res != ResOK) {
-            /* TODO: Consider taking some other action if open fails. */
-            return;
-          }
-          eventIOInited = TRUE;
-        }
 
-        /* Writing might be faster if the size is aligned to a multiple of the
-           C library or kernel's buffer size.  We could pad out the buffer with
-           a marker for this purpose. */
-      
-        res = (Res)mps_io_write(eventIO, (void *)EventLast[kind], size);
-        if (res == ResOK) {
-          /* TODO: Consider taking some other action if a write fails. */
-          EventWritten[kind] = EventLast[kind];
-          wrote = TRUE;
+/* eventMerge -- merge pending events into an output buffer
+ *
+ * Claims all the events written to the enabled buffers of the slots
+ * since the last merge, and copies them to the output buffer in
+ * order of their clocks.  Each buffer holds its events with the most
+ * recent first, so the merge repeatedly takes the most recent of the
+ * pending events and copies it to the output buffer from the top
+ * down.  Once the writer thread exists, this must be called with
+ * eventQueueLock held, so that no thread swaps a buffer that it is
+ * reading (.flush.swap).  See <design/telemetry/#sync.merge>.
+ */
+
+static void eventMerge(EventOut out)
+{
+  Count ranges = 0;
+  size_t size = 0;
+  char *top;
+  Index i;
+
+  for (i = 0; i < eventSlotsUsed; ++i) {
+    EventSlot slot = &eventSlots[i];
+    EventKind kind;
+    for (kind = 0; kind < EventKindLIMIT; ++kind) {
+      /* Is event logging enabled for this kind of event, or are or are
+         we just writing to the buffer for backtraces, cores, and other
+         debugging? */
+      if (BS_IS_MEMBER(EventKindControl, kind)) {
+        char *last = LOAD_ACQUIRE(slot->last[kind]);
+        AVER(slot->buffer[kind] <= last);
+        AVER(last <= slot->written[kind]);
+        AVER(slot->written[kind] <= slot->buffer[kind] + EventBufferSIZE);
+        if (last < slot->written[kind]) {
+          eventRanges[ranges].next = last;
+          eventRanges[ranges].limit = slot->written[kind];
+          ++ranges;
+          size += (size_t)(slot->written[kind] - last);
+          slot->written[kind] = last;
         }
       }
     }
   }
 
-  /* If we wrote out events, send an EventClockSync event and flush
-     the telemetry stream. */
-  if (wrote) {
-    (void)eventClockSync();
+  if (size == 0)
+    return;
+
+  /* Map the output buffer the first time there's something to write.
+     If it can't be mapped, the events are lost. */
+  if (out->buffer == NULL && eventAlloc(&out->buffer, eventOutSIZE) != ResOK)
+    return;
+
+  AVER(out->size + size <= eventOutSIZE);
+  top = out->buffer + out->size + size;
+  while (ranges > 0) {
+    Index newest = 0;
+    Event event;
+    for (i = 1; i < ranges; ++i)
+      if (((Event)eventRanges[i].next)->any.clock
+          > ((Event)eventRanges[newest].next)->any.clock)
+        newest = i;
+    event = (Event)eventRanges[newest].next;
+    top -= event->any.size;
+    (void)mps_lib_memcpy(top, event, event->any.size);
+    eventRanges[newest].next += event->any.size;
+    if (eventRanges[newest].next == eventRanges[newest].limit) {
+      --ranges;
+      eventRanges[newest] = eventRanges[ranges];
+    }
+  }
+  AVER(top == out->buffer + out->size);
+  out->size += size;
+}
+
+
+/* eventWritePacked -- write the packed events to the event stream
+ *
+ * The packed events follow an EventPacked event giving their length.
+ */
+
+static void eventWritePacked(size_t length)
+{
+  EventEventPackedStruct event;
+
+  AVER(length <= sizeof eventPacked);
+  if (length > 0) {
+    event.code = EventEventPackedCode;
+    event.size = (EventSize)sizeof(event);
+    EVENT_CLOCK(event.clock);
+    event.f0 = length;
+    /* TODO: Consider taking some other action if a write fails. */
+    (void)mps_io_write(eventIO, (void *)&event, sizeof(event));
+    (void)mps_io_write(eventIO, (void *)eventPacked, length);
+  }
+}
+
+
+/* eventWrite -- pack an output buffer and write it to the event stream */
+
+static void eventWrite(EventOut out)
+{
+  if (out->size > 0) {
+    char *p = out->buffer, *limit = out->buffer + out->size;
+    size_t length = 0;
+
+    EventPackStateInit(&eventPackState);
+    while (p < limit) {
+      Event event = (Event)p;
+      if (length + EventPackedSizeMAX(event->any.size)
+          > sizeof eventPacked) {
+        eventWritePacked(length);
+        length = 0;
+        EventPackStateInit(&eventPackState);
+      }
+      length += EventPack(&eventPacked[length], &eventPackState, event);
+      p += event->any.size;
+    }
+    AVER(p == limit);
+    eventWritePacked(length);
     (void)mps_io_flush(eventIO);
+    out->size = 0;
+  }
+}
+
+
+/* eventCopyFull -- copy the events of full buffers to an output buffer
+ *
+ * Each buffer holds its events with the most recent first, so they are
+ * copied from the top down, as in eventMerge, to put them in time
+ * order.
+ */
+
+static void eventCopyFull(EventOut out, EventFull full, Count count)
+{
+  Index i;
+
+  AVER(out->buffer != NULL);
+  for (i = 0; i < count; ++i) {
+    size_t size = (size_t)(full[i].limit - full[i].last);
+    char *top = out->buffer + out->size + size;
+    char *p = full[i].last;
+
+    AVER(out->size + size <= eventOutSIZE);
+    while (p < full[i].limit) {
+      Event event = (Event)p;
+      top -= event->any.size;
+      (void)mps_lib_memcpy(top, event, event->any.size);
+      p += event->any.size;
+    }
+    AVER(p == full[i].limit);
+    AVER(top == out->buffer + out->size);
+    out->size += size;
+  }
+}
+
+
+/* eventWriterStep -- write the buffers given to the writer thread
+ *
+ * Takes the full buffers queued by EventFlush, copies their events out
+ * and returns them to the spares, and writes the events.  Then writes
+ * the output buffer given to the writer by eventSync, if any.
+ */
+
+static Bool eventWriterStep(void *closure)
+{
+  EventFullStruct full[EVENT_SPARE_COUNT];
+  Count count;
+  EventOut out;
+  Index i;
+
+  UNUSED(closure);
+
+  LockClaim(eventQueueLock);
+  count = eventFullCount;
+  for (i = 0; i < count; ++i)
+    full[i] = eventFull[i];
+  eventFullCount = 0;
+  out = eventWriting;
+  eventWriting = NULL;
+  LockRelease(eventQueueLock);
+
+  if (count > 0) {
+    eventCopyFull(&eventFullOut, full, count);
+    LockClaim(eventQueueLock);
+    for (i = 0; i < count; ++i) {
+      AVER(eventSpareCount < EVENT_SPARE_COUNT);
+      eventSpare[eventSpareCount] = full[i].buffer;
+      ++eventSpareCount;
+    }
+    LockRelease(eventQueueLock);
+    eventClockSync(&eventFullOut);
+    eventWrite(&eventFullOut);
+  }
+
+  if (out != NULL)
+    eventWrite(out);
+  return FALSE;
+}
+
+
+/* eventWriterCreate -- create the writer thread and its spare buffers
+ *
+ * Must be called with the global recursive lock held.  If it fails,
+ * there is no writer thread, and the thread that syncs writes the
+ * events itself.
+ */
+
+static void eventWriterCreate(void)
+{
+  Background writer = NULL; /* suppress "may be used uninitialized" */
+  char *p;
+  Index i;
+
+  AVER(eventWriter == NULL);
+  if (eventAlloc(&eventFullOut.buffer, eventOutSIZE) != ResOK)
+    return;
+  eventFullOut.size = 0;
+  if (eventAlloc(&p, EVENT_SPARE_COUNT * EventBufferSIZE + LockSize())
+      != ResOK)
+    return;
+  for (i = 0; i < EVENT_SPARE_COUNT; ++i)
+    eventSpare[i] = p + i * EventBufferSIZE;
+  eventSpareCount = EVENT_SPARE_COUNT;
+  eventQueueLock = (Lock)(void *)(p + EVENT_SPARE_COUNT * EventBufferSIZE);
+  LockInit(eventQueueLock);
+
+  if (BackgroundCreateStatic(&writer, eventWriterStep, NULL) != ResOK)
+    return;
+  /* EventFlush reads eventWriter without the global lock. */
+  STORE_RELEASE(eventWriter, writer);
+}
+
+
+/* eventSync -- merge pending events and send them to the event stream
+ *
+ * If there is a writer thread, the merged events are handed to it,
+ * and if wait is TRUE this waits until they have been written.
+ */
+
+static void eventSync(Bool wait)
+{
+  EventOut out;
+
+  LockClaimGlobalRecursive();
+  AVER(eventInited);
+
+  out = &eventOut[eventOutNext];
+  AVER(out->size == 0);
+  if (eventQueueLock != NULL)
+    LockClaim(eventQueueLock);
+  eventMerge(out);
+  if (eventQueueLock != NULL)
+    LockRelease(eventQueueLock);
+
+  if (out->size > 0) {
+    /* Ensure the IO stream is open.  We do this late so that no stream is
+       created if no events are enabled by telemetry control. */
+    if (!eventIOInited) {
+      Res res = (Res)mps_io_create(&eventIO);
+      if (res != ResOK) {
+        /* TODO: Consider taking some other action if open fails. */
+        out->size = 0;
+        goto done;
+      }
+      eventIOInited = TRUE;
+      eventWriterCreate();
+    }
+
+    /* Send an EventClockSync event after the events. */
+    eventClockSync(out);
+
+    if (eventWriter != NULL) {
+      /* Wait for the writer to finish with the other buffer. */
+      BackgroundSync(eventWriter);
+      LockClaim(eventQueueLock);
+      AVER(eventWriting == NULL);
+      eventWriting = out;
+      LockRelease(eventQueueLock);
+      eventOutNext = 1 - eventOutNext;
+      BackgroundWake(eventWriter);
+    } else {
+      eventWrite(out);
+    }
   }
+
+  if (wait && eventWriter != NULL)
+    BackgroundSync(eventWriter);
+
+done:
+  LockReleaseGlobalRecursive();
+}
+
+
+/* EventFlush -- flush event buffer (perhaps to the event stream)
+ *
+ * Called by EVENT_BEGIN when the buffer for kind in slot is full.
+ *
+ * .flush.swap: Once there is a writer thread, the full buffer is
+ * swapped for a spare and queued for the writer, under eventQueueLock
+ * only, so that the thread neither merges the other buffers nor waits
+ * for the writer.  If there are no spares left, because the writer
+ * has fallen behind, the buffer's events are lost.  See
+ * <design/telemetry/#slot.flush>.
+ */
+
+void EventFlush(EventSlot slot, EventKind kind)
+{
+  Background writer;
+
+  AVER(eventInited);
+  AVER(slot != NULL);
+  AVER(NONNEGATIVE(kind));
+  AVER(kind < EventKindLIMIT);
+
+  writer = LOAD_ACQUIRE(eventWriter);
+  if (writer != NULL) {
+    Bool queued = FALSE;
+    LockClaim(eventQueueLock);
+    AVER(slot->buffer[kind] <= slot->last[kind]);
+    AVER(slot->last[kind] <= slot->written[kind]);
+    AVER(slot->written[kind] <= slot->buffer[kind] + EventBufferSIZE);
+    if (BS_IS_MEMBER(EventKindControl, kind)
+        && slot->last[kind] < slot->written[kind]
+        && eventSpareCount > 0)
+    {
+      EventFull full = &eventFull[eventFullCount];
+      AVER(eventFullCount < EVENT_SPARE_COUNT);
+      full->buffer = slot->buffer[kind];
+      full->last = slot->last[kind];
+      full->limit = slot->written[kind];
+      ++eventFullCount;
+      --eventSpareCount;
+      slot->buffer[kind] = eventSpare[eventSpareCount];
+      queued = TRUE;
+    }
+    slot->last[kind] = slot->written[kind] =
+      slot->buffer[kind] + EventBufferSIZE;
+    LockRelease(eventQueueLock);
+    if (queued)
+      BackgroundWake(writer);
+    return;
+  }
+
+  LockClaimGlobalRecursive();
+
+  AVER(slot->buffer[kind] <= slot->last[kind]);
+  AVER(slot->last[kind] <= slot->written[kind]);
+  AVER(slot->written[kind] <= slot->buffer[kind] + EventBufferSIZE);
+
+  /* Send all pending events to the event stream. */
+  eventSync(FALSE);
+
+  /* Flush the in-memory buffer whether or not we send this buffer, so
+     that we can continue to record recent events. */
+  slot->last[kind] = slot->written[kind] =
+    slot->buffer[kind] + EventBufferSIZE;
+
+  LockReleaseGlobalRecursive();
+}
+
+
+/* EventSync -- synchronize the event stream with the buffers */
+
+void EventSync(void)
+{
+  eventSync(TRUE);
 }
 
 
@@ -178,6 +667,7 @@ void EventInit(void)
 
 #define EVENT_PARAM_CHECK(name, index, sort, ident) \
   AVER(index == Event##name##Param##ident); \
+  AVER(index < EventParamMAX); \
   AVER(sizeof(EventF##sort) >= 0); /* check existence of type */ \
   EVENT_PARAM_CHECK_##sort(name, index, ident)
 
@@ -203,12 +693,9 @@ void EventInit(void)
   if (!eventInited) { /* See .trans.log */
     LockClaimGlobalRecursive();
     if (!eventInited) {
-      EventKind kind;
-      for (kind = 0; kind < EventKindLIMIT; ++kind) {
-        AVER(EventLast[kind] == NULL);
-        AVER(EventWritten[kind] == NULL);
-        EventLast[kind] = EventWritten[kind] = EventBuffer[kind] + EventBufferSIZE;
-      }
+      AVER(eventSlotsUsed == 0);
+      eventSlotInit(&eventSlots[0], TRUE, eventSharedBuffer);
+      eventSlotsUsed = 1;
       eventInited = TRUE;
       EventKindControl = (Word)mps_lib_telemetry_control();
       EventInternSerial = (Serial)1; /* 0 is reserved */
@@ -278,8 +765,10 @@ EventStringId EventInternGenString(size_t len, const char *label)
 
   AVER(label != NULL);
 
+  LockClaimGlobalRecursive();
   id = EventInternSerial;
   ++EventInternSerial;
+  LockReleaseGlobalRecursive();
 
   EVENT2S(Intern, id, len, label);
 
@@ -411,6 +900,7 @@ Res EventWrite(Event event, mps_lib_FILE *stream)
 void EventDump(mps_lib_FILE *stream)
 {
   Event event;
+  Index i;
   EventKind kind;
 
   AVER(stream != NULL);
@@ -422,14 +912,17 @@ void EventDump(mps_lib_FILE *stream)
     return;
   }
 
-  for (kind = 0; kind < EventKindLIMIT; ++kind) {
-    for (event = (Event)EventLast[kind];
-         (char *)event < EventBuffer[kind] + EventBufferSIZE;
-         event = (Event)((char *)event + event->any.size)) {
-      /* Try to keep going even if there's an error, because this is used as a
-         backtrace and we'll take what we can get. */
-      (void)EventWrite(event, stream);
-      (void)WriteF(stream, 0, "\n", NULL);
+  for (i = 0; i < eventSlotsUsed; ++i) {
+    EventSlot slot = &eventSlots[i];
+    for (kind = 0; kind < EventKindLIMIT; ++kind) {
+      for (event = (Event)slot->last[kind];
+           (char *)event < slot->buffer[kind] + EventBufferSIZE;
+           event = (Event)((char *)event + event->any.size)) {
+        /* Try to keep going even if there's an error, because this is
+           used as a backtrace and we'll take what we can get. */
+        (void)EventWrite(event, stream);
+        (void)WriteF(stream, 0, "\n", NULL);
+      }
     }
   }
 }
@@ -444,6 +937,12 @@ void EventSync(void)
 }
 
 
+void EventSlotRelease(void)
+{
+  NOOP;
+}
+
+
 void EventInit(void)
 {
   NOOP;
@@ -518,6 +1017,451 @@ extern void EventDump(mps_lib_FILE *stream)
 #endif /* EVENT */
 
 
+/* Packed events
+ *
+ * These are outside the EVENT conditional so that the event tools
+ * can decode packed events whatever variety of the MPS they are linked
+ * with.  See <design/telemetry/#packed>.
+ *
+ * Numbers are packed seven bits to a byte, least significant first,
+ * with the top bit set on every byte but the last.  EventClock is at
+ * least as wide as Word, so it holds all packed numbers.
+ */
+
+#define eventPackMORE ((Byte)0x80)  /* another byte follows */
+#define eventPackBITS 7             /* bits of number in each byte */
+
+#define eventPackAddrIndex(addr) \
+  (((addr) >> 3) & (EVENT_PACK_ADDR_COUNT - 1))
+
+
+/* EventPackStateInit -- start a stream of packed events */
+
+void EventPackStateInit(EventPackState state)
+{
+  AVER(state != NULL);
+  (void)mps_lib_memset(state, 0, sizeof *state);
+}
+
+
+/* eventPackNumber -- pack an unsigned number */
+
+static Byte *eventPackNumber(Byte *p, EventClock n)
+{
+  while (n >= eventPackMORE) {
+    *p++ = (Byte)((n & (eventPackMORE - 1)) | eventPackMORE);
+    n >>= eventPackBITS;
+  }
+  *p++ = (Byte)n;
+  return p;
+}
+
+
+/* eventPackFlagged -- pack a flag and an unsigned number
+ *
+ * The flag is the bottom bit of the first byte, which leaves room for
+ * one bit fewer of the number in that byte.
+ */
+
+static Byte *eventPackFlagged(Byte *p, Bool flag, EventClock n)
+{
+  Byte b = (Byte)(((n & ((eventPackMORE - 1) >> 1)) << 1) | (flag ? 1 : 0));
+  n >>= eventPackBITS - 1;
+  if (n == 0) {
+    *p++ = b;
+    return p;
+  }
+  *p++ = (Byte)(b | eventPackMORE);
+  return eventPackNumber(p, n);
+}
+
+
+/* eventZigzag -- encode the difference between two words
+ *
+ * The sign goes in the bottom bit, so that small differences either
+ * way pack into few bytes.
+ */
+
+static EventClock eventZigzag(Word w, Word prev)
+{
+  Word delta = w - prev;
+  if (delta >> (MPS_WORD_WIDTH - 1) != 0)
+    return (EventClock)(~delta << 1) | 1;
+  else
+    return (EventClock)(delta << 1);
+}
+
+
+/* eventPackWord -- pack a word relative to the previous value */
+
+static Byte *eventPackWord(Byte *p, Word w, Word prev)
+{
+  return eventPackNumber(p, eventZigzag(w, prev));
+}
+
+
+/* eventPackAddr -- pack an address
+ *
+ * An address that was recently packed is packed as its index in the
+ * table of recent addresses.  Otherwise it is packed relative to the
+ * previous value, and goes in the table.
+ */
+
+static Byte *eventPackAddr(Byte *p, EventPackState state, Word w, Word prev)
+{
+  Index i = eventPackAddrIndex(w);
+  if (state->addr[i] == w)
+    return eventPackFlagged(p, TRUE, i);
+  state->addr[i] = w;
+  return eventPackFlagged(p, FALSE, eventZigzag(w, prev));
+}
+
+
+/* eventPackString -- pack a string as its length and its characters */
+
+static Byte *eventPackString(Byte *p, const char *s)
+{
+  size_t len = StringLength(s);
+  AVER(len <= EventStringLengthMAX);
+  p = eventPackNumber(p, len);
+  (void)mps_lib_memcpy(p, s, len);
+  return p + len;
+}
+
+
+/* EventPack -- pack an event
+ *
+ * Writes at most EventPackedSizeMAX(event->any.size) bytes to buffer,
+ * and returns the number written.
+ */
+
+size_t EventPack(Byte *buffer, EventPackState state, Event event)
+{
+  Byte *p = buffer;
+  EventCode code;
+  EventClock delta;
+  Bool backwards;
+
+  AVER(buffer != NULL);
+  AVER(state != NULL);
+  AVER(event != NULL);
+  code = event->any.code;
+  AVER(code <= EventCodeMAX);
+
+  /* The clock is usually no earlier than the clock of the previous
+     event, and the code is usually the one that followed the previous
+     code last time.  If so, only the flag and the clock difference are
+     packed.  If not, the flag is set, and the code and the direction
+     of the difference follow. */
+  backwards = event->any.clock < state->clock;
+  if (backwards)
+    delta = state->clock - event->any.clock;
+  else
+    delta = event->any.clock - state->clock;
+  state->clock = event->any.clock;
+  if (!backwards && code == state->next[state->code]) {
+    p = eventPackFlagged(p, FALSE, delta);
+  } else {
+    p = eventPackFlagged(p, TRUE, delta);
+    p = eventPackNumber(p, ((EventClock)code << 1) | (backwards ? 1 : 0));
+    state->next[state->code] = code;
+  }
+  state->code = code;
+
+  /* An event with more than one parameter starts with a mask of the
+     fields that differ from the previous event of the same type, and
+     only those are packed.  Doubles and strings are always packed. */
+
+#define EVENT_PACK_CHANGED_P(name, index) \
+  ((Word)event->name.f##index != field[index])
+#define EVENT_PACK_CHANGED_A EVENT_PACK_CHANGED_P
+#define EVENT_PACK_CHANGED_W EVENT_PACK_CHANGED_P
+#define EVENT_PACK_CHANGED_U EVENT_PACK_CHANGED_P
+#define EVENT_PACK_CHANGED_B EVENT_PACK_CHANGED_P
+#define EVENT_PACK_CHANGED_D(name, index) TRUE
+#define EVENT_PACK_CHANGED_S(name, index) TRUE
+
+#define EVENT_PACK_MASK(name, index, sort, ident) \
+  ++params; \
+  if (EVENT_PACK_CHANGED_##sort(name, index)) \
+    mask |= (Word)1 << index;
+
+#define EVENT_PACK_PARAM_P(name, index) \
+  p = eventPackAddr(p, state, (Word)event->name.f##index, field[index]); \
+  field[index] = (Word)event->name.f##index;
+#define EVENT_PACK_PARAM_A EVENT_PACK_PARAM_P
+#define EVENT_PACK_PARAM_W(name, index) \
+  p = eventPackWord(p, event->name.f##index, field[index]); \
+  field[index] = event->name.f##index;
+#define EVENT_PACK_PARAM_U(name, index) \
+  p = eventPackNumber(p, event->name.f##index); \
+  field[index] = event->name.f##index;
+#define EVENT_PACK_PARAM_B EVENT_PACK_PARAM_U
+#define EVENT_PACK_PARAM_D(name, index) \
+  (void)mps_lib_memcpy(p, &event->name.f##index, sizeof(EventFD)); \
+  p += sizeof(EventFD);
+#define EVENT_PACK_PARAM_S(name, index) \
+  p = eventPackString(p, event->name.f##index);
+
+#define EVENT_PACK_PARAM(name, index, sort, ident) \
+  if ((mask & ((Word)1 << index)) != 0) { \
+    EVENT_PACK_PARAM_##sort(name, index) \
+  }
+
+#define EVENT_PACK(X, name, _code, always, kind) \
+  case _code: { \
+    Word *field = state->field[_code]; \
+    Word mask = 0; \
+    Count params = 0; \
+    UNUSED(field); \
+    EVENT_##name##_PARAMS(EVENT_PACK_MASK, name) \
+    if (params > 1) \
+      p = eventPackNumber(p, mask); \
+    else \
+      mask = ~(Word)0; \
+    EVENT_##name##_PARAMS(EVENT_PACK_PARAM, name) \
+    break; \
+  }
+
+  switch (code) {
+    EVENT_LIST(EVENT_PACK, X)
+  default:
+    NOTREACHED;
+    break;
+  }
+
+  AVER((size_t)(p - buffer) <= EventPackedSizeMAX(event->any.size));
+  return (size_t)(p - buffer);
+}
+
+
+/* eventUnpackNumber -- unpack an unsigned number
+ *
+ * Returns NULL if the number is too long or runs past limit.
+ */
+
+static const Byte *eventUnpackNumber(EventClock *nReturn, const Byte *p,
+                                     const Byte *limit)
+{
+  EventClock n = 0;
+  unsigned shift = 0;
+  Byte b;
+
+  do {
+    if (p >= limit || shift >= sizeof n * CHAR_BIT)
+      return NULL;
+    b = *p++;
+    n |= (EventClock)(b & (eventPackMORE - 1)) << shift;
+    shift += eventPackBITS;
+  } while ((b & eventPackMORE) != 0);
+  *nReturn = n;
+  return p;
+}
+
+
+/* eventUnpackFlagged -- unpack a flag and an unsigned number */
+
+static const Byte *eventUnpackFlagged(Bool *flagReturn, EventClock *nReturn,
+                                      const Byte *p, const Byte *limit)
+{
+  EventClock n = 0;
+  Byte b;
+
+  if (p >= limit)
+    return NULL;
+  b = *p++;
+  if ((b & eventPackMORE) != 0) {
+    p = eventUnpackNumber(&n, p, limit);
+    if (p == NULL)
+      return NULL;
+  }
+  *flagReturn = (b & 1) != 0;
+  *nReturn = (n << (eventPackBITS - 1)) | ((b & (eventPackMORE - 1)) >> 1);
+  return p;
+}
+
+
+/* eventUnzigzag -- decode the difference from the previous word */
+
+static Word eventUnzigzag(EventClock z, Word prev)
+{
+  if ((z & 1) != 0)
+    return prev + ~(Word)(z >> 1);
+  else
+    return prev + (Word)(z >> 1);
+}
+
+
+/* eventUnpackWord -- unpack a word relative to the previous value */
+
+static const Byte *eventUnpackWord(Word *wIO, const Byte *p,
+                                   const Byte *limit)
+{
+  EventClock z;
+  p = eventUnpackNumber(&z, p, limit);
+  if (p != NULL)
+    *wIO = eventUnzigzag(z, *wIO);
+  return p;
+}
+
+
+/* eventUnpackAddr -- unpack an address */
+
+static const Byte *eventUnpackAddr(Word *wIO, EventPackState state,
+                                   const Byte *p, const Byte *limit)
+{
+  Bool recent;
+  EventClock n;
+
+  p = eventUnpackFlagged(&recent, &n, p, limit);
+  if (p == NULL)
+    return NULL;
+  if (recent) {
+    if (n >= EVENT_PACK_ADDR_COUNT)
+      return NULL;
+    *wIO = state->addr[n];
+  } else {
+    *wIO = eventUnzigzag(n, *wIO);
+    state->addr[eventPackAddrIndex(*wIO)] = *wIO;
+  }
+  return p;
+}
+
+
+/* eventUnpackString -- unpack a string, returning its length */
+
+static const Byte *eventUnpackString(char *s, size_t *lenReturn,
+                                     const Byte *p, const Byte *limit)
+{
+  EventClock len;
+  p = eventUnpackNumber(&len, p, limit);
+  if (p == NULL || len > EventStringLengthMAX
+      || len > (EventClock)(limit - p))
+    return NULL;
+  (void)mps_lib_memcpy(s, p, (size_t)len);
+  s[(size_t)len] = '\0';
+  *lenReturn = (size_t)len;
+  return p + len;
+}
+
+
+/* EventUnpack -- unpack an event
+ *
+ * Unpacks the event at the start of the length bytes at buffer, and
+ * sets *lengthReturn to the number of bytes it took.  Returns ResFAIL
+ * if the bytes are not a whole packed event of a known type.
+ */
+
+Res EventUnpack(Event event, size_t *lengthReturn, EventPackState state,
+                const Byte *buffer, size_t length)
+{
+  const Byte *p = buffer, *limit = buffer + length;
+  EventClock delta, code;
+  Bool packedCode;
+  size_t size = 0;
+
+  AVER(event != NULL);
+  AVER(lengthReturn != NULL);
+  AVER(state != NULL);
+  AVER(buffer != NULL);
+
+  p = eventUnpackFlagged(&packedCode, &delta, p, limit);
+  if (p == NULL)
+    return ResFAIL;
+  if (packedCode) {
+    p = eventUnpackNumber(&code, p, limit);
+    if (p == NULL || (code >> 1) > EventCodeMAX)
+      return ResFAIL;
+    if ((code & 1) != 0)
+      state->clock -= delta;
+    else
+      state->clock += delta;
+    code >>= 1;
+    state->next[state->code] = (EventCode)code;
+  } else {
+    state->clock += delta;
+    code = state->next[state->code];
+  }
+  state->code = (EventCode)code;
+  event->any.code = (EventCode)code;
+  event->any.clock = state->clock;
+
+#define EVENT_UNPACK_COUNT(name, index, sort, ident) \
+  ++params;
+
+#define EVENT_UNPACK_PARAM_P(name, index) \
+  p = eventUnpackAddr(&field[index], state, p, limit);
+#define EVENT_UNPACK_PARAM_A EVENT_UNPACK_PARAM_P
+#define EVENT_UNPACK_PARAM_W(name, index) \
+  p = eventUnpackWord(&field[index], p, limit);
+#define EVENT_UNPACK_PARAM_U(name, index) \
+  { \
+    EventClock n = 0; \
+    p = eventUnpackNumber(&n, p, limit); \
+    field[index] = (Word)n; \
+  }
+#define EVENT_UNPACK_PARAM_B EVENT_UNPACK_PARAM_U
+#define EVENT_UNPACK_PARAM_D(name, index) \
+  if ((size_t)(limit - p) < sizeof(EventFD)) \
+    return ResFAIL; \
+  (void)mps_lib_memcpy(&event->name.f##index, p, sizeof(EventFD)); \
+  p += sizeof(EventFD);
+#define EVENT_UNPACK_PARAM_S(name, index) \
+  { \
+    size_t len = 0; \
+    p = eventUnpackString(event->name.f##index, &len, p, limit); \
+    size = offsetof(Event##name##Struct, f##index) + len + sizeof('\0'); \
+  }
+
+#define EVENT_UNPACK_FIELD_P(name, index) \
+  event->name.f##index = (EventFP)field[index];
+#define EVENT_UNPACK_FIELD_A(name, index) \
+  event->name.f##index = (EventFA)field[index];
+#define EVENT_UNPACK_FIELD_W(name, index) \
+  event->name.f##index = field[index];
+#define EVENT_UNPACK_FIELD_U(name, index) \
+  event->name.f##index = (EventFU)field[index];
+#define EVENT_UNPACK_FIELD_B(name, index) \
+  event->name.f##index = (EventFB)field[index];
+#define EVENT_UNPACK_FIELD_D(name, index) NOOP;
+#define EVENT_UNPACK_FIELD_S(name, index) NOOP;
+
+#define EVENT_UNPACK_PARAM(name, index, sort, ident) \
+  if (p != NULL && (mask & ((EventClock)1 << index)) != 0) { \
+    EVENT_UNPACK_PARAM_##sort(name, index) \
+  } \
+  EVENT_UNPACK_FIELD_##sort(name, index)
+
+#define EVENT_UNPACK(X, name, _code, always, kind) \
+  case _code: { \
+    Word *field = state->field[_code]; \
+    EventClock mask = 0; \
+    Count params = 0; \
+    UNUSED(field); \
+    EVENT_##name##_PARAMS(EVENT_UNPACK_COUNT, name) \
+    if (params > 1) \
+      p = eventUnpackNumber(&mask, p, limit); \
+    else \
+      mask = ~(EventClock)0; \
+    size = sizeof(Event##name##Struct); \
+    EVENT_##name##_PARAMS(EVENT_UNPACK_PARAM, name) \
+    break; \
+  }
+
+  switch (event->any.code) {
+    EVENT_LIST(EVENT_UNPACK, X)
+  default:
+    return ResFAIL; /* unknown event code */
+  }
+
+  if (p == NULL)
+    return ResFAIL;
+  event->any.size = (EventSize)size_tAlignUp(size, MPS_PF_ALIGN);
+  *lengthReturn = (size_t)(p - buffer);
+  return ResOK;
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
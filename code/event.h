@@ -24,6 +24,22 @@
 typedef Word EventStringId;
 typedef Word EventControlSet;
 
+
+/* EventSlotStruct -- event buffers for a thread
+ *
+ * Each thread writes events into the buffers of its own slot, so that
+ * it needs no lock.  See <design/telemetry/#slot>.
+ */
+
+typedef struct EventSlotStruct {
+  Bool shared;                  /* slot is shared by several threads */
+  Bool claimed;                 /* slot belongs to a thread */
+  char *last[EventKindLIMIT];   /* last event logged in each buffer */
+  char *written[EventKindLIMIT]; /* last event written out of each buffer */
+  char *buffer[EventKindLIMIT]; /* <design/telemetry/#slot.buffer> */
+} EventSlotStruct, *EventSlot;
+
+
 extern void EventSync(void);
 extern void EventInit(void);
 extern void EventFinish(void);
@@ -32,7 +48,9 @@ extern EventControlSet EventControl(EventControlSet resetMask,
 extern EventStringId EventInternString(const char *label);
 extern EventStringId EventInternGenString(size_t, const char *label);
 extern void EventLabelAddr(Addr addr, Word id);
-extern void EventFlush(EventKind kind);
+extern void EventFlush(EventSlot slot, EventKind kind);
+extern EventSlot EventSlotClaim(void);
+extern void EventSlotRelease(void);
 extern Res EventDescribe(Event event, mps_lib_FILE *stream, Count depth);
 extern Res EventWrite(Event event, mps_lib_FILE *stream);
 extern void EventDump(mps_lib_FILE *stream);
@@ -42,31 +60,54 @@ extern void EventDump(mps_lib_FILE *stream);
 
 /* Event writing support */
 
-extern char EventBuffer[EventKindLIMIT][EventBufferSIZE];
-extern char *EventLast[EventKindLIMIT];
 extern Word EventKindControl;
 
 
+/* EVENT_SLOT -- the current thread's event slot */
+
+#ifdef THREAD_LOCAL
+extern THREAD_LOCAL EventSlot EventThreadSlot;
+#define EVENT_SLOT() \
+  (EventThreadSlot != NULL ? EventThreadSlot : EventSlotClaim())
+#else
+#define EVENT_SLOT() EventSlotClaim()
+#endif
+
+
+/* EventKindIsEnabled -- is this kind of event being output? */
+
+#define EventKindIsEnabled(kind) BS_IS_MEMBER(EventKindControl, kind)
+
+
 /* Events are written into the buffer from the top down, so that a backtrace
-   can find them all starting at EventLast. */
+   can find them all starting at the slot's last pointer. */
+
+/* The event is published with a release store, so that EventSync
+   can copy it out while the thread goes on writing.  Only a shared
+   slot needs the lock.  See <design/telemetry/#slot.publish>. */
 
 #define EVENT_BEGIN(name, structSize) \
   BEGIN \
     if(EVENT_ALL || Event##name##Always) { /* see config.h */ \
       Event##name##Struct *_event; \
       size_t _size = size_tAlignUp(structSize, MPS_PF_ALIGN); \
-      if (_size > (size_t)(EventLast[Event##name##Kind] \
-                           - EventBuffer[Event##name##Kind])) \
-        EventFlush(Event##name##Kind); \
-      AVER(_size <= (size_t)(EventLast[Event##name##Kind] \
-                             - EventBuffer[Event##name##Kind])); \
-      _event = (void *)(EventLast[Event##name##Kind] - _size); \
+      EventSlot _slot = EVENT_SLOT(); \
+      if (_slot->shared) \
+        LockClaimGlobalRecursive(); \
+      if (_size > (size_t)(_slot->last[Event##name##Kind] \
+                           - _slot->buffer[Event##name##Kind])) \
+        EventFlush(_slot, Event##name##Kind); \
+      AVER(_size <= (size_t)(_slot->last[Event##name##Kind] \
+                             - _slot->buffer[Event##name##Kind])); \
+      _event = (void *)(_slot->last[Event##name##Kind] - _size); \
       _event->code = Event##name##Code; \
       _event->size = (EventSize)_size; \
       EVENT_CLOCK(_event->clock);
 
 #define EVENT_END(name, size) \
-      EventLast[Event##name##Kind] -= _size; \
+      STORE_RELEASE(_slot->last[Event##name##Kind], (char *)_event); \
+      if (_slot->shared) \
+        LockReleaseGlobalRecursive(); \
     } \
   END
 
@@ -123,6 +164,8 @@ extern Word EventKindControl;
 #else /* EVENT not */
 
 
+#define EventKindIsEnabled(kind) ((void)(kind), FALSE)
+
 #define EVENT0(name) NOOP
 /* The following lines were generated with
    python -c 'for i in range(1,22): print "#define EVENT%d(name, %s) BEGIN %s END" % (i, ", ".join(["p%d" % j for j in range(0, i)]), " ".join(["UNUSED(p%d);" % j for j in range(0, i)]))'
@@ -30,6 +30,17 @@
  * variable used to specify the telemetry file to the MPS library).
  * If the environment variable does not exist, the default filename of
  * "mpsio.log" is used.
+ *
+ * With the -F option, eventcnv follows the telemetry stream as the MPS
+ * writes it: at the end of the file (or when the writer closes a named
+ * pipe) it waits for more events instead of stopping.
+ *
+ * With the -s option, eventcnv prints a summary line every so many
+ * seconds of the program's time instead of printing each event.  See
+ * "Summarizing the telemetry stream" in the reference manual.
+ *
+ * eventcnv reads one event at a time, so it needs no more memory for
+ * large logs than for small ones.
  * 
  * $Id$
  */
@@ -46,11 +57,23 @@
 #include <string.h> /* for strcmp */
 #include "mpstd.h"
 
+#if defined(MPS_OS_W3)
+#include "mpswin.h" /* for Sleep */
+#else
+#include <unistd.h> /* for sleep */
+#endif
+
 #define DEFAULT_TELEMETRY_FILENAME "mpsio.log"
 #define TELEMETRY_FILENAME_ENVAR   "MPS_TELEMETRY_FILENAME"
 
+#define FOLLOW_WAIT_SECONDS 1   /* wait for more events when following */
+#define SUMMARY_GEN_MAX     64  /* generations in each summary */
+#define SUMMARY_PENDING_MAX 64  /* pauses waiting for their end event */
+
 static EventClock eventTime; /* current event time */
 static const char *prog; /* program name */
+static Bool follow = FALSE; /* wait for more events at end of file? */
+static double summaryInterval = 0.0; /* seconds between summaries, or 0 */
 
 /* Errors and Warnings */
 
@@ -97,7 +120,7 @@ static void everror(const char *format, ...)
 
 static void usage(void)
 {
-  (void)fprintf(stderr, "Usage: %s [-f logfile] [-h]\n"
+  (void)fprintf(stderr, "Usage: %s [-f logfile] [-F] [-s seconds] [-h]\n"
                 "See \"Telemetry\" in the reference manual for instructions.\n",
                 prog);
 }
@@ -134,6 +157,20 @@ static char *parseArgs(int argc, char *argv[])
         else
           name = argv[i];
         break;
+      case 'F': /* follow */
+        follow = TRUE;
+        break;
+      case 's': /* summary interval */
+        ++ i;
+        if (i == argc)
+          usageError();
+        else {
+          char *end;
+          summaryInterval = strtod(argv[i], &end);
+          if (*end != '\0' || summaryInterval <= 0.0)
+            usageError();
+        }
+        break;
       case '?': case 'h': /* help */
         usage();
         exit(EXIT_SUCCESS);
@@ -180,24 +217,62 @@ static void printParamS(const char *str)
 }
 
 
-/* EventRead -- read one event from the file */
+/* followWait -- wait for the MPS to write more events */
 
-static Res eventRead(Bool *eofOut, EventUnion *event, FILE *stream)
+static void followWait(void)
 {
-  size_t n;
-  size_t rest;
+  (void)fflush(stdout);
+#if defined(MPS_OS_W3)
+  Sleep(FOLLOW_WAIT_SECONDS * 1000);
+#else
+  (void)sleep(FOLLOW_WAIT_SECONDS);
+#endif
+}
 
-  /* Read the prefix common to all event structures, in order to decode the
-     event size. */
-  n = fread(&event->any, sizeof(event->any), 1, stream);
-  if (n < 1) {
-    if (feof(stream)) {
+
+/* readBytes -- read size bytes from the file
+ *
+ * Sets *eofOut if the file ended before all the bytes were read.
+ * When following, waits for the rest of the bytes instead, since the
+ * MPS may not have written all of the event yet.
+ */
+
+static Res readBytes(Bool *eofOut, void *p, size_t size, FILE *stream)
+{
+  size_t done = 0;
+
+  for (;;) {
+    done += fread((char *)p + done, 1, size - done, stream);
+    if (done == size)
+      break;
+    if (ferror(stream))
+      return ResIO;
+    if (!follow) {
       *eofOut = TRUE;
-      return ResOK;
+      return done == 0 ? ResOK : ResFAIL;
     }
-    return ResIO;
+    clearerr(stream);
+    followWait();
   }
 
+  *eofOut = FALSE;
+  return ResOK;
+}
+
+
+/* eventReadRaw -- read one unpacked event from the file */
+
+static Res eventReadRaw(Bool *eofOut, EventUnion *event, FILE *stream)
+{
+  size_t rest;
+  Res res;
+
+  /* Read the prefix common to all event structures, in order to decode the
+     event size. */
+  res = readBytes(eofOut, &event->any, sizeof(event->any), stream);
+  if (res != ResOK || *eofOut)
+    return res;
+
   if (event->any.size < sizeof(event->any))
     return ResFAIL; /* invalid size: too small */
 
@@ -207,19 +282,332 @@ static Res eventRead(Bool *eofOut, EventUnion *event, FILE *stream)
   /* Read the rest of the event. */
   rest = event->any.size - sizeof(event->any);
   if (rest > 0) {
-    n = fread((char *)event + sizeof(event->any), rest, 1, stream);
-    if (n < 1) {
-      if (feof(stream))
-        return ResFAIL; /* truncated event */
-      else
-        return ResIO;
-    }
+    res = readBytes(eofOut, (char *)event + sizeof(event->any), rest, stream);
+    if (res != ResOK)
+      return res;
+    if (*eofOut)
+      return ResFAIL; /* truncated event */
   }
 
+  return ResOK;
+}
+
+
+/* eventRead -- read one event from the file
+ *
+ * Each EventPacked event is followed by a block of packed events,
+ * which are unpacked one at a time.  See <design/telemetry/#packed>.
+ */
+
+static Byte packed[EventPackedSIZE]; /* block of packed events */
+static size_t packedNext = 0;   /* offset of next packed event */
+static size_t packedLimit = 0;  /* length of block */
+static EventPackStateStruct packState;
+
+static Res eventRead(Bool *eofOut, EventUnion *event, FILE *stream)
+{
+  size_t length;
+  Res res;
+
+  while (packedNext == packedLimit) {
+    res = eventReadRaw(eofOut, event, stream);
+    if (res != ResOK || *eofOut)
+      return res;
+    if (event->any.code != EventEventPackedCode)
+      return ResOK;
+    if (event->EventPacked.f0 > sizeof packed)
+      return ResFAIL; /* invalid length: too large */
+    packedNext = 0;
+    packedLimit = event->EventPacked.f0;
+    EventPackStateInit(&packState);
+    res = readBytes(eofOut, packed, packedLimit, stream);
+    if (res != ResOK)
+      return res;
+    if (*eofOut)
+      return ResFAIL; /* truncated block */
+  }
+
+  res = EventUnpack(event, &length, &packState, &packed[packedNext],
+                    packedLimit - packedNext);
+  if (res != ResOK)
+    return res;
+  packedNext += length;
   *eofOut = FALSE;
   return ResOK;
 }
 
+
+/* Summaries
+ *
+ * The summary accumulates statistics from the events since the last
+ * summary line.  Pauses are matched up by the parameters that their
+ * begin and end events share, and measured in event clock ticks.
+ */
+
+enum {
+  PausePOLL,                    /* ArenaPoll that did work */
+  PauseFLIP,                    /* TraceFlipBegin to TraceFlipEnd */
+  PauseACCESS,                  /* ArenaAccess pair */
+  PauseLIMIT
+};
+
+static const char *pauseName[PauseLIMIT] = {"poll", "flip", "access"};
+
+typedef struct PauseStatsStruct {
+  ulongest_t count;             /* number of pauses */
+  EventClock total;             /* total duration */
+  EventClock max;               /* longest pause */
+} PauseStatsStruct;
+
+typedef struct GenStatsStruct {
+  ulongest_t gen;               /* generation, from TraceEndGen */
+  ulongest_t condemned;         /* bytes condemned */
+  ulongest_t forwarded;         /* bytes forwarded */
+  ulongest_t preserved;         /* bytes preserved in place */
+  double mortality;             /* latest mortality */
+} GenStatsStruct;
+
+typedef struct SummaryStruct {
+  ulongest_t traces;            /* traces started */
+  ulongest_t condemned;         /* bytes condemned */
+  ulongest_t reclaimed;         /* bytes reclaimed */
+  ulongest_t fixes;             /* references fixed */
+  ulongest_t segFixes;          /* references to segments */
+  ulongest_t whiteFixes;        /* references to white segments */
+  ulongest_t readHits;          /* read barrier hits */
+  ulongest_t writeHits;         /* write barrier hits */
+  PauseStatsStruct pause[PauseLIMIT];
+  size_t gens;                  /* number of entries in gen */
+  GenStatsStruct gen[SUMMARY_GEN_MAX];
+} SummaryStruct;
+
+typedef struct PendingStruct {
+  Bool used;                    /* entry is waiting for an end event */
+  unsigned kind;                /* kind of pause */
+  ulongest_t key[2];            /* parameters that match the events */
+  EventClock clock;             /* time of the begin event */
+} PendingStruct;
+
+static SummaryStruct summary;
+static PendingStruct pending[SUMMARY_PENDING_MAX];
+static size_t pendingNext = 0;  /* entry to replace when full */
+static ulongest_t clocksPerSec = 0; /* from EventInit */
+static Bool clockSynced = FALSE; /* seen an EventClockSync? */
+static EventClock firstClock;   /* event clock of first EventClockSync */
+static ulongest_t firstSync;    /* mps_clock of first EventClockSync */
+static ulongest_t lastSync;     /* mps_clock of latest EventClockSync */
+static double ticksPerSec = 0.0; /* event clock rate, or 0 if unknown */
+static ulongest_t summarySync;  /* mps_clock of last summary */
+
+
+/* pauseEvent -- note the beginning or end of a pause
+ *
+ * If a pause with the same kind and key is pending, this is its end,
+ * and if record is TRUE, the pause is added to the summary.  Returns
+ * TRUE if this was the end of a pause.
+ */
+
+static Bool pauseEvent(unsigned kind, ulongest_t key0, ulongest_t key1,
+                       Bool begin, Bool record)
+{
+  size_t i;
+
+  for (i = 0; i < SUMMARY_PENDING_MAX; ++i) {
+    PendingStruct *p = &pending[i];
+    if (p->used && p->kind == kind && p->key[0] == key0 && p->key[1] == key1) {
+      p->used = FALSE;
+      if (record) {
+        PauseStatsStruct *stats = &summary.pause[kind];
+        EventClock time = eventTime >= p->clock ? eventTime - p->clock
+                                                : p->clock - eventTime;
+        ++stats->count;
+        stats->total += time;
+        if (time > stats->max)
+          stats->max = time;
+      }
+      return TRUE;
+    }
+  }
+
+  if (begin) {
+    /* Find a free entry, or replace the oldest if the end events of
+       some pauses are missing. */
+    for (i = 0; i < SUMMARY_PENDING_MAX; ++i)
+      if (!pending[i].used)
+        break;
+    if (i == SUMMARY_PENDING_MAX) {
+      i = pendingNext;
+      pendingNext = (pendingNext + 1) % SUMMARY_PENDING_MAX;
+    }
+    pending[i].used = TRUE;
+    pending[i].kind = kind;
+    pending[i].key[0] = key0;
+    pending[i].key[1] = key1;
+    pending[i].clock = eventTime;
+  }
+  return FALSE;
+}
+
+
+/* genStats -- find or add the statistics for a generation */
+
+static GenStatsStruct *genStats(ulongest_t gen)
+{
+  size_t i;
+
+  for (i = 0; i < summary.gens; ++i)
+    if (summary.gen[i].gen == gen)
+      return &summary.gen[i];
+  if (summary.gens == SUMMARY_GEN_MAX)
+    return NULL;
+  ++summary.gens;
+  summary.gen[i].gen = gen;
+  return &summary.gen[i];
+}
+
+
+/* printMillis -- print a duration in event clock ticks in milliseconds */
+
+static void printMillis(EventClock time)
+{
+  if (ticksPerSec > 0.0)
+    printf(" %.3f", (double)time * 1000.0 / ticksPerSec);
+  else
+    printf(" -");
+}
+
+
+/* printSummary -- print and reset the summary */
+
+static void printSummary(void)
+{
+  size_t i;
+  unsigned kind;
+
+  (void)EVENT_CLOCK_PRINT(stdout, eventTime);
+  printf(" Summary time");
+  if (clockSynced && clocksPerSec > 0)
+    printf(" %.3f", (double)(lastSync - firstSync) / (double)clocksPerSec);
+  else
+    printf(" -");
+  printf(" traces %"PRIuLONGEST" condemned %"PRIuLONGEST
+         " reclaimed %"PRIuLONGEST,
+         summary.traces, summary.condemned, summary.reclaimed);
+  printf(" fixes %"PRIuLONGEST" segFixes %"PRIuLONGEST
+         " whiteFixes %"PRIuLONGEST,
+         summary.fixes, summary.segFixes, summary.whiteFixes);
+  printf(" readHits %"PRIuLONGEST" writeHits %"PRIuLONGEST,
+         summary.readHits, summary.writeHits);
+  for (kind = 0; kind < PauseLIMIT; ++kind) {
+    PauseStatsStruct *stats = &summary.pause[kind];
+    printf(" %sPauses %"PRIuLONGEST" %sTotal", pauseName[kind],
+           stats->count, pauseName[kind]);
+    printMillis(stats->total);
+    printf(" %sMax", pauseName[kind]);
+    printMillis(stats->max);
+  }
+  putchar('\n');
+
+  for (i = 0; i < summary.gens; ++i) {
+    GenStatsStruct *gen = &summary.gen[i];
+    (void)EVENT_CLOCK_PRINT(stdout, eventTime);
+    printf(" SummaryGen %"PRIXLONGEST" condemned %"PRIuLONGEST
+           " forwarded %"PRIuLONGEST" preserved %"PRIuLONGEST
+           " mortality %.3f\n",
+           gen->gen, gen->condemned, gen->forwarded, gen->preserved,
+           gen->mortality);
+  }
+
+  (void)memset(&summary, 0, sizeof summary);
+  summarySync = lastSync;
+}
+
+
+/* summarize -- add an event to the summary */
+
+static void summarize(Event event)
+{
+  switch (event->any.code) {
+  case EventEventInitCode:
+    clocksPerSec = (ulongest_t)event->EventInit.f6;
+    break;
+
+  case EventEventClockSyncCode:
+    lastSync = (ulongest_t)event->EventClockSync.f0;
+    if (!clockSynced) {
+      clockSynced = TRUE;
+      firstClock = eventTime;
+      firstSync = summarySync = lastSync;
+    } else if (lastSync > firstSync && clocksPerSec > 0) {
+      ticksPerSec = (double)(eventTime - firstClock) * (double)clocksPerSec
+        / (double)(lastSync - firstSync);
+    }
+    if (clocksPerSec > 0
+        && (double)(lastSync - summarySync)
+           >= summaryInterval * (double)clocksPerSec)
+      printSummary();
+    break;
+
+  case EventTraceStartCode:
+    ++summary.traces;
+    summary.condemned += (ulongest_t)event->TraceStart.f3;
+    break;
+
+  case EventTraceStatFixCode:
+    summary.fixes += (ulongest_t)event->TraceStatFix.f1;
+    summary.segFixes += (ulongest_t)event->TraceStatFix.f2;
+    summary.whiteFixes += (ulongest_t)event->TraceStatFix.f3;
+    break;
+
+  case EventTraceStatReclaimCode:
+    summary.reclaimed += (ulongest_t)event->TraceStatReclaim.f2;
+    break;
+
+  case EventTraceEndGenCode: {
+    GenStatsStruct *gen = genStats((ulongest_t)event->TraceEndGen.f1);
+    if (gen != NULL) {
+      gen->condemned += (ulongest_t)event->TraceEndGen.f2;
+      gen->forwarded += (ulongest_t)event->TraceEndGen.f3;
+      gen->preserved += (ulongest_t)event->TraceEndGen.f4;
+      gen->mortality = event->TraceEndGen.f5;
+    }
+    break;
+  }
+
+  case EventArenaPollCode:
+    /* The begin and end events have the same start time, but only
+       the end event says whether any work was done. */
+    (void)pauseEvent(PausePOLL, (ulongest_t)event->ArenaPoll.f0,
+                     (ulongest_t)event->ArenaPoll.f1, TRUE,
+                     event->ArenaPoll.f2);
+    break;
+
+  case EventTraceFlipBeginCode:
+    (void)pauseEvent(PauseFLIP, (ulongest_t)event->TraceFlipBegin.f0,
+                     (ulongest_t)event->TraceFlipBegin.f1, TRUE, FALSE);
+    break;
+
+  case EventTraceFlipEndCode:
+    (void)pauseEvent(PauseFLIP, (ulongest_t)event->TraceFlipEnd.f0,
+                     (ulongest_t)event->TraceFlipEnd.f1, FALSE, TRUE);
+    break;
+
+  case EventArenaAccessCode:
+    /* The begin and end events have the same count. */
+    if (!pauseEvent(PauseACCESS, (ulongest_t)event->ArenaAccess.f0,
+                    (ulongest_t)event->ArenaAccess.f1, TRUE, TRUE)) {
+      if (event->ArenaAccess.f3 & AccessREAD)
+        ++summary.readHits;
+      if (event->ArenaAccess.f3 & AccessWRITE)
+        ++summary.writeHits;
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
 /* readLog -- read and parse log */
 
 static void readLog(FILE *stream)
@@ -234,7 +622,7 @@ static void readLog(FILE *stream)
     /* Read and parse event. */
     res = eventRead(&eof, event, stream);
     if (res == ResFAIL)
-      everror("Truncated log");
+      everror("Truncated or corrupt log");
     else if (res == ResIO)
       everror("I/O error reading log");
     else if (res != ResOK)
@@ -276,6 +664,11 @@ static void readLog(FILE *stream)
       break;
     }
 
+    if (summaryInterval > 0.0) {
+      summarize(event);
+      continue;
+    }
+
     (void)EVENT_CLOCK_PRINT(stdout, eventTime);
     printf(" %4X", (unsigned)code);
 
@@ -292,8 +685,11 @@ static void readLog(FILE *stream)
     }
 
     putchar('\n');
-    (void)fflush(stdout);
   } /* while(!feof(input)) */
+
+  if (summaryInterval > 0.0)
+    printSummary();
+  (void)fflush(stdout);
 }
 
 
@@ -133,6 +133,38 @@ typedef union EventUnion {
 } EventUnion, *Event;
 
 
+/* EventPackState -- state of a stream of packed events
+ *
+ * Each field of a packed event is encoded relative to the same field
+ * of the previous event of the same type, and its clock relative to
+ * the clock of the previous event.  Its code is predicted from the
+ * code of the previous event, and recently packed addresses are
+ * remembered in a small table so that they can be packed as their
+ * index in the table.  The writer and reader of the
+ * stream keep the same state.  See <design/telemetry/#packed>.
+ */
+
+#define EVENT_PACK_ADDR_COUNT 64 /* recent addresses; must be power of 2 */
+
+typedef struct EventPackStateStruct {
+  EventClock clock;             /* clock of previous event */
+  EventCode code;               /* code of previous event */
+  EventCode next[EventCodeMAX + 1]; /* code that last followed each code */
+  Word field[EventCodeMAX + 1][EventParamMAX]; /* by event code */
+  Word addr[EVENT_PACK_ADDR_COUNT]; /* recently packed addresses */
+} EventPackStateStruct, *EventPackState;
+
+extern void EventPackStateInit(EventPackState state);
+extern size_t EventPack(Byte *buffer, EventPackState state, Event event);
+extern Res EventUnpack(Event event, size_t *lengthReturn,
+                       EventPackState state, const Byte *buffer,
+                       size_t length);
+
+/* EventPackedSizeMAX -- largest size of a packed event of a given size */
+
+#define EventPackedSizeMAX(size) (2 * (size_t)(size) + 16)
+
+
 #endif /* eventcom_h */
 
 
@@ -35,9 +35,9 @@
  * of a telemetry stream, allowing that stream to be identified.
  */
 
-#define EVENT_VERSION_MAJOR  ((unsigned)1)
-#define EVENT_VERSION_MEDIAN ((unsigned)6)
-#define EVENT_VERSION_MINOR  ((unsigned)1)
+#define EVENT_VERSION_MAJOR  ((unsigned)2)
+#define EVENT_VERSION_MEDIAN ((unsigned)0)
+#define EVENT_VERSION_MINOR  ((unsigned)2)
 
 
 /* EVENT_LIST -- list of event types and general properties
@@ -67,7 +67,8 @@
  */
  
 #define EventNameMAX ((size_t)19)
-#define EventCodeMAX ((EventCode)0x0088)
+#define EventCodeMAX ((EventCode)0x008B)
+#define EventParamMAX ((size_t)13)
 
 #define EVENT_LIST(EVENT, X) \
   /*       0123456789012345678 <- don't exceed without changing EventNameMAX */ \
@@ -194,11 +195,14 @@
   EVENT(X, ArenaUseFreeZone   , 0x0085,  TRUE, Arena) \
   /* EVENT(X, ArenaBlacklistZone , 0x0086,  TRUE, Arena) */ \
   EVENT(X, PauseTimeSet       , 0x0087,  TRUE, Arena) \
-  EVENT(X, TraceEndGen        , 0x0088,  TRUE, Trace)
+  EVENT(X, TraceEndGen        , 0x0088,  TRUE, Trace) \
+  EVENT(X, EventPacked        , 0x0089,  TRUE, Arena) \
+  EVENT(X, ChainRetune        , 0x008A,  TRUE, Trace) \
+  EVENT(X, ArenaPressure      , 0x008B,  TRUE, Arena)
 
 
-/* Remember to update EventNameMAX and EventCodeMAX above! 
-   (These are checked in EventInit.) */
+/* Remember to update EventNameMAX, EventCodeMAX, and EventParamMAX
+   above!  (These are checked in EventInit.) */
 
 
 /* EVENT_*_PARAMS -- definition of event parameters
@@ -634,6 +638,9 @@
 #define EVENT_EventClockSync_PARAMS(PARAM, X) \
   PARAM(X,  0, W, clock)          /* mps_clock() value */
 
+#define EVENT_EventPacked_PARAMS(PARAM, X) \
+  PARAM(X,  0, W, length)         /* bytes of packed events following */
+
 #define EVENT_ArenaAccess_PARAMS(PARAM, X) \
   PARAM(X,  0, P, arena) \
   PARAM(X,  1, W, count) \
@@ -711,6 +718,18 @@
   PARAM(X,  4, W, preservedInPlace) /* bytes preserved in generation */ \
   PARAM(X,  5, D, mortality)    /* updated mortality */
 
+#define EVENT_ChainRetune_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, chain)        /* the chain */ \
+  PARAM(X,  1, W, gen)          /* index of generation in chain */ \
+  PARAM(X,  2, W, oldCapacity)  /* previous capacity in kB */ \
+  PARAM(X,  3, W, newCapacity)  /* new capacity in kB */ \
+  PARAM(X,  4, D, mortality)    /* updated mortality */
+
+#define EVENT_ArenaPressure_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena)        /* the arena */ \
+  PARAM(X,  1, D, pressure)     /* pressure read from the source */ \
+  PARAM(X,  2, B, underPressure) /* is the arena now under pressure? */
+
 
 #endif /* eventdef_h */
 
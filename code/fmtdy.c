@@ -205,32 +205,12 @@ int dylan_wrapper_check(mps_word_t *w)
 
 
 /* Scan a contiguous array of references in [base, limit). */
-/* This code has been hand-optimised and examined using Metrowerks */
-/* Codewarrior on a 68K and also Microsoft Visual C on a 486.  The */
-/* variables in the loop allocate nicely into registers.  Alter with */
-/* care. */
+/* Pointers are tagged with 0 in the bottom two bits. */
 
 static mps_res_t dylan_scan_contig(mps_ss_t mps_ss,
                                    mps_addr_t *base, mps_addr_t *limit)
 {
-  mps_res_t res;
-  mps_addr_t *p;        /* reference cursor */
-  mps_addr_t r;         /* reference to be fixed */
-
-  MPS_SCAN_BEGIN(mps_ss) {
-          p = base;
-    loop: if(p >= limit) goto out;
-          r = *p++;
-          if(((mps_word_t)r&3) != 0) /* pointers tagged with 0 */
-            goto loop;             /* not a pointer */
-          if(!MPS_FIX1(mps_ss, r)) goto loop;
-          res = MPS_FIX2(mps_ss, p-1);
-          if(res == MPS_RES_OK) goto loop;
-          return res;
-    out:  assert(p == limit);
-  } MPS_SCAN_END(mps_ss);
-
-  return MPS_RES_OK;
+  return mps_fix_area_tagged(mps_ss, base, limit, 3, 0);
 }
 
 /* dylan_weak_dependent -- returns the linked object, if any.
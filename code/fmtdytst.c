@@ -166,6 +166,29 @@ void dylan_write(mps_addr_t addr, mps_addr_t *refs, size_t nr_refs)
   }
 }
 
+/* dylan_write_barrier -- as dylan_write, but marking cards
+ *
+ * For arenas created with MPS_KEY_ARENA_CARD_MARKING.
+ */
+
+void dylan_write_barrier(mps_cards_t cards, mps_addr_t addr,
+                         mps_addr_t *refs, size_t nr_refs)
+{
+  mps_word_t *p = (mps_word_t *)addr;
+  mps_word_t t = p[1] >> 2;
+
+  /* If the object is a vector, update a random entry. */
+  if(p[0] == (mps_word_t)tvw && t > 0) {
+    mps_word_t r = rnd();
+    size_t i = 2 + (rnd() % t);
+
+    if(r & 1)
+      p[i] = ((r & ~(mps_word_t)3) | 1); /* random int */
+    else
+      MPS_WRITE_BARRIER(cards, &p[i], refs[(r >> 1) % nr_refs]);
+  }
+}
+
 /*  Writes to a dylan object.
     Currently just swaps two refs if it can.
     This is only used in a certain way by certain tests, it doesn't have
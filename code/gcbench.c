@@ -17,6 +17,7 @@
 #include "getopt.h"
 #else
 #include <getopt.h>
+#include <sys/time.h> /* gettimeofday */
 #endif
 
 #include <stdio.h> /* fprintf, printf, putchars, sscanf, stderr, stdout */
@@ -56,6 +57,23 @@ static size_t arena_grain_size = 1; /* arena grain size */
 static unsigned pinleaf = FALSE;  /* are leaf objects pinned at start */
 static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
 static double pause_time = ARENA_DEFAULT_PAUSE_TIME; /* maximum pause time */
+static unsigned collect_world = 0; /* passes between world collections */
+#define GC_THREADS_LIMIT 16
+static unsigned gc_threads[GC_THREADS_LIMIT]; /* collector thread counts */
+static unsigned ngc_threads = 0;  /* number of counts specified */
+static unsigned gc_thread_count = 1; /* collector threads for this run */
+static double base_wall = 0.0;    /* wall time with first count */
+static mps_bool_t background = FALSE; /* collect on a background thread */
+static mps_bool_t huge_pages = FALSE; /* back arena with huge pages */
+static mps_bool_t soft_dirty = FALSE; /* find dirty pages without barrier */
+static mps_bool_t fix_prefetch = FALSE; /* prefetch page table when fixing */
+
+/* Collection counts, see count_collections. */
+static unsigned long world_count = 0;   /* world collections started */
+static unsigned long chain_count = 0;   /* chain collections started */
+static unsigned long chain_overlap = 0; /* ... during a world collection */
+static unsigned live_count = 0;         /* collections in progress */
+static mps_bool_t world_live = FALSE;   /* world collection in progress? */
 
 typedef struct gcthread_s *gcthread_t;
 
@@ -67,6 +85,7 @@ struct gcthread_s {
     mps_root_t reg_root;
     mps_ap_t ap;
     gcthread_fn_t fn;
+    mps_bool_t collector; /* starts world collections and counts them */
 };
 
 typedef mps_word_t obj_t;
@@ -156,6 +175,41 @@ static obj_t update_tree(mps_ap_t ap, obj_t oldtree, unsigned d) {
   return tree;
 }
 
+/* count_collections -- count the collections started so far
+ *
+ * Drains the GC messages, counting the world and chain collections
+ * that started, and in particular the chain collections that started
+ * while a world collection was in progress. A world collection only
+ * starts when no other collection is running, so it is in progress
+ * until the number of collections in progress drops to zero.
+ */
+static void count_collections(void)
+{
+  mps_message_type_t type;
+
+  while (mps_message_queue_type(&type, arena)) {
+    mps_message_t message;
+    if (!mps_message_get(&message, arena, type))
+      break;
+    if (type == mps_message_type_gc_start()) {
+      const char *why = mps_message_gc_start_why(arena, message);
+      ++live_count;
+      if (strcmp(why, TraceStartWhyToString(TraceStartWhyCHAIN_GEN0CAP)) == 0) {
+        ++chain_count;
+        if (world_live)
+          ++chain_overlap;
+      } else {
+        ++world_count;
+        world_live = TRUE;
+      }
+    } else if (type == mps_message_type_gc()) {
+      if (live_count > 0 && --live_count == 0)
+        world_live = FALSE;
+    }
+    mps_message_discard(arena, message);
+  }
+}
+
 static void *gc_tree(gcthread_t thread) {
   unsigned i, j;
   mps_ap_t ap = thread->ap;
@@ -167,6 +221,11 @@ static void *gc_tree(gcthread_t thread) {
         tree = new_tree(ap, tree, depth);
       if (pupdate > 0.0)
         tree = update_tree(ap, tree, depth);
+      if (collect_world > 0 && thread->collector) {
+        count_collections();
+        if ((i * npass + j) % collect_world == 0)
+          RESMUST(mps_arena_start_collect(arena));
+      }
     }
   }
   return NULL;
@@ -195,6 +254,7 @@ static void weave(gcthread_fn_t fn)
   for (t = 0; t < nthreads; ++t) {
     gcthread_t thread = &threads[t];
     thread->fn = fn;
+    thread->collector = (t == 0);
     testthr_create(&thread->thread, start, thread);
   }
   
@@ -207,22 +267,52 @@ static void weave1(gcthread_fn_t fn)
   gcthread_t thread = alloca(sizeof(thread[0]));
   
   thread->fn = fn;
+  thread->collector = TRUE;
   start(thread);
 }
 
 
+/* wall_clock -- elapsed time in seconds
+ *
+ * On Windows, clock() measures elapsed time already.
+ */
+
+static double wall_clock(void)
+{
+#ifdef MPS_OS_W3
+  return (double)clock() / CLOCKS_PER_SEC;
+#else
+  struct timeval tv;
+  (void)gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+#endif
+}
+
+
 static void watch(gcthread_fn_t fn, const char *name)
 {
   clock_t begin, end;
+  double wall_begin, wall;
   
   begin = clock();
+  wall_begin = wall_clock();
   if (nthreads == 1)
     weave1(fn);
   else
     weave(fn);
   end = clock();
+  wall = wall_clock() - wall_begin;
   
-  printf("%s: %g\n", name, (double)(end - begin) / CLOCKS_PER_SEC);
+  if (ngc_threads == 0) {
+    printf("%s: %g\n", name, (double)(end - begin) / CLOCKS_PER_SEC);
+  } else {
+    /* Report speedup relative to the first count given. */
+    if (gc_thread_count == gc_threads[0])
+      base_wall = wall;
+    printf("%s: %g (gc threads %u, elapsed %g, speedup %.2f)\n",
+           name, (double)(end - begin) / CLOCKS_PER_SEC,
+           gc_thread_count, wall, base_wall / wall);
+  }
 }
 
 
@@ -237,8 +327,17 @@ static void arena_setup(gcthread_fn_t fn,
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, arena_grain_size);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
     MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, pause_time);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_GC_THREADS, gc_thread_count);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_BACKGROUND, background);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_HUGE_PAGES, huge_pages);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SOFT_DIRTY, soft_dirty);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_FIX_PREFETCH, fix_prefetch);
     RESMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
   } MPS_ARGS_END(args);
+  if (collect_world > 0) {
+    mps_message_type_enable(arena, mps_message_type_gc_start());
+    mps_message_type_enable(arena, mps_message_type_gc());
+  }
   RESMUST(dylan_fmt(&format, arena));
   /* Make wrappers now to avoid race condition. */
   /* dylan_make_wrappers() uses malloc. */
@@ -253,6 +352,12 @@ static void arena_setup(gcthread_fn_t fn,
   } MPS_ARGS_END(args);
   watch(fn, name);
   mps_arena_park(arena);
+  if (collect_world > 0) {
+    count_collections();
+    printf("collections: %lu world, %lu chain"
+           " (%lu during a world collection)\n",
+           world_count, chain_count, chain_overlap);
+  }
   mps_pool_destroy(pool);
   mps_fmt_destroy(format);
   if (ngen > 0)
@@ -279,6 +384,12 @@ static struct option longopts[] = {
   {"seed",             required_argument, NULL, 'x'},
   {"arena-unzoned",    no_argument,       NULL, 'z'},
   {"pause-time",       required_argument, NULL, 'P'},
+  {"collect-world",    required_argument, NULL, 'c'},
+  {"gc-threads",       required_argument, NULL, 'G'},
+  {"background",       no_argument,       NULL, 'B'},
+  {"huge-pages",       no_argument,       NULL, 'H'},
+  {"soft-dirty",       no_argument,       NULL, 'D'},
+  {"fix-prefetch",     no_argument,       NULL, 'F'},
   {NULL,               0,                 NULL, 0  }
 };
 
@@ -302,7 +413,7 @@ int main(int argc, char *argv[]) {
 
   seed = rnd_seed();
   
-  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:",
+  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:c:G:BHDF",
                            longopts, NULL)) != -1)
     switch (ch) {
     case 't':
@@ -396,6 +507,37 @@ int main(int argc, char *argv[]) {
     case 'P':
       pause_time = strtod(optarg, NULL);
       break;
+    case 'c':
+      collect_world = (unsigned)strtoul(optarg, NULL, 10);
+      break;
+    case 'G': {
+      char *p = optarg;
+      do {
+        if (ngc_threads >= GC_THREADS_LIMIT) {
+          fprintf(stderr, "exceeded GC_THREADS_LIMIT\n");
+          return EXIT_FAILURE;
+        }
+        gc_threads[ngc_threads] = (unsigned)strtoul(p, &p, 10);
+        if (gc_threads[ngc_threads] == 0) {
+          fprintf(stderr, "Bad gc thread count '%s'\n", optarg);
+          return EXIT_FAILURE;
+        }
+        ++ngc_threads;
+      } while (*p++ == ',');
+      break;
+    }
+    case 'B':
+      background = TRUE;
+      break;
+    case 'H':
+      huge_pages = TRUE;
+      break;
+    case 'D':
+      soft_dirty = TRUE;
+      break;
+    case 'F':
+      fix_prefetch = TRUE;
+      break;
     default:
       /* This is printed in parts to keep within the 509 character
          limit for string literals in portable standard C. */
@@ -443,10 +585,25 @@ int main(int argc, char *argv[]) {
               "    Disable zoned allocation in the arena\n"
               "  -P t, --pause-time\n"
               "    Maximum pause time in seconds (default %f) \n"
+              "  -c n, --collect-world=n\n"
+              "    Start a world collection every n passes, and count\n"
+              "    the chain collections that run alongside it.\n"
+              "  -G n[,n...], --gc-threads=n[,n...]\n"
+              "    Scan with n collector threads; run each test with\n"
+              "    each count and report the speedup over the first.\n",
+              pause_time);
+      fprintf(stderr,
+              "  -B, --background\n"
+              "    Do collection work on a background thread.\n"
+              "  -H, --huge-pages\n"
+              "    Back the arena with huge pages (Linux only).\n"
+              "  -D, --soft-dirty\n"
+              "    Find written pages without a write barrier (Linux only).\n"
+              "  -F, --fix-prefetch\n"
+              "    Prefetch page table entries when fixing.\n"
               "Tests:\n"
               "  amc   pool class AMC\n"
-              "  ams   pool class AMS\n",
-              pause_time);
+              "  ams   pool class AMS\n");
       return EXIT_FAILURE;
     }
   argc -= optind;
@@ -465,8 +622,17 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   found:
     (void)mps_lib_assert_fail_install(assert_die);
-    rnd_state_set(seed);
-    arena_setup(pools[i].fn, pools[i].pool_class(), pools[i].name);
+    if (ngc_threads == 0) {
+      rnd_state_set(seed);
+      arena_setup(pools[i].fn, pools[i].pool_class(), pools[i].name);
+    } else {
+      unsigned j;
+      for (j = 0; j < ngc_threads; ++j) {
+        gc_thread_count = gc_threads[j];
+        rnd_state_set(seed);
+        arena_setup(pools[i].fn, pools[i].pool_class(), pools[i].name);
+      }
+    }
     --argc;
     ++argv;
   }
@@ -38,6 +38,9 @@ static RingStruct arenaRing;       /* <design/arena/#static.ring> */
 static Serial arenaSerial;         /* <design/arena/#static.serial> */
 
 
+static Bool arenaBackgroundStep(void *closure);
+
+
 /* arenaClaimRingLock, arenaReleaseRingLock -- lock/release the arena ring
  *
  * See <design/arena/#static.ring.lock>.  */
@@ -177,6 +180,10 @@ Bool GlobalsCheck(Globals arenaGlobals)
   CHECKL(arena->tracedWork >= 0.0);
   CHECKL(arena->tracedTime >= 0.0);
   /* no check for arena->lastWorldCollect (Clock) */
+  if (arena->policy != NULL) {
+    CHECKD(Policy, arena->policy);
+    CHECKL(arena->policy->arena == arena);
+  }
 
   /* can't write a check for arena->epoch */
   CHECKD(History, ArenaHistory(arena));
@@ -267,6 +274,7 @@ Res GlobalsInit(Globals arenaGlobals)
   arena->tracedWork = 0.0;
   arena->tracedTime = 0.0;
   arena->lastWorldCollect = ClockNow();
+  arena->policy = NULL;
   ShieldInit(ArenaShield(arena));
 
   for (ti = 0; ti < TraceLIMIT; ++ti) {
@@ -338,6 +346,21 @@ Res GlobalsCompleteCreate(Globals arenaGlobals)
   arenaGlobals->lock = (Lock)p;
   LockInit(arenaGlobals->lock);
 
+  /* <design/write-barrier/#card> */
+  res = ArenaCardsCreate(arena);
+  if (res != ResOK)
+    return res;
+
+  /* <design/trace/#parallel> */
+  if (arena->gcThreads > 1) {
+    res = WorkersCreate(&arena->workers, arena, arena->gcThreads);
+    if (res != ResOK)
+      goto failWorkersCreate;
+    res = TraceBatchCreate(&arena->traceBatch, arena);
+    if (res != ResOK)
+      goto failTraceBatchCreate;
+  }
+
   {
     GenParamStruct params[] = ChainDEFAULT;
     res = ChainCreate(&arenaGlobals->defaultChain, arena, NELEMS(params), params);
@@ -345,11 +368,35 @@ Res GlobalsCompleteCreate(Globals arenaGlobals)
       goto failChainCreate;
   }
 
+  /* <design/trace/#background> */
+  if (arena->backgroundCollect) {
+    res = BackgroundCreate(&arena->background, arena,
+                           arenaBackgroundStep, arena);
+    if (res == ResUNIMPL)
+      arena->background = NULL; /* <design/trace/#background.unimpl> */
+    else if (res != ResOK)
+      goto failBackgroundCreate;
+  }
+
   arenaAnnounce(arena);
 
   return ResOK;
 
+failBackgroundCreate:
+  ChainDestroy(arenaGlobals->defaultChain);
+  arenaGlobals->defaultChain = NULL;
 failChainCreate:
+  if (arena->traceBatch != NULL) {
+    TraceBatchDestroy(arena->traceBatch, arena);
+    arena->traceBatch = NULL;
+  }
+failTraceBatchCreate:
+  if (arena->workers != NULL) {
+    WorkersDestroy(arena->workers);
+    arena->workers = NULL;
+  }
+failWorkersCreate:
+  ArenaCardsDestroy(arena);
   return res;
 }
 
@@ -397,14 +444,32 @@ void GlobalsPrepareToDestroy(Globals arenaGlobals)
 
   AVERT(Globals, arenaGlobals);
 
+  arena = GlobalsArena(arenaGlobals);
+
+  /* Stop the background collector first.  It may be waiting to enter
+   * the arena, so leave the arena while waiting for it to finish.
+   * <design/trace/#background.destroy> */
+  if (arena->background != NULL) {
+    Background background = arena->background;
+    arena->background = NULL;
+    ArenaLeave(arena);
+    BackgroundDestroy(background);
+    ArenaEnter(arena);
+  }
+
   /* Park the arena before destroying the default chain, to ensure
    * that there are no traces using that chain. */
   ArenaPark(arenaGlobals);
 
-  arena = GlobalsArena(arenaGlobals);
-
   arenaDenounce(arena);
 
+  if (arena->workers != NULL) {
+    TraceBatchDestroy(arena->traceBatch, arena);
+    arena->traceBatch = NULL;
+    WorkersDestroy(arena->workers);
+    arena->workers = NULL;
+  }
+
   defaultChain = arenaGlobals->defaultChain;
   arenaGlobals->defaultChain = NULL;
   ChainDestroy(defaultChain);
@@ -441,6 +506,8 @@ void GlobalsPrepareToDestroy(Globals arenaGlobals)
     arena->enabledMessageTypes = NULL;
   }
 
+  ArenaCardsDestroy(arena);
+
   /* destroy the final pool (see <design/finalize/>) */
   if (arena->isFinalPool) {
     /* All this subtlety is because PoolDestroy will call */
@@ -466,6 +533,7 @@ void GlobalsPrepareToDestroy(Globals arenaGlobals)
    */
   AVER(RingIsSingle(&arena->formatRing)); /* <design/check/#.common> */
   AVER(RingIsSingle(&arena->chainRing)); /* <design/check/#.common> */
+  AVER(arena->policy == NULL); /* <design/check/#.common> */
   AVER(RingIsSingle(&arena->messageRing));
   AVER(RingIsSingle(&arena->threadRing)); /* <design/check/#.common> */
   AVER(RingIsSingle(&arena->deadRing));
@@ -586,6 +654,7 @@ Bool ArenaBusy(Arena arena)
 Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
 {
   static Count count = 0;       /* used to match up ArenaAccess events */
+  Clock start;
   Seg seg;
   Ring node, nextNode;
   Res res;
@@ -600,6 +669,7 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
 
     ArenaEnter(arena);     /* <design/arena/#lock.arena> */
     EVENT4(ArenaAccess, arena, ++count, addr, mode);
+    start = WallClockNow();
 
     /* @@@@ The code below assumes that Roots and Segs are disjoint. */
     /* It will fall over (in TraceSegAccess probably) if there is a */
@@ -616,6 +686,7 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
       if (mode != AccessSetEMPTY) {
         res = PoolAccess(SegPool(seg), seg, addr, mode, context);
         AVER(res == ResOK); /* Mutator can't continue unless this succeeds */
+        ArenaPauseRecord(arena, PauseKindACCESS, start, WallClockNow());
       } else {
         /* Protection was already cleared, for example by another thread
            or a fault in a nested exception handler: nothing to do now. */
@@ -626,8 +697,10 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
     } else if (RootOfAddr(&root, arena, addr)) {
       arenaReleaseRingLock();
       mode &= RootPM(root);
-      if (mode != AccessSetEMPTY)
+      if (mode != AccessSetEMPTY) {
         RootAccess(root, mode);
+        ArenaPauseRecord(arena, PauseKindACCESS, start, WallClockNow());
+      }
       EVENT4(ArenaAccess, arena, count, addr, mode);
       ArenaLeave(arena);
       return TRUE;
@@ -662,13 +735,11 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context)
  * series of manual steps for looking around.  This might be worthwhile
  * if we introduce background activities other than tracing.  */
 
+static Bool arenaPollWork(Globals globals);
+
 void (ArenaPoll)(Globals globals)
 {
   Arena arena;
-  Clock start;
-  Bool worldCollected = FALSE;
-  Bool moreWork, workWasDone = FALSE;
-  Work tracedWork;
 
   AVERT(Globals, globals);
 
@@ -680,29 +751,95 @@ void (ArenaPoll)(Globals globals)
   if (!PolicyPoll(arena))
     return;
 
+  /* <design/trace/#background.poll> */
+  if (arena->background != NULL) {
+    BackgroundWake(arena->background);
+    return;
+  }
+
+  (void)arenaPollWork(globals);
+}
+
+
+/* arenaPollWork -- do collection work for one poll
+ *
+ * Returns TRUE if there is more work to do.
+ */
+
+static Bool arenaPollWork(Globals globals)
+{
+  Arena arena;
+  Clock start, pauseStart;
+  Bool worldCollected = FALSE;
+  Bool moreWork, workWasDone = FALSE;
+  Work tracedWork;
+  double pollTime;
+
+  AVERT(Globals, globals);
+  AVER(!globals->insidePoll);
+  arena = GlobalsArena(globals);
+
   globals->insidePoll = TRUE;
 
   /* fillMutatorSize has advanced; call TracePoll enough to catch up. */
   start = ClockNow();
+  pauseStart = WallClockNow();
+  pollTime = PolicyPollTime(arena);
 
   EVENT3(ArenaPoll, arena, start, FALSE);
 
+  /* <design/arena/#pressure> */
+  if (ArenaPressurePoll(arena, start) && arena->busyTraces == TraceSetEMPTY) {
+    Trace trace;
+    worldCollected = PolicyPressureTrace(&trace, arena, start);
+  }
+
   do {
     moreWork = TracePoll(&tracedWork, &worldCollected, globals,
                          !worldCollected);
     if (moreWork) {
       workWasDone = TRUE;
     }
-  } while (PolicyPollAgain(arena, start, moreWork, tracedWork));
+  } while (PolicyPollAgain(arena, start, pollTime, moreWork, tracedWork));
 
   /* Don't count time spent checking for work, if there was no work to do. */
   if (workWasDone) {
-    ArenaAccumulateTime(arena, start, ClockNow());
+    Clock end = ClockNow();
+    ArenaAccumulateTime(arena, start, end);
+    /* On the background thread, polling doesn't pause the mutator. */
+    if (arena->background == NULL)
+      ArenaPauseRecord(arena, PauseKindPOLL, pauseStart, WallClockNow());
   }
 
   EVENT3(ArenaPoll, arena, start, BOOLOF(workWasDone));
 
   globals->insidePoll = FALSE;
+  return moreWork;
+}
+
+
+/* arenaBackgroundStep -- do collection work on the background thread
+ *
+ * Enters the arena, does as much work as ArenaPoll would do in the
+ * mutator (bounded by the pause time, so that a mutator thread waits
+ * at most that long to handle a barrier hit), and leaves again so
+ * that mutator threads can enter.  Returns TRUE if there is more work
+ * to do.  See <design/trace/#background.step> and
+ * <design/trace/#background.pause>.
+ */
+
+static Bool arenaBackgroundStep(void *closure)
+{
+  Arena arena = closure;
+  Globals globals;
+  Bool moreWork = FALSE;
+
+  ArenaEnter(arena);
+  globals = ArenaGlobals(arena);
+  if (!globals->clamped && !globals->insidePoll)
+    moreWork = arenaPollWork(globals);
+  ArenaLeave(arena);
+  return moreWork;
 }
 
 
@@ -731,28 +868,22 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
   /* loop while there is work to do and time on the clock. */
   do {
     Trace trace;
-    if (arena->busyTraces != TraceSetEMPTY) {
-      trace = ArenaTrace(arena, (TraceId)0);
-    } else {
-      /* No traces are running: consider collecting the world. */
-      if (PolicyShouldCollectWorld(arena, (double)(availableEnd - now), now,
-                                   clocks_per_sec))
-      {
-        Res res;
-        res = TraceStartCollectAll(&trace, arena, TraceStartWhyOPPORTUNISM);
-        if (res != ResOK)
-          break;
-        arena->lastWorldCollect = now;
-      } else {
-        /* Not worth collecting the world; consider starting a trace. */
-        Bool worldCollected;
-        if (!PolicyStartTrace(&trace, &worldCollected, arena, FALSE))
-          break;
-      }
+    TraceId ti;
+    if (arena->busyTraces == TraceSetEMPTY) {
+      /* No traces are running: consider collecting the world, or
+         failing that, starting a trace. */
+      double stepTime = 0.0;
+      if (now < availableEnd)
+        stepTime = (availableEnd - now) / (double)clocks_per_sec;
+      if (!PolicyStepTrace(&trace, arena, stepTime, now))
+        break;
     }
-    TraceAdvance(trace);
-    if (trace->state == TraceFINISHED)
-      TraceDestroyFinished(trace);
+    /* Advance all active traces. */
+    TRACE_SET_ITER(ti, trace, arena->busyTraces, arena)
+      TraceAdvance(trace);
+      if (trace->state == TraceFINISHED)
+        TraceDestroyFinished(trace);
+    TRACE_SET_ITER_END(ti, trace, arena->busyTraces, arena);
     workWasDone = TRUE;
     now = ClockNow();
   } while (now < intervalEnd);
@@ -764,6 +895,71 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
   return workWasDone;
 }
 
+
+/* ArenaCollectUntil -- do useful work until a deadline
+ *
+ * Does the work allowed by flags (see <code/mpmtypes.h#collect>)
+ * until there is none left or the clock reaches deadline.  First
+ * finishes traces in progress, then starts traces the policy chooses
+ * (PolicyIdleTrace) and finishes those, and finally returns spare
+ * memory to the OS.  Returns CollectDEADLINE if work was left at the
+ * deadline, otherwise CollectDONE if work was done or CollectIDLE if
+ * there was none.  See <design/strategy/#policy.idle>.
+ */
+
+int ArenaCollectUntil(Globals globals, Clock deadline, unsigned flags)
+{
+  Bool workWasDone = FALSE, compacted = FALSE;
+  Clock start, now;
+  Arena arena;
+
+  AVERT(Globals, globals);
+  AVER((flags & ~(unsigned)CollectALL) == 0);
+
+  arena = GlobalsArena(globals);
+
+  for (;;) {
+    Trace trace;
+    TraceId ti;
+
+    start = now = ClockNow();
+    if (arena->busyTraces != TraceSetEMPTY) {
+      if (!(flags & CollectFINISH))
+        break;
+      if (now >= deadline)
+        return CollectDEADLINE;
+      TRACE_SET_ITER(ti, trace, arena->busyTraces, arena)
+        TraceAdvance(trace);
+        if (trace->state == TraceFINISHED)
+          TraceDestroyFinished(trace);
+      TRACE_SET_ITER_END(ti, trace, arena->busyTraces, arena);
+      ArenaAccumulateTime(arena, start, ClockNow());
+      workWasDone = TRUE;
+    } else if (now >= deadline) {
+      /* Can't tell whether the policy would start a trace without
+         starting it, so only an unfinished compaction counts. */
+      if ((flags & CollectCOMPACT) && !compacted)
+        return CollectDEADLINE;
+      break;
+    } else if ((flags & (CollectSTART | CollectWORLD))
+               && PolicyIdleTrace(&trace, arena,
+                                  (deadline - now) / (double)ClocksPerSec(),
+                                  now, (flags & CollectWORLD) != 0,
+                                  (flags & CollectSTART) != 0)) {
+      workWasDone = TRUE;
+    } else if ((flags & CollectCOMPACT) && !compacted) {
+      compacted = TRUE;
+      if (ArenaReleaseSpare(arena) > 0)
+        workWasDone = TRUE;
+    } else {
+      break;
+    }
+  }
+
+  return workWasDone ? CollectDONE : CollectIDLE;
+}
+
+
 /* ArenaFinalize -- registers an object for finalization
  *
  * See <design/finalize/>.  */
@@ -772,11 +968,13 @@ Res ArenaFinalize(Arena arena, Ref obj)
 {
   Res res;
   Pool refpool;
+  Clock start;
 
   AVERT(Arena, arena);
   AVER(PoolOfAddr(&refpool, arena, (Addr)obj));
   AVER(PoolHasAttr(refpool, AttrGC));
 
+  start = WallClockNow();
   if (!arena->isFinalPool) {
     Pool finalpool;
 
@@ -788,6 +986,7 @@ Res ArenaFinalize(Arena arena, Ref obj)
   }
 
   res = MRGRegister(arena->finalPool, obj);
+  ArenaPauseRecord(arena, PauseKindFINALIZE, start, WallClockNow());
   return res;
 }
 
@@ -799,6 +998,7 @@ Res ArenaFinalize(Arena arena, Ref obj)
 Res ArenaDefinalize(Arena arena, Ref obj)
 {
   Res res;
+  Clock start;
 
   AVERT(Arena, arena);
   AVER(ArenaHasAddr(arena, (Addr)obj));
@@ -806,7 +1006,9 @@ Res ArenaDefinalize(Arena arena, Ref obj)
   if (!arena->isFinalPool) {
     return ResFAIL;
   }
+  start = WallClockNow();
   res = MRGDeregister(arena->finalPool, obj);
+  ArenaPauseRecord(arena, PauseKindFINALIZE, start, WallClockNow());
   return res;
 }
 
@@ -891,6 +1093,9 @@ Ref ArenaRead(Arena arena, Ref *p)
   Bool b;
   Seg seg = NULL;       /* suppress "may be used uninitialized" */
   Rank rank;
+  TraceSet grey;
+  TraceId ti;
+  Trace trace;
 
   AVERT(Arena, arena);
 
@@ -910,10 +1115,13 @@ Ref ArenaRead(Arena arena, Ref *p)
   /* If the segment isn't grey it doesn't need scanning, and in fact it
      would be wrong to even ask what rank to scan it at, since there might
      not be any traces running. */
-  if (TraceSetInter(SegGrey(seg), arena->flippedTraces) != TraceSetEMPTY) {
-    rank = TraceRankForAccess(arena, seg);
-    TraceScanSingleRef(arena->flippedTraces, rank, arena, seg, p);
-  }
+  /* Each trace may be in a different band, so scan the reference
+     separately for each. See <design/trace/#multiple.access>. */
+  grey = TraceSetInter(SegGrey(seg), arena->flippedTraces);
+  TRACE_SET_ITER(ti, trace, grey, arena)
+    rank = TraceRankForAccess(trace, seg);
+    TraceScanSingleRef(TraceSetSingle(trace), rank, arena, seg, p);
+  TRACE_SET_ITER_END(ti, trace, grey, arena);
 
   /* We don't need to update the Seg Summary as in PoolSingleAccess
    * because we are not changing it after it has been scanned. */
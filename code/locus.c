@@ -110,6 +110,13 @@ Bool GenDescCheck(GenDesc gen)
   /* nothing to check for capacity */
   CHECKL(gen->mortality >= 0.0);
   CHECKL(gen->mortality <= 1.0);
+  CHECKL(BoolCheck(gen->adaptive));
+  if (gen->adaptive) {
+    CHECKL(0 < gen->minCapacity);
+    CHECKL(gen->minCapacity <= gen->capacity);
+    CHECKL(gen->capacity <= gen->maxCapacity);
+  }
+  /* no check for collected (Clock) */
   CHECKD_NOSIG(Ring, &gen->locusRing);
   CHECKD_NOSIG(Ring, &gen->segRing);
   return TRUE;
@@ -138,6 +145,10 @@ static void GenDescInit(GenDesc gen, GenParamStruct *params)
   gen->zones = ZoneSetEMPTY;
   gen->capacity = params->capacity;
   gen->mortality = params->mortality;
+  gen->adaptive = FALSE;
+  gen->minCapacity = params->capacity;
+  gen->maxCapacity = params->capacity;
+  gen->collected = ClockNow();
   RingInit(&gen->locusRing);
   RingInit(&gen->segRing);
   gen->sig = GenDescSig;
@@ -283,6 +294,9 @@ Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth)
                "  zones $B\n", (WriteFB)gen->zones,
                "  capacity $W\n", (WriteFW)gen->capacity,
                "  mortality $D\n", (WriteFD)gen->mortality,
+               "  adaptive $S\n", WriteFYesNo(gen->adaptive),
+               "  minCapacity $W\n", (WriteFW)gen->minCapacity,
+               "  maxCapacity $W\n", (WriteFW)gen->maxCapacity,
                NULL);
   if (res != ResOK)
     return res;
@@ -405,6 +419,7 @@ void ChainDestroy(Chain chain)
 
   arena = chain->arena;
   genCount = chain->genCount;
+  MessageDiscardChain(arena, chain);
   RingRemove(&chain->chainRing);
   chain->sig = SigInvalid;
   for (i = 0; i < genCount; ++i)
@@ -440,6 +455,27 @@ GenDesc ChainGen(Chain chain, Index gen)
 }
 
 
+/* chainCollecting -- is a trace collecting this chain in particular?
+ *
+ * A collection of the world is active on every chain, but doesn't
+ * prevent a collection of this chain from starting alongside it. See
+ * <design/trace/#multiple.start>.
+ */
+
+static Bool chainCollecting(Chain chain)
+{
+  TraceId ti;
+  Trace trace;
+
+  TRACE_SET_ITER(ti, trace, chain->activeTraces, chain->arena)
+    if (trace->chain == chain)
+      return TRUE;
+  TRACE_SET_ITER_END(ti, trace, chain->activeTraces, chain->arena);
+
+  return FALSE;
+}
+
+
 /* ChainDeferral -- time until next ephemeral GC for this chain */
 
 double ChainDeferral(Chain chain)
@@ -449,7 +485,7 @@ double ChainDeferral(Chain chain)
 
   AVERT(Chain, chain);
 
-  if (chain->activeTraces == TraceSetEMPTY) {
+  if (!chainCollecting(chain)) {
     for (i = 0; i < chain->genCount; ++i) {
       double genTime = chain->gens[i].capacity * 1024.0
         - (double)GenDescNewSize(&chain->gens[i]);
@@ -478,6 +514,138 @@ void ChainStartTrace(Chain chain, Trace trace)
 }
 
 
+/* GenRetuneMessage -- posted when an adaptive generation is retuned
+ *
+ * See <design/strategy/#policy.gen.message>.
+ */
+
+#define GenRetuneMessageSig ((Sig)0x5199E4E7) /* SIGnature GEN RETune */
+
+typedef struct GenRetuneMessageStruct *GenRetuneMessage;
+
+typedef struct GenRetuneMessageStruct {
+  Sig sig;
+  MessageStruct messageStruct;
+  mps_gen_retune_s retune;      /* what changed */
+} GenRetuneMessageStruct;
+
+#define GenRetuneMessageMessage(genRetuneMessage) \
+  (&((genRetuneMessage)->messageStruct))
+#define MessageGenRetuneMessage(message) \
+  (PARENT(GenRetuneMessageStruct, messageStruct, message))
+
+ATTRIBUTE_UNUSED
+static Bool GenRetuneMessageCheck(GenRetuneMessage grMessage)
+{
+  CHECKS(GenRetuneMessage, grMessage);
+  CHECKD(Message, GenRetuneMessageMessage(grMessage));
+  CHECKL(MessageGetType(GenRetuneMessageMessage(grMessage))
+         == MessageTypeGENRETUNE);
+  CHECKL(grMessage->retune.old_capacity != grMessage->retune.new_capacity);
+  return TRUE;
+}
+
+static void genRetuneMessageDelete(Message message)
+{
+  GenRetuneMessage grMessage;
+  Arena arena;
+
+  grMessage = MessageGenRetuneMessage(message);
+  AVERT(GenRetuneMessage, grMessage);
+
+  arena = MessageArena(message);
+  grMessage->sig = SigInvalid;
+  MessageFinish(message);
+  ControlFree(arena, grMessage, sizeof(GenRetuneMessageStruct));
+}
+
+static void genRetuneMessageRetune(mps_gen_retune_s *retuneReturn,
+                                   Message message)
+{
+  GenRetuneMessage grMessage;
+
+  grMessage = MessageGenRetuneMessage(message);
+  AVERT(GenRetuneMessage, grMessage);
+
+  *retuneReturn = grMessage->retune;
+}
+
+static MessageClassStruct GenRetuneMessageClassStruct = {
+  MessageClassSig,               /* sig */
+  "GenRetune",                   /* name */
+  MessageTypeGENRETUNE,          /* Message Type */
+  genRetuneMessageDelete,        /* Delete */
+  MessageNoFinalizationRef,      /* FinalizationRef */
+  MessageNoGCLiveSize,           /* GCLiveSize */
+  MessageNoGCCondemnedSize,      /* GCCondemnedSize */
+  MessageNoGCNotCondemnedSize,   /* GCNotCondemnedSize */
+  MessageNoGCStartWhy,           /* GCStartWhy */
+  genRetuneMessageRetune,        /* GenRetune */
+  MessageClassSig                /* <design/message/#class.sig.double> */
+};
+
+
+/* genDescRetune -- retune an adaptive generation after a trace
+ *
+ * Ask the policy for a new capacity, based on what the trace found,
+ * and post a message if it changed.  If the message can't be
+ * allocated, the change still happens but is not reported.  See
+ * <design/strategy/#policy.gen>.
+ */
+
+static void genDescRetune(Chain chain, Index i, Trace trace)
+{
+  GenDesc gen;
+  GenTraceStats stats;
+  Size survived, oldCapacity, newCapacity;
+  Clock now;
+  double interval;
+  GenRetuneMessage grMessage;
+  void *p;
+  Res res;
+
+  AVERT(Chain, chain);
+  AVER(i < chain->genCount);
+  AVERT(Trace, trace);
+
+  gen = &chain->gens[i];
+  stats = &gen->trace[trace->ti];
+  if (!gen->adaptive || stats->condemned == 0)
+    return;
+
+  now = ClockNow();
+  interval = now > gen->collected
+    ? (now - gen->collected) / (double)ClocksPerSec() : 0.0;
+  gen->collected = now;
+
+  survived = stats->forwarded + stats->preservedInPlace;
+  oldCapacity = gen->capacity;
+  newCapacity = PolicyGenCapacity(chain->arena, gen, stats->condemned,
+                                  survived, interval);
+  AVER(gen->minCapacity <= newCapacity);
+  AVER(newCapacity <= gen->maxCapacity);
+  if (newCapacity == oldCapacity)
+    return;
+  gen->capacity = newCapacity;
+  EVENT5(ChainRetune, chain, i, oldCapacity, newCapacity, gen->mortality);
+
+  res = ControlAlloc(&p, chain->arena, sizeof(GenRetuneMessageStruct));
+  if (res != ResOK)
+    return;
+  grMessage = p;
+  MessageInit(chain->arena, GenRetuneMessageMessage(grMessage),
+              &GenRetuneMessageClassStruct, MessageTypeGENRETUNE);
+  grMessage->retune.chain = chain;
+  grMessage->retune.gen = i;
+  grMessage->retune.old_capacity = oldCapacity;
+  grMessage->retune.new_capacity = newCapacity;
+  grMessage->retune.mortality = 1.0 - survived / (double)stats->condemned;
+  grMessage->sig = GenRetuneMessageSig;
+  AVERT(GenRetuneMessage, grMessage);
+  MessagePost(chain->arena, GenRetuneMessageMessage(grMessage));
+}
+
+
 /* ChainEndTrace -- called to notify end of GC for this chain */
 
 void ChainEndTrace(Chain chain, Trace trace)
@@ -489,8 +657,48 @@ void ChainEndTrace(Chain chain, Trace trace)
 
   chain->activeTraces = TraceSetDel(chain->activeTraces, trace);
 
-  for (i = 0; i < chain->genCount; ++i)
+  for (i = 0; i < chain->genCount; ++i) {
     genDescEndTrace(&chain->gens[i], trace);
+    genDescRetune(chain, i, trace);
+  }
+}
+
+
+/* ChainAdapt -- start or stop retuning a chain's capacities
+ *
+ * If bounds is NULL, stop retuning (genCount must be zero).
+ * Otherwise bounds points to an array of genCount capacity bounds,
+ * one for each generation, and each generation's capacity is clamped
+ * to its bounds at once.  See <design/strategy/#policy.gen>.
+ */
+
+void ChainAdapt(Chain chain, size_t genCount, GenBounds bounds)
+{
+  size_t i;
+
+  AVERT(Chain, chain);
+
+  if (bounds == NULL) {
+    AVER(genCount == 0);
+    for (i = 0; i < chain->genCount; ++i)
+      chain->gens[i].adaptive = FALSE;
+    return;
+  }
+
+  AVER(genCount == chain->genCount);
+  for (i = 0; i < genCount; ++i) {
+    GenDesc gen = &chain->gens[i];
+    AVER(0 < bounds[i].minCapacity);
+    AVER(bounds[i].minCapacity <= bounds[i].maxCapacity);
+    gen->minCapacity = bounds[i].minCapacity;
+    gen->maxCapacity = bounds[i].maxCapacity;
+    if (gen->capacity < gen->minCapacity)
+      gen->capacity = gen->minCapacity;
+    if (gen->capacity > gen->maxCapacity)
+      gen->capacity = gen->maxCapacity;
+    gen->adaptive = TRUE;
+    AVERT(GenDesc, gen);
+  }
 }
 
 
@@ -887,6 +1095,10 @@ void LocusInit(Arena arena)
   gen->zones = ZoneSetEMPTY;
   gen->capacity = 0; /* unused */
   gen->mortality = 0.5;
+  gen->adaptive = FALSE;
+  gen->minCapacity = 0;
+  gen->maxCapacity = 0;
+  gen->collected = 0;
   RingInit(&gen->locusRing);
   RingInit(&gen->segRing);
   gen->sig = GenDescSig;
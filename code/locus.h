@@ -22,6 +22,17 @@ typedef struct GenParamStruct {
 } GenParamStruct;
 
 
+/* GenBoundsStruct -- structure for bounding adaptive generations */
+/* .gen-bounds: This structure must match <code/mps.h#gen-bounds>. */
+
+typedef struct GenBoundsStruct *GenBounds;
+
+typedef struct GenBoundsStruct {
+  Size minCapacity;             /* smallest capacity in kB */
+  Size maxCapacity;             /* largest capacity in kB */
+} GenBoundsStruct;
+
+
 /* GenTraceStats -- per-generation per-trace statistics */
 
 typedef struct GenTraceStatsStruct *GenTraceStats;
@@ -44,6 +55,10 @@ typedef struct GenDescStruct {
   ZoneSet zones;        /* zoneset for this generation */
   Size capacity;        /* capacity in kB */
   double mortality;     /* predicted mortality */
+  Bool adaptive;        /* retune capacity after collections? */
+  Size minCapacity;     /* smallest adaptive capacity in kB */
+  Size maxCapacity;     /* largest adaptive capacity in kB */
+  Clock collected;      /* when generation was last collected */
   RingStruct locusRing; /* Ring of all PoolGen's in this GenDesc (locus) */
   RingStruct segRing; /* Ring of GCSegs in this generation */
   GenTraceStatsStruct trace[TraceLIMIT];
@@ -100,6 +115,7 @@ extern Res ChainCreate(Chain *chainReturn, Arena arena, size_t genCount,
                        GenParam params);
 extern void ChainDestroy(Chain chain);
 extern Bool ChainCheck(Chain chain);
+extern void ChainAdapt(Chain chain, size_t genCount, GenBounds bounds);
 
 extern double ChainDeferral(Chain chain);
 extern void ChainStartTrace(Chain chain, Trace trace);
@@ -5,10 +5,15 @@
  *
  * This is (not much of) a coverage test for the Leaf Object
  * pool (PoolClassLO).
+ *
+ * test_lazy checks that segments are reclaimed lazily, on demand by
+ * buffer fill and one at a time by mps_arena_step.  See
+ * design.mps.trace.reclaim.lazy.
  */
 
 #include "testlib.h"
 #include "mpslib.h"
+#include "mpm.h"
 #include "mps.h"
 #include "mpsclo.h"
 #include "mpsavm.h"
@@ -42,6 +47,98 @@ static mps_fmt_A_s locv_fmt =
 static mps_addr_t roots[4];
 
 
+/* test_lazy -- check lazy reclaim of LO segments
+ *
+ * Fills lazySEGS segments with small objects, keeping one object in
+ * each segment alive, then collects and steps the trace until it is
+ * reclaiming.
+ */
+
+#define lazySEGS        16
+#define lazyOBJSIZE     ((size_t)64)
+#define lazyFILLSIZE    ((size_t)2048)
+
+static mps_addr_t lazyRoots[lazySEGS];
+
+static Trace lazyTrace(mps_arena_t arena)
+{
+  Arena a = (Arena)arena;
+  TraceId ti;
+  Trace trace, found = NULL;
+
+  TRACE_SET_ITER(ti, trace, a->busyTraces, a)
+    found = trace;
+  TRACE_SET_ITER_END(ti, trace, a->busyTraces, a);
+  return found;
+}
+
+static void test_lazy(mps_arena_t arena, mps_fmt_t format)
+{
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  mps_addr_t p;
+  Trace trace;
+  Count pending;
+  size_t i, j, perSeg = ArenaGrainSize((Arena)arena) / lazyOBJSIZE;
+
+  die(mps_pool_create(&pool, arena, mps_class_lo(), format), "LOCreate");
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "APCreate");
+  die(mps_root_create_table(&root, arena, mps_rank_exact(), (mps_rm_t)0,
+                            lazyRoots, lazySEGS),
+      "RootCreate");
+
+  mps_arena_park(arena);
+  for (i = 0; i < lazySEGS; ++i) {
+    for (j = 0; j < perSeg; ++j) {
+      die(mps_reserve(&p, ap, lazyOBJSIZE), "mps_reserve lazy");
+      *(mps_word_t *)p = lazyOBJSIZE;
+      cdie(mps_commit(ap, p, lazyOBJSIZE), "commit lazy");
+      if (j == 0)
+        lazyRoots[i] = p;
+    }
+  }
+
+  /* Start a collection without releasing the arena (as
+     mps_arena_start_collect would) and step it one piece of work at a
+     time until it starts reclaiming. */
+  ArenaEnter((Arena)arena);
+  die(TraceStartCollectAll(&trace, (Arena)arena,
+                           TraceStartWhyCLIENTFULL_INCREMENTAL),
+      "TraceStartCollectAll");
+  ArenaLeave((Arena)arena);
+  while (trace->state != TraceRECLAIM) {
+    (void)mps_arena_step(arena, 0.0, 0.0);
+    Insist(lazyTrace(arena) == trace);
+  }
+  pending = RingLength(&trace->reclaimRing);
+  Insist(pending >= lazySEGS);
+
+  /* Allocation reclaims just the segment it allocates from. */
+  die(mps_reserve(&p, ap, lazyFILLSIZE), "mps_reserve fill");
+  *(mps_word_t *)p = lazyFILLSIZE;
+  cdie(mps_commit(ap, p, lazyFILLSIZE), "commit fill");
+  Insist(lazyTrace(arena) == trace);
+  Insist(trace->state == TraceRECLAIM);
+  Insist(RingLength(&trace->reclaimRing) == pending - 1);
+
+  /* Each step reclaims one more segment. */
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  Insist(lazyTrace(arena) == trace);
+  Insist(RingLength(&trace->reclaimRing) == pending - 2);
+
+  mps_arena_park(arena);
+  Insist(lazyTrace(arena) == NULL);
+  for (i = 0; i < lazySEGS; ++i)
+    Insist(*(mps_word_t *)lazyRoots[i] == lazyOBJSIZE);
+
+  mps_root_destroy(root);
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  mps_arena_release(arena);
+}
+
+
 int main(int argc, char *argv[])
 {
   mps_arena_t arena;
@@ -90,6 +187,8 @@ int main(int argc, char *argv[])
     mps_arena_formatted_objects_walk(arena, stepper, &count, 0);
     cdie(count == 4, "walk 4 objects");
   }
+
+  test_lazy(arena, format);
   
   mps_ap_destroy(ap);
   mps_pool_destroy(pool);
@@ -74,6 +74,7 @@ Bool MessageClassCheck(MessageClass klass)
   CHECKL(FUNCHECK(klass->gcCondemnedSize));
   CHECKL(FUNCHECK(klass->gcNotCondemnedSize));
   CHECKL(FUNCHECK(klass->gcStartWhy));
+  CHECKL(FUNCHECK(klass->genRetune));
   CHECKL(klass->endSig == MessageClassSig);
 
   return TRUE;
@@ -177,6 +178,29 @@ void MessageEmpty(Arena arena)
   }
 }
 
+/* Discard the queued generation retune messages about a chain, which
+ * is being destroyed, so that none can be received that refers to
+ * it.  See <design/strategy/#policy.gen.message>. */
+void MessageDiscardChain(Arena arena, Chain chain)
+{
+  Ring node, next;
+
+  AVERT(Arena, arena);
+  AVER(chain != NULL);
+
+  RING_FOR(node, &arena->messageRing, next) {
+    Message message = MessageNodeMessage(node);
+    if (MessageGetType(message) == MessageTypeGENRETUNE) {
+      mps_gen_retune_s retune;
+      MessageGenRetune(&retune, message);
+      if (retune.chain == chain) {
+        RingRemove(&message->queueRing);
+        MessageDelete(message);
+      }
+    }
+  }
+}
+
 
 /* Delivery (Client) Interface -- functions for recipient
  *
@@ -368,6 +392,15 @@ const char *MessageGCStartWhy(Message message)
   return (*message->klass->gcStartWhy)(message);
 }
 
+void MessageGenRetune(mps_gen_retune_s *retuneReturn, Message message)
+{
+  AVER(retuneReturn != NULL);
+  AVERT(Message, message);
+  AVER(MessageGetType(message) == MessageTypeGENRETUNE);
+
+  (*message->klass->genRetune)(retuneReturn, message);
+}
+
 
 /* Message Method Stubs, Type-specific
  *
@@ -424,6 +457,16 @@ const char *MessageNoGCStartWhy(Message message)
   return NULL;
 }
 
+void MessageNoGenRetune(mps_gen_retune_s *retuneReturn, Message message)
+{
+  AVER(retuneReturn != NULL);
+  AVERT(Message, message);
+  UNUSED(retuneReturn);
+  UNUSED(message);
+
+  NOTREACHED;
+}
+
 
 /* C. COPYRIGHT AND LICENSE
  *
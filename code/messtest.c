@@ -37,6 +37,7 @@ static MessageClassStruct DFMessageClassStruct = {
   MessageNoGCCondemnedSize,    /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize, /* GCNotCondemnedSize */
   MessageNoGCStartWhy,         /* GCStartWhy */
+  MessageNoGenRetune,          /* GenRetune */
   MessageClassSig              /* <design/message/#class.sig.double> */
 };
 
@@ -53,6 +54,7 @@ static MessageClassStruct DGCMessageClassStruct = {
   MessageNoGCCondemnedSize,    /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize, /* GCNoteCondemnedSize */
   MessageNoGCStartWhy,         /* GCStartWhy */
+  MessageNoGenRetune,          /* GenRetune */
   MessageClassSig              /* <design/message/#class.sig.double> */
 };
 
@@ -18,6 +18,7 @@
 
 #include "event.h"
 #include "lock.h"
+#include "work.h"
 #include "prmc.h"
 #include "prot.h"
 #include "sp.h"
@@ -133,6 +134,11 @@ extern int (AddrComp)(Addr a, Addr b, Size size);
 #define ClockNow() ((Clock)mps_clock())
 #define ClocksPerSec() ((Clock)mps_clocks_per_sec())
 
+/* Wall clock -- see <design/arena/#pause.clock> */
+
+extern Clock WallClockNow(void);
+extern Clock WallClocksPerSec(void);
+
 
 /* Result codes */
 
@@ -220,6 +226,8 @@ extern void PoolDestroy(Pool pool);
 extern BufferClass PoolDefaultBufferClass(Pool pool);
 extern Res PoolAlloc(Addr *pReturn, Pool pool, Size size);
 extern void PoolFree(Pool pool, Addr old, Size size);
+extern Bool PoolAllocFast(Addr *pReturn, Pool pool, Size size);
+extern Bool PoolFreeFast(Pool pool, Addr old, Size size);
 extern Res PoolTraceBegin(Pool pool, Trace trace);
 extern Res PoolAccess(Pool pool, Seg seg, Addr addr,
                       AccessSet mode, MutatorContext context);
@@ -233,6 +241,7 @@ extern void PoolReclaim(Pool pool, Trace trace, Seg seg);
 extern void PoolWalk(Pool pool, Seg seg, FormattedObjectsVisitor f,
                      void *v, size_t s);
 extern void PoolFreeWalk(Pool pool, FreeBlockVisitor f, void *p);
+extern Res PoolAddrObject(Addr *pReturn, Pool pool, Seg seg, Addr addr);
 extern Size PoolTotalSize(Pool pool);
 extern Size PoolFreeSize(Pool pool);
 
@@ -242,6 +251,8 @@ extern Res PoolNoAlloc(Addr *pReturn, Pool pool, Size size);
 extern Res PoolTrivAlloc(Addr *pReturn, Pool pool, Size size);
 extern void PoolNoFree(Pool pool, Addr old, Size size);
 extern void PoolTrivFree(Pool pool, Addr old, Size size);
+extern Bool PoolNoAllocFast(Addr *pReturn, Pool pool, Size size);
+extern Bool PoolNoFreeFast(Pool pool, Addr old, Size size);
 extern Res PoolNoBufferFill(Addr *baseReturn, Addr *limitReturn,
                             Pool pool, Buffer buffer, Size size);
 extern Res PoolTrivBufferFill(Addr *baseReturn, Addr *limitReturn,
@@ -279,6 +290,7 @@ extern Res PoolTrivFramePop(Pool pool, Buffer buf, AllocFrame frame);
 extern void PoolNoWalk(Pool pool, Seg seg, FormattedObjectsVisitor f,
                        void *p, size_t s);
 extern void PoolTrivFreeWalk(Pool pool, FreeBlockVisitor f, void *p);
+extern Res PoolTrivAddrObject(Addr *pReturn, Pool pool, Seg seg, Addr addr);
 extern PoolDebugMixin PoolNoDebugMixin(Pool pool);
 extern BufferClass PoolNoBufferClass(void);
 extern Size PoolNoSize(Pool pool);
@@ -311,6 +323,7 @@ extern Arena MessageArena(Message message);
 extern Bool MessageOnQueue(Message message);
 extern void MessagePost(Arena arena, Message message);
 extern void MessageEmpty(Arena arena);
+extern void MessageDiscardChain(Arena arena, Chain chain);
 /* -- Delivery (Client) Interface -- functions for recipient */
 extern void MessageTypeEnable(Arena arena, MessageType type);
 extern void MessageTypeDisable(Arena arena, MessageType type);
@@ -330,6 +343,8 @@ extern Size MessageGCLiveSize(Message message);
 extern Size MessageGCCondemnedSize(Message message);
 extern Size MessageGCNotCondemnedSize(Message message);
 extern const char *MessageGCStartWhy(Message message);
+extern void MessageGenRetune(mps_gen_retune_s *retuneReturn,
+                             Message message);
 /* -- Message Method Stubs, Type-specific */
 extern void MessageNoFinalizationRef(Ref *refReturn,
                                      Arena arena, Message message);
@@ -337,6 +352,8 @@ extern Size MessageNoGCLiveSize(Message message);
 extern Size MessageNoGCCondemnedSize(Message message);
 extern Size MessageNoGCNotCondemnedSize(Message message);
 extern const char *MessageNoGCStartWhy(Message message);
+extern void MessageNoGenRetune(mps_gen_retune_s *retuneReturn,
+                               Message message);
 
 
 /* Trace Interface -- see <code/trace.c> */
@@ -367,6 +384,12 @@ extern void ScanStateFinish(ScanState ss);
 extern Bool ScanStateCheck(ScanState ss);
 extern void ScanStateSetSummary(ScanState ss, RefSet summary);
 extern RefSet ScanStateSummary(ScanState ss);
+extern void ScanStateSharedClaim(ScanState ss);
+extern void ScanStateSharedRelease(ScanState ss);
+extern Bool ScanStateExpose(ScanState ss, Seg seg, AccessSet mode);
+extern void ScanStateCover(ScanState ss, Seg seg);
+extern Bool ScanStateExposeHeld(ScanState ss, Seg seg);
+extern void ScanStateCoverHeld(ScanState ss);
 
 /* See impl.h.mpmst.ss */
 #define ScanStateZoneShift(ss)             ((Shift)(ss)->ss_s._zs)
@@ -391,11 +414,18 @@ extern Res TraceStart(Trace trace, double mortality, double finishingTime);
 extern Bool TracePoll(Work *workReturn, Bool *collectWorldReturn,
                       Globals globals, Bool collectWorldAllowed);
 
-extern Rank TraceRankForAccess(Arena arena, Seg seg);
+extern Rank TraceRankForAccess(Trace trace, Seg seg);
 extern void TraceSegAccess(Arena arena, Seg seg, AccessSet mode);
+extern Res TraceSingleAccess(Arena arena, Seg seg, Addr addr,
+                             AccessSet mode, MutatorContext context);
+extern Bool TraceSegCanSingleAccess(Seg seg);
+extern void TraceSegNoteSingleAccess(Seg seg);
 
 extern void TraceAdvance(Trace trace);
+extern Bool TraceReclaimSeg(Seg seg);
 extern Res TraceStartCollectAll(Trace *traceReturn, Arena arena, int why);
+extern Res TraceBatchCreate(TraceBatch *batchReturn, Arena arena);
+extern void TraceBatchDestroy(TraceBatch batch, Arena arena);
 extern Res TraceDescribe(Trace trace, mps_lib_FILE *stream, Count depth);
 
 /* traceanc.c -- Trace Ancillary */
@@ -463,6 +493,8 @@ extern double TraceWorkFactor;
     } \
   END
 
+extern Res TraceFixArea(ScanState ss, Word *base, Word *limit,
+                        Word mask, Word select, Word pattern);
 extern Res TraceScanArea(ScanState ss, Word *base, Word *limit,
                          mps_area_scan_t scan_area,
                          void *closure);
@@ -477,6 +509,10 @@ DECLARE_CLASS(Arena, AbstractArena, Inst);
 extern Bool ArenaClassCheck(ArenaClass klass);
 
 extern Bool ArenaCheck(Arena arena);
+/* .chunk.index.many: sentinel for chunk index entries that map to
+ * several chunks.  See <design/arena/#chunk.index>. */
+extern ChunkStruct ArenaChunkIndexManyStruct;
+
 extern Res ArenaCreate(Arena *arenaReturn, ArenaClass klass, ArgList args);
 extern void ArenaDestroy(Arena arena);
 extern Res ArenaDescribe(Arena arena, mps_lib_FILE *stream, Count depth);
@@ -484,6 +520,17 @@ extern Res ArenaDescribeTracts(Arena arena, mps_lib_FILE *stream, Count depth);
 extern Bool ArenaAccess(Addr addr, AccessSet mode, MutatorContext context);
 extern Res ArenaFreeLandInsert(Arena arena, Addr base, Addr limit);
 extern void ArenaFreeLandDelete(Arena arena, Addr base, Addr limit);
+extern Res ArenaCardsCreate(Arena arena);
+extern void ArenaCardsDestroy(Arena arena);
+extern Bool ArenaCardsFirstDirty(Addr *cardReturn, Arena arena, Chunk chunk,
+                                 Addr base, Addr limit);
+extern Bool ArenaCardsDirty(Arena arena, Addr base, Addr limit);
+extern void ArenaCardsClear(Arena arena);
+extern Bool ArenaDirty(Arena arena, Addr base, Addr limit);
+extern void ArenaDirtyCacheInit(Arena arena);
+extern Bool ArenaDirtyCached(Arena arena, Addr base, Addr limit);
+extern void ArenaDirtyClear(Arena arena);
+extern Addr ArenaDirtyLimit(Arena arena, Addr base, Addr limit);
 
 extern Bool GlobalsCheck(Globals arena);
 extern Res GlobalsInit(Globals arena);
@@ -507,6 +554,17 @@ extern Ring GlobalsRememberedSummaryRing(Globals);
 #define ArenaPoolRing(arena) (&ArenaGlobals(arena)->poolRing)
 #define ArenaChunkTree(arena) RVALUE((arena)->chunkTree)
 #define ArenaChunkRing(arena) RVALUE(&(arena)->chunkRing)
+#define ArenaChunkIndexMANY (&ArenaChunkIndexManyStruct)
+#define ArenaChunkIndexOfAddr(addr) \
+  ((Index)((Word)(addr) >> ARENA_CHUNK_INDEX_SHIFT) \
+   & (ARENA_CHUNK_INDEX_LENGTH - 1))
+#define ArenaChunkIndexEntry(arena, addr) \
+  ((Chunk)LOAD_ACQUIRE((arena)->chunkIndex[ArenaChunkIndexOfAddr(addr)]))
+#define ArenaCardMarking(arena) RVALUE((arena)->cardMarking)
+#define ArenaCards(arena)       (&(arena)->cardsStruct)
+#define ArenaSoftDirty(arena)   RVALUE((arena)->softDirty)
+#define ArenaTracksDirty(arena) \
+  RVALUE((arena)->cardMarking || (arena)->softDirty)
 #define ArenaShield(arena)      (&(arena)->shieldStruct)
 #define ArenaHistory(arena)     (&(arena)->historyStruct)
 
@@ -535,6 +593,8 @@ extern void ArenaEnterRecursive(Arena arena);
 extern void ArenaLeaveRecursive(Arena arena);
 
 extern Bool (ArenaStep)(Globals globals, double interval, double multiplier);
+extern int ArenaCollectUntil(Globals globals, Clock deadline,
+                             unsigned flags);
 extern void ArenaClamp(Globals globals);
 extern void ArenaRelease(Globals globals);
 extern void ArenaPark(Globals globals);
@@ -600,6 +660,15 @@ extern Size ArenaSpareCommitLimit(Arena arena);
 extern void ArenaSetSpareCommitLimit(Arena arena, Size limit);
 extern double ArenaPauseTime(Arena arena);
 extern void ArenaSetPauseTime(Arena arena, double pauseTime);
+extern void ArenaPauseRecord(Arena arena, PauseKind kind,
+                             Clock start, Clock end);
+extern void ArenaPauseStats(mps_pause_stats_s *statsReturn, Arena arena,
+                            PauseKind kind);
+extern Count ArenaWindowStats(mps_window_stats_s *statsReturn, Count count,
+                              Arena arena);
+extern double ArenaMMU(Arena arena);
+extern void ArenaPauseStatsReset(Arena arena);
+extern double PauseBucketLimit(Index bucket);
 extern Size ArenaNoPurgeSpare(Arena arena, Size size);
 extern Res ArenaNoGrow(Arena arena, LocusPref pref, Size size);
 
@@ -609,6 +678,8 @@ extern Size ArenaCollectable(Arena arena);
 extern Res ArenaExtend(Arena, Addr base, Size size);
 
 extern void ArenaCompact(Arena arena, Trace trace);
+extern Size ArenaReleaseSpare(Arena arena);
+extern Bool ArenaPressurePoll(Arena arena, Clock now);
 
 extern Res ArenaFinalize(Arena arena, Ref obj);
 extern Res ArenaDefinalize(Arena arena, Ref obj);
@@ -626,12 +697,25 @@ extern Res ArenaNoExtend(Arena arena, Addr base, Size size);
 
 extern Res PolicyAlloc(Tract *tractReturn, Arena arena, LocusPref pref,
                        Size size, Pool pool);
-extern Bool PolicyShouldCollectWorld(Arena arena, double availableTime,
-                                     Clock now, Clock clocks_per_sec);
 extern Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
                              Arena arena, Bool collectWorldAllowed);
+extern Bool PolicyStepTrace(Trace *traceReturn, Arena arena,
+                            double stepTime, Clock now);
+extern Bool PolicyIdleTrace(Trace *traceReturn, Arena arena,
+                            double idleTime, Clock now,
+                            Bool worldAllowed, Bool chainAllowed);
+extern Bool PolicyPressureTrace(Trace *traceReturn, Arena arena,
+                                Clock now);
+extern Size PolicyGenCapacity(Arena arena, GenDesc gen, Size condemned,
+                              Size survived, double interval);
 extern Bool PolicyPoll(Arena arena);
-extern Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork);
+extern double PolicyPollTime(Arena arena);
+extern Bool PolicyPollAgain(Arena arena, Clock start, double pollTime,
+                            Bool moreWork, Work tracedWork);
+extern void PolicyInfo(mps_policy_info_s *infoReturn, Arena arena);
+extern Bool PolicyCheck(Policy policy);
+extern Res PolicyCreate(Policy *policyReturn, Arena arena, ArgList args);
+extern void PolicyDestroy(Policy policy);
 
 
 /* Locus interface */
@@ -666,6 +750,8 @@ extern Res SegSplit(Seg *segLoReturn, Seg *segHiReturn, Seg seg, Addr at);
 extern Res SegAbsDescribe(Inst seg, mps_lib_FILE *stream, Count depth);
 extern Res SegDescribe(Seg seg, mps_lib_FILE *stream, Count depth);
 extern void SegSetSummary(Seg seg, RefSet summary);
+extern void SegSetWritten(Seg seg);
+extern void SegClearWritten(Seg seg);
 extern Bool SegHasBuffer(Seg seg);
 extern Bool SegBuffer(Buffer *bufferReturn, Seg seg);
 extern void SegSetBuffer(Seg seg, Buffer buffer);
@@ -696,12 +782,21 @@ extern Addr (SegLimit)(Seg seg);
 #define SegGrey(seg)            RVALUE((TraceSet)(seg)->grey)
 #define SegWhite(seg)           RVALUE((TraceSet)(seg)->white)
 #define SegNailed(seg)          RVALUE((TraceSet)(seg)->nailed)
+#define SegSingleAccesses(seg)  RVALUE((Count)(seg)->singleAccesses)
+#define SegWritten(seg)         RVALUE((Bool)(seg)->written)
+#define SegTracksDirty(seg, arena) \
+  RVALUE(ArenaCardMarking(arena) \
+         || (ArenaSoftDirty(arena) && !SegWritten(seg)))
 #define SegPoolRing(seg)        RVALUE(&(seg)->poolRing)
 #define SegOfPoolRing(node)     RING_ELT(Seg, poolRing, (node))
 #define SegOfGreyRing(node)     (&(RING_ELT(GCSeg, greyRing, (node)) \
                                    ->segStruct))
 
+#define SegOfReclaimRing(node)  (&(RING_ELT(GCSeg, reclaimRing, (node)) \
+                                   ->segStruct))
+
 #define SegSummary(seg)         (((GCSeg)(seg))->summary)
+#define SegReclaimPending(seg)  (!RingIsSingle(&((GCSeg)(seg))->reclaimRing))
 
 #define SegSetPM(seg, mode)     ((void)((seg)->pm = BS_BITFIELD(Access, (mode))))
 #define SegSetSM(seg, mode)     ((void)((seg)->sm = BS_BITFIELD(Access, (mode))))
@@ -730,6 +825,7 @@ extern Res BufferReserve(Addr *pReturn, Buffer buffer, Size size);
    BufferFill(pReturn, buffer, size))
 
 extern Res BufferFill(Addr *pReturn, Buffer buffer, Size size);
+extern Size BufferRefillSize(Buffer buffer, Size size);
 
 extern Bool BufferCommit(Buffer buffer, Addr p, Size size);
 /* macro equivalent for BufferCommit, keep in sync with <code/buffer.c> */
@@ -954,11 +1050,13 @@ extern AccessSet RootPM(Root root);
 extern RefSet RootSummary(Root root);
 extern void RootGrey(Root root, Trace trace);
 extern Res RootScan(ScanState ss, Root root);
+extern Bool RootParallel(Root root);
 extern Arena RootArena(Root root);
 extern Bool RootOfAddr(Root *root, Arena arena, Addr addr);
 extern void RootAccess(Root root, AccessSet mode);
 typedef Res (*RootIterateFn)(Root root, void *p);
 extern Res RootsIterate(Globals arena, RootIterateFn f, void *p);
+extern void RootsStackDirty(Globals arenaGlobals);
 
 
 /* Land Interface -- see <design/land/> */
@@ -176,6 +176,7 @@ static void testInArena(mps_arena_class_t arena_class, mps_arg_s *arena_args,
     MPS_ARGS_ADD(args, MPS_KEY_MVFF_SLOT_HIGH, TRUE);
     MPS_ARGS_ADD(args, MPS_KEY_MVFF_FIRST_FIT, TRUE);
     MPS_ARGS_ADD(args, MPS_KEY_SPARE, rnd_double());
+    MPS_ARGS_ADD(args, MPS_KEY_MVFF_THREAD_CACHES, 1 + rnd() % 4);
     die(stress(arena, NULL, randomSize8, align, "MVFF",
                mps_class_mvff(), args), "stress MVFF");
   } MPS_ARGS_END(args);
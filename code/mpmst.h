@@ -57,6 +57,8 @@ typedef struct mps_pool_class_s {
   PoolInitMethod init;          /* initialize the pool descriptor */
   PoolAllocMethod alloc;        /* allocate memory from pool */
   PoolFreeMethod free;          /* free memory to pool */
+  PoolAllocFastMethod allocFast; /* allocate without the arena lock */
+  PoolFreeFastMethod freeFast;  /* free without the arena lock */
   PoolBufferFillMethod bufferFill;      /* out-of-line reserve */
   PoolBufferEmptyMethod bufferEmpty;    /* out-of-line commit */
   PoolAccessMethod access;      /* handles read/write accesses */
@@ -73,6 +75,7 @@ typedef struct mps_pool_class_s {
   PoolFramePopMethod framePop;  /* pop an allocation frame */
   PoolWalkMethod walk;          /* walk over a segment */
   PoolFreeWalkMethod freewalk;  /* walk over free blocks */
+  PoolAddrObjectMethod addrObject; /* find object containing address */
   PoolBufferClassMethod bufferClass; /* default BufferClass of pool */
   PoolDebugMixinMethod debugMixin; /* find the debug mixin, if any */
   PoolSizeMethod totalSize;     /* total memory allocated from arena */
@@ -186,6 +189,9 @@ typedef struct MessageClassStruct {
   /* methods specific to MessageTypeGCSTART */
   MessageGCStartWhyMethod gcStartWhy;
 
+  /* methods specific to MessageTypeGENRETUNE */
+  MessageGenRetuneMethod genRetune;
+
   Sig endSig;                   /* <design/message/#class.sig.double> */
 } MessageClassStruct;
 
@@ -247,6 +253,7 @@ typedef struct SegStruct {      /* segment structure */
   Addr limit;                   /* limit of segment */
   unsigned depth : ShieldDepthWIDTH; /* see design.mps.shield.def.depth */
   BOOLFIELD(queued);            /* in shield queue? */
+  BOOLFIELD(written);           /* <design/write-barrier/#soft-dirty.written> */
   AccessSet pm : AccessLIMIT;   /* protection mode, <code/shield.c> */
   AccessSet sm : AccessLIMIT;   /* shield mode, <code/shield.c> */
   TraceSet grey : TraceLIMIT;   /* traces for which seg is grey */
@@ -254,6 +261,8 @@ typedef struct SegStruct {      /* segment structure */
   TraceSet nailed : TraceLIMIT; /* traces for which seg has nailed objects */
   RankSet rankSet : RankLIMIT;  /* ranks of references in this seg */
   unsigned defer : WB_DEFER_BITS; /* defer write barrier for this many scans */
+  unsigned singleAccesses : SINGLE_ACCESS_BITS; /* since last scan */
+  unsigned singleLimit : SINGLE_ACCESS_BITS; /* budget for singleAccesses */
 } SegStruct;
 
 
@@ -270,6 +279,7 @@ typedef struct GCSegStruct {    /* GC segment structure */
   RefSet summary;               /* summary of references out of seg */
   Buffer buffer;                /* non-NULL if seg is buffered */
   RingStruct genRing;           /* link in list of segs in gen */
+  RingStruct reclaimRing;       /* link in trace's segs awaiting reclaim */
   Sig sig;                      /* <design/sig/> */
 } GCSegStruct;
 
@@ -345,6 +355,8 @@ typedef struct BufferStruct {
   Addr poolLimit;               /* the pool's idea of the limit */
   Align alignment;              /* allocation alignment */
   unsigned rampCount;           /* see <code/buffer.c#ramp.hack> */
+  Count refills;                /* refills since refillEpoch */
+  Epoch refillEpoch;            /* <design/buffer/#refill.size> */
 } BufferStruct;
 
 
@@ -389,6 +401,24 @@ typedef struct mps_fmt_s {
 } FormatStruct;
 
 
+/* PolicyStruct -- client collection policy
+ *
+ * A policy installed by the client to override the decisions in
+ * <code/policy.c>.  Any of the functions may be NULL, meaning that
+ * the default decision stands.  See <design/strategy/#policy.client>.  */
+
+#define PolicySig       ((Sig)0x519B011C) /* SIGnature POLICy */
+
+typedef struct mps_policy_s {
+  Sig sig;
+  Arena arena;                  /* owning arena */
+  mps_policy_start_t start;     /* should a trace start? */
+  mps_policy_condemn_t condemn; /* which generations to condemn? */
+  mps_policy_poll_t poll;       /* how long to work for in a poll? */
+  void *closure;                /* passed to the functions */
+} PolicyStruct;
+
+
 /* ScanState
  *
  * .ss: See <code/trace.c>.
@@ -432,6 +462,11 @@ typedef struct ScanStateStruct {
   STATISTIC_DECL(Count preservedInPlaceCount) /* objects preserved in place */
   STATISTIC_DECL(Size copiedSize) /* bytes copied */
   Size scannedSize;             /* bytes scanned */
+  Lock fixLock;                 /* <design/trace/#parallel.fix> */
+  Count sharedDepth;            /* nesting of ScanStateSharedClaim */
+  Index worker;                 /* collector thread, see WorkersJob */
+  Count exposedCount;           /* number of segments in exposed */
+  Seg exposed[TRACE_PARALLEL_EXPOSED]; /* see ScanStateExposeHeld */
 } ScanStateStruct;
 
 
@@ -481,6 +516,8 @@ typedef struct TraceStruct {
   Size preservedInPlaceSize;    /* bytes preserved in place */
   STATISTIC_DECL(Count reclaimCount) /* segments reclaimed */
   STATISTIC_DECL(Count reclaimSize) /* bytes reclaimed */
+  RingStruct reclaimRing;       /* segs awaiting lazy reclaim */
+  Size lazyReclaimSize;         /* total size of segs reclaimed lazily */
 } TraceStruct;
 
 
@@ -676,6 +713,19 @@ typedef struct SortStruct {
 } SortStruct;
 
 
+/* ProtDirtyCacheStruct -- soft-dirty bits read ahead
+ *
+ * See <design/prot/#if.dirty.cached>.
+ */
+
+typedef struct ProtDirtyCacheStruct {
+  Word epoch;                   /* epoch the bits are relative to */
+  Word pageBase;                /* first page with bits read */
+  Word pageLimit;               /* limit of pages with bits read */
+  Word dirty[PROT_DIRTY_CACHE_PAGES / MPS_WORD_WIDTH]; /* bit per page */
+} ProtDirtyCacheStruct;
+
+
 /* ShieldStruct -- per-arena part of the shield
  *
  * See design.mps.shield, impl.c.shield.
@@ -737,6 +787,31 @@ typedef struct mps_arena_s {
   Size spareCommitted;          /* Amount of memory in hysteresis fund */
   Size spareCommitLimit;        /* Limit on spareCommitted */
   double pauseTime;             /* Maximum pause time, in seconds. */
+  Count gcThreads;              /* <design/trace/#parallel> */
+  Bool backgroundCollect;       /* <design/trace/#background> */
+  Bool cardMarking;             /* <design/write-barrier/#card> */
+  mps_cards_s cardsStruct;      /* card tables, <design/write-barrier/#card> */
+  unsigned char *cardsMany;     /* <design/write-barrier/#card.many> */
+  unsigned char cardNone;       /* <design/write-barrier/#card.none> */
+  unsigned char *cardNoneStripe; /* <design/write-barrier/#card.none> */
+  Bool softDirty;               /* <design/write-barrier/#soft-dirty> */
+  Bool fixPrefetch;             /* <design/scan/#fix-area.prefetch> */
+  Word softDirtyEpoch;          /* epoch of last ProtDirtyClear */
+  ProtDirtyCacheStruct softDirtyCacheStruct; /* read at flip */
+  mps_pressure_t pressure;      /* <design/arena/#pressure>, or NULL */
+  void *pressureClosure;        /* closure argument for pressure */
+  Clock pressureRead;           /* when pressure was last called */
+  Bool underPressure;           /* is the system short of memory? */
+  Size pressureSpareLimit;      /* spare commit limit to restore */
+
+  /* pause statistics, <design/arena/#pause> */
+  mps_pause_stats_s pauseStats[PauseKindLIMIT];
+  Clock windowStart;            /* when the current window started */
+  double windowFill;            /* fillMutatorSize at windowStart */
+  double windowPaused;          /* pause time in current window, in secs */
+  Count windowCount;            /* number of windows in window[] */
+  Index windowNext;             /* where the next window goes */
+  mps_window_stats_s window[ARENA_WINDOW_COUNT]; /* closed windows */
 
   Shift zoneShift;              /* see also <code/ref.c> */
   Size grainSize;               /* <design/arena/#grain> */
@@ -747,6 +822,7 @@ typedef struct mps_arena_s {
   Chunk primary;                /* the primary chunk */
   RingStruct chunkRing;         /* all the chunks, in a ring for iteration */
   Tree chunkTree;               /* all the chunks, in a tree for fast lookup */
+  Chunk chunkIndex[ARENA_CHUNK_INDEX_LENGTH]; /* <design/arena/#chunk.index> */
   Serial chunkSerial;           /* next chunk number */
 
   Bool hasFreeLand;              /* Is freeLand available? */
@@ -783,6 +859,9 @@ typedef struct mps_arena_s {
   TraceSet flippedTraces;       /* set of running and flipped traces */
   TraceStruct trace[TraceLIMIT]; /* trace structures.  See
                                    <design/trace/#intance.limit> */
+  Workers workers;              /* collector threads, or NULL */
+  TraceBatch traceBatch;        /* parallel scan batches, with workers */
+  Background background;        /* background collector, or NULL */
 
   /* trace ancillary fields (<code/traceanc.c>) */
   TraceStartMessage tsMessage[TraceLIMIT];  /* <design/message-gc/> */
@@ -792,6 +871,7 @@ typedef struct mps_arena_s {
   double tracedWork;
   double tracedTime;
   Clock lastWorldCollect;
+  Policy policy;                /* client policy, or NULL */
 
   RingStruct greyRing[RankLIMIT]; /* ring of grey segments at each rank */
   STATISTIC_DECL(Count writeBarrierHitCount) /* write barrier hits */
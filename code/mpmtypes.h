@@ -56,6 +56,7 @@ typedef Word ZoneSet;                   /* design.mps.refset */
 typedef unsigned Rank;
 typedef unsigned RankSet;
 typedef unsigned RootMode;
+typedef unsigned PauseKind;             /* <design/arena/#pause> */
 typedef Size Epoch;                     /* design.mps.ld */
 typedef unsigned TraceId;               /* <design/trace/> */
 typedef unsigned TraceSet;              /* <design/trace/> */
@@ -72,12 +73,14 @@ typedef struct BufferClassStruct *BufferClass; /* <design/buffer/> */
 typedef unsigned BufferMode;            /* <design/buffer/> */
 typedef struct mps_fmt_s *Format;       /* design.mps.format */
 typedef struct LockStruct *Lock;        /* <code/lock.c>* */
+typedef struct ProtDirtyCacheStruct *ProtDirtyCache; /* <design/prot/> */
 typedef struct mps_pool_s *Pool;        /* <design/pool/> */
 typedef Pool AbstractPool;
 typedef struct mps_pool_class_s *PoolClass;  /* <code/poolclas.c> */
 typedef struct TraceStruct *Trace;      /* <design/trace/> */
 typedef struct ScanStateStruct *ScanState; /* <design/trace/> */
 typedef struct mps_chain_s *Chain;      /* <design/trace/> */
+typedef struct mps_policy_s *Policy;    /* <design/strategy/#policy.client> */
 typedef struct TractStruct *Tract;      /* <design/arena/> */
 typedef struct ChunkStruct *Chunk;      /* <code/tract.c> */
 typedef struct ChunkCacheEntryStruct *ChunkCacheEntry; /* <code/tract.c> */
@@ -94,6 +97,9 @@ typedef struct GlobalsStruct *Globals;  /* <design/arena/> */
 typedef struct VMStruct *VM;            /* <code/vm.c>* */
 typedef struct RootStruct *Root;        /* <code/root.c> */
 typedef struct mps_thr_s *Thread;       /* <code/th.c>* */
+typedef struct WorkersStruct *Workers;  /* <code/work.h> */
+typedef struct TraceBatchStruct *TraceBatch; /* <code/trace.c> */
+typedef struct BackgroundStruct *Background; /* <code/work.h> */
 typedef struct MutatorContextStruct *MutatorContext; /* <design/prmc/> */
 typedef struct PoolDebugMixinStruct *PoolDebugMixin;
 typedef struct AllocPatternStruct *AllocPattern;
@@ -186,6 +192,8 @@ typedef void (*PoolVarargsMethod)(ArgStruct args[], va_list varargs);
 typedef Res (*PoolInitMethod)(Pool pool, Arena arena, PoolClass klass, ArgList args);
 typedef Res (*PoolAllocMethod)(Addr *pReturn, Pool pool, Size size);
 typedef void (*PoolFreeMethod)(Pool pool, Addr old, Size size);
+typedef Bool (*PoolAllocFastMethod)(Addr *pReturn, Pool pool, Size size);
+typedef Bool (*PoolFreeFastMethod)(Pool pool, Addr old, Size size);
 typedef Res (*PoolBufferFillMethod)(Addr *baseReturn, Addr *limitReturn,
                                     Pool pool, Buffer buffer, Size size);
 typedef void (*PoolBufferEmptyMethod)(Pool pool, Buffer buffer,
@@ -208,6 +216,8 @@ typedef Res (*PoolFramePopMethod)(Pool pool, Buffer buf,
 typedef void (*PoolWalkMethod)(Pool pool, Seg seg, FormattedObjectsVisitor f,
                                void *v, size_t s);
 typedef void (*PoolFreeWalkMethod)(Pool pool, FreeBlockVisitor f, void *p);
+typedef Res (*PoolAddrObjectMethod)(Addr *pReturn, Pool pool, Seg seg,
+                                    Addr addr);
 typedef BufferClass (*PoolBufferClassMethod)(void);
 typedef PoolDebugMixin (*PoolDebugMixinMethod)(Pool pool);
 typedef Size (*PoolSizeMethod)(Pool pool);
@@ -231,6 +241,8 @@ typedef Size (*MessageGCLiveSizeMethod)(Message message);
 typedef Size (*MessageGCCondemnedSizeMethod)(Message message);
 typedef Size (*MessageGCNotCondemnedSizeMethod)(Message message);
 typedef const char * (*MessageGCStartWhyMethod)(Message message);
+typedef void (*MessageGenRetuneMethod)
+  (mps_gen_retune_s *retuneReturn, Message message);
 
 /* Message Types -- <design/message/> and elsewhere */
 
@@ -275,7 +287,11 @@ typedef Res (*LandFindInZonesMethod)(Bool *foundReturn, Range rangeReturn, Range
 #define AttrFMT         ((Attr)(1<<0))  /* <design/type/#attr> */
 #define AttrGC          ((Attr)(1<<1))
 #define AttrMOVINGGC    ((Attr)(1<<2))
-#define AttrMASK        (AttrFMT | AttrGC | AttrMOVINGGC)
+#define AttrPARALLEL    ((Attr)(1<<3))
+#define AttrLAZY        ((Attr)(1<<4))
+#define AttrPARALLELFIX ((Attr)(1<<5))
+#define AttrMASK        (AttrFMT | AttrGC | AttrMOVINGGC | AttrPARALLEL \
+                         | AttrLAZY | AttrPARALLELFIX)
 
 
 /* Locus preferences */
@@ -308,6 +324,19 @@ enum {
 };
 
 
+/* Pause kinds */
+/* .pause: Synchronize with <code/mps.h#pause>. */
+/* This is checked by <code/mpsi.c#check>. */
+
+enum {
+  PauseKindPOLL = 0,
+  PauseKindFLIP,
+  PauseKindACCESS,
+  PauseKindFINALIZE,
+  PauseKindLIMIT
+};
+
+
 /* Root Modes -- not implemented */
 /* .rm: Synchronize with <code/mps.h#rm>. */
 /* This comment exists as a placeholder for when root modes are */
@@ -365,6 +394,7 @@ enum {
   TraceStartWhyCLIENTFULL_BLOCK, /* do full */
   TraceStartWhyWALK,            /* walking references -- see walk.c */
   TraceStartWhyEXTENSION,       /* MPS extension using traces */
+  TraceStartWhyPRESSURE,        /* start full */
   TraceStartWhyLIMIT /* not a reason, the limit of the enum. */
 };
 
@@ -376,10 +406,29 @@ enum {
   MessageTypeFINALIZATION,  /* MPS_MESSAGE_TYPE_FINALIZATION */
   MessageTypeGC,  /* MPS_MESSAGE_TYPE_GC = trace end */
   MessageTypeGCSTART,  /* MPS_MESSAGE_TYPE_GC_START */
+  MessageTypeGENRETUNE,  /* MPS_MESSAGE_TYPE_GEN_RETUNE */
   MessageTypeLIMIT /* not a message type, the limit of the enum. */
 };
 
 
+/* Collection until a deadline -- see ArenaCollectUntil */
+/* .collect: Keep in sync with <code/mps.h#collect> */
+
+enum {
+  CollectFINISH = 1 << 0,   /* MPS_COLLECT_FINISH */
+  CollectSTART = 1 << 1,    /* MPS_COLLECT_START */
+  CollectWORLD = 1 << 2,    /* MPS_COLLECT_WORLD */
+  CollectCOMPACT = 1 << 3,  /* MPS_COLLECT_COMPACT */
+  CollectALL = (1 << 4) - 1 /* MPS_COLLECT_ALL */
+};
+
+enum {
+  CollectIDLE,              /* MPS_COLLECT_IDLE */
+  CollectDONE,              /* MPS_COLLECT_DONE */
+  CollectDEADLINE           /* MPS_COLLECT_DEADLINE */
+};
+
+
 /* FindDelete operations -- see <design/land/> */
 
 enum {
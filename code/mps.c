@@ -104,8 +104,12 @@
 
 #include "lockan.c"     /* generic locks */
 #include "than.c"       /* generic threads manager */
+#include "workan.c"     /* generic collector threads */
+#include "clockan.c"    /* generic clock */
 #include "vman.c"       /* malloc-based pseudo memory mapping */
 #include "protan.c"     /* generic memory protection */
+#include "protsdan.c"   /* generic dirty page tracking */
+#include "vmpsan.c"     /* generic memory pressure */
 #include "prmcan.c"     /* generic operating system mutator context */
 #include "prmcanan.c"   /* generic architecture mutator context */
 #include "span.c"       /* generic stack probe */
@@ -117,9 +121,13 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thxc.c"       /* OS X Mach threading */
+#include "workix.c"     /* Posix collector threads */
+#include "clockan.c"    /* generic clock */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protxc.c"     /* OS X Mach exception handling */
+#include "protsdan.c"   /* generic dirty page tracking */
+#include "vmpsan.c"     /* generic memory pressure */
 #include "prmci3.c"     /* 32-bit Intel mutator context decoding */
 #include "prmcxc.c"     /* Mac OS X mutator context */
 #include "prmcxci3.c"   /* 32-bit Intel for Mac OS X mutator context */
@@ -132,9 +140,13 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thxc.c"       /* OS X Mach threading */
+#include "workix.c"     /* Posix collector threads */
+#include "clockan.c"    /* generic clock */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protxc.c"     /* OS X Mach exception handling */
+#include "protsdan.c"   /* generic dirty page tracking */
+#include "vmpsan.c"     /* generic memory pressure */
 #include "prmci6.c"     /* 64-bit Intel mutator context decoding */
 #include "prmcxc.c"     /* Mac OS X mutator context */
 #include "prmcxci6.c"   /* 64-bit Intel for Mac OS X mutator context */
@@ -147,10 +159,14 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thix.c"       /* Posix threading */
+#include "workix.c"     /* Posix collector threads */
+#include "clockix.c"    /* Posix monotonic clock */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protsgix.c"   /* Posix signal handling */
+#include "protsdan.c"   /* generic dirty page tracking */
+#include "vmpsan.c"     /* generic memory pressure */
 #include "prmcanan.c"   /* generic architecture mutator context */
 #include "prmcix.c"     /* Posix mutator context */
 #include "prmcfri3.c"   /* 32-bit Intel for FreeBSD mutator context */
@@ -163,10 +179,14 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thix.c"       /* Posix threading */
+#include "workix.c"     /* Posix collector threads */
+#include "clockix.c"    /* Posix monotonic clock */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protsgix.c"   /* Posix signal handling */
+#include "protsdan.c"   /* generic dirty page tracking */
+#include "vmpsan.c"     /* generic memory pressure */
 #include "prmcanan.c"   /* generic architecture mutator context */
 #include "prmcix.c"     /* Posix mutator context */
 #include "prmcfri6.c"   /* 64-bit Intel for FreeBSD mutator context */
@@ -179,10 +199,14 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thix.c"       /* Posix threading */
+#include "workix.c"     /* Posix collector threads */
+#include "clockix.c"    /* Posix monotonic clock */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protsgix.c"   /* Posix signal handling */
+#include "protsdli.c"   /* Linux soft-dirty page tracking */
+#include "vmpsli.c"     /* Linux memory pressure */
 #include "prmci3.c"     /* 32-bit Intel mutator context */
 #include "prmcix.c"     /* Posix mutator context */
 #include "prmclii3.c"   /* 32-bit Intel for Linux mutator context */
@@ -195,10 +219,14 @@
 
 #include "lockix.c"     /* Posix locks */
 #include "thix.c"       /* Posix threading */
+#include "workix.c"     /* Posix collector threads */
+#include "clockix.c"    /* Posix monotonic clock */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protsgix.c"   /* Posix signal handling */
+#include "protsdli.c"   /* Linux soft-dirty page tracking */
+#include "vmpsli.c"     /* Linux memory pressure */
 #include "prmci6.c"     /* 64-bit Intel mutator context */
 #include "prmcix.c"     /* Posix mutator context */
 #include "prmclii6.c"   /* 64-bit Intel for Linux mutator context */
@@ -211,8 +239,12 @@
 
 #include "lockw3.c"     /* Windows locks */
 #include "thw3.c"       /* Windows threading */
+#include "workan.c"     /* generic collector threads */
+#include "clockan.c"    /* generic clock */
 #include "vmw3.c"       /* Windows virtual memory */
 #include "protw3.c"     /* Windows protection */
+#include "protsdan.c"   /* generic dirty page tracking */
+#include "vmpsan.c"     /* generic memory pressure */
 #include "prmci3.c"     /* 32-bit Intel mutator context decoding */
 #include "prmcw3.c"     /* Windows mutator context */
 #include "prmcw3i3.c"   /* Windows on 32-bit Intel mutator context */
@@ -226,8 +258,12 @@
 
 #include "lockw3.c"     /* Windows locks */
 #include "thw3.c"       /* Windows threading */
+#include "workan.c"     /* generic collector threads */
+#include "clockan.c"    /* generic clock */
 #include "vmw3.c"       /* Windows virtual memory */
 #include "protw3.c"     /* Windows protection */
+#include "protsdan.c"   /* generic dirty page tracking */
+#include "vmpsan.c"     /* generic memory pressure */
 #include "prmci6.c"     /* 64-bit Intel mutator context decoding */
 #include "prmcw3.c"     /* Windows mutator context */
 #include "prmcw3i6.c"   /* Windows on 64-bit Intel mutator context */
@@ -241,8 +277,12 @@
 
 #include "lockw3.c"     /* Windows locks */
 #include "thw3.c"       /* Windows threading */
+#include "workan.c"     /* generic collector threads */
+#include "clockan.c"    /* generic clock */
 #include "vmw3.c"       /* Windows virtual memory */
 #include "protw3.c"     /* Windows protection */
+#include "protsdan.c"   /* generic dirty page tracking */
+#include "vmpsan.c"     /* generic memory pressure */
 #include "prmci3.c"     /* 32-bit Intel mutator context decoding */
 #include "prmcw3.c"     /* Windows mutator context */
 #include "prmcw3i3.c"   /* Windows on 32-bit Intel mutator context */
@@ -256,8 +296,12 @@
 
 #include "lockw3.c"     /* Windows locks */
 #include "thw3.c"       /* Windows threading */
+#include "workan.c"     /* generic collector threads */
+#include "clockan.c"    /* generic clock */
 #include "vmw3.c"       /* Windows virtual memory */
 #include "protw3.c"     /* Windows protection */
+#include "protsdan.c"   /* generic dirty page tracking */
+#include "vmpsan.c"     /* generic memory pressure */
 #include "prmci6.c"     /* 64-bit Intel mutator context decoding */
 #include "prmcw3.c"     /* Windows mutator context */
 #include "prmcw3i6.c"   /* Windows on 64-bit Intel mutator context */
@@ -56,7 +56,9 @@ typedef mps_pool_class_t mps_class_t;      /* deprecated alias */
 typedef struct mps_thr_s    *mps_thr_t;    /* thread registration */
 typedef struct mps_ap_s     *mps_ap_t;     /* allocation point */
 typedef struct mps_ld_s     *mps_ld_t;     /* location dependency */
+typedef struct mps_cards_s  *mps_cards_t;  /* card table */
 typedef struct mps_ss_s     *mps_ss_t;     /* scan state */
+typedef struct mps_policy_s *mps_policy_t; /* collection policy */
 typedef struct mps_message_s
   *mps_message_t;                          /* message */
 typedef struct mps_alloc_pattern_s
@@ -121,6 +123,37 @@ typedef void (*mps_fmt_pad_t)(mps_addr_t, size_t);
 typedef mps_addr_t (*mps_fmt_class_t)(mps_addr_t);
 
 
+/* Collection Policy */
+/* See <design/strategy/#policy.client>. */
+
+typedef struct mps_policy_info_s { /* collection policy estimates */
+  mps_bool_t world_allowed;     /* may the world be collected now? */
+  double step_time;             /* idle time offered, or 0 */
+  size_t collectable;           /* bytes the world collection condemns */
+  double collection_rate;       /* estimated bytes traced per second */
+  double world_time;            /* estimated time to collect the world */
+  double world_since;           /* time since the last step collected it */
+  double world_deferral;        /* bytes until the world is due */
+  mps_chain_t chain;            /* chain most over capacity, or NULL */
+  double chain_deferral;        /* bytes until that chain is due */
+  double pause_time;            /* maximum pause time */
+} mps_policy_info_s;
+
+typedef mps_bool_t (*mps_policy_start_t)(mps_bool_t *, mps_chain_t *,
+                                         mps_arena_t,
+                                         const mps_policy_info_s *, void *);
+typedef size_t (*mps_policy_condemn_t)(mps_arena_t, mps_chain_t, size_t,
+                                       const mps_policy_info_s *, void *);
+typedef double (*mps_policy_poll_t)(mps_arena_t, const mps_policy_info_s *,
+                                    void *);
+
+
+/* Memory pressure */
+/* See <design/arena/#pressure>. */
+
+typedef double (*mps_pressure_t)(void *);
+
+
 /* Keyword argument lists */
 
 typedef void (*mps_fun_t)(void);
@@ -155,6 +188,10 @@ typedef struct mps_arg_s {
     mps_fmt_pad_t fmt_pad;
     mps_fmt_class_t fmt_class;
     mps_pool_t pool;
+    mps_policy_start_t policy_start;
+    mps_policy_condemn_t policy_condemn;
+    mps_policy_poll_t policy_poll;
+    mps_pressure_t pressure;
   } val;
 } mps_arg_s;
 
@@ -192,6 +229,27 @@ extern const struct mps_key_s _mps_key_SPARE_COMMIT_LIMIT;
 extern const struct mps_key_s _mps_key_PAUSE_TIME;
 #define MPS_KEY_PAUSE_TIME      (&_mps_key_PAUSE_TIME)
 #define MPS_KEY_PAUSE_TIME_FIELD d
+extern const struct mps_key_s _mps_key_ARENA_GC_THREADS;
+#define MPS_KEY_ARENA_GC_THREADS (&_mps_key_ARENA_GC_THREADS)
+#define MPS_KEY_ARENA_GC_THREADS_FIELD count
+extern const struct mps_key_s _mps_key_ARENA_BACKGROUND;
+#define MPS_KEY_ARENA_BACKGROUND (&_mps_key_ARENA_BACKGROUND)
+#define MPS_KEY_ARENA_BACKGROUND_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_CARD_MARKING;
+#define MPS_KEY_ARENA_CARD_MARKING (&_mps_key_ARENA_CARD_MARKING)
+#define MPS_KEY_ARENA_CARD_MARKING_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_SOFT_DIRTY;
+#define MPS_KEY_ARENA_SOFT_DIRTY (&_mps_key_ARENA_SOFT_DIRTY)
+#define MPS_KEY_ARENA_SOFT_DIRTY_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_FIX_PREFETCH;
+#define MPS_KEY_ARENA_FIX_PREFETCH (&_mps_key_ARENA_FIX_PREFETCH)
+#define MPS_KEY_ARENA_FIX_PREFETCH_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_PRESSURE;
+#define MPS_KEY_ARENA_PRESSURE (&_mps_key_ARENA_PRESSURE)
+#define MPS_KEY_ARENA_PRESSURE_FIELD pressure
+extern const struct mps_key_s _mps_key_ARENA_PRESSURE_CLOSURE;
+#define MPS_KEY_ARENA_PRESSURE_CLOSURE (&_mps_key_ARENA_PRESSURE_CLOSURE)
+#define MPS_KEY_ARENA_PRESSURE_CLOSURE_FIELD p
 
 extern const struct mps_key_s _mps_key_EXTEND_BY;
 #define MPS_KEY_EXTEND_BY       (&_mps_key_EXTEND_BY)
@@ -221,6 +279,9 @@ extern const struct mps_key_s _mps_key_INTERIOR;
 extern const struct mps_key_s _mps_key_VMW3_TOP_DOWN;
 #define MPS_KEY_VMW3_TOP_DOWN   (&_mps_key_VMW3_TOP_DOWN)
 #define MPS_KEY_VMW3_TOP_DOWN_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_HUGE_PAGES;
+#define MPS_KEY_ARENA_HUGE_PAGES (&_mps_key_ARENA_HUGE_PAGES)
+#define MPS_KEY_ARENA_HUGE_PAGES_FIELD b
 
 extern const struct mps_key_s _mps_key_FMT_ALIGN;
 #define MPS_KEY_FMT_ALIGN   (&_mps_key_FMT_ALIGN)
@@ -246,6 +307,18 @@ extern const struct mps_key_s _mps_key_FMT_PAD;
 extern const struct mps_key_s _mps_key_FMT_CLASS;
 #define MPS_KEY_FMT_CLASS   (&_mps_key_FMT_CLASS)
 #define MPS_KEY_FMT_CLASS_FIELD fmt_class
+extern const struct mps_key_s _mps_key_POLICY_START;
+#define MPS_KEY_POLICY_START (&_mps_key_POLICY_START)
+#define MPS_KEY_POLICY_START_FIELD policy_start
+extern const struct mps_key_s _mps_key_POLICY_CONDEMN;
+#define MPS_KEY_POLICY_CONDEMN (&_mps_key_POLICY_CONDEMN)
+#define MPS_KEY_POLICY_CONDEMN_FIELD policy_condemn
+extern const struct mps_key_s _mps_key_POLICY_POLL;
+#define MPS_KEY_POLICY_POLL (&_mps_key_POLICY_POLL)
+#define MPS_KEY_POLICY_POLL_FIELD policy_poll
+extern const struct mps_key_s _mps_key_POLICY_CLOSURE;
+#define MPS_KEY_POLICY_CLOSURE (&_mps_key_POLICY_CLOSURE)
+#define MPS_KEY_POLICY_CLOSURE_FIELD p
 
 /* Maximum length of a keyword argument list. */
 #define MPS_ARGS_MAX          32
@@ -288,7 +361,8 @@ extern void _mps_args_set_key(mps_arg_s args[MPS_ARGS_MAX], unsigned i,
 enum {
   _mps_MESSAGE_TYPE_FINALIZATION,
   _mps_MESSAGE_TYPE_GC,
-  _mps_MESSAGE_TYPE_GC_START
+  _mps_MESSAGE_TYPE_GC_START,
+  _mps_MESSAGE_TYPE_GEN_RETUNE
 };
 
 /* Message Types
@@ -296,6 +370,7 @@ enum {
 #define mps_message_type_finalization() _mps_MESSAGE_TYPE_FINALIZATION
 #define mps_message_type_gc() _mps_MESSAGE_TYPE_GC
 #define mps_message_type_gc_start() _mps_MESSAGE_TYPE_GC_START
+#define mps_message_type_gen_retune() _mps_MESSAGE_TYPE_GEN_RETUNE
 
 
 /* Reference Ranks
@@ -324,6 +399,48 @@ typedef struct mps_ap_s {       /* allocation point descriptor */
 } mps_ap_s;
 
 
+/* Card Table */
+/* .cards: Keep in sync with ArenaCardsFirstDirty in <code/arena.c>. */
+
+typedef struct mps_cards_s {    /* card table descriptor */
+  unsigned char **stripe;       /* cards for each stripe of memory */
+  mps_word_t stripeShift;       /* log2 of the stripe size */
+  mps_word_t stripeMask;        /* number of stripes minus one */
+  mps_word_t shift;             /* log2 of the card size */
+  mps_word_t mask;              /* cards per stripe minus one */
+} mps_cards_s;
+
+
+/* Pause Statistics */
+/* .pause: Keep in sync with <code/mpmtypes.h#pause>.  See
+ * <design/arena/#pause>. */
+
+enum {
+  MPS_PAUSE_POLL,               /* collection work when allocating */
+  MPS_PAUSE_FLIP,               /* threads stopped to scan roots */
+  MPS_PAUSE_ACCESS,             /* handling a barrier hit */
+  MPS_PAUSE_FINALIZE,           /* (de)registering for finalization */
+  MPS_PAUSE_KIND_LIMIT
+};
+
+typedef unsigned mps_pause_kind_t;
+
+#define MPS_PAUSE_BUCKETS 128
+
+typedef struct mps_pause_stats_s { /* pause histogram */
+  size_t count;                 /* number of pauses */
+  double total;                 /* total length of pauses, in seconds */
+  double max;                   /* longest pause, in seconds */
+  size_t bucket[MPS_PAUSE_BUCKETS]; /* see mps_pause_bucket_limit */
+} mps_pause_stats_s;
+
+typedef struct mps_window_stats_s { /* mutator figures for a window */
+  double length;                /* length of window, in seconds */
+  double alloc_rate;            /* bytes allocated per second */
+  double utilization;           /* fraction of window not paused */
+} mps_window_stats_s;
+
+
 /* Segregated-fit Allocation Caches */
 /* .sac: Keep in sync with <code/sac.h>. */
 
@@ -443,6 +560,24 @@ extern mps_res_t mps_arena_start_collect(mps_arena_t);
 extern mps_res_t mps_arena_collect(mps_arena_t);
 extern mps_bool_t mps_arena_step(mps_arena_t, double, double);
 
+/* <a id="collect"> Keep in sync with <code/mpmtypes.h#collect> */
+enum {
+  MPS_COLLECT_FINISH = 1,       /* finish collections in progress */
+  MPS_COLLECT_START = 2,        /* start collections of chains */
+  MPS_COLLECT_WORLD = 4,        /* start a collection of the world */
+  MPS_COLLECT_COMPACT = 8       /* return spare memory to the OS */
+};
+#define MPS_COLLECT_ALL (MPS_COLLECT_FINISH | MPS_COLLECT_START | \
+                         MPS_COLLECT_WORLD | MPS_COLLECT_COMPACT)
+
+enum {
+  MPS_COLLECT_IDLE,             /* there was nothing to do */
+  MPS_COLLECT_DONE,             /* work was done and none is left */
+  MPS_COLLECT_DEADLINE          /* work was left at the deadline */
+};
+
+extern int mps_arena_collect_until(mps_arena_t, mps_clock_t, unsigned);
+
 extern mps_res_t mps_arena_create(mps_arena_t *, mps_arena_class_t, ...);
 extern mps_res_t mps_arena_create_v(mps_arena_t *, mps_arena_class_t, va_list);
 extern mps_res_t mps_arena_create_k(mps_arena_t *, mps_arena_class_t,
@@ -461,6 +596,19 @@ extern size_t mps_arena_spare_commit_limit(mps_arena_t);
 extern double mps_arena_pause_time(mps_arena_t);
 extern void mps_arena_pause_time_set(mps_arena_t, double);
 
+extern double mps_pressure_system(void *);
+extern mps_bool_t mps_arena_under_pressure(mps_arena_t);
+
+extern void mps_arena_pause_stats(mps_pause_stats_s *, mps_arena_t,
+                                  mps_pause_kind_t);
+extern size_t mps_arena_window_stats(mps_window_stats_s *, size_t,
+                                     mps_arena_t);
+extern double mps_arena_mmu(mps_arena_t);
+extern void mps_arena_pause_stats_reset(mps_arena_t);
+extern double mps_pause_bucket_limit(size_t);
+
+extern mps_cards_t mps_arena_cards(mps_arena_t);
+
 extern mps_bool_t mps_arena_busy(mps_arena_t);
 extern mps_bool_t mps_arena_has_addr(mps_arena_t, mps_addr_t);
 extern mps_bool_t mps_addr_pool(mps_pool_t *, mps_arena_t, mps_addr_t);
@@ -509,9 +657,24 @@ typedef struct mps_gen_param_s {
   double mps_mortality;
 } mps_gen_param_s;
 
+/* .gen-bounds: This structure must match <code/locus.h#gen-bounds>. */
+typedef struct mps_gen_bounds_s {
+  size_t mps_min_capacity;
+  size_t mps_max_capacity;
+} mps_gen_bounds_s;
+
 extern mps_res_t mps_chain_create(mps_chain_t *, mps_arena_t,
                                   size_t, mps_gen_param_s *);
 extern void mps_chain_destroy(mps_chain_t);
+extern void mps_chain_adapt(mps_chain_t, size_t, mps_gen_bounds_s *);
+
+
+/* Collection Policy */
+
+extern mps_res_t mps_policy_create_k(mps_policy_t *, mps_arena_t,
+                                     mps_arg_s []);
+extern void mps_policy_destroy(mps_policy_t);
+extern void mps_arena_policy_info(mps_policy_info_s *, mps_arena_t);
 
 
 /* Manual Allocation */
@@ -663,6 +826,18 @@ extern mps_res_t mps_reserve_with_reservoir_permit(mps_addr_t *,
    (_mps_ap)->limit != 0 || mps_ap_trip(_mps_ap, _p, _size))
 
 
+/* Write Barrier Macro */
+/* .write-barrier: Keep in sync with <design/write-barrier/#card.store>. */
+
+#define MPS_WRITE_BARRIER(_cards, _p, _ref) \
+  MPS_BEGIN \
+    ((unsigned char volatile *)(_cards)->stripe \
+       [((mps_word_t)(_p) >> (_cards)->stripeShift) & (_cards)->stripeMask]) \
+      [((mps_word_t)(_p) >> (_cards)->shift) & (_cards)->mask] = 1; \
+    *(mps_addr_t volatile *)(_p) = (mps_addr_t)(_ref); \
+  MPS_END
+
+
 /* Root Creation and Destruction */
 
 extern mps_res_t mps_root_create(mps_root_t *, mps_arena_t, mps_rank_t,
@@ -716,6 +891,8 @@ extern void (mps_tramp)(void **, mps_tramp_t, void *, size_t);
 
 extern mps_res_t mps_thread_reg(mps_thr_t *, mps_arena_t);
 extern void mps_thread_dereg(mps_thr_t);
+extern void mps_thread_park(mps_thr_t);
+extern void mps_thread_unpark(mps_thr_t);
 
 
 /* Location Dependency */
@@ -758,6 +935,18 @@ extern size_t mps_message_gc_not_condemned_size(mps_arena_t,
 /* -- mps_message_type_gc_start */
 extern const char *mps_message_gc_start_why(mps_arena_t, mps_message_t);
 
+/* -- mps_message_type_gen_retune */
+typedef struct mps_gen_retune_s { /* change of generation capacity */
+  mps_chain_t chain;            /* chain of the generation */
+  size_t gen;                   /* index of the generation in the chain */
+  size_t old_capacity;          /* previous capacity, in kilobytes */
+  size_t new_capacity;          /* new capacity, in kilobytes */
+  double mortality;             /* mortality in the collection */
+} mps_gen_retune_s;
+
+extern void mps_message_gen_retune(mps_gen_retune_s *,
+                                   mps_arena_t, mps_message_t);
+
 
 /* Finalization */
 
@@ -822,6 +1011,9 @@ extern mps_res_t mps_scan_area_tagged(mps_ss_t, void *, void *, void *);
 extern mps_res_t mps_scan_area_tagged_or_zero(mps_ss_t, void *, void *, void *);
 
 extern mps_res_t mps_fix(mps_ss_t, mps_addr_t *);
+extern mps_res_t mps_fix_area(mps_ss_t, void *, void *, mps_word_t);
+extern mps_res_t mps_fix_area_tagged(mps_ss_t, void *, void *,
+                                     mps_word_t, mps_word_t);
 
 #define MPS_SCAN_BEGIN(ss) \
   MPS_BEGIN \
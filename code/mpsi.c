@@ -47,6 +47,7 @@
 #include "mpm.h"
 #include "mps.h"
 #include "sac.h"
+#include "vm.h"
 
 #include <stdarg.h>
 
@@ -82,6 +83,19 @@ static Bool mpsi_check(void)
          == (int)_mps_MESSAGE_TYPE_GC);
   CHECKL((int)MessageTypeGCSTART
          == (int)_mps_MESSAGE_TYPE_GC_START);
+  CHECKL((int)MessageTypeGENRETUNE
+         == (int)_mps_MESSAGE_TYPE_GEN_RETUNE);
+
+  /* Check that external and internal collection flags and statuses */
+  /* match.  See <code/mps.h#collect> and <code/mpmtypes.h#collect>. */
+  CHECKL((unsigned)CollectFINISH == (unsigned)MPS_COLLECT_FINISH);
+  CHECKL((unsigned)CollectSTART == (unsigned)MPS_COLLECT_START);
+  CHECKL((unsigned)CollectWORLD == (unsigned)MPS_COLLECT_WORLD);
+  CHECKL((unsigned)CollectCOMPACT == (unsigned)MPS_COLLECT_COMPACT);
+  CHECKL((unsigned)CollectALL == (unsigned)MPS_COLLECT_ALL);
+  CHECKL((int)CollectIDLE == (int)MPS_COLLECT_IDLE);
+  CHECKL((int)CollectDONE == (int)MPS_COLLECT_DONE);
+  CHECKL((int)CollectDEADLINE == (int)MPS_COLLECT_DEADLINE);
 
   /* The external idea of a word width and the internal one */
   /* had better match.  See <design/interface-c/#cons>. */
@@ -101,6 +115,15 @@ static Bool mpsi_check(void)
   /* out to external. */
   CHECKL(COMPATTYPE(mps_clock_t, Clock));
 
+  /* Check that external and internal pause kinds match. */
+  /* See <code/mps.h#pause> and <code/mpmtypes.h#pause>. */
+  CHECKL(COMPATTYPE(mps_pause_kind_t, PauseKind));
+  CHECKL((int)PauseKindPOLL == (int)MPS_PAUSE_POLL);
+  CHECKL((int)PauseKindFLIP == (int)MPS_PAUSE_FLIP);
+  CHECKL((int)PauseKindACCESS == (int)MPS_PAUSE_ACCESS);
+  CHECKL((int)PauseKindFINALIZE == (int)MPS_PAUSE_FINALIZE);
+  CHECKL((int)PauseKindLIMIT == (int)MPS_PAUSE_KIND_LIMIT);
+
   return TRUE;
 }
 
@@ -234,6 +257,100 @@ void mps_arena_pause_time_set(mps_arena_t arena, double pause_time)
 }
 
 
+/* mps_pressure_system -- memory pressure reported by the OS
+ *
+ * A pressure function for MPS_KEY_ARENA_PRESSURE.  See
+ * <design/arena/#pressure>.
+ */
+
+double mps_pressure_system(void *closure)
+{
+  UNUSED(closure);
+  return VMPressure();
+}
+
+mps_bool_t mps_arena_under_pressure(mps_arena_t arena)
+{
+  Bool b;
+
+  ArenaEnter(arena);
+  b = arena->underPressure;
+  ArenaLeave(arena);
+
+  return (mps_bool_t)b;
+}
+
+
+/* mps_arena_pause_stats etc. -- pause and utilization statistics
+ *
+ * See <design/arena/#pause>.
+ */
+
+void mps_arena_pause_stats(mps_pause_stats_s *stats_o, mps_arena_t arena,
+                           mps_pause_kind_t kind)
+{
+  AVER(stats_o != NULL);
+  AVER(kind < PauseKindLIMIT);
+
+  ArenaEnter(arena);
+  ArenaPauseStats(stats_o, arena, kind);
+  ArenaLeave(arena);
+}
+
+size_t mps_arena_window_stats(mps_window_stats_s *stats_o, size_t count,
+                              mps_arena_t arena)
+{
+  Count found;
+
+  AVER(stats_o != NULL || count == 0);
+
+  ArenaEnter(arena);
+  found = ArenaWindowStats(stats_o, count, arena);
+  ArenaLeave(arena);
+  return found;
+}
+
+double mps_arena_mmu(mps_arena_t arena)
+{
+  double mmu;
+
+  ArenaEnter(arena);
+  mmu = ArenaMMU(arena);
+  ArenaLeave(arena);
+  return mmu;
+}
+
+void mps_arena_pause_stats_reset(mps_arena_t arena)
+{
+  ArenaEnter(arena);
+  ArenaPauseStatsReset(arena);
+  ArenaLeave(arena);
+}
+
+double mps_pause_bucket_limit(size_t bucket)
+{
+  AVER(bucket < MPS_PAUSE_BUCKETS);
+  return PauseBucketLimit(bucket);
+}
+
+
+/* mps_arena_cards -- return the card table for MPS_WRITE_BARRIER
+ *
+ * The table does not move or change while the arena exists, so the
+ * client may keep the result.  See <design/write-barrier/#card>.
+ */
+
+mps_cards_t mps_arena_cards(mps_arena_t arena)
+{
+  mps_cards_t cards;
+
+  ArenaEnter(arena);
+  cards = ArenaCards(arena);
+  ArenaLeave(arena);
+  return cards;
+}
+
+
 void mps_arena_clamp(mps_arena_t arena)
 {
   ArenaEnter(arena);
@@ -319,6 +436,16 @@ mps_bool_t mps_arena_step(mps_arena_t arena,
   return b;
 }
 
+int mps_arena_collect_until(mps_arena_t arena, mps_clock_t deadline,
+                            unsigned flags)
+{
+  int status;
+  ArenaEnter(arena);
+  status = ArenaCollectUntil(ArenaGlobals(arena), (Clock)deadline, flags);
+  ArenaLeave(arena);
+  return status;
+}
+
 
 /* mps_arena_create -- create an arena object */
 
@@ -766,6 +893,12 @@ mps_res_t mps_alloc(mps_addr_t *p_o, mps_pool_t pool, size_t size)
   AVER_CRITICAL(TESTT(Pool, pool));
   arena = PoolArena(pool);
 
+  /* See <design/pool/#method.alloc-fast>. */
+  if (PoolAllocFast(&p, pool, size)) {
+    *p_o = (mps_addr_t)p;
+    return MPS_RES_OK;
+  }
+
   ArenaEnter(arena);
 
   ArenaPoll(ArenaGlobals(arena)); /* .poll */
@@ -808,6 +941,10 @@ void mps_free(mps_pool_t pool, mps_addr_t p, size_t size)
   AVER_CRITICAL(TESTT(Pool, pool));
   arena = PoolArena(pool);
 
+  /* See <design/pool/#method.alloc-fast>. */
+  if (PoolFreeFast(pool, (Addr)p, size))
+    return;
+
   ArenaEnter(arena);
 
   AVERT_CRITICAL(Pool, pool);
@@ -1629,15 +1766,52 @@ mps_res_t mps_thread_reg(mps_thr_t *mps_thr_o, mps_arena_t arena)
 void mps_thread_dereg(mps_thr_t thread)
 {
   Arena arena;
+  Bool current;
 
   AVER(ThreadCheckSimple(thread));
   arena = ThreadArena(thread);
+  current = ThreadIsCurrent(thread);
 
   ArenaEnter(arena);
 
   ThreadDeregister(thread, arena);
 
   ArenaLeave(arena);
+
+  /* Let another thread have this thread's event slot.  See
+     <design/telemetry/#slot.release>. */
+  if (current)
+    EventSlotRelease();
+}
+
+void mps_thread_park(mps_thr_t thread)
+{
+  Arena arena;
+
+  AVER(ThreadCheckSimple(thread));
+  arena = ThreadArena(thread);
+
+  ArenaEnter(arena);
+
+  /* The client's callee-save registers may be in this frame.  See
+     <design/thread-manager/#impl.ix.park.copy>. */
+  ThreadPark(thread, CALLER_STACK_HOT());
+
+  ArenaLeave(arena);
+}
+
+void mps_thread_unpark(mps_thr_t thread)
+{
+  Arena arena;
+
+  AVER(ThreadCheckSimple(thread));
+  arena = ThreadArena(thread);
+
+  ArenaEnter(arena);
+
+  ThreadUnpark(thread);
+
+  ArenaLeave(arena);
 }
 
 void mps_ld_reset(mps_ld_t ld, mps_arena_t arena)
@@ -1703,6 +1877,27 @@ mps_res_t mps_fix(mps_ss_t mps_ss, mps_addr_t *ref_io)
   return res;
 }
 
+/* mps_fix_area, mps_fix_area_tagged -- fix an area of references
+ *
+ * These may be called within MPS_SCAN_BEGIN and MPS_SCAN_END only via
+ * MPS_FIX_CALL, since they update the scan state's summary directly.
+ */
+
+mps_res_t mps_fix_area(mps_ss_t mps_ss, void *base, void *limit,
+                       mps_word_t mask)
+{
+  ScanState ss = PARENT(ScanStateStruct, ss_s, mps_ss);
+  return TraceFixArea(ss, base, limit, mask, 0, 0);
+}
+
+mps_res_t mps_fix_area_tagged(mps_ss_t mps_ss, void *base, void *limit,
+                              mps_word_t mask, mps_word_t pattern)
+{
+  ScanState ss = PARENT(ScanStateStruct, ss_s, mps_ss);
+  AVER((pattern & ~mask) == 0);
+  return TraceFixArea(ss, base, limit, mask, mask, pattern);
+}
+
 mps_word_t mps_collections(mps_arena_t arena)
 {
   return ArenaEpoch(arena); /* thread safe: see <code/arena.h#epoch.ts> */
@@ -1943,6 +2138,19 @@ const char *mps_message_gc_start_why(mps_arena_t arena,
   return s;
 }
 
+void mps_message_gen_retune(mps_gen_retune_s *retune_o,
+                            mps_arena_t arena, mps_message_t message)
+{
+  ArenaEnter(arena);
+
+  AVER(retune_o != NULL);
+  AVERT(Arena, arena);
+
+  MessageGenRetune(retune_o, message);
+
+  ArenaLeave(arena);
+}
+
 
 /* Telemetry */
 
@@ -2139,6 +2347,74 @@ void mps_chain_destroy(mps_chain_t chain)
 }
 
 
+/* mps_chain_adapt -- start or stop retuning a chain's capacities */
+
+void mps_chain_adapt(mps_chain_t chain, size_t gen_count,
+                     mps_gen_bounds_s *bounds)
+{
+  Arena arena;
+
+  AVER(TESTT(Chain, chain));
+  arena = chain->arena;
+
+  ArenaEnter(arena);
+  ChainAdapt(chain, gen_count, (GenBoundsStruct *)bounds);
+  ArenaLeave(arena);
+}
+
+
+/* mps_policy_create_k -- create and install a client policy */
+
+mps_res_t mps_policy_create_k(mps_policy_t *mps_policy_o,
+                              mps_arena_t arena,
+                              mps_arg_s args[])
+{
+  Policy policy;
+  Res res;
+
+  ArenaEnter(arena);
+
+  AVER(mps_policy_o != NULL);
+  AVERT(Arena, arena);
+  AVERT(ArgList, args);
+
+  res = PolicyCreate(&policy, arena, args);
+
+  ArenaLeave(arena);
+
+  if (res != ResOK)
+    return (mps_res_t)res;
+  *mps_policy_o = (mps_policy_t)policy;
+  return MPS_RES_OK;
+}
+
+
+/* mps_policy_destroy -- remove and destroy a client policy */
+
+void mps_policy_destroy(mps_policy_t policy)
+{
+  Arena arena;
+
+  AVER(TESTT(Policy, policy));
+  arena = policy->arena;
+
+  ArenaEnter(arena);
+  PolicyDestroy(policy);
+  ArenaLeave(arena);
+}
+
+
+/* mps_arena_policy_info -- return the estimates behind the policy */
+
+void mps_arena_policy_info(mps_policy_info_s *info_o, mps_arena_t arena)
+{
+  ArenaEnter(arena);
+  AVER(info_o != NULL);
+  PolicyInfo(info_o, arena);
+  ArenaLeave(arena);
+}
+
+
 /* _mps_args_set_key -- set the key for a keyword argument 
  *
  * This sets the key for the i'th keyword argument in the array args,
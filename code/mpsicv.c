@@ -17,6 +17,7 @@
 #include "mpstd.h"
 
 #include <stdio.h> /* printf */
+#include <string.h> /* strncmp */
 
 
 #define exactRootsCOUNT  49
@@ -333,6 +334,58 @@ static void arena_commit_test(mps_arena_t arena)
 }
 
 
+/* pressure_test
+ *
+ * Simulate memory pressure and check that the arena notices, keeps
+ * no spare memory, and collects the world; and that it notices when
+ * the pressure is relieved.  The arena reads the pressure at most
+ * every ARENA_PRESSURE_INTERVAL seconds, so keep allocating until it
+ * does.
+ *
+ * incidentally tests:
+ *   mps_message_gc_start_why
+ *   mps_arena_spare_committed
+ */
+
+static double pressureLevel = 0.0;
+
+static double pressure_simulated(void *closure)
+{
+  return *(double *)closure;
+}
+
+static void pressure_test(mps_arena_t arena)
+{
+  size_t spareLimit = mps_arena_spare_commit_limit(arena);
+  mps_bool_t collected = FALSE;
+  mps_message_t message;
+
+  Insist(!mps_arena_under_pressure(arena));
+  Insist(mps_pressure_system(NULL) >= 0.0);
+  mps_message_type_enable(arena, mps_message_type_gc_start());
+
+  pressureLevel = 2.0;
+  while (!collected) {
+    exactRoots[rnd() % exactRootsCOUNT] = make();
+    while (mps_message_get(&message, arena, mps_message_type_gc_start())) {
+      const char *why = mps_message_gc_start_why(arena, message);
+      if (strncmp(why, "Memory pressure", 15) == 0)
+        collected = TRUE;
+      mps_message_discard(arena, message);
+    }
+  }
+  Insist(mps_arena_under_pressure(arena));
+  Insist(mps_arena_spare_committed(arena) == 0);
+  Insist(mps_arena_spare_commit_limit(arena) == spareLimit);
+
+  pressureLevel = 0.0;
+  while (mps_arena_under_pressure(arena))
+    exactRoots[rnd() % exactRootsCOUNT] = make();
+
+  mps_message_type_disable(arena, mps_message_type_gc_start());
+}
+
+
 static void *test(void *arg, size_t s)
 {
   mps_arena_t arena;
@@ -525,6 +578,8 @@ static void *test(void *arg, size_t s)
 
   arena_commit_test(arena);
   alignmentTest(arena);
+  mps_arena_release(arena);
+  pressure_test(arena);
 
   die(mps_arena_collect(arena), "collect");
   mps_arena_release(arena);
@@ -566,6 +621,8 @@ int main(int argc, char *argv[])
     /* Randomize pause time as a regression test for job004011. */
     MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, rnd_pause_time());
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, TEST_ARENA_SIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_PRESSURE, pressure_simulated);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_PRESSURE_CLOSURE, &pressureLevel);
     die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
         "arena_create");
   } MPS_ARGS_END(args);
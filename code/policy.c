@@ -11,6 +11,7 @@
 
 #include "locus.h"
 #include "mpm.h"
+#include <float.h> /* for DBL_MAX */
 
 SRCID(policy, "$Id$");
 
@@ -131,31 +132,108 @@ found:
 }
 
 
+/* policyCollectionRate -- estimate rate of collection, in bytes/second */
+
+static double policyCollectionRate(Arena arena)
+{
+  AVERT(Arena, arena);
+
+  /* The condition arena->tracedTime >= 1.0 ensures that the division
+   * can't overflow. */
+  if (arena->tracedTime >= 1.0)
+    return arena->tracedWork / arena->tracedTime;
+  else
+    return ARENA_DEFAULT_COLLECTION_RATE;
+}
+
+
 /* policyCollectionTime -- estimate time to collect the world, in seconds */
 
 static double policyCollectionTime(Arena arena)
 {
   Size collectableSize;
-  double collectionRate;
   double collectionTime;
   
   AVERT(Arena, arena);
 
   collectableSize = ArenaCollectable(arena);
-  /* The condition arena->tracedTime >= 1.0 ensures that the division
-   * can't overflow. */
-  if (arena->tracedTime >= 1.0)
-    collectionRate = arena->tracedWork / arena->tracedTime;
-  else
-    collectionRate = ARENA_DEFAULT_COLLECTION_RATE;
-  collectionTime = collectableSize / collectionRate;
+  collectionTime = collectableSize / policyCollectionRate(arena);
   collectionTime += ARENA_DEFAULT_COLLECTION_OVERHEAD;
 
   return collectionTime;
 }
 
 
-/* PolicyShouldCollectWorld -- should we collect the world now?
+/* policyInfo -- compute the estimates on which the policy is based
+ *
+ * worldAllowed is TRUE if a collection of the world may be started.
+ * stepTime is the time offered by mps_arena_step or
+ * mps_arena_collect_until, in seconds, or zero if the MPS is not
+ * using idle time.  See <design/strategy/#policy.info>.
+ */
+
+static void policyInfo(mps_policy_info_s *infoReturn, Arena arena,
+                       Bool worldAllowed, double stepTime, Clock now)
+{
+  Size sFoundation, sCondemned, sSurvivors, sConsTrace;
+  double tTracePerScan; /* tTrace/cScan */
+  Ring node, nextNode;
+
+  AVER(infoReturn != NULL);
+  AVERT(Arena, arena);
+  AVERT(Bool, worldAllowed);
+  AVER(stepTime >= 0.0);
+
+  infoReturn->world_allowed = worldAllowed;
+  infoReturn->step_time = stepTime;
+  infoReturn->collectable = ArenaCollectable(arena);
+  infoReturn->collection_rate = policyCollectionRate(arena);
+  infoReturn->world_time = policyCollectionTime(arena);
+  infoReturn->world_since = ((now - arena->lastWorldCollect)
+                             / (double)ClocksPerSec());
+
+  /* Compute dynamic criterion.  See strategy.lisp-machine. */
+  sFoundation = (Size)0; /* condemning everything, only roots @@@@ */
+  /* @@@@ sCondemned should be scannable only */
+  sCondemned = infoReturn->collectable;
+  sSurvivors = (Size)(sCondemned * (1 - arena->topGen.mortality));
+  tTracePerScan = sFoundation + (sSurvivors * (1 + TraceCopyScanRATIO));
+  AVER(TraceWorkFactor >= 0);
+  AVER(sSurvivors + tTracePerScan * TraceWorkFactor <= (double)SizeMAX);
+  sConsTrace = (Size)(sSurvivors + tTracePerScan * TraceWorkFactor);
+  infoReturn->world_deferral = (double)ArenaAvail(arena) - (double)sConsTrace;
+
+  /* Find the chain most over its capacity. */
+  infoReturn->chain = NULL;
+  infoReturn->chain_deferral = DBL_MAX;
+  RING_FOR(node, &arena->chainRing, nextNode) {
+    Chain chain = RING_ELT(Chain, chainRing, node);
+    double deferral;
+
+    AVERT(Chain, chain);
+    deferral = ChainDeferral(chain);
+    if (deferral < infoReturn->chain_deferral) {
+      infoReturn->chain = chain;
+      infoReturn->chain_deferral = deferral;
+    }
+  }
+
+  infoReturn->pause_time = ArenaPauseTime(arena);
+}
+
+
+/* PolicyInfo -- return the current estimates to the client */
+
+void PolicyInfo(mps_policy_info_s *infoReturn, Arena arena)
+{
+  AVER(infoReturn != NULL);
+  AVERT(Arena, arena);
+  policyInfo(infoReturn, arena, arena->busyTraces == TraceSetEMPTY,
+             0.0, ClockNow());
+}
+
+
+/* policyShouldCollectWorld -- should we collect the world now?
  *
  * Return TRUE if we should try collecting the world now, FALSE if
  * not.
@@ -166,35 +244,59 @@ static double policyCollectionTime(Arena arena)
  * opportunistically.
  */
 
-Bool PolicyShouldCollectWorld(Arena arena, double availableTime,
-                              Clock now, Clock clocks_per_sec)
+static Bool policyShouldCollectWorld(const mps_policy_info_s *info)
 {
-  Size collectableSize;
-  double collectionTime, sinceLastWorldCollect;
-
-  AVERT(Arena, arena);
-  /* Can't collect the world if we're already collecting. */
-  AVER(arena->busyTraces == TraceSetEMPTY);
+  AVER(info != NULL);
 
-  if (availableTime <= 0.0)
+  if (info->step_time <= 0.0)
     /* Can't collect the world if we're not given any time. */
     return FALSE;
 
   /* Don't collect the world if it's very small. */
-  collectableSize = ArenaCollectable(arena);
-  if (collectableSize < ARENA_MINIMUM_COLLECTABLE_SIZE)
+  if (info->collectable < ARENA_MINIMUM_COLLECTABLE_SIZE)
     return FALSE;
 
-  /* How long would it take to collect the world? */
-  collectionTime = policyCollectionTime(arena);
+  /* Offered enough time, and long enough since we last did it? */
+  return info->step_time > info->world_time
+    && info->world_since > info->world_time / ARENA_MAX_COLLECT_FRACTION;
+}
+
 
-  /* How long since we last collected the world? */
-  sinceLastWorldCollect = ((now - arena->lastWorldCollect) /
-                           (double) clocks_per_sec);
+/* policyChainDue -- the chain that is over capacity, if any */
 
-  /* Offered enough time, and long enough since we last did it? */
-  return availableTime > collectionTime
-    && sinceLastWorldCollect > collectionTime / ARENA_MAX_COLLECT_FRACTION;
+static Chain policyChainDue(const mps_policy_info_s *info)
+{
+  AVER(info != NULL);
+  return info->chain_deferral < 0.0 ? info->chain : NULL;
+}
+
+
+/* policyChainIdle -- is it worth collecting this chain early?
+ *
+ * In idle time, collecting a chain before it is due saves a pause
+ * later.  It's worth it if the nursery is at least
+ * ARENA_IDLE_NURSERY_FRACTION full, so that its objects have had time
+ * to die, and if its survivors are expected to be traced in the time
+ * offered.
+ */
+
+static Bool policyChainIdle(Chain chain, const mps_policy_info_s *info)
+{
+  GenDesc gen;
+  Size newSize;
+
+  AVER(info != NULL);
+
+  if (chain == NULL || chain->activeTraces != TraceSetEMPTY)
+    return FALSE;
+  AVERT(Chain, chain);
+  AVER(chain->genCount > 0);
+  gen = &chain->gens[0];
+  newSize = GenDescNewSize(gen);
+  if (newSize < gen->capacity * 1024.0 * ARENA_IDLE_NURSERY_FRACTION)
+    return FALSE;
+  return newSize * (1.0 - gen->mortality) / info->collection_rate
+    <= info->step_time;
 }
 
 
@@ -203,36 +305,40 @@ Bool PolicyShouldCollectWorld(Arena arena, double availableTime,
  * If successful, set *mortalityReturn to an estimate of the mortality
  * of the condemned parts of this chain and return ResOK.
  *
- * This is only called if ChainDeferral returned a value sufficiently
- * low that we decided to start the collection. (Usually such values
- * are less than zero; see <design/strategy/#policy.start.chain>.)
+ * By default, condemn the highest generation that is over capacity,
+ * and all lower generations, or just the nursery if none is over
+ * capacity.  The client policy may choose another top generation.
+ * See <design/strategy/#policy.start.chain>.
  */
 
-static Res policyCondemnChain(double *mortalityReturn, Chain chain, Trace trace)
+static Res policyCondemnChain(double *mortalityReturn, Chain chain,
+                              Trace trace, const mps_policy_info_s *info)
 {
   Res res;
   size_t topCondemnedGen, i;
   GenDesc gen;
   Size condemnedSize = 0, survivorSize = 0, genNewSize, genTotalSize;
+  Policy policy;
 
   AVERT(Chain, chain);
   AVERT(Trace, trace);
+  AVER(chain->genCount > 0);
 
   /* Find the highest generation that's over capacity. We will condemn
    * this and all lower generations in the chain. */
   topCondemnedGen = chain->genCount;
-  for (;;) {
-    /* It's an error to call this function unless some generation is
-     * over capacity as reported by ChainDeferral. */
-    AVER(topCondemnedGen > 0);
-    if (topCondemnedGen == 0)
-      return ResFAIL;
+  do {
     -- topCondemnedGen;
     gen = &chain->gens[topCondemnedGen];
     AVERT(GenDesc, gen);
     genNewSize = GenDescNewSize(gen);
-    if (genNewSize >= gen->capacity * (Size)1024)
-      break;
+  } while (topCondemnedGen > 0 && genNewSize < gen->capacity * (Size)1024);
+
+  policy = trace->arena->policy;
+  if (policy != NULL && policy->condemn != NULL) {
+    topCondemnedGen = (*policy->condemn)(trace->arena, chain, topCondemnedGen,
+                                         info, policy->closure);
+    AVER(topCondemnedGen < chain->genCount);
   }
 
   /* At this point, we've decided to condemn topCondemnedGen and all
@@ -269,6 +375,83 @@ failBegin:
 }
 
 
+/* policyStartTrace -- start the trace the policy chooses
+ *
+ * collectWorld is the default decision to collect the world, and
+ * worldWhy the reason to give if the world is collected.  chain is
+ * the default chain to collect, or NULL.  A client policy may
+ * override both decisions.  See <design/strategy/#policy.client.start>.
+ *
+ * The results are as for PolicyStartTrace.
+ */
+
+static Bool policyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
+                             Arena arena, const mps_policy_info_s *info,
+                             Bool collectWorld, int worldWhy, Chain chain)
+{
+  Res res;
+  Trace trace;
+  Policy policy;
+  double mortality;
+
+  AVER(traceReturn != NULL);
+  AVER(collectWorldReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(info != NULL);
+  AVERT(Bool, collectWorld);
+  AVER(chain == NULL || TESTT(Chain, chain));
+
+  policy = arena->policy;
+  if (policy != NULL && policy->start != NULL) {
+    mps_bool_t worldIO = collectWorld;
+    mps_chain_t chainIO = chain;
+    if (!(*policy->start)(&worldIO, &chainIO, arena, info, policy->closure))
+      return FALSE;
+    collectWorld = info->world_allowed && worldIO;
+    chain = chainIO;
+  }
+
+  if (collectWorld) {
+    /* Start full collection. */
+    res = TraceStartCollectAll(&trace, arena, worldWhy);
+    if (res != ResOK)
+      goto failStart;
+    *collectWorldReturn = TRUE;
+    *traceReturn = trace;
+    return TRUE;
+  }
+
+  /* Start collection on the chain, unless it's already collecting. */
+  if (chain == NULL)
+    return FALSE;
+  AVERT(Chain, chain);
+  AVER(chain->arena == arena);
+  if (chain->activeTraces != TraceSetEMPTY)
+    return FALSE;
+
+  res = TraceCreate(&trace, arena, TraceStartWhyCHAIN_GEN0CAP);
+  AVER(res == ResOK);
+  trace->chain = chain;
+  ChainStartTrace(chain, trace);
+  res = policyCondemnChain(&mortality, chain, trace, info);
+  if (res != ResOK) /* should try some other trace, really @@@@ */
+    goto failCondemn;
+  if (TraceIsEmpty(trace))
+    goto nothingCondemned;
+  res = TraceStart(trace, mortality, trace->condemned * TraceWorkFactor);
+  /* We don't expect normal GC traces to fail to start. */
+  AVER(res == ResOK);
+  *traceReturn = trace;
+  return TRUE;
+
+nothingCondemned:
+failCondemn:
+  TraceDestroyInit(trace);
+failStart:
+  return FALSE;
+}
+
+
 /* PolicyStartTrace -- consider starting a trace
  *
  * If collectWorldAllowed is TRUE, consider starting a collection of
@@ -284,83 +467,185 @@ failBegin:
 
 Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
                       Arena arena, Bool collectWorldAllowed)
+{
+  mps_policy_info_s info;
+
+  AVER(traceReturn != NULL);
+  AVERT(Arena, arena);
+
+  policyInfo(&info, arena, collectWorldAllowed, 0.0, ClockNow());
+  return policyStartTrace(traceReturn, collectWorldReturn, arena, &info,
+                          collectWorldAllowed && info.world_deferral < 0.0,
+                          TraceStartWhyDYNAMICCRITERION,
+                          policyChainDue(&info));
+}
+
+
+/* PolicyStepTrace -- consider starting a trace in idle time
+ *
+ * This is the policy behind mps_arena_step.  No trace may be running.
+ * stepTime is the time available for collection, in seconds, and now
+ * is the current time.
+ *
+ * If a trace was started, update *traceReturn and return TRUE.
+ * Otherwise, leave *traceReturn unchanged and return FALSE.
+ */
+
+Bool PolicyStepTrace(Trace *traceReturn, Arena arena, double stepTime,
+                     Clock now)
+{
+  mps_policy_info_s info;
+  Bool collectWorld = FALSE;
+
+  AVER(traceReturn != NULL);
+  AVERT(Arena, arena);
+  /* Can't collect the world if we're already collecting. */
+  AVER(arena->busyTraces == TraceSetEMPTY);
+
+  policyInfo(&info, arena, TRUE, stepTime, now);
+  if (!policyStartTrace(traceReturn, &collectWorld, arena, &info,
+                        policyShouldCollectWorld(&info),
+                        TraceStartWhyOPPORTUNISM, policyChainDue(&info)))
+    return FALSE;
+  if (collectWorld)
+    arena->lastWorldCollect = now;
+  return TRUE;
+}
+
+
+/* PolicyIdleTrace -- consider starting a trace before a deadline
+ *
+ * This is the policy behind mps_arena_collect_until.  No trace may be
+ * running.  idleTime is the time left before the deadline, in
+ * seconds, and now is the current time.  The world is considered as
+ * for mps_arena_step if worldAllowed is TRUE, and chains are
+ * considered if chainAllowed is TRUE.  A chain that is not yet due
+ * may be collected early (see policyChainIdle).
+ *
+ * If a trace was started, update *traceReturn and return TRUE.
+ * Otherwise, leave *traceReturn unchanged and return FALSE.
+ */
+
+Bool PolicyIdleTrace(Trace *traceReturn, Arena arena, double idleTime,
+                     Clock now, Bool worldAllowed, Bool chainAllowed)
+{
+  mps_policy_info_s info;
+  Bool collectWorld = FALSE;
+  Chain chain = NULL;
+
+  AVER(traceReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(idleTime >= 0.0);
+  AVERT(Bool, worldAllowed);
+  AVERT(Bool, chainAllowed);
+  AVER(arena->busyTraces == TraceSetEMPTY);
+
+  policyInfo(&info, arena, worldAllowed, idleTime, now);
+  if (chainAllowed) {
+    chain = policyChainDue(&info);
+    if (chain == NULL && policyChainIdle(info.chain, &info))
+      chain = info.chain;
+  }
+  if (!policyStartTrace(traceReturn, &collectWorld, arena, &info,
+                        worldAllowed && policyShouldCollectWorld(&info),
+                        TraceStartWhyOPPORTUNISM, chain))
+    return FALSE;
+  if (collectWorld)
+    arena->lastWorldCollect = now;
+  return TRUE;
+}
+
+
+/* PolicyPressureTrace -- consider collecting the world under pressure
+ *
+ * Called when the arena is under memory pressure (see
+ * ArenaPressurePoll).  Collecting the world frees the most memory,
+ * but if the pressure persists, don't spend more than
+ * ARENA_MAX_COLLECT_FRACTION of the time doing it.  No trace may be
+ * running.  See <design/strategy/#policy.pressure>.
+ *
+ * If a trace was started, update *traceReturn and return TRUE.
+ * Otherwise, leave *traceReturn unchanged and return FALSE.
+ */
+
+Bool PolicyPressureTrace(Trace *traceReturn, Arena arena, Clock now)
 {
   Res res;
   Trace trace;
+  double since;
 
   AVER(traceReturn != NULL);
   AVERT(Arena, arena);
+  AVER(arena->underPressure);
+  AVER(arena->busyTraces == TraceSetEMPTY);
 
-  if (collectWorldAllowed) {
-    Size sFoundation, sCondemned, sSurvivors, sConsTrace;
-    double tTracePerScan; /* tTrace/cScan */
-    double dynamicDeferral;
-
-    /* Compute dynamic criterion.  See strategy.lisp-machine. */
-    sFoundation = (Size)0; /* condemning everything, only roots @@@@ */
-    /* @@@@ sCondemned should be scannable only */
-    sCondemned = ArenaCommitted(arena) - ArenaSpareCommitted(arena);
-    sSurvivors = (Size)(sCondemned * (1 - arena->topGen.mortality));
-    tTracePerScan = sFoundation + (sSurvivors * (1 + TraceCopyScanRATIO));
-    AVER(TraceWorkFactor >= 0);
-    AVER(sSurvivors + tTracePerScan * TraceWorkFactor <= (double)SizeMAX);
-    sConsTrace = (Size)(sSurvivors + tTracePerScan * TraceWorkFactor);
-    dynamicDeferral = (double)ArenaAvail(arena) - (double)sConsTrace;
-
-    if (dynamicDeferral < 0.0) {
-      /* Start full collection. */
-      res = TraceStartCollectAll(&trace, arena, TraceStartWhyDYNAMICCRITERION);
-      if (res != ResOK)
-        goto failStart;
-      *collectWorldReturn = TRUE;
-      *traceReturn = trace;
-      return TRUE;
-    }
-  }
-  {
-    /* Find the chain most over its capacity. */
-    Ring node, nextNode;
-    double firstTime = 0.0;
-    Chain firstChain = NULL;
-
-    RING_FOR(node, &arena->chainRing, nextNode) {
-      Chain chain = RING_ELT(Chain, chainRing, node);
-      double time;
-
-      AVERT(Chain, chain);
-      time = ChainDeferral(chain);
-      if (time < firstTime) {
-        firstTime = time; firstChain = chain;
-      }
-    }
+  since = (now - arena->lastWorldCollect) / (double)ClocksPerSec();
+  if (since <= policyCollectionTime(arena) / ARENA_MAX_COLLECT_FRACTION)
+    return FALSE;
 
-    /* If one was found, start collection on that chain. */
-    if(firstTime < 0) {
-      double mortality;
-
-      res = TraceCreate(&trace, arena, TraceStartWhyCHAIN_GEN0CAP);
-      AVER(res == ResOK);
-      trace->chain = firstChain;
-      ChainStartTrace(firstChain, trace);
-      res = policyCondemnChain(&mortality, firstChain, trace);
-      if (res != ResOK) /* should try some other trace, really @@@@ */
-        goto failCondemn;
-      if (TraceIsEmpty(trace))
-        goto nothingCondemned;
-      res = TraceStart(trace, mortality, trace->condemned * TraceWorkFactor);
-      /* We don't expect normal GC traces to fail to start. */
-      AVER(res == ResOK);
-      *traceReturn = trace;
-      return TRUE;
-    }
-  } /* (dynamicDeferral > 0.0) */
-  return FALSE;
+  res = TraceStartCollectAll(&trace, arena, TraceStartWhyPRESSURE);
+  if (res != ResOK)
+    return FALSE;
+  arena->lastWorldCollect = now;
+  *traceReturn = trace;
+  return TRUE;
+}
 
-nothingCondemned:
-failCondemn:
-  TraceDestroyInit(trace);
-failStart:
-  return FALSE;
+
+/* PolicyGenCapacity -- choose the capacity of an adaptive generation
+ *
+ * Called after a trace that condemned condemned bytes in the
+ * generation, of which survived bytes survived.  interval is the time
+ * in seconds since the generation was last collected.  Return the
+ * new capacity in kB, within the generation's bounds.  See
+ * <design/strategy/#policy.gen.impl>.
+ */
+
+Size PolicyGenCapacity(Arena arena, GenDesc gen, Size condemned,
+                       Size survived, double interval)
+{
+  double workTime, budget, factor = 1.0, capacity;
+
+  AVERT(Arena, arena);
+  AVERT(GenDesc, gen);
+  AVER(gen->adaptive);
+  AVER(survived <= condemned);
+  AVER(interval >= 0.0);
+
+  /* How long did tracing the survivors take?  On the background
+     thread tracing doesn't pause the mutator, so the pause time doesn't
+     limit it.  <design/trace/#background.pause> */
+  workTime = survived / policyCollectionRate(arena);
+  budget = ArenaPauseTime(arena) * LocusAdaptPAUSES;
+
+  if (arena->background == NULL && workTime > budget) {
+    /* Too big: shrink so that the survivors can be traced in time. */
+    factor = budget / workTime;
+  } else if (interval > 0.0 && condemned > 0) {
+    /* The generation filled at condemned / interval bytes per second,
+     * so it is collected every capacity / rate seconds.  If it spends
+     * too large a fraction of that tracing survivors, objects aren't
+     * getting enough time to die: grow it in proportion. */
+    double rate = condemned / interval;
+    double overhead = workTime * rate / (gen->capacity * 1024.0);
+    if (overhead > ARENA_MAX_COLLECT_FRACTION)
+      factor = overhead / ARENA_MAX_COLLECT_FRACTION;
+  }
+
+  if (factor > LocusAdaptSTEP)
+    factor = LocusAdaptSTEP;
+  if (factor < 1.0 / LocusAdaptSTEP)
+    factor = 1.0 / LocusAdaptSTEP;
+  if (1.0 - LocusAdaptHYSTERESIS < factor
+      && factor < 1.0 + LocusAdaptHYSTERESIS)
+    return gen->capacity;
+
+  capacity = gen->capacity * factor;
+  if (capacity < (double)gen->minCapacity)
+    return gen->minCapacity;
+  if (capacity > (double)gen->maxCapacity)
+    return gen->maxCapacity;
+  return (Size)capacity;
 }
 
 
@@ -379,29 +664,59 @@ Bool PolicyPoll(Arena arena)
 }
 
 
+/* PolicyPollTime -- how long to do collection work in a poll?
+ *
+ * Return the time in seconds for which a poll may do collection work.
+ * This is the arena's pause time, unless the client policy says
+ * otherwise.  See <design/strategy/#policy.client.poll>.
+ */
+
+double PolicyPollTime(Arena arena)
+{
+  Policy policy;
+  mps_policy_info_s info;
+  double pollTime;
+
+  AVERT(Arena, arena);
+
+  policy = arena->policy;
+  if (policy == NULL || policy->poll == NULL)
+    return ArenaPauseTime(arena);
+
+  policyInfo(&info, arena, arena->busyTraces == TraceSetEMPTY,
+             0.0, ClockNow());
+  pollTime = (*policy->poll)(arena, &info, policy->closure);
+  AVER(pollTime >= 0.0);
+  return pollTime;
+}
+
+
 /* PolicyPollAgain -- do another unit of work?
  *
  * Return TRUE if the MPS should do another unit of work; FALSE if it
  * should return to the mutator.
  *
  * start is the clock time when the MPS was entered.
+ * pollTime is the result of PolicyPollTime for this poll.
  * moreWork and tracedWork are the results of the last call to TracePoll.
  */
 
-Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork)
+Bool PolicyPollAgain(Arena arena, Clock start, double pollTime,
+                     Bool moreWork, Work tracedWork)
 {
   Bool moreTime;
   Globals globals;
   double nextPollThreshold;
 
   AVERT(Arena, arena);
+  AVER(pollTime >= 0.0);
   UNUSED(tracedWork);
 
   if (ArenaEmergency(arena))
     return TRUE;
 
   /* Is there more work to do and more time to do it in? */
-  moreTime = (ClockNow() - start) < ArenaPauseTime(arena) * ClocksPerSec();
+  moreTime = (ClockNow() - start) < pollTime * ClocksPerSec();
   if (moreWork && moreTime)
     return TRUE;
 
@@ -409,22 +724,117 @@ Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork)
 
   globals = ArenaGlobals(arena);
 
-  if (moreWork) {
-    /* We did one quantum of work; consume one unit of 'time'. */
-    nextPollThreshold = globals->pollThreshold + ArenaPollALLOCTIME;
-  } else {
-    /* No more work to do.  Sleep until NOW + a bit. */
+  if (arena->background != NULL) {
+    /* The background collector carries on by itself while there is
+     * more work, and polls run ahead of the mutator, so just wake it
+     * again after NOW + a bit.  <design/trace/#background.poll> */
     nextPollThreshold = globals->fillMutatorSize + ArenaPollALLOCTIME;
-  }
+    AVER(nextPollThreshold > globals->fillMutatorSize);
+  } else {
+    if (moreWork) {
+      /* We did one quantum of work; consume one unit of 'time'. */
+      nextPollThreshold = globals->pollThreshold + ArenaPollALLOCTIME;
+    } else {
+      /* No more work to do.  Sleep until NOW + a bit. */
+      nextPollThreshold = globals->fillMutatorSize + ArenaPollALLOCTIME;
+    }
 
-  /* Advance pollThreshold; check: enough precision? */
-  AVER(nextPollThreshold > globals->pollThreshold);
+    /* Advance pollThreshold; check: enough precision? */
+    AVER(nextPollThreshold > globals->pollThreshold);
+  }
   globals->pollThreshold = nextPollThreshold;
 
   return FALSE;
 }
 
 
+/* PolicyCheck -- check the consistency of a client policy */
+
+Bool PolicyCheck(Policy policy)
+{
+  CHECKS(Policy, policy);
+  CHECKU(Arena, policy->arena);
+  CHECKL(policy->start == NULL || FUNCHECK(policy->start));
+  CHECKL(policy->condemn == NULL || FUNCHECK(policy->condemn));
+  CHECKL(policy->poll == NULL || FUNCHECK(policy->poll));
+  /* closure can't be checked */
+  return TRUE;
+}
+
+
+/* PolicyCreate -- create a client policy and install it in the arena
+ *
+ * An arena has at most one client policy.  See
+ * <design/strategy/#policy.client>.
+ */
+
+ARG_DEFINE_KEY(POLICY_START, Fun);
+ARG_DEFINE_KEY(POLICY_CONDEMN, Fun);
+ARG_DEFINE_KEY(POLICY_POLL, Fun);
+ARG_DEFINE_KEY(POLICY_CLOSURE, Pointer);
+
+Res PolicyCreate(Policy *policyReturn, Arena arena, ArgList args)
+{
+  ArgStruct arg;
+  Policy policy;
+  Res res;
+  void *p;
+  mps_policy_start_t start = NULL;
+  mps_policy_condemn_t condemn = NULL;
+  mps_policy_poll_t poll = NULL;
+  void *closure = NULL;
+
+  AVER(policyReturn != NULL);
+  AVERT(Arena, arena);
+  AVERT(ArgList, args);
+  AVER(arena->policy == NULL);
+
+  if (ArgPick(&arg, args, MPS_KEY_POLICY_START))
+    start = arg.val.policy_start;
+  if (ArgPick(&arg, args, MPS_KEY_POLICY_CONDEMN))
+    condemn = arg.val.policy_condemn;
+  if (ArgPick(&arg, args, MPS_KEY_POLICY_POLL))
+    poll = arg.val.policy_poll;
+  if (ArgPick(&arg, args, MPS_KEY_POLICY_CLOSURE))
+    closure = arg.val.p;
+
+  res = ControlAlloc(&p, arena, sizeof(PolicyStruct));
+  if (res != ResOK)
+    return res;
+  policy = (Policy)p; /* avoid pun */
+
+  policy->arena = arena;
+  policy->start = start;
+  policy->condemn = condemn;
+  policy->poll = poll;
+  policy->closure = closure;
+
+  policy->sig = PolicySig;
+  AVERT(Policy, policy);
+
+  arena->policy = policy;
+
+  *policyReturn = policy;
+  return ResOK;
+}
+
+
+/* PolicyDestroy -- remove a client policy and destroy it */
+
+void PolicyDestroy(Policy policy)
+{
+  Arena arena;
+
+  AVERT(Policy, policy);
+  arena = policy->arena;
+  AVER(arena->policy == policy);
+
+  arena->policy = NULL;
+  policy->sig = SigInvalid;
+  ControlFree(arena, policy, sizeof(PolicyStruct));
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
@@ -41,10 +41,15 @@ Bool PoolClassCheck(PoolClass klass)
   CHECKL(klass->size >= sizeof(PoolStruct));
   CHECKL(AttrCheck(klass->attr));
   CHECKL(!(klass->attr & AttrMOVINGGC) || (klass->attr & AttrGC));
+  CHECKL(!(klass->attr & AttrPARALLEL) || (klass->attr & AttrGC));
+  CHECKL(!(klass->attr & AttrLAZY) || (klass->attr & AttrGC));
+  CHECKL(!(klass->attr & AttrPARALLELFIX) || (klass->attr & AttrGC));
   CHECKL(FUNCHECK(klass->varargs));
   CHECKL(FUNCHECK(klass->init));
   CHECKL(FUNCHECK(klass->alloc));
   CHECKL(FUNCHECK(klass->free));
+  CHECKL(FUNCHECK(klass->allocFast));
+  CHECKL(FUNCHECK(klass->freeFast));
   CHECKL(FUNCHECK(klass->bufferFill));
   CHECKL(FUNCHECK(klass->bufferEmpty));
   CHECKL(FUNCHECK(klass->access));
@@ -61,6 +66,7 @@ Bool PoolClassCheck(PoolClass klass)
   CHECKL(FUNCHECK(klass->framePop));
   CHECKL(FUNCHECK(klass->walk));
   CHECKL(FUNCHECK(klass->freewalk));
+  CHECKL(FUNCHECK(klass->addrObject));
   CHECKL(FUNCHECK(klass->bufferClass));
   CHECKL(FUNCHECK(klass->debugMixin));
   CHECKL(FUNCHECK(klass->totalSize));
@@ -276,6 +282,44 @@ void PoolFree(Pool pool, Addr old, Size size)
 }
 
 
+/* PoolAllocFast, PoolFreeFast -- try to allocate or free without
+ * the arena lock
+ *
+ * Return TRUE if the pool class satisfied the request on its own,
+ * or FALSE if the caller must claim the arena lock and call
+ * PoolAlloc or PoolFree instead.  See <design/pool/#method.alloc-fast>.
+ *
+ * .fast.check: Only the signature of the pool is checked, because a
+ * full check would read structures protected by the arena lock.
+ *
+ * .fast.event: The PoolAlloc and PoolFree events can't be written
+ * without the arena lock, so the fast path is declined while object
+ * events are being recorded.
+ */
+
+Bool PoolAllocFast(Addr *pReturn, Pool pool, Size size)
+{
+  AVER_CRITICAL(pReturn != NULL);
+  AVER_CRITICAL(TESTT(Pool, pool)); /* .fast.check */
+  AVER_CRITICAL(size > 0);
+
+  if (EventKindIsEnabled(EventKindObject)) /* .fast.event */
+    return FALSE;
+  return Method(Pool, pool, allocFast)(pReturn, pool, size);
+}
+
+Bool PoolFreeFast(Pool pool, Addr old, Size size)
+{
+  AVER_CRITICAL(TESTT(Pool, pool)); /* .fast.check */
+  AVER_CRITICAL(old != NULL);
+  AVER_CRITICAL(size > 0);
+
+  if (EventKindIsEnabled(EventKindObject)) /* .fast.event */
+    return FALSE;
+  return Method(Pool, pool, freeFast)(pool, old, size);
+}
+
+
 Res PoolAccess(Pool pool, Seg seg, Addr addr,
                AccessSet mode, MutatorContext context)
 {
@@ -418,6 +462,25 @@ void PoolWalk(Pool pool, Seg seg, FormattedObjectsVisitor f, void *p, size_t s)
 }
 
 
+/* PoolAddrObject -- find the client object containing an address
+ *
+ * Returns ResUNIMPL if the pool can't find objects, and ResFAIL if
+ * there is no object at the address that it is safe to scan.
+ */
+
+Res PoolAddrObject(Addr *pReturn, Pool pool, Seg seg, Addr addr)
+{
+  AVER(pReturn != NULL);
+  AVERT(Pool, pool);
+  AVERT(Seg, seg);
+  AVER(SegPool(seg) == pool);
+  AVER(SegBase(seg) <= addr);
+  AVER(addr < SegLimit(seg));
+
+  return Method(Pool, pool, addrObject)(pReturn, pool, seg, addr);
+}
+
+
 /* PoolFreeWalk -- walk free blocks in this pool
  *
  * PoolFreeWalk is not required to find all free blocks.
@@ -195,6 +195,8 @@ DEFINE_CLASS(Pool, AbstractPool, klass)
   klass->init = PoolAbsInit;
   klass->alloc = PoolNoAlloc;
   klass->free = PoolNoFree;
+  klass->allocFast = PoolNoAllocFast;
+  klass->freeFast = PoolNoFreeFast;
   klass->bufferFill = PoolNoBufferFill;
   klass->bufferEmpty = PoolNoBufferEmpty;
   klass->access = PoolNoAccess;
@@ -211,6 +213,7 @@ DEFINE_CLASS(Pool, AbstractPool, klass)
   klass->framePop = PoolNoFramePop;
   klass->walk = PoolNoWalk;
   klass->freewalk = PoolTrivFreeWalk;
+  klass->addrObject = PoolTrivAddrObject;
   klass->bufferClass = PoolNoBufferClass;
   klass->debugMixin = PoolNoDebugMixin;
   klass->totalSize = PoolNoSize;
@@ -298,6 +301,29 @@ void PoolTrivFree(Pool pool, Addr old, Size size)
 }
 
 
+/* PoolNoAllocFast, PoolNoFreeFast -- decline the fast path
+ *
+ * These are called without the arena lock, so they must not check
+ * the pool.  See <design/pool/#method.alloc-fast>.
+ */
+
+Bool PoolNoAllocFast(Addr *pReturn, Pool pool, Size size)
+{
+  UNUSED(pReturn);
+  UNUSED(pool);
+  UNUSED(size);
+  return FALSE;
+}
+
+Bool PoolNoFreeFast(Pool pool, Addr old, Size size)
+{
+  UNUSED(pool);
+  UNUSED(old);
+  UNUSED(size);
+  return FALSE;
+}
+
+
 Res PoolNoBufferFill(Addr *baseReturn, Addr *limitReturn,
                      Pool pool, Buffer buffer, Size size)
 {
@@ -441,7 +467,9 @@ Res PoolNoAccess(Pool pool, Seg seg, Addr addr,
  *
  * Should be used (for the access method) by Pool Classes which intend
  * to handle page faults by scanning the entire segment and lowering
- * the barrier.
+ * the barrier.  Formatted pools that can find the object containing an
+ * address may have a read barrier hit handled by scanning just that
+ * object instead; see <design/trace/#single-access>.
  */
 Res PoolSegAccess(Pool pool, Seg seg, Addr addr,
                   AccessSet mode, MutatorContext context)
@@ -454,8 +482,11 @@ Res PoolSegAccess(Pool pool, Seg seg, Addr addr,
   AVERT(AccessSet, mode);
   AVERT(MutatorContext, context);
 
-  UNUSED(addr);
-  UNUSED(context);
+  /* Scan just the object that was touched, if that pays.  See
+     <design/trace/#single-access>. */
+  if (TraceSingleAccess(PoolArena(pool), seg, addr, mode, context) == ResOK)
+    return ResOK;
+
   TraceSegAccess(PoolArena(pool), seg, mode);
   return ResOK;
 }
@@ -473,9 +504,9 @@ Res PoolSegAccess(Pool pool, Seg seg, Addr addr,
  *
  * .single-access.assume.ref: It currently assumes that the address
  * being faulted on contains a plain reference or a tagged non-reference.
- * .single-access.improve.format: Later this will be abstracted
- * through the cleint object format interface, so that
- * no such assumption is necessary.
+ * .single-access.improve.format: For formatted pools, TraceSingleAccess
+ * scans the whole object through the format instead, so that no such
+ * assumption is necessary.  See <design/trace/#single-access.object>.
  */
 Res PoolSingleAccess(Pool pool, Seg seg, Addr addr,
                      AccessSet mode, MutatorContext context)
@@ -507,12 +538,18 @@ Res PoolSingleAccess(Pool pool, Seg seg, Addr addr,
       /* (we assume it is not a reference otherwise). */
       if(WordIsAligned((Word)ref, sizeof(Word))) {
         Rank rank;
+        TraceSet grey;
+        TraceId ti;
+        Trace trace;
         /* See the note in TraceRankForAccess */
         /* (<code/trace.c#scan.conservative>). */
         
-        rank = TraceRankForAccess(arena, seg);
-        TraceScanSingleRef(arena->flippedTraces, rank, arena,
-                           seg, (Ref *)addr);
+        grey = TraceSetInter(SegGrey(seg), arena->flippedTraces);
+        TRACE_SET_ITER(ti, trace, grey, arena)
+          rank = TraceRankForAccess(trace, seg);
+          TraceScanSingleRef(TraceSetSingle(trace), rank, arena,
+                             seg, (Ref *)addr);
+        TRACE_SET_ITER_END(ti, trace, grey, arena);
       }
     }
     res = MutatorContextStepInstruction(context);
@@ -576,7 +613,7 @@ void PoolTrivGrey(Pool pool, Trace trace, Seg seg)
   /* segs. */
   /* @@@@ This should not really be called 'trivial'! */
   if(!TraceSetIsMember(SegWhite(seg), trace))
-    SegSetGrey(seg, TraceSetSingle(trace));
+    SegSetGrey(seg, TraceSetAdd(SegGrey(seg), trace));
 }
 
 
@@ -727,6 +764,17 @@ void PoolTrivFreeWalk(Pool pool, FreeBlockVisitor f, void *p)
 }
 
 
+Res PoolTrivAddrObject(Addr *pReturn, Pool pool, Seg seg, Addr addr)
+{
+  AVER(pReturn != NULL);
+  AVERT(Pool, pool);
+  AVERT(Seg, seg);
+  UNUSED(addr);
+
+  return ResUNIMPL;
+}
+
+
 BufferClass PoolNoBufferClass(void)
 {
   NOTREACHED;
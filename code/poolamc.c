@@ -48,7 +48,9 @@ DECLARE_CLASS(Seg, amcSeg, GCSeg);
 typedef struct amcGenStruct {
   PoolGenStruct pgen;
   RingStruct amcRing;           /* link in list of gens in pool */
-  Buffer forward;               /* forwarding buffer */
+  Count forwardCount;           /* number of forwarding buffers */
+  Buffer *forward;              /* forwarding buffer for each collector
+                                   thread, <design/poolamc/#fix.parallel> */
   Sig sig;                      /* <code/misc.h#sig> */
 } amcGenStruct;
 
@@ -92,6 +94,19 @@ enum {
  * collection via TracePoll), and by hash array allocations (where we
  * don't want the allocation to provoke a collection that makes the
  * location dependency stale immediately).
+ *
+ * .seg.copied: The "copied" field is the set of traces that have
+ * forwarded objects into the segment. The broken hearts left behind
+ * point here until those traces reclaim their white segments, so
+ * another trace must not condemn the segment and move the objects
+ * again in the meantime. See <design/poolamc/#seg.copied>.
+ *
+ * .seg.last-object: The "lastObject" field is the base of the object
+ * that AMCAddrObject last found in the segment, or NULL.  Objects below
+ * the scan limit don't move or change size until the segment is
+ * reclaimed, so the next search can start there rather than at the
+ * base of the segment.  amcReclaimNailed pads over dead objects, so it
+ * resets the field.
  */
 
 typedef struct amcSegStruct *amcSeg;
@@ -103,6 +118,8 @@ typedef struct amcSegStruct {
   amcGen gen;               /* generation this segment belongs to */
   Nailboard board;          /* nailboard for this segment or NULL if none */
   Size forwarded[TraceLIMIT]; /* size of objects forwarded for each trace */
+  TraceSet copied;          /* .seg.copied */
+  Addr lastObject;          /* .seg.last-object */
   BOOLFIELD(accountedAsBuffered); /* .seg.accounted-as-buffered */
   BOOLFIELD(old);           /* .seg.old */
   BOOLFIELD(deferred);      /* .seg.deferred */
@@ -116,6 +133,10 @@ static Bool amcSegCheck(amcSeg amcseg)
   CHECKS(amcSeg, amcseg);
   CHECKD(GCSeg, &amcseg->gcSegStruct);
   CHECKU(amcGen, amcseg->gen);
+  CHECKL(TraceSetCheck(amcseg->copied));
+  CHECKL(amcseg->lastObject == NULL
+         || (SegBase(MustBeA(Seg, amcseg)) <= amcseg->lastObject
+             && amcseg->lastObject < SegLimit(MustBeA(Seg, amcseg))));
   if (amcseg->board) {
     CHECKD(Nailboard, amcseg->board);
     CHECKL(SegNailed(MustBeA(Seg, amcseg)) != TraceSetEMPTY);
@@ -150,6 +171,8 @@ static Res AMCSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 
   amcseg->gen = amcgen;
   amcseg->board = NULL;
+  amcseg->copied = TraceSetEMPTY;
+  amcseg->lastObject = NULL;
   amcseg->accountedAsBuffered = FALSE;
   amcseg->old = FALSE;
   amcseg->deferred = FALSE;
@@ -407,7 +430,9 @@ static Bool amcGenCheck(amcGen gen)
   CHECKD(PoolGen, &gen->pgen);
   amc = amcGenAMC(gen);
   CHECKU(AMC, amc);
-  CHECKD(Buffer, gen->forward);
+  CHECKL(gen->forwardCount >= 1);
+  CHECKL(gen->forward != NULL);
+  CHECKD(Buffer, gen->forward[0]);
   CHECKD_NOSIG(Ring, &gen->amcRing);
 
   return TRUE;
@@ -536,8 +561,10 @@ static Res amcGenCreate(amcGen *genReturn, AMC amc, GenDesc gen)
 {
   Pool pool = MustBeA(AbstractPool, amc);
   Arena arena;
-  Buffer buffer;
+  Buffer *forward;
+  Count count;
   amcGen amcgen;
+  Index i;
   Res res;
   void *p;
 
@@ -548,15 +575,25 @@ static Res amcGenCreate(amcGen *genReturn, AMC amc, GenDesc gen)
     goto failControlAlloc;
   amcgen = (amcGen)p;
 
-  res = BufferCreate(&buffer, CLASS(amcBuf), pool, FALSE, argsNone);
+  /* One forwarding buffer for each collector thread, so that threads
+     copy without a lock.  See <design/poolamc/#fix.parallel>. */
+  count = arena->gcThreads;
+  res = ControlAlloc(&p, arena, count * sizeof(Buffer));
   if(res != ResOK)
-    goto failBufferCreate;
+    goto failForwardAlloc;
+  forward = p;
+  for (i = 0; i < count; ++i) {
+    res = BufferCreate(&forward[i], CLASS(amcBuf), pool, FALSE, argsNone);
+    if(res != ResOK)
+      goto failBufferCreate;
+  }
 
   res = PoolGenInit(&amcgen->pgen, gen, pool);
   if(res != ResOK)
     goto failGenInit;
   RingInit(&amcgen->amcRing);
-  amcgen->forward = buffer;
+  amcgen->forwardCount = count;
+  amcgen->forward = forward;
   amcgen->sig = amcGenSig;
 
   AVERT(amcGen, amcgen);
@@ -567,9 +604,14 @@ static Res amcGenCreate(amcGen *genReturn, AMC amc, GenDesc gen)
   return ResOK;
 
 failGenInit:
-  BufferDestroy(buffer);
 failBufferCreate:
-  ControlFree(arena, p, sizeof(amcGenStruct));
+  while (i > 0) {
+    --i;
+    BufferDestroy(forward[i]);
+  }
+  ControlFree(arena, forward, count * sizeof(Buffer));
+failForwardAlloc:
+  ControlFree(arena, amcgen, sizeof(amcGenStruct));
 failControlAlloc:
   return res;
 }
@@ -580,6 +622,7 @@ failControlAlloc:
 static void amcGenDestroy(amcGen gen)
 {
   Arena arena;
+  Index i;
 
   AVERT(amcGen, gen);
 
@@ -589,7 +632,9 @@ static void amcGenDestroy(amcGen gen)
   RingRemove(&gen->amcRing);
   RingFinish(&gen->amcRing);
   PoolGenFinish(&gen->pgen);
-  BufferDestroy(gen->forward);
+  for (i = 0; i < gen->forwardCount; ++i)
+    BufferDestroy(gen->forward[i]);
+  ControlFree(arena, gen->forward, gen->forwardCount * sizeof(Buffer));
   ControlFree(arena, gen, sizeof(amcGenStruct));
 }
 
@@ -598,6 +643,7 @@ static void amcGenDestroy(amcGen gen)
 
 static Res amcGenDescribe(amcGen gen, mps_lib_FILE *stream, Count depth)
 {
+  Index i;
   Res res;
 
   if(!TESTT(amcGen, gen))
@@ -606,10 +652,15 @@ static Res amcGenDescribe(amcGen gen, mps_lib_FILE *stream, Count depth)
     return ResFAIL;
 
   res = WriteF(stream, depth,
-               "amcGen $P {\n", (WriteFP)gen,
-               "  buffer $P\n", (WriteFP)gen->forward, NULL);
+               "amcGen $P {\n", (WriteFP)gen, NULL);
   if (res != ResOK)
     return res;
+  for (i = 0; i < gen->forwardCount; ++i) {
+    res = WriteF(stream, depth + 2,
+                 "buffer $P\n", (WriteFP)gen->forward[i], NULL);
+    if (res != ResOK)
+      return res;
+  }
 
   res = PoolGenDescribe(&gen->pgen, stream, depth + 2);
   if (res != ResOK)
@@ -620,6 +671,42 @@ static Res amcGenDescribe(amcGen gen, mps_lib_FILE *stream, Count depth)
 }
 
 
+/* amcGenSetForward -- set the generation a generation forwards to
+ *
+ * Sets the generation of all the generation's forwarding buffers.
+ * to may be NULL, to disassociate the buffers.
+ */
+
+static void amcGenSetForward(amcGen gen, amcGen to)
+{
+  Index i;
+  for (i = 0; i < gen->forwardCount; ++i)
+    amcBufSetGen(gen->forward[i], to);
+}
+
+
+/* amcGenDetachForward -- detach all of a generation's forwarding buffers */
+
+static void amcGenDetachForward(amcGen gen, Pool pool)
+{
+  Index i;
+  for (i = 0; i < gen->forwardCount; ++i)
+    BufferDetach(gen->forward[i], pool);
+}
+
+
+/* amcGenIsForward -- is a buffer one of a generation's forwarding buffers? */
+
+static Bool amcGenIsForward(amcGen gen, Buffer buffer)
+{
+  Index i;
+  for (i = 0; i < gen->forwardCount; ++i)
+    if (gen->forward[i] == buffer)
+      return TRUE;
+  return FALSE;
+}
+
+
 /* amcSegCreateNailboard -- create nailboard for segment */
 
 static Res amcSegCreateNailboard(Seg seg, Pool pool)
@@ -776,10 +863,10 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
     }
     /* Set up forwarding buffers. */
     for(i = 0; i < genCount; ++i) {
-      amcBufSetGen(amc->gen[i]->forward, amc->gen[i+1]);
+      amcGenSetForward(amc->gen[i], amc->gen[i+1]);
     }
     /* Dynamic gen forwards to itself. */
-    amcBufSetGen(amc->gen[genCount]->forward, amc->gen[genCount]);
+    amcGenSetForward(amc->gen[genCount], amc->gen[genCount]);
   }
   amc->nursery = amc->gen[0];
   amc->rampGen = amc->gen[genCount-1]; /* last ephemeral gen */
@@ -843,7 +930,7 @@ static void AMCFinish(Inst inst)
   /* buffers by this time. */
   RING_FOR(node, &amc->genRing, nextNode) {
     amcGen gen = RING_ELT(amcGen, amcRing, node);
-    BufferDetach(gen->forward, pool);
+    amcGenDetachForward(gen, pool);
   }
 
   ring = PoolSegRing(pool);
@@ -865,7 +952,7 @@ static void AMCFinish(Inst inst)
   ring = &amc->genRing;
   RING_FOR(node, ring, nextNode) {
     amcGen gen = RING_ELT(amcGen, amcRing, node);
-    amcBufSetGen(gen->forward, NULL);
+    amcGenSetForward(gen, NULL);
   }
   RING_FOR(node, ring, nextNode) {
     amcGen gen = RING_ELT(amcGen, amcRing, node);
@@ -912,12 +999,24 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   /* organize locations appropriately.  */
   if (size < amc->extendBy) {
     grainsSize = amc->extendBy; /* .extend-by.aligned */
+    /* <design/buffer/#refill.size> */
+    if (BufferIsMutator(buffer)) {
+      Size refillSize = BufferRefillSize(buffer, size);
+      if (refillSize > grainsSize)
+        grainsSize = refillSize;
+    }
   } else {
     grainsSize = SizeArenaGrains(size, arena);
   }
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD_FIELD(args, amcKeySegGen, p, gen);
     res = PoolGenAlloc(&seg, pgen, CLASS(amcSeg), grainsSize, args);
+    /* If the refill size is too much, fall back to the old size. */
+    if (res != ResOK && size < amc->extendBy
+        && grainsSize > amc->extendBy) {
+      grainsSize = amc->extendBy;
+      res = PoolGenAlloc(&seg, pgen, CLASS(amcSeg), grainsSize, args);
+    }
   } MPS_ARGS_END(args);
   if(res != ResOK)
     return res;
@@ -932,7 +1031,7 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   /* If ramping, or if the buffer is intended for allocating hash
    * table arrays, defer the size accounting. */
   if ((amc->rampMode == RampRAMPING
-       && buffer == amc->rampGen->forward
+       && amcGenIsForward(amc->rampGen, buffer)
        && gen == amc->rampGen)
       || amcbuf->forHashArrays) 
   {
@@ -1117,6 +1216,13 @@ static Res AMCWhiten(Pool pool, Trace trace, Seg seg)
 
   AVERT(Trace, trace);
 
+  /* Don't condemn objects that another running trace has forwarded
+     here: its broken hearts still point at them. See .seg.copied. */
+  if (TraceSetDel(TraceSetInter(amcseg->copied, PoolArena(pool)->busyTraces),
+                  trace)
+      != TraceSetEMPTY)
+    return ResOK;
+
   if (SegBuffer(&buffer, seg)) {
     AVERT(Buffer, buffer);
 
@@ -1194,22 +1300,25 @@ static Res AMCWhiten(Pool pool, Trace trace, Seg seg)
   }
 
   amcseg->forwarded[trace->ti] = 0;
+  amcseg->copied = TraceSetEMPTY;
   SegSetWhite(seg, TraceSetAdd(SegWhite(seg), trace));
   GenDescCondemned(gen->pgen.gen, trace, condemned + SegSize(seg));
 
   /* Ensure we are forwarding into the right generation. */
 
   /* see <design/poolamc/#gen.ramp> */
-  /* This switching needs to be more complex for multiple traces. */
-  AVER(TraceSetIsSingle(PoolArena(pool)->busyTraces));
-  if(amc->rampMode == RampBEGIN && gen == amc->rampGen) {
-    BufferDetach(gen->forward, pool);
-    amcBufSetGen(gen->forward, gen);
-    amc->rampMode = RampRAMPING;
-  } else if(amc->rampMode == RampFINISH && gen == amc->rampGen) {
-    BufferDetach(gen->forward, pool);
-    amcBufSetGen(gen->forward, amc->afterRampGen);
-    amc->rampMode = RampCOLLECTING;
+  /* This switching needs to be more complex for multiple traces, so */
+  /* it is deferred until only one trace is running. */
+  if(TraceSetIsSingle(PoolArena(pool)->busyTraces)) {
+    if(amc->rampMode == RampBEGIN && gen == amc->rampGen) {
+      amcGenDetachForward(gen, pool);
+      amcGenSetForward(gen, gen);
+      amc->rampMode = RampRAMPING;
+    } else if(amc->rampMode == RampFINISH && gen == amc->rampGen) {
+      amcGenDetachForward(gen, pool);
+      amcGenSetForward(gen, amc->afterRampGen);
+      amc->rampMode = RampCOLLECTING;
+    }
   }
 
   return ResOK;
@@ -1373,7 +1482,10 @@ static Res AMCScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg)
 
   format = pool->format;
 
-  if(amcSegHasNailboard(seg)) {
+  /* The nailboard records which objects are pinned for the traces in
+     SegNailed(seg). For any other trace the segment must be scanned in
+     full. See <design/trace/#multiple.white.foreign>. */
+  if(amcSegHasNailboard(seg) && TraceSetSub(ss->traces, SegNailed(seg))) {
     return amcScanNailed(totalReturn, ss, pool, seg, amc);
   }
 
@@ -1499,13 +1611,51 @@ fixInPlace: /* see <design/poolamc/>.Nailboard.emergency */
 }
 
 
+/* amcFixReserve, amcFixCommit -- allocate in a forwarding buffer
+ *
+ * Like BUFFER_RESERVE and BUFFER_COMMIT, but a collector thread claims
+ * the shared state if the buffer must be refilled or has tripped.  See
+ * <design/poolamc/#fix.parallel>.
+ */
+
+static Res amcFixReserve(Addr *pReturn, ScanState ss, Buffer buffer,
+                         Size size)
+{
+  Addr alloc = BufferAlloc(buffer);
+  Res res;
+
+  if (AddrAdd(alloc, size) > alloc
+      && AddrAdd(alloc, size) <= (Addr)BufferAP(buffer)->limit) {
+    *pReturn = alloc;
+    BufferAP(buffer)->alloc = AddrAdd(alloc, size);
+    return ResOK;
+  }
+  ScanStateSharedClaim(ss);
+  res = BufferFill(pReturn, buffer, size);
+  ScanStateSharedRelease(ss);
+  return res;
+}
+
+static Bool amcFixCommit(ScanState ss, Buffer buffer, Addr p, Size size)
+{
+  Bool committed;
+
+  BufferAP(buffer)->init = BufferAlloc(buffer);
+  if (BufferAP(buffer)->limit != 0)
+    return TRUE;
+  ScanStateSharedClaim(ss);
+  committed = BufferTrip(buffer, p, size);
+  ScanStateSharedRelease(ss);
+  return committed;
+}
+
+
 /* AMCFix -- fix a reference to the pool
  *
  * See <design/poolamc/#fix>.
  */
 static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
 {
-  Arena arena;
   AMC amc;
   Res res;
   Format format;       /* cache of pool->format */
@@ -1519,6 +1669,7 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
   amcGen gen;          /* generation of old copy of object */
   TraceSet grey;       /* greyness of object being relocated */
   Seg toSeg;           /* segment to which object is being relocated */
+  Bool exposed;        /* must cover seg before returning? */
   TraceId ti;
   Trace trace;
 
@@ -1537,6 +1688,8 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
   /* managing a nailed segment.  This involves marking the segment */
   /* as nailed, and setting up a per-word mark table */
   if(ss->rank == RankAMBIG) {
+    /* Nailing changes shared state: <design/poolamc/#fix.parallel>. */
+    ScanStateSharedClaim(ss);
     /* .nail.new: Check to see whether we need a Nailboard for */
     /* this seg.  We use "SegNailed(seg) == TraceSetEMPTY" */
     /* rather than "!amcSegHasNailboard(seg)" because this avoids */
@@ -1547,12 +1700,15 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
     /* nailboard). */
     if(SegNailed(seg) == TraceSetEMPTY) {
       res = amcSegCreateNailboard(seg, pool);
-      if(res != ResOK)
+      if(res != ResOK) {
+        ScanStateSharedRelease(ss);
         return res;
+      }
       STATISTIC(++ss->nailCount);
       SegSetNailed(seg, TraceSetUnion(SegNailed(seg), ss->traces));
     }
     amcFixInPlace(pool, seg, ss, refIO);
+    ScanStateSharedRelease(ss);
     return ResOK;
   }
 
@@ -1565,11 +1721,12 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
   base = AddrSub(ref, headerSize);
   AVER_CRITICAL(AddrIsAligned(base, PoolAlignment(pool)));  
   AVER_CRITICAL(ref < SegLimit(seg)); /* see .ref-limit */
-  arena = pool->arena;
 
   /* .exposed.seg: Statements tagged ".exposed.seg" below require */
-  /* that "seg" (that is: the 'from' seg) has been ShieldExposed. */
-  ShieldExpose(arena, seg);
+  /* that "seg" (that is: the 'from' seg) has been exposed for */
+  /* reading, and ".exposed.seg.write" for writing.  See */
+  /* <design/poolamc/#fix.parallel>. */
+  exposed = ScanStateExpose(ss, seg, AccessREAD);
   newRef = (*format->isMoved)(ref);  /* .exposed.seg */
 
   if(newRef == (Addr)0) {
@@ -1584,9 +1741,11 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
       /* Segment only needs greying if there are new traces for */
       /* which we are nailing. */
       if(!TraceSetSub(ss->traces, SegNailed(seg))) {
+        ScanStateSharedClaim(ss);
         if(SegRankSet(seg) != RankSetEMPTY) /* not for AMCZ */
           SegSetGrey(seg, TraceSetUnion(SegGrey(seg), ss->traces));
         SegSetNailed(seg, TraceSetUnion(SegNailed(seg), ss->traces));
+        ScanStateSharedRelease(ss);
       }
       res = ResOK;
       goto returnRes;
@@ -1601,45 +1760,68 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
     /* <design/fix/#protocol.was-marked> */
     ss->wasMarked = FALSE;
 
-    /* Get the forwarding buffer from the object's generation. */
+    if (!exposed)
+      exposed = ScanStateExpose(ss, seg, AccessWRITE);
+
+    /* Get this collector thread's forwarding buffer for the object's
+       generation.  Only this thread uses the buffer and the segment
+       it is attached to, so copying needs the shared state only to
+       refill the buffer, to expose the segment for the first time, or
+       to change its colour or summary.  See
+       <design/poolamc/#fix.parallel>. */
     gen = amcSegGen(seg);
-    buffer = gen->forward;
+    AVER_CRITICAL(ss->worker < gen->forwardCount);
+    buffer = gen->forward[ss->worker];
     AVER_CRITICAL(buffer != NULL);
 
     length = AddrOffset(ref, clientQ);  /* .exposed.seg */
     STATISTIC(++ss->forwardedCount);
     do {
-      res = BUFFER_RESERVE(&newBase, buffer, length);
+      Bool toExposed;   /* must cover toSeg after copying? */
+
+      res = amcFixReserve(&newBase, ss, buffer, length);
       if (res != ResOK)
         goto returnRes;
       newRef = AddrAdd(newBase, headerSize);
 
       toSeg = BufferSeg(buffer);
-      ShieldExpose(arena, toSeg);
+      toExposed = ScanStateExposeHeld(ss, toSeg);
 
       /* Since we're moving an object from one segment to another, */
       /* union the greyness and the summaries together. */
       grey = SegGrey(seg);
       if(SegRankSet(seg) != RankSetEMPTY) { /* not for AMCZ */
         grey = TraceSetUnion(grey, ss->traces);
-        SegSetSummary(toSeg, RefSetUnion(SegSummary(toSeg), SegSummary(seg)));
+        if (!RefSetSub(SegSummary(seg), SegSummary(toSeg))) {
+          ScanStateSharedClaim(ss);
+          SegSetSummary(toSeg, RefSetUnion(SegSummary(toSeg),
+                                           SegSummary(seg)));
+          ScanStateSharedRelease(ss);
+        }
       } else {
         AVER(SegRankSet(toSeg) == RankSetEMPTY);
       }
-      SegSetGrey(toSeg, TraceSetUnion(SegGrey(toSeg), grey));
+      if (!TraceSetSub(grey, SegGrey(toSeg))) {
+        ScanStateSharedClaim(ss);
+        SegSetGrey(toSeg, TraceSetUnion(SegGrey(toSeg), grey));
+        ScanStateSharedRelease(ss);
+      }
+      MustBeA_CRITICAL(amcSeg, toSeg)->copied
+        = TraceSetUnion(MustBeA_CRITICAL(amcSeg, toSeg)->copied, ss->traces);
 
       /* <design/trace/#fix.copy> */
       (void)AddrCopy(newBase, base, length);  /* .exposed.seg */
 
-      ShieldCover(arena, toSeg);
-    } while (!BUFFER_COMMIT(buffer, newBase, length));
+      if (toExposed)
+        ScanStateCover(ss, toSeg);
+    } while (!amcFixCommit(ss, buffer, newBase, length));
 
     STATISTIC(ss->copiedSize += length);
     TRACE_SET_ITER(ti, trace, ss->traces, ss->arena)
       MustBeA(amcSeg, seg)->forwarded[ti] += length;
     TRACE_SET_ITER_END(ti, trace, ss->traces, ss->arena);
 
-    (*format->move)(ref, newRef);  /* .exposed.seg */
+    (*format->move)(ref, newRef);  /* .exposed.seg.write */
 
     EVENT1(AMCFixForward, newRef);
   } else {
@@ -1655,7 +1837,8 @@ updateReference:
   res = ResOK;
 
 returnRes:
-  ShieldCover(arena, seg);  /* .exposed.seg */
+  if (exposed)
+    ScanStateCover(ss, seg);  /* .exposed.seg */
   return res;
 }
 
@@ -1686,6 +1869,7 @@ static void amcReclaimNailed(Pool pool, Trace trace, Seg seg)
 
   /* see <design/poolamc/#nailboard.limitations> for improvements */
   headerSize = format->headerSize;
+  MustBeA(amcSeg, seg)->lastObject = NULL; /* .seg.last-object */
   ShieldExpose(arena, seg);
   p = SegBase(seg);
   limit = SegBufferScanLimit(seg);
@@ -1786,9 +1970,10 @@ static void AMCReclaim(Pool pool, Trace trace, Seg seg)
 
   EVENT3(AMCReclaim, gen, trace, seg);
 
-  /* This switching needs to be more complex for multiple traces. */
-  AVER_CRITICAL(TraceSetIsSingle(PoolArena(pool)->busyTraces));
-  if(amc->rampMode == RampCOLLECTING) {
+  /* This switching needs to be more complex for multiple traces, so */
+  /* it is deferred until only one trace is running. */
+  if(amc->rampMode == RampCOLLECTING
+     && TraceSetIsSingle(PoolArena(pool)->busyTraces)) {
     if(amc->rampCount > 0) {
       /* Entered ramp mode before previous one was cleaned up */
       amc->rampMode = RampBEGIN;
@@ -1853,6 +2038,54 @@ static void AMCWalk(Pool pool, Seg seg, FormattedObjectsVisitor f,
 }
 
 
+/* AMCAddrObject -- find the object containing an address
+ *
+ * Walks the objects from the last object found in the segment, or
+ * from the base of the segment if addr is below that (see
+ * .seg.last-object), so that a mutator working forward through a
+ * segment pays for one walk in total rather than one per fault.
+ * Objects beyond the scan limit of a buffer may not be initialized,
+ * and only the nailed objects in a segment with a nailboard get
+ * scanned, so addresses in those are declined.
+ */
+
+static Res AMCAddrObject(Addr *pReturn, Pool pool, Seg seg, Addr addr)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  Addr base, limit;
+  Format format;
+
+  AVER(pReturn != NULL);
+  AVERC(AMCZPool, pool);
+  AVERT(Seg, seg);
+  AVER(SegBase(seg) <= addr);
+  AVER(addr < SegLimit(seg));
+
+  if (amcSegHasNailboard(seg))
+    return ResFAIL;
+  limit = SegBufferScanLimit(seg);
+  if (addr >= limit)
+    return ResFAIL;
+
+  format = pool->format;
+  base = amcseg->lastObject;
+  if (base == NULL || addr < base)
+    base = SegBase(seg);
+  for (;;) {
+    Addr object = AddrAdd(base, format->headerSize);
+    Addr next = AddrSub((*format->skip)(object), format->headerSize);
+    AVER(next > base);
+    if (addr < next) {
+      amcseg->lastObject = base;
+      *pReturn = object;
+      return ResOK;
+    }
+    base = next;
+    AVER(base < limit);
+  }
+}
+
+
 /* amcWalkAll -- Apply a function to all (black) objects in a pool */
 
 static void amcWalkAll(Pool pool, FormattedObjectsVisitor f, void *p, size_t s)
@@ -1981,7 +2214,7 @@ DEFINE_CLASS(Pool, AMCZPool, klass)
   klass->instClassStruct.describe = AMCDescribe;
   klass->instClassStruct.finish = AMCFinish;
   klass->size = sizeof(AMCStruct);
-  klass->attr |= AttrMOVINGGC;
+  klass->attr |= AttrMOVINGGC | AttrPARALLELFIX;
   klass->varargs = AMCVarargs;
   klass->init = AMCZInit;
   klass->bufferFill = AMCBufferFill;
@@ -1993,6 +2226,7 @@ DEFINE_CLASS(Pool, AMCZPool, klass)
   klass->rampBegin = AMCRampBegin;
   klass->rampEnd = AMCRampEnd;
   klass->walk = AMCWalk;
+  klass->addrObject = AMCAddrObject;
   klass->bufferClass = amcBufClassGet;
   klass->totalSize = AMCTotalSize;
   klass->freeSize = AMCFreeSize;  
@@ -2005,6 +2239,7 @@ DEFINE_CLASS(Pool, AMCPool, klass)
 {
   INHERIT_CLASS(klass, AMCPool, AMCZPool);
   PoolClassMixInScan(klass);
+  klass->attr |= AttrPARALLEL;
   klass->init = AMCInit;
   klass->scan = AMCScan;
 }
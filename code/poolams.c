@@ -785,7 +785,13 @@ static Res AMSInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   ams->grainShift = SizeLog2(PoolAlignment(pool));
   /* .ambiguous.noshare: If the pool is required to support ambiguous */
   /* references, the alloc and white tables cannot be shared. */
-  ams->shareAllocTable = !supportAmbiguous;
+  /* .multiple.noshare: Nor can they be shared if more than one trace */
+  /* may run, because a segment that is white for one trace may have */
+  /* to be scanned in full for another, and that needs the alloc */
+  /* table. This costs a bit per grain, and a copy of the table on */
+  /* reclaim. See <design/poolams/#colour.single> and */
+  /* <design/poolams/#init.share>. */
+  ams->shareAllocTable = !supportAmbiguous && TraceLIMIT == 1;
   ams->pgen = NULL;
 
   /* The next four might be overridden by a subclass. */
@@ -909,7 +915,7 @@ static Res AMSBufferFill(Addr *baseReturn, Addr *limitReturn,
   Addr baseAddr, limitAddr;
   RankSet rankSet;
   Bool b;                       /* the return value of amsSegAlloc */
-  Size allocatedSize;
+  Size allocatedSize, refillSize;
 
   AVER(baseReturn != NULL);
   AVER(limitReturn != NULL);
@@ -929,6 +935,13 @@ static Res AMSBufferFill(Addr *baseReturn, Addr *limitReturn,
   /* <design/poolams/#fill.slow> */
   RING_FOR(node, ring, nextNode) {
     seg = SegOfPoolRing(node);
+    /* Reclaim the segment now if it's awaiting lazy reclaim, see */
+    /* <design/poolams/#fill.lazy>. */
+    if (SegReclaimPending(seg)
+        && SegRankSet(seg) == rankSet
+        && !SegHasBuffer(seg)
+        && !TraceReclaimSeg(seg))
+      continue; /* segment was freed */
     amsseg = Seg2AMSSeg(seg);
     AVERT_CRITICAL(AMSSeg, amsseg);
     if (amsseg->freeGrains >= AMSGrains(ams, size)) {
@@ -945,8 +958,15 @@ static Res AMSBufferFill(Addr *baseReturn, Addr *limitReturn,
     }
   }
 
-  /* No suitable segment found; make a new one. */
-  res = AMSSegCreate(&seg, pool, size, rankSet);
+  /* No suitable segment found; make a new one.  For the mutator, make
+   * it large enough for several refills if possible.
+   * <design/buffer/#refill.size> */
+  refillSize = size;
+  if (BufferIsMutator(buffer))
+    refillSize = BufferRefillSize(buffer, size);
+  res = AMSSegCreate(&seg, pool, refillSize, rankSet);
+  if (res != ResOK && refillSize > size)
+    res = AMSSegCreate(&seg, pool, size, rankSet);
   if (res != ResOK)
     return res;
   b = amsSegAlloc(&base, &limit, seg, size);
@@ -1469,17 +1489,24 @@ static Res AMSFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
         if (SegRankSet(seg) == RankSetEMPTY && ss->rank != RankAMBIG) {
           /* <design/poolams/#fix.to-black> */
           Addr clientNext, next;
+          Bool exposed;
 
-          ShieldExpose(PoolArena(pool), seg);
+          exposed = ScanStateExpose(ss, seg, AccessREAD);
           clientNext = (*pool->format->skip)(clientRef);
-          ShieldCover(PoolArena(pool), seg);
+          if (exposed)
+            ScanStateCover(ss, seg);
           next = AddrSub(clientNext, format->headerSize);
           /* Part of the object might be grey, because of ambiguous */
           /* fixes, but that's OK, because scan will ignore that. */
           AMS_RANGE_WHITE_BLACKEN(seg, i, AMS_ADDR_INDEX(seg, next));
         } else { /* turn it grey */
           AMS_WHITE_GREYEN(seg, i);
-          SegSetGrey(seg, TraceSetUnion(SegGrey(seg), ss->traces));
+          /* <design/poolams/#fix.parallel> */
+          if (!TraceSetSub(ss->traces, SegGrey(seg))) {
+            ScanStateSharedClaim(ss);
+            SegSetGrey(seg, TraceSetUnion(SegGrey(seg), ss->traces));
+            ScanStateSharedRelease(ss);
+          }
           /* mark it for scanning - <design/poolams/#marked.fix> */
           amsseg->marksChanged = TRUE;
         }
@@ -1532,7 +1559,11 @@ static void AMSBlacken(Pool pool, TraceSet traceSet, Seg seg)
     AVERT(AMSSeg, amsseg);
     AVER(amsseg->marksChanged); /* there must be something grey */
     amsseg->marksChanged = FALSE;
+    /* amsIterate reads the objects to find their sizes, and the */
+    /* segment may be protected (it's grey). */
+    ShieldExpose(PoolArena(pool), seg);
     res = amsIterate(seg, amsBlackenObject, NULL);
+    ShieldCover(PoolArena(pool), seg);
     AVER(res == ResOK);
   }
 }
@@ -1676,6 +1707,67 @@ static void AMSWalk(Pool pool, Seg seg, FormattedObjectsVisitor f,
 }
 
 
+/* AMSAddrObject -- find the object containing an address
+ *
+ * This is the object function passed to amsIterate by AMSAddrObject.
+ * It stops the iteration, by returning ResFAIL, as soon as it reaches
+ * addr.
+ */
+
+typedef struct amsAddrObjectClosureStruct {
+  Addr addr;                    /* address to look for */
+  Addr object;                  /* client object containing it, or NULL */
+} amsAddrObjectClosureStruct, *amsAddrObjectClosure;
+
+static Res amsAddrObjectFind(Seg seg, Index i, Addr p, Addr next,
+                             void *clos)
+{
+  amsAddrObjectClosure closure = clos;
+  Format format = SegPool(seg)->format;
+
+  UNUSED(i);
+  AVER(p < next);
+
+  if (closure->addr < p)
+    return ResFAIL; /* addr is free, or in the buffer */
+  if (closure->addr < next) {
+    closure->object = AddrAdd(p, format->headerSize);
+    return ResFAIL;
+  }
+  return ResOK;
+}
+
+static Res AMSAddrObject(Addr *pReturn, Pool pool, Seg seg, Addr addr)
+{
+  AMS ams;
+  AMSSeg amsseg;
+  amsAddrObjectClosureStruct closureStruct;
+
+  AVER(pReturn != NULL);
+  AVERT(Pool, pool);
+  AVERT(Seg, seg);
+  AVER(SegBase(seg) <= addr);
+  AVER(addr < SegLimit(seg));
+  ams = PoolAMS(pool);
+  AVERT(AMS, ams);
+  amsseg = Seg2AMSSeg(seg);
+  AVERT(AMSSeg, amsseg);
+
+  /* amsIterate can't find objects while the alloc table is in use as
+     the white table. */
+  if (ams->shareAllocTable && amsseg->colourTablesInUse)
+    return ResFAIL;
+
+  closureStruct.addr = addr;
+  closureStruct.object = NULL;
+  (void)amsIterate(seg, amsAddrObjectFind, &closureStruct);
+  if (closureStruct.object == NULL)
+    return ResFAIL;
+  *pReturn = closureStruct.object;
+  return ResOK;
+}
+
+
 /* AMSFreeWalk -- free block walking method of the pool class */
 
 static void AMSFreeWalk(Pool pool, FreeBlockVisitor f, void *p)
@@ -1779,6 +1871,7 @@ DEFINE_CLASS(Pool, AMSPool, klass)
   klass->instClassStruct.describe = AMSDescribe;
   klass->instClassStruct.finish = AMSFinish;
   klass->size = sizeof(AMSStruct);
+  klass->attr |= AttrPARALLEL | AttrLAZY | AttrPARALLELFIX;
   klass->varargs = AMSVarargs;
   klass->init = AMSInit;
   klass->bufferClass = RankBufClassGet;
@@ -1792,6 +1885,7 @@ DEFINE_CLASS(Pool, AMSPool, klass)
   klass->reclaim = AMSReclaim;
   klass->walk = AMSWalk;
   klass->freewalk = AMSFreeWalk;
+  klass->addrObject = AMSAddrObject;
   klass->totalSize = AMSTotalSize;
   klass->freeSize = AMSFreeSize;
   AVERT(PoolClass, klass);
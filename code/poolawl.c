@@ -333,10 +333,21 @@ static Bool AWLCanTrySingleAccess(Arena arena, AWL awl, Seg seg, Addr addr)
     return FALSE;
   }
 
-  /* The trace is already in the weak band, so we can scan the whole
-     segment without retention anyway.  Go for it. */
-  if (TraceRankForAccess(arena, seg) == RankWEAK)
-    return FALSE;
+  /* If every trace for which the segment is grey is already in the
+     weak band, we can scan the whole segment without retention
+     anyway.  Go for it. */
+  {
+    TraceSet grey = TraceSetInter(SegGrey(seg), arena->flippedTraces);
+    Bool allWeak = TRUE;
+    TraceId ti;
+    Trace trace;
+    TRACE_SET_ITER(ti, trace, grey, arena)
+      if (TraceRankForAccess(trace, seg) != RankWEAK)
+        allWeak = FALSE;
+    TRACE_SET_ITER_END(ti, trace, grey, arena);
+    if (allWeak)
+      return FALSE;
+  }
 
   awlseg = MustBeA(AWLSeg, seg);
 
@@ -796,7 +807,13 @@ static void AWLGrey(Pool pool, Trace trace, Seg seg)
     AWLSeg awlseg = MustBeA(AWLSeg, seg);
 
     SegSetGrey(seg, TraceSetAdd(SegGrey(seg), trace));
-    if (SegBuffer(&buffer, seg)) {
+
+    /* If the segment is white for another trace, the tables belong to
+       that trace and must be left alone; the segment will be scanned
+       in full for this one. See <design/poolawl/#awlseg.mark>. */
+    if (SegWhite(seg) != TraceSetEMPTY) {
+      return;
+    } else if (SegBuffer(&buffer, seg)) {
       Addr base = SegBase(seg);
 
       AWLRangeGrey(awlseg,
@@ -822,7 +839,9 @@ static void AWLBlacken(Pool pool, TraceSet traceSet, Seg seg)
 
   AVERT(TraceSet, traceSet);
 
-  BTSetRange(awlseg->scanned, 0, awlseg->grains);
+  /* Leave the tables alone if they belong to some other trace. */
+  if (TraceSetSub(SegWhite(seg), traceSet))
+    BTSetRange(awlseg->scanned, 0, awlseg->grains);
 }
 
 
@@ -914,7 +933,9 @@ static Res awlScanSinglePass(Bool *anyScannedReturn,
       if (res != ResOK)
         return res;
       *anyScannedReturn = TRUE;
-      BTSet(awlseg->scanned, i);
+      /* Leave the tables alone if they belong to some other trace. */
+      if (TraceSetSub(SegWhite(seg), ss->traces))
+        BTSet(awlseg->scanned, i);
     }
     objectLimit = AddrSub(objectLimit, format->headerSize);
     AVER(p < objectLimit);
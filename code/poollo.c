@@ -559,6 +559,11 @@ static Res LOBufferFill(Addr *baseReturn, Addr *limitReturn,
   /* Try to find a segment with enough space already. */
   RING_FOR(node, PoolSegRing(pool), nextNode) {
     seg = SegOfPoolRing(node);
+    /* Reclaim the segment now if it's awaiting lazy reclaim, see */
+    /* <design/poollo/#fun.buffer-fill.lazy>. */
+    if (SegReclaimPending(seg) && !SegHasBuffer(seg)
+        && !TraceReclaimSeg(seg))
+      continue; /* segment was freed */
     loseg = MustBeA(LOSeg, seg);
     AVERT(LOSeg, loseg);
     if(LOGrainsSize(lo, loseg->freeGrains) >= size
@@ -787,6 +792,7 @@ DEFINE_CLASS(Pool, LOPool, klass)
   PoolClassMixInFormat(klass);
   PoolClassMixInCollect(klass);
   klass->instClassStruct.finish = LOFinish;
+  klass->attr |= AttrLAZY;
   klass->size = sizeof(LOStruct);
   klass->varargs = LOVarargs;
   klass->init = LOInit;
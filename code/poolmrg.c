@@ -457,6 +457,7 @@ static MessageClassStruct MRGMessageClassStruct = {
   MessageNoGCCondemnedSize,    /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize, /* GCNotCondemnedSize */
   MessageNoGCStartWhy,         /* GCStartWhy */
+  MessageNoGenRetune,          /* GenRetune */
   MessageClassSig              /* <design/message/#class.sig.double> */
 };
 
@@ -43,6 +43,20 @@ extern PoolClass PoolClassMVFF(void);
 #define MVFFSig           ((Sig)0x5193FFF9) /* SIGnature MVFF */
 
 typedef struct MVFFStruct *MVFF;
+
+/* MVFFCacheStruct -- cache of free blocks for some threads
+ *
+ * See .cache.
+ */
+
+typedef struct MVFFCacheStruct *MVFFCache;
+typedef struct MVFFCacheStruct {
+  Lock lock;                    /* protects the rest of the structure */
+  Size size;                    /* total size of blocks in cache */
+  Size fastAllocSize;           /* allocated on fast path since last poll */
+  Addr lists[MVFF_CACHE_CLASSES]; /* exact-size free lists */
+} MVFFCacheStruct;
+
 typedef struct MVFFStruct {     /* MVFF pool outer structure */
   PoolStruct poolStruct;        /* generic structure */
   LocusPrefStruct locusPrefStruct; /* the preferences for allocation */
@@ -56,6 +70,8 @@ typedef struct MVFFStruct {     /* MVFF pool outer structure */
   FailoverStruct foStruct;      /* free memory (fail-over mechanism) */
   Bool firstFit;                /* as opposed to last fit */
   Bool slotHigh;                /* prefers high part of large block */
+  Count cacheCount;             /* number of thread caches */
+  MVFFCache caches;             /* thread caches, see .cache */
   Sig sig;                      /* <design/sig/> */
 } MVFFStruct;
 
@@ -92,6 +108,118 @@ typedef MVFFDebugStruct *MVFFDebug;
 #define MVFFDebug2MVFF(mvffd) (&((mvffd)->mvffStruct))
 
 
+/* .cache: Each cache is a set of exact-size free lists, one for each
+ * multiple of the pool alignment up to MVFF_CACHE_CLASSES.  They let
+ * mps_alloc and mps_free be satisfied without claiming the arena
+ * lock: see <design/poolmvff/#impl.cache>.  A thread uses the cache
+ * picked by hashing its identifier, so that threads rarely contend for
+ * a cache's lock.  Cached blocks are linked through their first word.
+ * A cache lock may be claimed while the arena lock is held, but not
+ * the other way round. */
+
+#define mvffCacheNext(block) (*(Addr *)(block))
+
+static Bool mvffCacheClass(Index *classReturn, MVFF mvff, Size size)
+{
+  Align align = PoolAlignment(MVFFPool(mvff));
+  Index i = (Index)(SizeAlignUp(size, align) / align) - 1;
+  if (i >= MVFF_CACHE_CLASSES)
+    return FALSE;
+  *classReturn = i;
+  return TRUE;
+}
+
+/* mvffCacheThread -- the cache used by the calling thread
+ *
+ * Thread identifiers are often addresses of thread control blocks,
+ * so fold in the high bits before reducing.
+ */
+static MVFFCache mvffCacheThread(MVFF mvff)
+{
+  Word id;
+  if (mvff->cacheCount == 1)
+    return &mvff->caches[0];
+  id = ThreadCurrentId();
+  id ^= id >> 12;
+  id ^= id >> 24;
+  return &mvff->caches[id % mvff->cacheCount];
+}
+
+/* mvffCachePop -- take a block from a cache, if there is one
+ *
+ * Must be called with cache->lock held.
+ */
+static Bool mvffCachePop(Addr *aReturn, MVFF mvff, MVFFCache cache,
+                         Size size)
+{
+  Index i;
+  Addr block;
+
+  if (!mvffCacheClass(&i, mvff, size))
+    return FALSE;
+  block = cache->lists[i];
+  if (block == NULL)
+    return FALSE;
+  cache->lists[i] = mvffCacheNext(block);
+  cache->size -= (i + 1) * PoolAlignment(MVFFPool(mvff));
+  *aReturn = block;
+  return TRUE;
+}
+
+/* mvffCacheFlush -- return all cached blocks to the free land
+ *
+ * Must be called with the arena lock held.  Returns the total size
+ * of the blocks returned.
+ */
+static Size mvffCacheFlush(MVFF mvff)
+{
+  Align align = PoolAlignment(MVFFPool(mvff));
+  Size flushed = 0;
+  Index c, i;
+
+  for (c = 0; c < mvff->cacheCount; ++c) {
+    MVFFCache cache = &mvff->caches[c];
+    LockClaim(cache->lock);
+    for (i = 0; i < MVFF_CACHE_CLASSES; ++i) {
+      while (cache->lists[i] != NULL) {
+        RangeStruct range, coalescedRange;
+        Addr block = cache->lists[i];
+        Res res;
+        cache->lists[i] = mvffCacheNext(block);
+        RangeInitSize(&range, block, (i + 1) * align);
+        res = LandInsert(&coalescedRange, MVFFFreeLand(mvff), &range);
+        /* Insertion must succeed because it fails over to a Freelist. */
+        AVER(res == ResOK);
+      }
+    }
+    flushed += cache->size;
+    cache->size = 0;
+    LockRelease(cache->lock);
+  }
+  return flushed;
+}
+
+/* mvffCacheSize -- total size of blocks in all caches
+ *
+ * Claims each cache's lock to read its size, so the total is exact
+ * for each cache, though other threads may change the caches it has
+ * already read.  Must not be called with a cache lock held.
+ */
+
+static Size mvffCacheSize(MVFF mvff)
+{
+  Size size = 0;
+  Index c;
+  for (c = 0; c < mvff->cacheCount; ++c) {
+    MVFFCache cache = &mvff->caches[c];
+    LockClaim(cache->lock);
+    size += cache->size;
+    LockRelease(cache->lock);
+  }
+  return size;
+}
+
+
 /* MVFFReduce -- return memory to the arena
  *
  * This is usually called immediately after inserting a range into the
@@ -278,6 +406,10 @@ static Res mvffFindFree(Range rangeReturn, MVFF mvff, Size size,
 
   land = MVFFFreeLand(mvff);
   found = (*findMethod)(rangeReturn, &oldRange, land, size, findDelete);
+  if (!found && mvffCacheFlush(mvff) > 0) {
+    /* Cached blocks might coalesce into a suitable one. */
+    found = (*findMethod)(rangeReturn, &oldRange, land, size, findDelete);
+  }
   if (!found) {
     RangeStruct newRange;
     Res res;
@@ -306,7 +438,9 @@ static Res mvffFindFree(Range rangeReturn, MVFF mvff, Size size,
 static Res MVFFAlloc(Addr *aReturn, Pool pool, Size size)
 {
   Res res;
+  Bool found;
   MVFF mvff;
+  MVFFCache cache;
   RangeStruct range;
   LandFindMethod findMethod;
   FindDelete findDelete;
@@ -318,6 +452,18 @@ static Res MVFFAlloc(Addr *aReturn, Pool pool, Size size)
   AVER_CRITICAL(size > 0);
 
   size = SizeAlignUp(size, PoolAlignment(pool));
+
+  /* Account for fast path allocation here, where it is safe to touch
+     the arena.  See <design/poolmvff/#impl.cache.poll>. */
+  cache = mvffCacheThread(mvff);
+  LockClaim(cache->lock);
+  ArenaGlobals(PoolArena(pool))->fillMutatorSize += cache->fastAllocSize;
+  cache->fastAllocSize = 0;
+  found = mvffCachePop(aReturn, mvff, cache, size);
+  LockRelease(cache->lock);
+  if (found)
+    return ResOK;
+
   findMethod = mvff->firstFit ? LandFindFirst : LandFindLast;
   findDelete = mvff->slotHigh ? FindDeleteHIGH : FindDeleteLOW;
 
@@ -359,6 +505,81 @@ static void MVFFFree(Pool pool, Addr old, Size size)
 }
 
 
+/* MVFFAllocFast -- allocate a cached block without the arena lock
+ *
+ * .fast.poll: Decline once the fast path has allocated
+ * ArenaPollALLOCTIME bytes, so that MVFFAlloc gets to run, credit
+ * them to the allocation clock, and let mps_alloc poll the arena.
+ */
+
+static Bool MVFFAllocFast(Addr *aReturn, Pool pool, Size size)
+{
+  MVFF mvff = PoolMVFF(pool);
+  MVFFCache cache;
+  Bool found = FALSE;
+
+  AVER_CRITICAL(TESTT(MVFF, mvff));
+
+  cache = mvffCacheThread(mvff);
+  LockClaim(cache->lock);
+  if (cache->fastAllocSize < ArenaPollALLOCTIME) { /* .fast.poll */
+    found = mvffCachePop(aReturn, mvff, cache, size);
+    if (found)
+      cache->fastAllocSize += size;
+  }
+  LockRelease(cache->lock);
+  return found;
+}
+
+
+/* MVFFFreeFast -- add a block to the cache without the arena lock
+ *
+ * .fast.remote: A block goes into the cache of the thread that frees
+ * it, which need not be the one that allocated it.  Every cache
+ * belongs to the whole pool, so no block has to be returned to its
+ * allocating thread.
+ */
+
+static Bool MVFFFreeFast(Pool pool, Addr old, Size size)
+{
+  MVFF mvff = PoolMVFF(pool);
+  MVFFCache cache;
+  Bool cached = FALSE;
+  Index i;
+
+  AVER_CRITICAL(TESTT(MVFF, mvff));
+  AVER_CRITICAL(AddrIsAligned(old, PoolAlignment(pool)));
+
+#if defined(AVER_AND_CHECK_ALL)
+  /* .fast.range: PoolFree checks that the block belongs to the pool,
+     and so must this.  PoolHasRange reads the chunk tree, which only
+     the arena lock protects, so the checking varieties claim it for
+     the check, before the cache lock (see .cache). */
+  {
+    Arena arena = PoolArena(pool);
+    ArenaEnter(arena);
+    AVER(PoolHasRange(pool, old, AddrAdd(old, size)));
+    ArenaLeave(arena);
+  }
+#endif
+
+  if (!mvffCacheClass(&i, mvff, size))
+    return FALSE;
+  size = SizeAlignUp(size, PoolAlignment(pool));
+
+  cache = mvffCacheThread(mvff);
+  LockClaim(cache->lock);
+  if (cache->size + size <= MVFF_CACHE_SIZE_MAX) {
+    mvffCacheNext(old) = cache->lists[i];
+    cache->lists[i] = old;
+    cache->size += size;
+    cached = TRUE;
+  }
+  LockRelease(cache->lock);
+  return cached;
+}
+
+
 /* MVFFBufferFill -- Fill the buffer
  *
  * Fill it with the largest block we can find. This is worst-fit
@@ -449,6 +670,62 @@ static void MVFFDebugVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
 ARG_DEFINE_KEY(MVFF_SLOT_HIGH, Bool);
 ARG_DEFINE_KEY(MVFF_ARENA_HIGH, Bool);
 ARG_DEFINE_KEY(MVFF_FIRST_FIT, Bool);
+ARG_DEFINE_KEY(MVFF_THREAD_CACHES, Count);
+
+/* mvffCachesInit -- allocate and initialize the thread caches */
+
+static Res mvffCachesInit(MVFF mvff, Arena arena, Count cacheCount)
+{
+  void *p;
+  Index c, i;
+  Res res;
+
+  res = ControlAlloc(&p, arena, cacheCount * sizeof(MVFFCacheStruct));
+  if (res != ResOK)
+    return res;
+  mvff->caches = p;
+
+  for (c = 0; c < cacheCount; ++c) {
+    MVFFCache cache = &mvff->caches[c];
+    res = ControlAlloc(&p, arena, LockSize());
+    if (res != ResOK)
+      goto failLockAlloc;
+    cache->lock = p;
+    LockInit(cache->lock);
+    cache->size = 0;
+    cache->fastAllocSize = 0;
+    for (i = 0; i < MVFF_CACHE_CLASSES; ++i)
+      cache->lists[i] = NULL;
+  }
+  mvff->cacheCount = cacheCount;
+  return ResOK;
+
+failLockAlloc:
+  while (c > 0) {
+    --c;
+    LockFinish(mvff->caches[c].lock);
+    ControlFree(arena, mvff->caches[c].lock, LockSize());
+  }
+  ControlFree(arena, mvff->caches, cacheCount * sizeof(MVFFCacheStruct));
+  return res;
+}
+
+/* mvffCachesFinish -- discard the thread caches
+ *
+ * Cached blocks are still in the pool's total land, so they are
+ * returned to the arena along with the rest of the pool's memory.
+ */
+
+static void mvffCachesFinish(MVFF mvff, Arena arena)
+{
+  Index c;
+
+  for (c = 0; c < mvff->cacheCount; ++c) {
+    LockFinish(mvff->caches[c].lock);
+    ControlFree(arena, mvff->caches[c].lock, LockSize());
+  }
+  ControlFree(arena, mvff->caches, mvff->cacheCount * sizeof(MVFFCacheStruct));
+}
 
 static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 {
@@ -461,6 +738,7 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   double spare = MVFF_SPARE_DEFAULT;
   MVFF mvff;
   Res res;
+  Count cacheCount = MVFF_THREAD_CACHES_DEFAULT;
   ArgStruct arg;
 
   AVER(pool != NULL);
@@ -494,6 +772,9 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   if (ArgPick(&arg, args, MPS_KEY_MVFF_FIRST_FIT))
     firstFit = arg.val.b;
 
+  if (ArgPick(&arg, args, MPS_KEY_MVFF_THREAD_CACHES))
+    cacheCount = arg.val.count;
+
   AVER(extendBy > 0);           /* .arg.check */
   AVER(avgSize > 0);            /* .arg.check */
   AVER(avgSize <= extendBy);    /* .arg.check */
@@ -508,6 +789,7 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   AVERT(Bool, slotHigh);
   AVERT(Bool, arenaHigh);
   AVERT(Bool, firstFit);
+  AVER(cacheCount > 0);         /* .arg.check */
 
   res = NextMethod(Pool, MVFFPool, init)(pool, arena, klass, args);
   if (res != ResOK)
@@ -523,6 +805,10 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   mvff->firstFit = firstFit;
   mvff->spare = spare;
 
+  res = mvffCachesInit(mvff, arena, cacheCount);
+  if (res != ResOK)
+    goto failCachesInit;
+
   LocusPrefInit(MVFFLocusPref(mvff));
   LocusPrefExpress(MVFFLocusPref(mvff),
                    arenaHigh ? LocusPrefHIGH : LocusPrefLOW, NULL);
@@ -586,6 +872,8 @@ failFreePrimaryInit:
 failTotalLandInit:
   PoolFinish(MVFFBlockPool(mvff));
 failBlockPoolInit:
+  mvffCachesFinish(mvff, arena);
+failCachesInit:
   NextMethod(Inst, MVFFPool, finish)(MustBeA(Inst, pool));
 failNextInit:
   AVER(res != ResOK);
@@ -630,6 +918,7 @@ static void MVFFFinish(Inst inst)
   LandFinish(MVFFFreePrimary(mvff));
   LandFinish(MVFFTotalLand(mvff));
   PoolFinish(MVFFBlockPool(mvff));
+  mvffCachesFinish(mvff, PoolArena(pool));
   NextMethod(Inst, MVFFPool, finish)(inst);
 }
 
@@ -672,7 +961,7 @@ static Size MVFFFreeSize(Pool pool)
   mvff = PoolMVFF(pool);
   AVERT(MVFF, mvff);
 
-  return LandSize(MVFFFreeLand(mvff));
+  return LandSize(MVFFFreeLand(mvff)) + mvffCacheSize(mvff);
 }
 
 
@@ -699,6 +988,8 @@ static Res MVFFDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                "firstFit  $U\n",  (WriteFU)mvff->firstFit,
                "slotHigh  $U\n",  (WriteFU)mvff->slotHigh,
                "spare     $D\n",  (WriteFD)mvff->spare,
+               "cacheCount $U\n", (WriteFU)mvff->cacheCount,
+               "cacheSize $W\n",  (WriteFW)mvffCacheSize(mvff),
                NULL);
   if (res != ResOK)
     return res;
@@ -737,6 +1028,8 @@ DEFINE_CLASS(Pool, MVFFPool, klass)
   klass->init = MVFFInit;
   klass->alloc = MVFFAlloc;
   klass->free = MVFFFree;
+  klass->allocFast = MVFFAllocFast;
+  klass->freeFast = MVFFFreeFast;
   klass->bufferFill = MVFFBufferFill;
   klass->bufferEmpty = MVFFBufferEmpty;
   klass->totalSize = MVFFTotalSize;
@@ -800,6 +1093,10 @@ static Bool MVFFCheck(MVFF mvff)
   CHECKL(SizeIsArenaGrains(LandSize(MVFFTotalLand(mvff)), PoolArena(MVFFPool(mvff))));
   CHECKL(BoolCheck(mvff->slotHigh));
   CHECKL(BoolCheck(mvff->firstFit));
+  CHECKL(mvff->cacheCount > 0);                 /* see .arg.check */
+  CHECKL(mvff->caches != NULL);
+  /* The caches are protected by their own locks, so can't be checked
+     here without claiming them.  See .cache. */
   return TRUE;
 }
 
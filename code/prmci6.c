@@ -35,21 +35,156 @@ SRCID(prmci6, "$Id$");
 #endif
 
 
+/* DecodeCB -- Decode an x86 control byte into Hi, Medium & Low fields */
+
+static void DecodeCB(unsigned int *hReturn,
+                     unsigned int *mReturn,
+                     unsigned int *lReturn,
+                     Byte op)
+{
+  unsigned int uop = (unsigned int)op;
+  *lReturn = uop & 7;
+  uop = uop >> 3;
+  *mReturn = uop & 7;
+  uop = uop >> 3;
+  *hReturn = uop & 3;
+}
+
+
+/* RegValue -- Return the value of a machine register from a context */
+
+static Word RegValue(MutatorContext context, unsigned int regnum)
+{
+  MRef addr;
+
+  addr = Prmci6AddressHoldingReg(context, regnum);
+  return *addr;
+}
+
+
+/* InsDisp -- Return a sign-extended displacement from an instruction */
+
+static Word InsDisp(Byte insvec[], Count i, Size size)
+{
+  if (size == 1) {
+    signed char eltb = ((signed char *)insvec)[i];
+    return (Word)eltb;
+  } else {
+    /* Little-endian, and possibly unaligned. */
+    Word disp = (Word)insvec[i]
+      | (Word)insvec[i + 1] << 8
+      | (Word)insvec[i + 2] << 16
+      | (Word)insvec[i + 3] << 24;
+    AVER(size == 4);
+    if (disp & ((Word)1 << 31))
+      disp |= ~(Word)0 << 32;
+    return disp;
+  }
+}
+
+
+/* DecodeSimpleMov -- decode the operands of a 64-bit MOV
+ *
+ * If the instruction at insvec (after its REX prefix) is a move
+ * between a register and a memory operand addressed by a base
+ * register, an optional scaled index register, and an 8- or 32-bit
+ * displacement, find the register, the effective address and the
+ * length of the instruction.  See .source.amd64 section 1.4 (ModRM and
+ * SIB bytes) and section 1.2.7 (REX prefix).  RIP-relative and
+ * absolute operands can't refer to the heap, so aren't decoded.
+ */
+
+static Bool DecodeSimpleMov(unsigned int *regnumReturn,
+                            MRef *memReturn,
+                            Size *inslenReturn,
+                            MutatorContext context,
+                            Byte insvec[])
+{
+  unsigned int rex = insvec[0];
+  unsigned int mod, r, m;
+  Word base, idx, disp;
+  Count i;
+  Size dispSize;
+
+  DecodeCB(&mod, &r, &m, insvec[2]);
+  i = 3;
+  if (mod == 1)
+    dispSize = 1;
+  else if (mod == 2)
+    dispSize = 4;
+  else if (mod == 0 && m != 5)
+    dispSize = 0;
+  else
+    return FALSE; /* register operand or RIP-relative */
+
+  if (m == 4) {
+    /* There is a SIB byte. */
+    unsigned int s, x, b;
+    DecodeCB(&s, &x, &b, insvec[i]);
+    ++i;
+    if (mod == 0 && b == 5)
+      return FALSE; /* no base register */
+    x |= (rex & 2) << 2;    /* REX.X */
+    idx = (x == 4) ? 0 : RegValue(context, x) << s;
+    base = RegValue(context, b | (rex & 1) << 3);  /* REX.B */
+  } else {
+    idx = 0;
+    base = RegValue(context, m | (rex & 1) << 3);  /* REX.B */
+  }
+
+  disp = (dispSize == 0) ? 0 : InsDisp(insvec, i, dispSize);
+  *regnumReturn = r | (rex & 4) << 1;  /* REX.R */
+  *memReturn = (MRef)(base + idx + disp);
+  *inslenReturn = i + dispSize;
+  return TRUE;
+}
+
+
+/* IsSimpleMov -- is the faulting instruction a simple MOV?
+ *
+ * .simple-mov: Only MOV r64,r/m64 (REX.W 8B) and MOV r/m64,r64 (REX.W
+ * 89) are recognized, since these are how compiled code loads and
+ * stores a word of an object.  See .source.amd64 section 3 (MOV).
+ * Other prefixes (segment overrides in particular) and other operand
+ * sizes are declined.
+ */
+
 static Bool IsSimpleMov(Size *inslenReturn,
                         MRef *srcReturn,
                         MRef *destReturn,
                         MutatorContext context)
 {
   Byte *insvec;
+  unsigned int regnum;
+  MRef mem;
   MRef faultmem;
 
   Prmci6DecodeFaultContext(&faultmem, &insvec, context);
-  /* Unimplemented */
-  UNUSED(inslenReturn);
-  UNUSED(srcReturn);
-  UNUSED(destReturn);
-  
-  return FALSE;
+
+  /* REX prefix with the W bit set: 0100 1RXB */
+  if ((insvec[0] & 0xF8) != 0x48)
+    return FALSE;
+  if (insvec[1] != 0x8B && insvec[1] != 0x89)
+    return FALSE;
+  if (!DecodeSimpleMov(&regnum, &mem, inslenReturn, context, insvec))
+    return FALSE;
+
+  /* Unlike prmci3.c, don't assert that the computed address is the
+     fault address: an access that straddles a page boundary faults
+     on the second page. */
+  if (faultmem != mem)
+    return FALSE;
+
+  if (insvec[1] == 0x8B) {
+    /* MOV reg, r/m64 */
+    *srcReturn = mem;
+    *destReturn = Prmci6AddressHoldingReg(context, regnum);
+  } else {
+    /* MOV r/m64, reg */
+    *destReturn = mem;
+    *srcReturn = Prmci6AddressHoldingReg(context, regnum);
+  }
+  return TRUE;
 }
 
 
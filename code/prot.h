@@ -25,6 +25,16 @@ extern void ProtSet(Addr base, Addr limit, AccessSet mode);
 extern void ProtSync(Arena arena);
 
 
+/* Dirty Page Interface -- see <design/prot/#if.dirty> */
+
+extern Bool ProtDirtySupported(void);
+extern Word ProtDirtyClear(void);
+extern Bool ProtDirty(Addr base, Addr limit, Word epoch);
+extern Addr ProtDirtyLimit(Addr base, Addr limit, Word epoch);
+extern void ProtDirtyCacheInit(ProtDirtyCache cache, Word epoch);
+extern Bool ProtDirtyCached(ProtDirtyCache cache, Addr base, Addr limit);
+
+
 #endif /* prot_h */
 
 
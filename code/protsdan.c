@@ -0,0 +1,117 @@
+/* protsdan.c: DIRTY PAGE TRACKING FOR ANSI
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: This is the implementation of the dirty page part of
+ * <code/prot.h> for platforms that can't find out which pages have
+ * been written.  Arenas that ask for dirty page tracking use the
+ * write barrier instead.  See <design/prot/#if.dirty>.
+ */
+
+#include "mpm.h"
+
+SRCID(protsdan, "$Id$");
+
+
+/* ProtDirtySupported -- can the MPS find dirty pages? */
+
+Bool ProtDirtySupported(void)
+{
+  return FALSE;
+}
+
+
+/* ProtDirtyClear -- forget which pages are dirty */
+
+Word ProtDirtyClear(void)
+{
+  NOTREACHED;
+  return 0;
+}
+
+
+/* ProtDirty -- might any page in a range have been written? */
+
+Bool ProtDirty(Addr base, Addr limit, Word epoch)
+{
+  AVER(base < limit);
+  UNUSED(epoch);
+  NOTREACHED;
+  return TRUE;
+}
+
+
+/* ProtDirtyLimit -- where does the written part of a range end? */
+
+Addr ProtDirtyLimit(Addr base, Addr limit, Word epoch)
+{
+  AVER(base < limit);
+  UNUSED(epoch);
+  NOTREACHED;
+  return limit;
+}
+
+
+/* ProtDirtyCacheInit -- prepare to read dirty bits ahead */
+
+void ProtDirtyCacheInit(ProtDirtyCache cache, Word epoch)
+{
+  AVER(cache != NULL);
+  cache->epoch = epoch;
+  cache->pageBase = 0;
+  cache->pageLimit = 0;
+}
+
+
+/* ProtDirtyCached -- as ProtDirty, reading dirty bits ahead */
+
+Bool ProtDirtyCached(ProtDirtyCache cache, Addr base, Addr limit)
+{
+  AVER(cache != NULL);
+  AVER(base < limit);
+  NOTREACHED;
+  return TRUE;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,398 @@
+/* protsdli.c: DIRTY PAGE TRACKING FOR LINUX
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: This implements the dirty page part of <code/prot.h>
+ * using the kernel's soft-dirty bits.  Writing "4" to
+ * /proc/self/clear_refs clears the soft-dirty bit of every page in
+ * the process, and bit 55 of a page's entry in /proc/self/pagemap is
+ * set if the page has been written since then.  The kernel notices
+ * the write by taking a minor fault, but the process never sees a
+ * signal.  See <design/prot/#if.dirty> and
+ * <design/write-barrier/#soft-dirty>.
+ *
+ * .epoch: The soft-dirty bits belong to the process, not to an arena,
+ * so clearing them on behalf of one arena loses information that
+ * another arena needs.  Each clear advances an epoch, and ProtDirty
+ * treats every page as dirty if the bits have been cleared since the
+ * caller's last clear.
+ *
+ * .epoch.lock: ProtDirty and ProtDirtyClear are called with an arena
+ * lock held, so they must not claim the global lock, which is claimed
+ * before arena locks (<design/arena/#lock.ring>).  ProtDirtyClear
+ * claims a lock of its own instead, which is claimed after arena locks
+ * and never held while claiming another lock.  Under it, the epoch is
+ * advanced atomically and then the bits are cleared, so every clear
+ * gets a new epoch and no other clear can come between.  ProtDirty
+ * doesn't claim the lock: it checks the epoch both before and after
+ * reading the bits.
+ *
+ * .lock.storage: The size of a lock is only known at run time, and
+ * there is no arena to allocate it from, so ProtDirtySupported maps a
+ * page for it.  Like the global locks, it is never freed.
+ *
+ * .kernel: Soft-dirty tracking needs a kernel built with
+ * CONFIG_MEM_SOFT_DIRTY.  ProtDirtySupported checks that it works by
+ * writing to a fresh page.
+ */
+
+#include "mpm.h"
+#include "vm.h"
+
+#if !defined(MPS_OS_LI)
+#error "protsdli.c is specific to MPS_OS_LI"
+#endif
+
+#include <fcntl.h> /* see .feature.li in config.h */
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+SRCID(protsdli, "$Id$");
+
+
+/* Pagemap entries are 64 bits on every architecture. */
+__extension__ typedef unsigned long long PagemapEntry;
+
+#define PAGEMAP_SOFT_DIRTY ((PagemapEntry)1 << 55)
+#define PAGEMAP_BATCH 64        /* entries read by one pread */
+#define PAGEMAP_CACHE_BATCH 512 /* entries read by one pread to a cache */
+
+
+static int protDirtyState = 0;  /* 0 = not probed, 1 = works, -1 = not */
+static int pagemapFD = -1;      /* open /proc/self/pagemap */
+static Word protDirtyEpoch = 0; /* see .epoch */
+static Lock protDirtyLock = NULL; /* see .epoch.lock */
+
+#define protDirtyEpochGet() \
+  __atomic_load_n(&protDirtyEpoch, __ATOMIC_ACQUIRE)
+#define protDirtyEpochAdvance() \
+  __atomic_add_fetch(&protDirtyEpoch, 1, __ATOMIC_ACQ_REL)
+
+
+/* protDirtyClear -- clear all soft-dirty bits in the process */
+
+static Bool protDirtyClear(void)
+{
+  int fd;
+  ssize_t n;
+
+  fd = open("/proc/self/clear_refs", O_WRONLY);
+  if (fd == -1)
+    return FALSE;
+  n = write(fd, "4", 1);
+  (void)close(fd);
+  return n == 1;
+}
+
+
+/* protDirtyPage -- is the page at addr soft-dirty? */
+
+static Bool protDirtyPage(Addr addr)
+{
+  PagemapEntry entry;
+  off_t offset = (off_t)((Word)addr / PageSize()) * (off_t)sizeof entry;
+
+  if (pread(pagemapFD, &entry, sizeof entry, offset) != (ssize_t)sizeof entry)
+    return TRUE;
+  return (entry & PAGEMAP_SOFT_DIRTY) != 0;
+}
+
+
+/* protDirtyProbe -- check that soft-dirty bits work */
+
+static Bool protDirtyProbe(void)
+{
+  Size pageSize = PageSize();
+  void *p;
+  Bool ok;
+
+  pagemapFD = open("/proc/self/pagemap", O_RDONLY);
+  if (pagemapFD == -1)
+    return FALSE;
+
+  p = mmap(NULL, pageSize, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANON, -1, 0);
+  if (p == MAP_FAILED)
+    goto failMap;
+
+  *(volatile char *)p = 1;
+  (void)protDirtyEpochAdvance();
+  ok = protDirtyClear() && !protDirtyPage(p);
+  *(volatile char *)p = 2;
+  ok = ok && protDirtyPage(p);
+  (void)munmap(p, pageSize);
+  if (!ok)
+    goto failProbe;
+
+  /* See .lock.storage. */
+  p = mmap(NULL, SizeAlignUp(LockSize(), pageSize), PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANON, -1, 0);
+  if (p == MAP_FAILED)
+    goto failLock;
+  protDirtyLock = p;
+  LockInit(protDirtyLock);
+  return TRUE;
+
+failLock:
+failProbe:
+failMap:
+  (void)close(pagemapFD);
+  pagemapFD = -1;
+  return FALSE;
+}
+
+
+/* ProtDirtySupported -- can the MPS find dirty pages? */
+
+Bool ProtDirtySupported(void)
+{
+  Bool supported;
+
+  LockClaimGlobal();
+  if (protDirtyState == 0)
+    protDirtyState = protDirtyProbe() ? 1 : -1;
+  supported = protDirtyState > 0;
+  LockReleaseGlobal();
+  return supported;
+}
+
+
+/* ProtDirtyClear -- forget which pages are dirty
+ *
+ * Returns the epoch to pass to ProtDirty.
+ */
+
+Word ProtDirtyClear(void)
+{
+  Word epoch;
+  Bool cleared;
+
+  AVER(protDirtyState > 0);
+
+  LockClaim(protDirtyLock); /* see .epoch.lock */
+  epoch = protDirtyEpochAdvance();
+  cleared = protDirtyClear();
+  LockRelease(protDirtyLock);
+  /* The probe succeeded, so this can't fail. */
+  AVER(cleared);
+  return epoch;
+}
+
+
+/* ProtDirty -- might any page in a range have been written?
+ *
+ * Returns TRUE if any page overlapping [base, limit) may have been
+ * written since the call to ProtDirtyClear that returned epoch.
+ */
+
+Bool ProtDirty(Addr base, Addr limit, Word epoch)
+{
+  PagemapEntry entry[PAGEMAP_BATCH];
+  Size pageSize = PageSize();
+  Word page, pageLimit;
+
+  AVER(protDirtyState > 0);
+  AVER(base < limit);
+
+  if (protDirtyEpochGet() != epoch) /* see .epoch */
+    return TRUE;
+
+  /* Segments in a client arena need not be whole pages. */
+  page = (Word)base / pageSize;
+  pageLimit = ((Word)limit + pageSize - 1) / pageSize;
+  while (page < pageLimit) {
+    Count count = pageLimit - page, i;
+    ssize_t n;
+    if (count > PAGEMAP_BATCH)
+      count = PAGEMAP_BATCH;
+    n = pread(pagemapFD, entry, count * sizeof entry[0],
+              (off_t)(page * sizeof entry[0]));
+    if (n != (ssize_t)(count * sizeof entry[0]))
+      return TRUE;
+    for (i = 0; i < count; ++i)
+      if ((entry[i] & PAGEMAP_SOFT_DIRTY) != 0)
+        return TRUE;
+    page += count;
+  }
+
+  /* The bits might have been cleared while we read them: see
+     .epoch.lock. */
+  return protDirtyEpochGet() != epoch;
+}
+
+
+/* ProtDirtyLimit -- where does the written part of a range end?
+ *
+ * Returns the limit of the highest page overlapping [base, limit) that
+ * may have been written since the call to ProtDirtyClear that returned
+ * epoch, or base if there is no such page.  The result is no greater
+ * than limit.
+ */
+
+Addr ProtDirtyLimit(Addr base, Addr limit, Word epoch)
+{
+  PagemapEntry entry[PAGEMAP_BATCH];
+  Size pageSize = PageSize();
+  Word pageBase, page;
+  Addr dirtyLimit = base;
+
+  AVER(protDirtyState > 0);
+  AVER(base < limit);
+
+  if (protDirtyEpochGet() != epoch) /* see .epoch */
+    return limit;
+
+  /* Read the entries from the top down, and stop at the first dirty
+     one. */
+  pageBase = (Word)base / pageSize;
+  page = ((Word)limit + pageSize - 1) / pageSize;
+  while (page > pageBase && dirtyLimit == base) {
+    Count count = page - pageBase, i;
+    ssize_t n;
+    if (count > PAGEMAP_BATCH)
+      count = PAGEMAP_BATCH;
+    page -= count;
+    n = pread(pagemapFD, entry, count * sizeof entry[0],
+              (off_t)(page * sizeof entry[0]));
+    if (n != (ssize_t)(count * sizeof entry[0]))
+      return limit;
+    for (i = count; i > 0; --i)
+      if ((entry[i - 1] & PAGEMAP_SOFT_DIRTY) != 0) {
+        dirtyLimit = (Addr)((page + i) * pageSize);
+        if (dirtyLimit > limit)
+          dirtyLimit = limit;
+        break;
+      }
+  }
+
+  /* The bits might have been cleared while we read them: see
+     .epoch.lock. */
+  if (protDirtyEpochGet() != epoch)
+    return limit;
+  return dirtyLimit;
+}
+
+
+/* ProtDirtyCacheInit -- prepare to read dirty bits ahead
+ *
+ * The cache answers for the clear that returned epoch.  It starts
+ * empty.
+ */
+
+void ProtDirtyCacheInit(ProtDirtyCache cache, Word epoch)
+{
+  AVER(cache != NULL);
+  cache->epoch = epoch;
+  cache->pageBase = 0;
+  cache->pageLimit = 0;
+}
+
+
+/* ProtDirtyCached -- as ProtDirty, reading dirty bits ahead
+ *
+ * Reads the pagemap a batch at a time from the first page asked
+ * about, and answers later calls for pages already read from the
+ * cache, so that a caller asking about ranges in address order reads
+ * each page's entry once.  A range below the cached pages, or beyond
+ * them, starts the cache again.  Only valid while nothing writes to
+ * the pages, such as while the mutator is suspended at flip.  See
+ * <design/prot/#if.dirty.cached>.
+ */
+
+Bool ProtDirtyCached(ProtDirtyCache cache, Addr base, Addr limit)
+{
+  PagemapEntry entry[PAGEMAP_BATCH];
+  Size pageSize = PageSize();
+  Word page, pageLimit;
+
+  AVER(protDirtyState > 0);
+  AVER(cache != NULL);
+  AVER(base < limit);
+
+  if (protDirtyEpochGet() != cache->epoch) /* see .epoch */
+    return TRUE;
+
+  page = (Word)base / pageSize;
+  pageLimit = ((Word)limit + pageSize - 1) / pageSize;
+  if (page < cache->pageBase || page > cache->pageLimit)
+    cache->pageBase = cache->pageLimit = page;
+  while (page < pageLimit) {
+    Word cachedLimit;
+    if (page == cache->pageLimit) {
+      Count count, i;
+      ssize_t n;
+      if (cache->pageLimit - cache->pageBase == PROT_DIRTY_CACHE_PAGES)
+        cache->pageBase = page; /* cache full: start again here */
+      count = cache->pageBase + PROT_DIRTY_CACHE_PAGES - page;
+      if (count > PAGEMAP_BATCH)
+        count = PAGEMAP_BATCH;
+      n = pread(pagemapFD, entry, count * sizeof entry[0],
+                (off_t)(page * sizeof entry[0]));
+      if (n != (ssize_t)(count * sizeof entry[0])) {
+        cache->pageBase = cache->pageLimit = page;
+        return TRUE;
+      }
+      for (i = 0; i < count; ++i) {
+        Index bit = page - cache->pageBase + i;
+        if ((entry[i] & PAGEMAP_SOFT_DIRTY) != 0)
+          BTSet(cache->dirty, bit);
+        else
+          BTRes(cache->dirty, bit);
+      }
+      cache->pageLimit = page + count;
+    }
+    cachedLimit = pageLimit < cache->pageLimit ? pageLimit : cache->pageLimit;
+    if (!BTIsResRange(cache->dirty, page - cache->pageBase,
+                      cachedLimit - cache->pageBase))
+      return TRUE;
+    page = cachedLimit;
+  }
+
+  /* The bits might have been cleared since we read them: see
+     .epoch.lock. */
+  return protDirtyEpochGet() != cache->epoch;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -47,7 +47,8 @@ static Bool pthreadextModuleInitialized = FALSE;
  * See <design/pthreadext/#impl.global>.*
  */
 
-static PThreadext suspendingVictim = NULL;  /* current victim */
+static RingStruct suspendingRing;           /* victims being suspended */
+static Count suspendingCount = 0;           /* signals not yet acknowledged */
 static RingStruct suspendedRing;            /* PThreadext suspend ring */
 
 
@@ -71,17 +72,31 @@ static void suspendSignalHandler(int sig,
     sigset_t signal_set;
     ucontext_t ucontext;
     MutatorContextStruct context;
+    pthread_t self = pthread_self();
+    PThreadext victim = NULL;
+    Ring node, next;
 
     AVER(sig == PTHREADEXT_SIGSUSPEND);
     UNUSED(sig);
     UNUSED(info);
 
-    AVER(suspendingVictim != NULL);
+    /* Find our own PThreadext among the victims.  The ring doesn't
+     * change until all the victims have acknowledged.  See
+     * <design/pthreadext/#impl.suspend.parallel>. */
+    RING_FOR(node, &suspendingRing, next) {
+      PThreadext pt = RING_ELT(PThreadext, threadRing, node);
+      if (pthread_equal(pt->id, self)) {
+        victim = pt;
+        break;
+      }
+    }
+    AVER(victim != NULL);
+
     /* copy the ucontext structure so we definitely have it on our stack,
      * not (e.g.) shared with other threads. */
     ucontext = *(ucontext_t *)uap;
     MutatorContextInitThread(&context, &ucontext);
-    suspendingVictim->context = &context;
+    victim->context = &context;
     /* Block all signals except PTHREADEXT_SIGRESUME while suspended. */
     sigfillset(&signal_set);
     sigdelset(&signal_set, PTHREADEXT_SIGRESUME);
@@ -118,7 +133,8 @@ static void PThreadextModuleInit(void)
   
     AVER(pthreadextModuleInitialized == FALSE);
 
-    /* Initialize the ring of suspended threads */
+    /* Initialize the rings of suspending and suspended threads */
+    RingInit(&suspendingRing);
     RingInit(&suspendedRing);
 
     /* Initialize the semaphore */
@@ -241,65 +257,149 @@ extern void PThreadextFinish(PThreadext pthreadext)
 }
 
 
-/* PThreadextSuspend -- suspend a thread
+/* PThreadextSuspendBegin -- start suspending a set of threads
  *
- * See <design/pthreadext/#impl.suspend>
+ * See <design/pthreadext/#impl.suspend.parallel>.
  */
 
-Res PThreadextSuspend(PThreadext target, MutatorContext *contextReturn)
+void PThreadextSuspendBegin(void)
 {
-  Ring node, next;
-  Res res;
   int status;
 
-  AVERT(PThreadext, target);
-  AVER(contextReturn != NULL);
-  AVER(target->context == NULL); /* multiple suspends illegal */
+  /* The first call to init will initialize the package. */
+  status = pthread_once(&pthreadextOnce, PThreadextModuleInit);
+  AVER(status == 0);
 
-  /* Serialize access to suspend, makes life easier */
+  /* Serialize access to suspend, makes life easier.  The mutex is
+     held until PThreadextSuspendEnd. */
   status = pthread_mutex_lock(&pthreadextMut);
   AVER(status == 0);
-  AVER(suspendingVictim == NULL);
+  AVER(RingIsSingle(&suspendingRing));
+  AVER(suspendingCount == 0);
+}
+
+
+/* PThreadextSuspendAdd -- add a thread to the set to suspend
+ *
+ * Must be called between PThreadextSuspendBegin and
+ * PThreadextSuspendEnd.  The thread isn't signalled yet.
+ */
+
+void PThreadextSuspendAdd(PThreadext target)
+{
+  Ring node, next;
+
+  AVER(TESTT(PThreadext, target));
+  AVER(target->context == NULL); /* multiple suspends illegal */
 
   /* Threads are added to the suspended ring on suspension */
   /* If the same thread Id has already been suspended, then */
   /* don't signal the thread, just add the target onto the id ring */
   RING_FOR(node, &suspendedRing, next) {
     PThreadext alreadySusp = RING_ELT(PThreadext, threadRing, node);
-    if (alreadySusp->id == target->id) {
+    if (pthread_equal(alreadySusp->id, target->id)) {
       RingAppend(&alreadySusp->idRing, &target->idRing);
       target->context = alreadySusp->context;
-      goto noteSuspended;
+      RingAppend(&suspendedRing, &target->threadRing);
+      return;
     }
   }
 
-  /* Ok, we really need to suspend this thread. */
-  suspendingVictim = target;
-  status = pthread_kill(target->id, PTHREADEXT_SIGSUSPEND);
-  if (status != 0) {
-    res = ResFAIL;
-    goto unlock;
+  /* Likewise if it's about to be suspended.  Its context is filled in
+     by PThreadextSuspendEnd. */
+  RING_FOR(node, &suspendingRing, next) {
+    PThreadext victim = RING_ELT(PThreadext, threadRing, node);
+    if (pthread_equal(victim->id, target->id)) {
+      RingAppend(&victim->idRing, &target->idRing);
+      return;
+    }
   }
 
-  /* Wait for the victim to acknowledge suspension. */
-  while (sem_wait(&pthreadextSem) != 0) {
-    if (errno != EINTR) {
-      res = ResFAIL;
-      goto unlock;
-    }
+  RingAppend(&suspendingRing, &target->threadRing);
+}
+
+
+/* PThreadextSuspendEnd -- suspend the threads added since Begin
+ *
+ * Signals all the victims, then waits for all their acknowledgements,
+ * so that they suspend in parallel.  A thread that couldn't be
+ * signalled (because it has terminated) is left with a NULL context.
+ */
+
+void PThreadextSuspendEnd(void)
+{
+  Ring node, next;
+  int status;
+
+  /* Signal all the victims.  The suspending ring must not change
+     until they have all acknowledged, because their signal handlers
+     search it. */
+  RING_FOR(node, &suspendingRing, next) {
+    PThreadext victim = RING_ELT(PThreadext, threadRing, node);
+    if (pthread_kill(victim->id, PTHREADEXT_SIGSUSPEND) == 0)
+      ++suspendingCount;
   }
 
-noteSuspended:
-  AVER(target->context != NULL);
-  RingAppend(&suspendedRing, &target->threadRing);
-  *contextReturn = target->context;
-  res = ResOK;
+  /* Wait for the victims to acknowledge suspension. */
+  while (suspendingCount > 0) {
+    if (sem_wait(&pthreadextSem) == 0)
+      --suspendingCount;
+    else
+      AVER(errno == EINTR);
+  }
+
+  /* Move the victims, and other PThreadexts for the same threads, to
+     the suspended ring. */
+  RING_FOR(node, &suspendingRing, next) {
+    PThreadext victim = RING_ELT(PThreadext, threadRing, node);
+    Ring idNode, idNext;
+    RingRemove(&victim->threadRing);
+    if (victim->context != NULL)
+      RingAppend(&suspendedRing, &victim->threadRing);
+    RING_FOR(idNode, &victim->idRing, idNext) {
+      PThreadext pt = RING_ELT(PThreadext, idRing, idNode);
+      if (victim->context != NULL) {
+        pt->context = victim->context;
+        RingAppend(&suspendedRing, &pt->threadRing);
+      } else {
+        RingRemove(&pt->idRing);
+      }
+    }
+  }
+  AVER(RingIsSingle(&suspendingRing));
 
-unlock:
-  suspendingVictim = NULL;
   status = pthread_mutex_unlock(&pthreadextMut);
   AVER(status == 0);
-  return res;
+}
+
+
+/* PThreadextSuspend -- suspend a thread
+ *
+ * See <design/pthreadext/#impl.suspend>
+ */
+
+Res PThreadextSuspend(PThreadext target, MutatorContext *contextReturn)
+{
+  AVERT(PThreadext, target);
+  AVER(contextReturn != NULL);
+
+  PThreadextSuspendBegin();
+  PThreadextSuspendAdd(target);
+  PThreadextSuspendEnd();
+
+  if (target->context == NULL)
+    return ResFAIL;
+  *contextReturn = target->context;
+  return ResOK;
+}
+
+
+/* PThreadextContext -- context of a thread, or NULL if not suspended */
+
+MutatorContext PThreadextContext(PThreadext pthreadext)
+{
+  AVER(TESTT(PThreadext, pthreadext));
+  return pthreadext->context;
 }
 
 
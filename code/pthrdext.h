@@ -60,6 +60,22 @@ extern Res PThreadextSuspend(PThreadext pthreadext,
                              MutatorContext *contextReturn);
 
 
+/*  PThreadextSuspendBegin/Add/End -- Suspend several pthreadexts at once
+ *
+ *  Call Add for each pthreadext between Begin and End.  Those that
+ *  are suspended have a context afterwards; see PThreadextContext.
+ */
+
+extern void PThreadextSuspendBegin(void);
+extern void PThreadextSuspendAdd(PThreadext pthreadext);
+extern void PThreadextSuspendEnd(void);
+
+
+/*  PThreadextContext -- Return the context of a suspended pthreadext */
+
+extern MutatorContext PThreadextContext(PThreadext pthreadext);
+
+
 /*  PThreadextResume --  Resume a suspended pthreadext */
 
 extern Res PThreadextResume(PThreadext pthreadext);
@@ -9,6 +9,7 @@
  * design.mps.root-interface. */
 
 #include "mpm.h"
+#include "vm.h" /* for PageSize, see .stack.mark */
 
 SRCID(root, "$Id$");
 
@@ -53,6 +54,10 @@ typedef struct RootStruct {
       mps_area_scan_t scan_area;/* area scanner for stack and registers */
       AreaScanUnion the;
       Word *stackCold;          /* cold end of stack */
+      Word *stackMark;          /* hot end of summarized pages, or NULL */
+      Word *stackClean;         /* unchanged from here to stackCold */
+      RefSet *pageSummary;      /* summaries of pages, cold end first */
+      Count pageCount;          /* length of pageSummary */
     } thread;
     struct {
       mps_fmt_scan_t scan;      /* format-like scanner */
@@ -135,6 +140,13 @@ Bool RootCheck(Root root)
     /* Can't check anything about closure as it could mean anything to
        scan_area. */
     /* Can't check anything about stackCold. */
+    CHECKL(root->the.thread.stackMark == NULL
+           || (root->the.thread.stackMark < root->the.thread.stackCold
+               && root->the.thread.stackMark <= root->the.thread.stackClean
+               && root->the.thread.stackClean <= root->the.thread.stackCold
+               && root->the.thread.pageSummary != NULL));
+    CHECKL((root->the.thread.pageSummary == NULL)
+           == (root->the.thread.pageCount == 0));
     break;
 
   case RootTHREAD_TAGGED:
@@ -143,6 +155,13 @@ Bool RootCheck(Root root)
     /* Can't check anything about tag as it could mean anything to
        scan_area. */
     /* Can't check anything about stackCold. */
+    CHECKL(root->the.thread.stackMark == NULL
+           || (root->the.thread.stackMark < root->the.thread.stackCold
+               && root->the.thread.stackMark <= root->the.thread.stackClean
+               && root->the.thread.stackClean <= root->the.thread.stackCold
+               && root->the.thread.pageSummary != NULL));
+    CHECKL((root->the.thread.pageSummary == NULL)
+           == (root->the.thread.pageCount == 0));
     break;
 
   case RootFMT:
@@ -350,6 +369,10 @@ Res RootCreateThread(Root *rootReturn, Arena arena,
   theUnion.thread.scan_area = scan_area;
   theUnion.thread.the.closure = closure;
   theUnion.thread.stackCold = stackCold;
+  theUnion.thread.stackMark = NULL;
+  theUnion.thread.stackClean = NULL;
+  theUnion.thread.pageSummary = NULL;
+  theUnion.thread.pageCount = 0;
 
   return rootCreate(rootReturn, arena, rank, (RootMode)0, RootTHREAD,
                     &theUnion);
@@ -377,6 +400,10 @@ Res RootCreateThreadTagged(Root *rootReturn, Arena arena,
   theUnion.thread.the.tag.mask = mask;
   theUnion.thread.the.tag.pattern = pattern;
   theUnion.thread.stackCold = stackCold;
+  theUnion.thread.stackMark = NULL;
+  theUnion.thread.stackClean = NULL;
+  theUnion.thread.pageSummary = NULL;
+  theUnion.thread.pageCount = 0;
 
   return rootCreate(rootReturn, arena, rank, (RootMode)0, RootTHREAD_TAGGED,
                     &theUnion);
@@ -444,6 +471,11 @@ void RootDestroy(Root root)
   RingRemove(&root->arenaRing);
   RingFinish(&root->arenaRing);
 
+  if ((root->var == RootTHREAD || root->var == RootTHREAD_TAGGED)
+      && root->the.thread.pageCount > 0)
+    ControlFree(arena, root->the.thread.pageSummary,
+                root->the.thread.pageCount * sizeof(RefSet));
+
   root->sig = SigInvalid;
 
   ControlFree(arena, root, sizeof(RootStruct));
@@ -518,6 +550,115 @@ static void rootSetSummary(Root root, RefSet summary)
 
 /* RootScan -- scan root */
 
+/* rootStackGrow -- make room for the summaries of count stack pages */
+
+static Res rootStackGrow(Root root, Count count)
+{
+  Arena arena = root->arena;
+  Count oldCount = root->the.thread.pageCount;
+  RefSet *summaries;
+  void *p;
+  Index i;
+  Res res;
+
+  if (count < oldCount * 2)
+    count = oldCount * 2;
+  res = ControlAlloc(&p, arena, count * sizeof(RefSet));
+  if (res != ResOK)
+    return res;
+  summaries = p;
+  for (i = 0; i < count; ++i)
+    summaries[i] = i < oldCount ? root->the.thread.pageSummary[i] : RefSetUNIV;
+  if (oldCount > 0)
+    ControlFree(arena, root->the.thread.pageSummary,
+                oldCount * sizeof(RefSet));
+  root->the.thread.pageSummary = summaries;
+  root->the.thread.pageCount = count;
+  return ResOK;
+}
+
+
+/* rootScanThread -- scan the stack and registers of a thread
+ *
+ * .stack.mark: The root keeps a summary of each page of a suspended
+ * thread's stack beyond the page containing the hot end, which is
+ * the mark.  Pages that haven't been written since they were scanned
+ * (from stackClean to stackCold) and had no references to white
+ * zones are skipped.  Pages are the unit in which the operating
+ * system tracks writes.  See <design/root/#stack.mark>.
+ */
+
+static Res rootScanThread(ScanState ss, Root root, void *closure)
+{
+  Thread thread = root->the.thread.thread;
+  mps_area_scan_t scan_area = root->the.thread.scan_area;
+  Word *stackCold = root->the.thread.stackCold;
+  Size pageSize = PageSize();
+  Word *mark, *clean, *base;
+  RefSet unfixed;
+  Addr hot = NULL, coldLimit;
+  Count count;
+  Res res;
+
+  if (ArenaSoftDirty(root->arena))
+    hot = ThreadStackHot(thread);
+  if (hot == NULL)
+    goto scanAll;
+  mark = (Word *)AddrAlignUp(hot, pageSize);
+  if (mark >= stackCold)
+    goto scanAll;
+  coldLimit = AddrAlignUp((Addr)stackCold, pageSize);
+  count = AddrOffset(mark, coldLimit) / pageSize;
+  if (count > root->the.thread.pageCount) {
+    /* The control pool isn't thread-safe, so serialize with the other
+       collector threads.  See <design/root/#parallel>. */
+    ScanStateSharedClaim(ss);
+    res = rootStackGrow(root, count);
+    ScanStateSharedRelease(ss);
+    if (res != ResOK)
+      goto scanAll;
+  }
+
+  /* Pages from the old mark to stackClean have been written, and
+     pages hotter than the old mark have no summaries. */
+  clean = stackCold;
+  if (root->the.thread.stackMark != NULL) {
+    clean = root->the.thread.stackClean;
+    if (clean < mark)
+      clean = mark;
+  }
+  root->the.thread.stackMark = NULL;
+
+  unfixed = ScanStateUnfixedSummary(ss);
+  for (base = mark; base < stackCold;
+       base = (Word *)AddrAdd((Addr)base, pageSize)) {
+    Word *limit = (Word *)AddrAdd((Addr)base, pageSize);
+    RefSet *summary = &root->the.thread.pageSummary[
+      AddrOffset(base, coldLimit) / pageSize - 1];
+    if (limit > stackCold)
+      limit = stackCold;
+    if (base < clean
+        || ZoneSetInter(*summary, ScanStateWhite(ss)) != ZoneSetEMPTY) {
+      ScanStateSetUnfixedSummary(ss, RefSetEMPTY);
+      res = TraceScanArea(ss, base, limit, scan_area, closure);
+      if (res != ResOK)
+        return res;
+      *summary = ScanStateUnfixedSummary(ss);
+    }
+    unfixed = RefSetUnion(unfixed, *summary);
+  }
+  ScanStateSetUnfixedSummary(ss, unfixed);
+  root->the.thread.stackMark = mark;
+  root->the.thread.stackClean = mark;
+
+  return ThreadScan(ss, thread, mark, scan_area, closure);
+
+scanAll:
+  root->the.thread.stackMark = NULL;
+  return ThreadScan(ss, thread, stackCold, scan_area, closure);
+}
+
+
 Res RootScan(ScanState ss, Root root)
 {
   Res res;
@@ -565,19 +706,13 @@ Res RootScan(ScanState ss, Root root)
     break;
 
   case RootTHREAD:
-    res = ThreadScan(ss, root->the.thread.thread,
-                     root->the.thread.stackCold,
-                     root->the.thread.scan_area,
-                     root->the.thread.the.closure);
+    res = rootScanThread(ss, root, root->the.thread.the.closure);
     if (res != ResOK)
       goto failScan;
     break;
 
   case RootTHREAD_TAGGED:
-    res = ThreadScan(ss, root->the.thread.thread,
-                     root->the.thread.stackCold,
-                     root->the.thread.scan_area,
-                     &root->the.thread.the.tag);
+    res = rootScanThread(ss, root, &root->the.thread.the.tag);
     if (res != ResOK)
       goto failScan;
     break;
@@ -609,6 +744,35 @@ failScan:
 }
 
 
+/* RootParallel -- may a root be scanned by a collector thread?
+ *
+ * Thread stacks, except the one belonging to the calling thread, and
+ * area roots of at least ROOT_PARALLEL_SIZE bytes are scanned by the
+ * arena's collector threads at flip.  Other roots call client code
+ * that may not expect to run concurrently, or are too small to be
+ * worth handing out.  See <design/root/#parallel>.
+ */
+
+Bool RootParallel(Root root)
+{
+  AVERT(Root, root);
+
+  switch(root->var) {
+  case RootAREA:
+  case RootAREA_TAGGED:
+    return AddrOffset(root->the.area.base, root->the.area.limit)
+           >= ROOT_PARALLEL_SIZE;
+
+  case RootTHREAD:
+  case RootTHREAD_TAGGED:
+    return !ThreadIsCurrent(root->the.thread.thread);
+
+  default:
+    return FALSE;
+  }
+}
+
+
 /* RootOfAddr -- return the root at addr
  *
  * Returns TRUE if the addr is in a root (and returns the root in
@@ -670,6 +834,35 @@ Res RootsIterate(Globals arena, RootIterateFn f, void *p)
 }
 
 
+/* RootsStackDirty -- note which stack pages have been written
+ *
+ * Must be called while the mutator is suspended, before the arena
+ * clears its dirty state.  See <design/root/#stack.mark.dirty>.
+ */
+
+void RootsStackDirty(Globals arenaGlobals)
+{
+  Arena arena;
+  Ring node, next;
+
+  AVERT(Globals, arenaGlobals);
+  arena = GlobalsArena(arenaGlobals);
+  if (!ArenaSoftDirty(arena))
+    return;
+
+  RING_FOR(node, &arenaGlobals->rootRing, next) {
+    Root root = RING_ELT(Root, arenaRing, node);
+
+    if ((root->var == RootTHREAD || root->var == RootTHREAD_TAGGED)
+        && root->the.thread.stackMark != NULL
+        && root->the.thread.stackClean < root->the.thread.stackCold)
+      root->the.thread.stackClean =
+        (Word *)ArenaDirtyLimit(arena, (Addr)root->the.thread.stackClean,
+                                (Addr)root->the.thread.stackCold);
+  }
+}
+
+
 /* RootDescribe -- describe a root */
 
 Res RootDescribe(Root root, mps_lib_FILE *stream, Count depth)
@@ -746,6 +939,9 @@ Res RootDescribe(Root root, mps_lib_FILE *stream, Count depth)
                  "closure $P\n",
                  (WriteFP)root->the.thread.the.closure,
                  "stackCold $P\n", (WriteFP)root->the.thread.stackCold,
+                 "stackMark $P\n", (WriteFP)root->the.thread.stackMark,
+                 "stackClean $P\n", (WriteFP)root->the.thread.stackClean,
+                 "pageCount $U\n", (WriteFU)root->the.thread.pageCount,
                  NULL);
     if (res != ResOK)
       return res;
@@ -757,6 +953,9 @@ Res RootDescribe(Root root, mps_lib_FILE *stream, Count depth)
                  "mask $B\n", (WriteFB)root->the.thread.the.tag.mask,
                  "pattern $B\n", (WriteFB)root->the.thread.the.tag.pattern,
                  "stackCold $P\n", (WriteFP)root->the.thread.stackCold,
+                 "stackMark $P\n", (WriteFP)root->the.thread.stackMark,
+                 "stackClean $P\n", (WriteFP)root->the.thread.stackClean,
+                 "pageCount $U\n", (WriteFU)root->the.thread.pageCount,
                  NULL);
     if (res != ResOK)
       return res;
@@ -13,34 +13,13 @@
  */
 
 #include "mps.h"
-#include "mpstd.h" /* for MPS_BUILD_MV */
-
-
-#ifdef MPS_BUILD_MV
-/* MSVC warning 4127 = conditional expression is constant */
-/* Objects to: MPS_SCAN_AREA(1). */
-#pragma warning( disable : 4127 )
-#endif
-
-
-#define MPS_SCAN_AREA(test) \
-  MPS_SCAN_BEGIN(ss) {                                  \
-    mps_word_t *p = base;                               \
-    while (p < (mps_word_t *)limit) {                   \
-      mps_word_t word = *p;                             \
-      mps_word_t tag_bits = word & mask;                \
-      if (test) {                                       \
-        mps_addr_t ref = (mps_addr_t)(word ^ tag_bits); \
-        if (MPS_FIX1(ss, ref)) {                        \
-          mps_res_t res = MPS_FIX2(ss, &ref);           \
-          if (res != MPS_RES_OK)                        \
-            return res;                                 \
-          *p = (mps_word_t)ref | tag_bits;              \
-        }                                               \
-      }                                                 \
-      ++p;                                              \
-    }                                                   \
-  } MPS_SCAN_END(ss);
+
+
+/* .fix-area: The scanners below are written in terms of mps_fix_area
+ * and mps_fix_area_tagged, which apply the first stage of fixing
+ * (MPS_FIX1) to several words at once and only then fix the
+ * survivors.  A client scanner for an area of references can do the
+ * same.  See <design/scan/#fix-area>. */
 
 
 /* mps_scan_area -- scan contiguous area of references
@@ -57,13 +36,9 @@ mps_res_t mps_scan_area(mps_ss_t ss,
                         void *base, void *limit,
                         void *closure)
 {
-  mps_word_t mask = 0;
-  
   (void)closure; /* unused */
 
-  MPS_SCAN_AREA(1);
-
-  return MPS_RES_OK;
+  return mps_fix_area(ss, base, limit, 0);
 }
 
 
@@ -84,11 +59,8 @@ mps_res_t mps_scan_area_masked(mps_ss_t ss,
                                void *closure)
 {
   mps_scan_tag_t tag = closure;
-  mps_word_t mask = tag->mask;
-
-  MPS_SCAN_AREA(1);
 
-  return MPS_RES_OK;
+  return mps_fix_area(ss, base, limit, tag->mask);
 }
 
 
@@ -106,12 +78,8 @@ mps_res_t mps_scan_area_tagged(mps_ss_t ss,
                                void *closure)
 {
   mps_scan_tag_t tag = closure;
-  mps_word_t mask = tag->mask;
-  mps_word_t pattern = tag->pattern;
 
-  MPS_SCAN_AREA(tag_bits == pattern);
-
-  return MPS_RES_OK;
+  return mps_fix_area_tagged(ss, base, limit, tag->mask, tag->pattern);
 }
 
 
@@ -128,6 +96,10 @@ mps_res_t mps_scan_area_tagged(mps_ss_t ss,
  * registers when using an optimising C compiler and non-zero tags on
  * references, since the compiler is likely to leave untagged
  * addresses of objects around which must not be ignored.
+ *
+ * The two kinds of reference are fixed in separate passes over the
+ * area.  No word is fixed twice, because fixing a reference doesn't
+ * change its tag.
  */
 
 mps_res_t mps_scan_area_tagged_or_zero(mps_ss_t ss,
@@ -135,12 +107,12 @@ mps_res_t mps_scan_area_tagged_or_zero(mps_ss_t ss,
                                        void *closure)
 {
   mps_scan_tag_t tag = closure;
-  mps_word_t mask = tag->mask;
-  mps_word_t pattern = tag->pattern;
-
-  MPS_SCAN_AREA(tag_bits == 0 || tag_bits == pattern);
+  mps_res_t res;
 
-  return MPS_RES_OK;
+  res = mps_fix_area_tagged(ss, base, limit, tag->mask, tag->pattern);
+  if (res != MPS_RES_OK || tag->pattern == 0)
+    return res;
+  return mps_fix_area_tagged(ss, base, limit, tag->mask, 0);
 }  
 
 
@@ -137,8 +137,11 @@ static Res SegAbsInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   seg->pm = AccessSetEMPTY;
   seg->sm = AccessSetEMPTY;
   seg->defer = WB_DEFER_INIT;
+  seg->singleAccesses = 0;
+  seg->singleLimit = SINGLE_ACCESS_INIT;
   seg->depth = 0;
   seg->queued = FALSE;
+  seg->written = FALSE;
   seg->firstTract = NULL;
   RingInit(SegPoolRing(seg));
   
@@ -309,6 +312,50 @@ void SegSetSummary(Seg seg, RefSet summary)
 }
 
 
+/* SegSetWritten, SegClearWritten -- note collector writes to a segment
+ *
+ * In an arena that uses soft-dirty pages, the collector's own writes
+ * would look like the mutator's at the next flip.  So a segment with
+ * references that the collector is about to write goes back to the
+ * write barrier until then, first folding in what the mutator wrote
+ * while it was unprotected.  ShieldRaise either protects the segment or suspends
+ * the mutator, so no write is missed between the two.  See
+ * <design/write-barrier/#soft-dirty.written>.
+ */
+
+void SegSetWritten(Seg seg)
+{
+  Arena arena;
+
+  AVERT(Seg, seg);
+  arena = PoolArena(SegPool(seg));
+  AVER(ArenaSoftDirty(arena));
+  AVER(!SegWritten(seg));
+  AVER(SegRankSet(seg) != RankSetEMPTY);
+
+  seg->written = TRUE;
+  if (SegSummary(seg) != RefSetUNIV) {
+    ShieldRaise(arena, seg, AccessWRITE);
+    if (ArenaDirty(arena, SegBase(seg), SegLimit(seg)))
+      SegSetSummary(seg, RefSetUNIV);
+  }
+}
+
+void SegClearWritten(Seg seg)
+{
+  Arena arena;
+
+  AVERT(Seg, seg);
+  arena = PoolArena(SegPool(seg));
+  AVER(ArenaSoftDirty(arena));
+  AVER(SegWritten(seg));
+
+  seg->written = FALSE;
+  if (SegRankSet(seg) != RankSetEMPTY)
+    ShieldLower(arena, seg, AccessWRITE);
+}
+
+
 /* SegSetRankAndSummary -- set both the rank set and the summary */
 
 void SegSetRankAndSummary(Seg seg, RankSet rankSet, RefSet summary)
@@ -757,7 +804,10 @@ Bool SegCheck(Seg seg)
   /* All unsynced segments have positive depth or are in the queue
      (design.mps.shield.inv.unsynced.depth). */
   CHECKL(seg->sm == seg->pm || seg->depth > 0 || seg->queued);
-  
+
+  /* See design.mps.trace.single-access.adapt. */
+  CHECKL(seg->singleLimit >= 1);
+
   CHECKL(RankSetCheck(seg->rankSet));
   if (seg->rankSet == RankSetEMPTY) {
     /* <design/seg/#field.rankSet.empty>: If there are no refs */
@@ -918,6 +968,7 @@ static Res segTrivMerge(Seg seg, Seg segHi,
   AVER(seg->sm == segHi->sm);
   AVER(seg->depth == segHi->depth);
   AVER(seg->queued == segHi->queued);
+  AVER(seg->written == segHi->written);
   /* Neither segment may be exposed, or in the shield cache */
   /* See <design/seg/#split-merge.shield> & <code/shield.c#def.depth> */
   AVER(seg->depth == 0);
@@ -1000,6 +1051,10 @@ static Res segTrivSplit(Seg seg, Seg segHi,
   segHi->sm = seg->sm;
   segHi->depth = seg->depth;
   segHi->queued = seg->queued;
+  segHi->written = seg->written;
+  segHi->defer = seg->defer;
+  segHi->singleAccesses = seg->singleAccesses;
+  segHi->singleLimit = seg->singleLimit;
   segHi->firstTract = NULL;
   RingInit(SegPoolRing(segHi));
 
@@ -1060,6 +1115,10 @@ Bool GCSegCheck(GCSeg gcseg)
 
   CHECKD_NOSIG(Ring, &gcseg->genRing);
 
+  /* Only a white segment can be awaiting reclaim. */
+  CHECKD_NOSIG(Ring, &gcseg->reclaimRing);
+  CHECKL(RingIsSingle(&gcseg->reclaimRing) || seg->white != TraceSetEMPTY);
+
   return TRUE;
 }
 
@@ -1081,6 +1140,7 @@ static Res gcSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   gcseg->buffer = NULL;
   RingInit(&gcseg->greyRing);
   RingInit(&gcseg->genRing);
+  RingInit(&gcseg->reclaimRing);
 
   SetClassOfPoly(seg, CLASS(GCSeg));
   gcseg->sig = GCSegSig;
@@ -1101,6 +1161,10 @@ static void gcSegFinish(Inst inst)
     RingRemove(&gcseg->greyRing);
     seg->grey = TraceSetEMPTY;
   }
+  /* A pool that is destroyed while the arena is collecting may have
+     segments awaiting reclaim.  See design.mps.trace.reclaim.lazy. */
+  if (!RingIsSingle(&gcseg->reclaimRing))
+    RingRemove(&gcseg->reclaimRing);
   gcseg->summary = RefSetEMPTY;
 
   gcseg->sig = SigInvalid;
@@ -1110,6 +1174,7 @@ static void gcSegFinish(Inst inst)
 
   RingFinish(&gcseg->greyRing);
   RingFinish(&gcseg->genRing);
+  RingFinish(&gcseg->reclaimRing);
 
   /* finish the superclass fields last */
   NextMethod(Inst, GCSeg, finish)(inst);
@@ -1287,7 +1352,10 @@ static void gcSegSetRankSet(Seg seg, RankSet rankSet)
   if (oldRankSet == RankSetEMPTY) {
     if (rankSet != RankSetEMPTY) {
       AVER(gcseg->summary == RefSetEMPTY);
-      ShieldRaise(arena, seg, AccessWRITE);
+      /* Dirty tracking replaces the write barrier
+         <design/write-barrier/#card>. */
+      if (!SegTracksDirty(seg, arena))
+        ShieldRaise(arena, seg, AccessWRITE);
     }
   } else {
     if (rankSet == RankSetEMPTY) {
@@ -1301,7 +1369,7 @@ static void gcSegSetRankSet(Seg seg, RankSet rankSet)
 static void gcSegSyncWriteBarrier(Seg seg, Arena arena)
 {
   /* Can't check seg -- this function enforces invariants tested by SegCheck. */
-  if (SegSummary(seg) == RefSetUNIV)
+  if (SegSummary(seg) == RefSetUNIV || SegTracksDirty(seg, arena))
     ShieldLower(arena, seg, AccessWRITE);
   else
     ShieldRaise(arena, seg, AccessWRITE);
@@ -1442,11 +1510,22 @@ static Res gcSegMerge(Seg seg, Seg segHi,
   AVER(buf == NULL || gcseg->buffer == NULL); /* See .buffer */
   grey = SegGrey(segHi);      /* check greyness */
   AVER(SegGrey(seg) == grey);
+  /* .reclaim: Both halves have the same white set, so both or neither
+     are awaiting reclaim. */
+  AVER(RingIsSingle(&gcseg->reclaimRing)
+       == RingIsSingle(&gcsegHi->reclaimRing));
 
   /* Assume that the write barrier shield is being used to implement
      the remembered set only, and so we can merge the shield and
      protection modes by unioning the segment summaries.  See also
-     design.mps.seg.merge.inv.similar. */
+     design.mps.seg.merge.inv.similar.  If only one half is on the
+     write barrier because the collector wrote it, it comes off:
+     raising the barrier here could queue the segment in the shield
+     <design/write-barrier/#soft-dirty.written>. */
+  if (SegWritten(seg) && !SegWritten(segHi))
+    SegClearWritten(seg);
+  else if (SegWritten(segHi) && !SegWritten(seg))
+    SegClearWritten(segHi);
   summary = RefSetUnion(gcseg->summary, gcsegHi->summary);
   SegSetSummary(seg, summary);
   SegSetSummary(segHi, summary);
@@ -1470,6 +1549,11 @@ static Res gcSegMerge(Seg seg, Seg segHi,
   RingFinish(&gcsegHi->greyRing);
   RingRemove(&gcsegHi->genRing);
   RingFinish(&gcsegHi->genRing);
+  /* If segHi was awaiting reclaim then so is seg (see .reclaim), and
+     the merged segment is reclaimed as one. */
+  if (!RingIsSingle(&gcsegHi->reclaimRing))
+    RingRemove(&gcsegHi->reclaimRing);
+  RingFinish(&gcsegHi->reclaimRing);
 
   /* Reassign any buffer that was connected to segHi  */
   if (NULL != buf) {
@@ -1531,6 +1615,9 @@ static Res gcSegSplit(Seg seg, Seg segHi,
   RingInit(&gcsegHi->greyRing);
   RingInit(&gcsegHi->genRing);
   RingInsert(&gcseg->genRing, &gcsegHi->genRing);
+  RingInit(&gcsegHi->reclaimRing);
+  if (!RingIsSingle(&gcseg->reclaimRing))
+    RingInsert(&gcseg->reclaimRing, &gcsegHi->reclaimRing);
   gcsegHi->sig = GCSegSig;
   gcSegSetGreyInternal(segHi, TraceSetEMPTY, grey);
 
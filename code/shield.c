@@ -710,7 +710,10 @@ void (ShieldLeave)(Arena arena)
 /* ShieldExpose -- allow the MPS access to a segment while denying the mutator
  *
  * The first expose of a shielded segment suspends the mutator to
- * ensure the MPS has exclusive access.
+ * ensure the MPS has exclusive access.  In an arena that uses
+ * soft-dirty pages, a segment with references goes back to the write
+ * barrier before the MPS writes to it.  See
+ * <design/write-barrier/#soft-dirty.written>.
  */
 
 void (ShieldExpose)(Arena arena, Seg seg)
@@ -723,6 +726,10 @@ void (ShieldExpose)(Arena arena, Seg seg)
   shield = ArenaShield(arena);
   AVER_CRITICAL(shield->inside);
 
+  if (ArenaSoftDirty(arena) && !SegWritten(seg)
+      && SegRankSet(seg) != RankSetEMPTY)
+    SegSetWritten(seg);
+
   SegSetDepth(seg, SegDepth(seg) + 1);
   AVER_CRITICAL(SegDepth(seg) > 0); /* overflow */
   ++shield->depth;
@@ -278,6 +278,53 @@ static void test_step(mps_arena_t arena, double multiplier)
     }
 }
 
+/* test_collect_until -- check mps_arena_collect_until
+ *
+ * The arena is clamped, so only these calls do collection work.
+ */
+
+static void test_collect_until(mps_arena_t arena, mps_chain_t chain)
+{
+    mps_clock_t later = mps_clock() + mps_clocks_per_sec() * 60;
+    GenDesc nursery = &chain->gens[0];
+    mps_word_t collections;
+    int status;
+
+    /* Finish any collection left by mps_arena_step. */
+    status = mps_arena_collect_until(arena, later, MPS_COLLECT_FINISH);
+    Insist(status != MPS_COLLECT_DEADLINE);
+    Insist(arena->busyTraces == TraceSetEMPTY);
+
+    /* A nursery more than ARENA_IDLE_NURSERY_FRACTION full is
+       collected early, given the time. */
+    while (GenDescNewSize(nursery) < gen1SIZE * 1024 * 3 / 4)
+        exactRoots[(size_t)rnd() % exactRootsCOUNT] = make();
+    collections = mps_collections(arena);
+    status = mps_arena_collect_until(arena, later, MPS_COLLECT_START);
+    Insist(status == MPS_COLLECT_DONE);
+    Insist(arena->busyTraces != TraceSetEMPTY);
+
+    /* A deadline in the past leaves the trace unfinished. */
+    status = mps_arena_collect_until(arena, mps_clock(), MPS_COLLECT_FINISH);
+    Insist(status == MPS_COLLECT_DEADLINE);
+    Insist(arena->busyTraces != TraceSetEMPTY);
+
+    status = mps_arena_collect_until(arena, later, MPS_COLLECT_FINISH);
+    Insist(status == MPS_COLLECT_DONE);
+    Insist(arena->busyTraces == TraceSetEMPTY);
+    Insist(mps_collections(arena) > collections);
+    status = mps_arena_collect_until(arena, later, MPS_COLLECT_FINISH);
+    Insist(status == MPS_COLLECT_IDLE);
+
+    /* Compaction returns all spare memory, once. */
+    status = mps_arena_collect_until(arena, later, MPS_COLLECT_COMPACT);
+    Insist(status != MPS_COLLECT_DEADLINE);
+    Insist(mps_arena_spare_committed(arena) == 0);
+    status = mps_arena_collect_until(arena, later, MPS_COLLECT_COMPACT);
+    Insist(status == MPS_COLLECT_IDLE);
+    Insist(ArenaGlobals(arena)->clamped);
+}
+
 /* test -- the body of the test */
 
 static void test(mps_arena_t arena, unsigned long step_period)
@@ -457,6 +504,8 @@ static void test(mps_arena_t arena, unsigned long step_period)
     print_time("", total_clock_time / clock_reads, " per read;");
     print_time(" recently measured as ", clock_time, ").\n");
 
+    test_collect_until(arena, chain);
+
     mps_arena_park(arena);
     mps_ap_destroy(ap);
     mps_root_destroy(exactRoot);
@@ -57,6 +57,20 @@ extern void ThreadRingSuspend(Ring threadRing, Ring deadRing);
 extern void ThreadRingResume(Ring threadRing, Ring deadRing);
 
 
+/*  ThreadPark/Unpark
+ *
+ *  The current thread promises not to access the heap between park
+ *  and unpark, typically because it's blocked in a system call.  A
+ *  thread manager may then leave it running when it suspends the
+ *  others, but it still gets scanned.  hot is the hot end of the
+ *  client's stack where it called the MPS (see CALLER_STACK_HOT), or
+ *  NULL if that isn't known.
+ */
+
+extern void ThreadPark(Thread thread, Addr hot);
+extern void ThreadUnpark(Thread thread);
+
+
 /*  ThreadRingThread
  *
  *  Return the thread from an element of the Arena's
@@ -68,11 +82,43 @@ extern Thread ThreadRingThread(Ring threadRing);
 
 extern Arena ThreadArena(Thread thread);
 
+
+/*  ThreadCurrentId
+ *
+ *  Return a word that distinguishes the calling thread from the other
+ *  threads that are running, whether or not it is registered.  It is
+ *  only suitable for hashing: identifiers may be reused once a thread
+ *  exits.  Must be thread-safe.
+ */
+
+extern Word ThreadCurrentId(void);
+
+
+/*  ThreadIsCurrent
+ *
+ *  Return TRUE if thread is the calling thread.  ThreadScan scans the
+ *  stack of the calling thread from its own stack pointer, so such a
+ *  thread must not be scanned from any other thread.  Must be
+ *  thread-safe.
+ */
+
+extern Bool ThreadIsCurrent(Thread thread);
+
 extern Res ThreadScan(ScanState ss, Thread thread, Word *stackCold,
                       mps_area_scan_t scan_area,
                       void *closure);
 
 
+/*  ThreadStackHot
+ *
+ *  Return the hot end of the stack of a thread suspended by
+ *  ThreadRingSuspend, or NULL if that isn't known, for example
+ *  because the thread is the current thread or is dead.
+ */
+
+extern Addr ThreadStackHot(Thread thread);
+
+
 #endif /* th_h */
 
 
@@ -97,6 +97,23 @@ void ThreadRingResume(Ring threadRing, Ring deadRing)
   AVERT(Ring, deadRing);
 }
 
+/* ThreadPark, ThreadUnpark -- note a blocking call
+ *
+ * There is only one thread, so nothing to do.
+ */
+
+void ThreadPark(Thread thread, Addr hot)
+{
+  AVERT(Thread, thread);
+  UNUSED(hot);
+}
+
+void ThreadUnpark(Thread thread)
+{
+  AVERT(Thread, thread);
+}
+
+
 Thread ThreadRingThread(Ring threadRing)
 {
   Thread thread;
@@ -116,6 +133,30 @@ Arena ThreadArena(Thread thread)
 }
 
 
+/* ThreadCurrentId -- identify the calling thread
+ *
+ * There is only one thread in a generic implementation.
+ */
+
+Word ThreadCurrentId(void)
+{
+  return 0;
+}
+
+
+/* ThreadIsCurrent -- is a thread the calling thread?
+ *
+ * ThreadScan always scans the calling thread's stack, so every thread
+ * must be treated as the current thread.
+ */
+
+Bool ThreadIsCurrent(Thread thread)
+{
+  AVERT(Thread, thread);
+  return TRUE;
+}
+
+
 Res ThreadScan(ScanState ss, Thread thread, Word *stackCold,
                mps_area_scan_t scan_area,
                void *closure)
@@ -125,6 +166,19 @@ Res ThreadScan(ScanState ss, Thread thread, Word *stackCold,
 }
 
 
+/* ThreadStackHot -- hot end of a suspended thread's stack
+ *
+ * Only needed with soft-dirty pages, which this platform doesn't
+ * have.  See <design/root/#stack.mark>.
+ */
+
+Addr ThreadStackHot(Thread thread)
+{
+  AVERT(Thread, thread);
+  return NULL;
+}
+
+
 Res ThreadDescribe(Thread thread, mps_lib_FILE *stream, Count depth)
 {
   Res res;
@@ -30,6 +30,21 @@
  * .stack.align: assume roots on the stack are always word-aligned,
  * but don't assume that the stack pointer is necessarily
  * word-aligned at the time of reading the context of another thread.
+ *
+ * .park: A parked thread has promised not to touch the heap until it
+ * unparks, so it isn't signalled when the other threads are suspended.
+ * Its registers were saved by ThreadPark, and its stack is scanned from
+ * the stack pointer at that time.  Any reference it holds across the
+ * park is in a callee-save register or in a frame above that, and
+ * ambiguous references don't move, so the saved values are still
+ * correct.  See <design/thread-manager/#impl.ix.park>.
+ *
+ * .park.copy: The registers are saved a few frames into the MPS, and
+ * those frames may hold the client's callee-save registers.  They are
+ * dead once mps_thread_park returns, and the blocking call overwrites
+ * them, so ThreadPark copies them into the thread structure and the
+ * copy is scanned instead.  If they don't fit, the thread isn't
+ * really parked, and is suspended like any other.
  */
 
 #include "prmcix.h"
@@ -52,6 +67,13 @@ typedef struct mps_thr_s {       /* PThreads thread structure */
   PThreadextStruct thrextStruct; /* PThreads extension */
   pthread_t id;                  /* Pthread object of thread */
   MutatorContext context;        /* Context if suspended, NULL if not */
+  Bool parked;                   /* in a blocking call? .park */
+  Bool parkSaved;                /* context saved at park? .park.copy */
+  ucontext_t parkUcontext;       /* registers saved by ThreadPark */
+  MutatorContextStruct parkContext; /* context of parked thread */
+  Word *parkHot;                 /* client's stack pointer at park */
+  Count parkCount;               /* words in parkStack */
+  Word parkStack[THREAD_PARK_STACK / sizeof(Word)]; /* .park.copy */
 } ThreadStruct;
 
 
@@ -64,6 +86,10 @@ Bool ThreadCheck(Thread thread)
   CHECKL(thread->serial < thread->arena->threadSerial);
   CHECKD_NOSIG(Ring, &thread->arenaRing);
   CHECKL(BoolCheck(thread->alive));
+  CHECKL(BoolCheck(thread->parked));
+  CHECKL(BoolCheck(thread->parkSaved));
+  CHECKL(!thread->parkSaved || thread->parked);
+  CHECKL(thread->parkCount <= NELEMS(thread->parkStack));
   CHECKD(PThreadext, &thread->thrextStruct);
   return TRUE;
 }
@@ -101,6 +127,10 @@ Res ThreadRegister(Thread *threadReturn, Arena arena)
   thread->arena = arena;
   thread->alive = TRUE;
   thread->context = NULL;
+  thread->parked = FALSE;
+  thread->parkSaved = FALSE;
+  thread->parkHot = NULL;
+  thread->parkCount = 0;
 
   PThreadextInit(&thread->thrextStruct, thread->id);
 
@@ -119,6 +149,7 @@ void ThreadDeregister(Thread thread, Arena arena)
 {
   AVERT(Thread, thread);
   AVERT(Arena, arena);
+  AVER(!thread->parked);
 
   RingRemove(&thread->arenaRing);
 
@@ -167,26 +198,49 @@ static void mapThreadRing(Ring threadRing, Ring deadRing, Bool (*func)(Thread))
 
 /* ThreadRingSuspend -- suspend all threads on a ring, except the
  * current one.
+ *
+ * The threads are signalled together and suspend in parallel, so the
+ * mapping is done in two passes.  See
+ * <design/pthreadext/#impl.suspend.parallel>.
  */
 
-static Bool threadSuspend(Thread thread)
+static void threadSuspendAdd(Thread thread)
 {
-  /* .error.suspend: if PThreadextSuspend fails, we assume the thread
-   * has been terminated. */
-  Res res;
   AVER(thread->context == NULL);
-  res = PThreadextSuspend(&thread->thrextStruct, &thread->context);
-  AVER(res == ResOK);
+  if (thread->parkSaved)
+    thread->context = &thread->parkContext; /* .park */
+  else
+    PThreadextSuspendAdd(&thread->thrextStruct);
+}
+
+static Bool threadSuspendEnd(Thread thread)
+{
+  /* .error.suspend: if the thread couldn't be suspended, we assume
+   * it has been terminated. */
+  if (!thread->parkSaved)
+    thread->context = PThreadextContext(&thread->thrextStruct);
   AVER(thread->context != NULL);
   /* design.thread-manager.sol.thread.term.attempt */
-  return res == ResOK;
+  return thread->context != NULL;
 }
 
-
-
 void ThreadRingSuspend(Ring threadRing, Ring deadRing)
 {
-  mapThreadRing(threadRing, deadRing, threadSuspend);
+  Ring node, next;
+
+  /* PThreadextCheck can't be called between Begin and End, so check
+     the threads first. */
+  RING_FOR(node, threadRing, next) {
+    AVERT(Thread, RING_ELT(Thread, arenaRing, node));
+  }
+  PThreadextSuspendBegin();
+  RING_FOR(node, threadRing, next) {
+    Thread thread = RING_ELT(Thread, arenaRing, node);
+    if (!pthread_equal(pthread_self(), thread->id)) /* .thread.id */
+      threadSuspendAdd(thread);
+  }
+  PThreadextSuspendEnd();
+  mapThreadRing(threadRing, deadRing, threadSuspendEnd);
 }
 
 
@@ -199,6 +253,11 @@ static Bool threadResume(Thread thread)
   /* .error.resume: If PThreadextResume fails, we assume the thread
    * has been terminated. */
   AVER(thread->context != NULL);
+  if (thread->parkSaved) {
+    AVER(thread->context == &thread->parkContext);
+    thread->context = NULL;
+    return TRUE;
+  }
   res = PThreadextResume(&thread->thrextStruct);
   AVER(res == ResOK);
   thread->context = NULL;
@@ -212,6 +271,59 @@ void ThreadRingResume(Ring threadRing, Ring deadRing)
 }
 
 
+/* ThreadPark -- note that the current thread is about to block
+ *
+ * See .park and .park.copy.
+ */
+
+void ThreadPark(Thread thread, Addr hot)
+{
+  int status;
+  Word *base, *limit;
+  Count count;
+
+  AVERT(Thread, thread);
+  AVER(pthread_equal(pthread_self(), thread->id));
+  AVER(!thread->parked);
+  AVER(thread->context == NULL);
+
+  thread->parked = TRUE;
+  if (hot == NULL)
+    return;
+
+  status = getcontext(&thread->parkUcontext);
+  AVER(status == 0);
+  MutatorContextInitThread(&thread->parkContext, &thread->parkUcontext);
+
+  /* .stack.align */
+  base = (Word *)AddrAlignUp(MutatorContextSP(&thread->parkContext),
+                             sizeof(Word));
+  limit = (Word *)AddrAlignUp(hot, sizeof(Word));
+  AVER(base <= limit);
+  count = (Count)(limit - base);
+  if (count > NELEMS(thread->parkStack))
+    return;
+  (void)mps_lib_memcpy(thread->parkStack, base, count * sizeof(Word));
+  thread->parkHot = limit;
+  thread->parkCount = count;
+  thread->parkSaved = TRUE;
+}
+
+
+/* ThreadUnpark -- note that the current thread may use the heap again */
+
+void ThreadUnpark(Thread thread)
+{
+  AVERT(Thread, thread);
+  AVER(pthread_equal(pthread_self(), thread->id));
+  AVER(thread->parked);
+  AVER(thread->context == NULL);
+
+  thread->parked = FALSE;
+  thread->parkSaved = FALSE;
+}
+
+
 /* ThreadRingThread -- return the thread at the given ring element */
 
 Thread ThreadRingThread(Ring threadRing)
@@ -236,6 +348,23 @@ Arena ThreadArena(Thread thread)
 }
 
 
+/* ThreadCurrentId -- identify the calling thread */
+
+Word ThreadCurrentId(void)
+{
+  return (Word)pthread_self();
+}
+
+
+/* ThreadIsCurrent -- is a thread the calling thread? */
+
+Bool ThreadIsCurrent(Thread thread)
+{
+  AVERT(Thread, thread);
+  return pthread_equal(pthread_self(), thread->id);
+}
+
+
 /* ThreadScan -- scan the state of a thread (stack and regs) */
 
 Res ThreadScan(ScanState ss, Thread thread, Word *stackCold,
@@ -261,7 +390,19 @@ Res ThreadScan(ScanState ss, Thread thread, Word *stackCold,
     context = thread->context;
     AVER(context != NULL);
 
-    stackPtr = MutatorContextSP(context);
+    if (thread->parkSaved) {
+      /* Scan the copy of the frames below the client's stack pointer
+         at park, then the client's frames (.park.copy). */
+      AVER(context == &thread->parkContext);
+      res = TraceScanArea(ss, thread->parkStack,
+                          thread->parkStack + thread->parkCount,
+                          scan_area, closure);
+      if (res != ResOK)
+        return res;
+      stackPtr = (Addr)thread->parkHot;
+    } else {
+      stackPtr = MutatorContextSP(context);
+    }
     /* .stack.align */
     stackBase  = (Word *)AddrAlignUp(stackPtr, sizeof(Word));
     stackLimit = stackCold;
@@ -286,6 +427,22 @@ Res ThreadScan(ScanState ss, Thread thread, Word *stackCold,
 }
 
 
+/* ThreadStackHot -- hot end of a suspended thread's stack
+ *
+ * A parked thread is still running, so its stack may change while it
+ * is scanned (.park).
+ */
+
+Addr ThreadStackHot(Thread thread)
+{
+  AVERT(Thread, thread);
+  if (!thread->alive || thread->parkSaved || thread->context == NULL
+      || pthread_equal(pthread_self(), thread->id))
+    return NULL;
+  return MutatorContextSP(thread->context);
+}
+
+
 /* ThreadDescribe -- describe a thread */
 
 Res ThreadDescribe(Thread thread, mps_lib_FILE *stream, Count depth)
@@ -297,6 +454,7 @@ Res ThreadDescribe(Thread thread, mps_lib_FILE *stream, Count depth)
                "  arena $P ($U)\n",
                (WriteFP)thread->arena, (WriteFU)thread->arena->serial,
                "  alive $S\n", WriteFYesNo(thread->alive),
+               "  parked $S\n", WriteFYesNo(thread->parked),
                "  id $U\n",          (WriteFU)thread->id,
                "} Thread $P ($U)\n", (WriteFP)thread, (WriteFU)thread->serial,
                NULL);
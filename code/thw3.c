@@ -222,6 +222,23 @@ void ThreadRingResume(Ring threadRing, Ring deadRing)
 }
 
 
+/* ThreadPark, ThreadUnpark -- note a blocking call
+ *
+ * Parked threads are suspended like any other.
+ */
+
+void ThreadPark(Thread thread, Addr hot)
+{
+  AVERT(Thread, thread);
+  UNUSED(hot);
+}
+
+void ThreadUnpark(Thread thread)
+{
+  AVERT(Thread, thread);
+}
+
+
 Thread ThreadRingThread(Ring threadRing)
 {
   Thread thread;
@@ -239,6 +256,37 @@ Arena ThreadArena(Thread thread)
   return thread->arena;
 }
 
+
+/* ThreadCurrentId -- identify the calling thread */
+
+Word ThreadCurrentId(void)
+{
+  return (Word)GetCurrentThreadId();
+}
+
+
+/* ThreadIsCurrent -- is a thread the calling thread? */
+
+Bool ThreadIsCurrent(Thread thread)
+{
+  AVERT(Thread, thread);
+  return thread->id == GetCurrentThreadId();
+}
+
+
+/* ThreadStackHot -- hot end of a suspended thread's stack
+ *
+ * Only needed with soft-dirty pages, which this platform doesn't
+ * have.  See <design/root/#stack.mark>.
+ */
+
+Addr ThreadStackHot(Thread thread)
+{
+  AVERT(Thread, thread);
+  return NULL;
+}
+
+
 Res ThreadDescribe(Thread thread, mps_lib_FILE *stream, Count depth)
 {
   Res res;
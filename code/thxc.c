@@ -26,6 +26,7 @@
 #include <mach/task.h>
 #include <mach/thread_act.h>
 #include <mach/thread_status.h>
+#include <pthread.h>
 
 
 SRCID(thxc, "$Id$");
@@ -186,6 +187,23 @@ void ThreadRingResume(Ring threadRing, Ring deadRing)
   mapThreadRing(threadRing, deadRing, threadResume);
 }
 
+/* ThreadPark, ThreadUnpark -- note a blocking call
+ *
+ * Parked threads are suspended like any other.
+ */
+
+void ThreadPark(Thread thread, Addr hot)
+{
+  AVERT(Thread, thread);
+  UNUSED(hot);
+}
+
+void ThreadUnpark(Thread thread)
+{
+  AVERT(Thread, thread);
+}
+
+
 Thread ThreadRingThread(Ring threadRing)
 {
   Thread thread;
@@ -205,6 +223,23 @@ Arena ThreadArena(Thread thread)
 }
 
 
+/* ThreadCurrentId -- identify the calling thread */
+
+Word ThreadCurrentId(void)
+{
+  return (Word)pthread_self();
+}
+
+
+/* ThreadIsCurrent -- is a thread the calling thread? */
+
+Bool ThreadIsCurrent(Thread thread)
+{
+  AVERT(Thread, thread);
+  return thread->port == mach_thread_self();
+}
+
+
 /* ThreadScan -- scan the state of a thread (stack and regs) */
 
 #include "prmcxc.h"
@@ -272,6 +307,19 @@ Res ThreadScan(ScanState ss, Thread thread, Word *stackCold,
 }
 
 
+/* ThreadStackHot -- hot end of a suspended thread's stack
+ *
+ * Only needed with soft-dirty pages, which this platform doesn't
+ * have.  See <design/root/#stack.mark>.
+ */
+
+Addr ThreadStackHot(Thread thread)
+{
+  AVERT(Thread, thread);
+  return NULL;
+}
+
+
 Res ThreadDescribe(Thread thread, mps_lib_FILE *stream, Count depth)
 {
   Res res;
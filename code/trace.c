@@ -51,6 +51,11 @@ Bool ScanStateCheck(ScanState ss)
   CHECKL(TraceSetSuper(ss->arena->busyTraces, ss->traces));
   CHECKL(RankCheck(ss->rank));
   CHECKL(BoolCheck(ss->wasMarked));
+  if (ss->fixLock != NULL)
+    CHECKD_NOSIG(Lock, ss->fixLock);
+  CHECKL(ss->fixLock != NULL || ss->sharedDepth == 0);
+  CHECKL(ss->exposedCount <= TRACE_PARALLEL_EXPOSED);
+  CHECKL(ss->fixLock != NULL || ss->exposedCount == 0);
   /* @@@@ checks for counts missing */
   return TRUE;
 }
@@ -108,6 +113,10 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
   STATISTIC(ss->preservedInPlaceCount = (Count)0);
   STATISTIC(ss->copiedSize = (Size)0);
   ss->scannedSize = (Size)0; /* see .work */
+  ss->fixLock = NULL;
+  ss->sharedDepth = 0;
+  ss->worker = 0;
+  ss->exposedCount = 0;
   ss->sig = ScanStateSig;
 
   AVERT(ScanState, ss);
@@ -119,10 +128,134 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
 void ScanStateFinish(ScanState ss)
 {
   AVERT(ScanState, ss);
+  AVER(ss->sharedDepth == 0);
+  AVER(ss->exposedCount == 0);
   ss->sig = SigInvalid;
 }
 
 
+/* ScanStateSharedClaim, ScanStateSharedRelease -- bracket changes to
+ * shared state during a fix
+ *
+ * A fix method of a pool class with AttrPARALLELFIX may run on
+ * several collector threads at once, holding only the stripe lock for
+ * the white segment.  It must bracket changes to anything other than
+ * that segment's objects and tables (other segments, buffers, the
+ * shield, the control pool) with these, which claim the scan state's
+ * fixLock.  Claims nest.  They do nothing if the scan state is not
+ * being used by a collector thread.  See <design/trace/#parallel.fix>.
+ */
+
+void ScanStateSharedClaim(ScanState ss)
+{
+  AVERT_CRITICAL(ScanState, ss);
+  if (ss->fixLock != NULL) {
+    if (ss->sharedDepth == 0)
+      LockClaim(ss->fixLock);
+    ++ss->sharedDepth;
+  }
+}
+
+void ScanStateSharedRelease(ScanState ss)
+{
+  AVERT_CRITICAL(ScanState, ss);
+  if (ss->fixLock != NULL) {
+    AVER_CRITICAL(ss->sharedDepth > 0);
+    --ss->sharedDepth;
+    if (ss->sharedDepth == 0)
+      LockRelease(ss->fixLock);
+  }
+}
+
+
+/* ScanStateExpose, ScanStateCover -- access a white segment during a fix
+ *
+ * ScanStateExpose gives a fix method access of the given mode to the
+ * white segment it is fixing, and returns TRUE if ScanStateCover must
+ * be called afterwards.  When the scan state is used by a collector
+ * thread and the segment is neither protected nor shielded against
+ * the access, nothing needs doing: only fixes to the segment could
+ * change that, and they are serialized by its stripe lock.  Otherwise
+ * it claims the shared state, because the shield is not thread-safe.
+ * See <design/trace/#parallel.fix.shield>.
+ */
+
+Bool ScanStateExpose(ScanState ss, Seg seg, AccessSet mode)
+{
+  AVERT_CRITICAL(ScanState, ss);
+  AVERT_CRITICAL(Seg, seg);
+  AVERT_CRITICAL(AccessSet, mode);
+
+  /* Without the lock, a segment must not need to go back to the write
+     barrier <design/write-barrier/#soft-dirty.written>. */
+  if (ss->fixLock != NULL
+      && BS_INTER(BS_UNION(SegSM(seg), SegPM(seg)), mode) == AccessSetEMPTY
+      && (mode == AccessREAD || !ArenaSoftDirty(ss->arena)
+          || SegWritten(seg) || SegRankSet(seg) == RankSetEMPTY))
+    return FALSE;
+  ScanStateSharedClaim(ss);
+  ShieldExpose(ss->arena, seg);
+  return TRUE;
+}
+
+void ScanStateCover(ScanState ss, Seg seg)
+{
+  AVERT_CRITICAL(ScanState, ss);
+  ShieldCover(ss->arena, seg);
+  ScanStateSharedRelease(ss);
+}
+
+
+/* ScanStateExposeHeld, ScanStateCoverHeld -- access another segment
+ * during a fix
+ *
+ * ScanStateExposeHeld gives a fix method read and write access to a
+ * segment other than the white one, such as the segment it copies an
+ * object to, and returns TRUE if ScanStateCover must be called
+ * afterwards.  When the scan state is used by a collector thread, the
+ * segment is usually kept exposed until the batch is finished, so
+ * that later calls for the same segment need no lock; the thread
+ * doing the collection work then calls ScanStateCoverHeld.  The
+ * caller must ensure that no other thread writes to the segment.  See
+ * <design/trace/#parallel.fix.expose>.
+ */
+
+Bool ScanStateExposeHeld(ScanState ss, Seg seg)
+{
+  Index i;
+
+  AVERT_CRITICAL(ScanState, ss);
+  AVERT_CRITICAL(Seg, seg);
+
+  if (ss->fixLock != NULL) {
+    for (i = 0; i < ss->exposedCount; ++i)
+      if (ss->exposed[i] == seg)
+        return FALSE;
+    if (ss->exposedCount < TRACE_PARALLEL_EXPOSED) {
+      ScanStateSharedClaim(ss);
+      ShieldExpose(ss->arena, seg);
+      ScanStateSharedRelease(ss);
+      ss->exposed[ss->exposedCount] = seg;
+      ++ss->exposedCount;
+      return FALSE;
+    }
+  }
+  ScanStateSharedClaim(ss);
+  ShieldExpose(ss->arena, seg);
+  return TRUE;
+}
+
+void ScanStateCoverHeld(ScanState ss)
+{
+  AVERT(ScanState, ss);
+  AVER(ss->sharedDepth == 0);
+  while (ss->exposedCount > 0) {
+    --ss->exposedCount;
+    ShieldCover(ss->arena, ss->exposed[ss->exposedCount]);
+  }
+}
+
+
 /* TraceIdCheck -- check that a TraceId is valid */
 
 Bool TraceIdCheck(TraceId ti)
@@ -191,6 +324,10 @@ Bool TraceCheck(Trace trace)
   if(trace->chain != NULL) {
     CHECKU(Chain, trace->chain);
   }
+  /* Only a trace that is reclaiming has segments awaiting reclaim. */
+  CHECKD_NOSIG(Ring, &trace->reclaimRing);
+  CHECKL(RingIsSingle(&trace->reclaimRing)
+         || trace->state == TraceRECLAIM);
   CHECKL(FUNCHECK(trace->fix));
   /* Can't check trace->fixClosure. */
 
@@ -361,6 +498,18 @@ Res TraceAddWhite(Trace trace, Seg seg)
   pool = SegPool(seg);
   AVERT(Pool, pool);
 
+  /* Finish reclaiming the segment if it is still white for a trace
+     in the reclaim phase.  See design.mps.trace.reclaim.lazy.other. */
+  if (SegReclaimPending(seg) && !TraceReclaimSeg(seg))
+    return ResOK;
+
+  /* A segment may only be white for one trace at a time, and must not
+     be condemned while another trace still has to scan it. See
+     <design/trace/#multiple.white.disjoint>. */
+  if (TraceSetDel(TraceSetUnion(SegWhite(seg), SegGrey(seg)), trace)
+      != TraceSetEMPTY)
+    return ResOK;
+
   condemnedBefore = trace->condemned;
 
   /* Give the pool the opportunity to turn the segment white. */
@@ -481,17 +630,265 @@ static Res traceScanRoot(TraceSet ts, Rank rank, Arena arena, Root root)
 }
 
 
+/* traceSegDirty -- fold dirty memory into a segment's summary
+ *
+ * If the mutator may have stored a reference into the segment since
+ * the arena last cleared its dirty state, the segment's summary is no
+ * longer reliable.  See <design/write-barrier/#card.scan>.
+ */
+
+static void traceSegDirty(Arena arena, Seg seg)
+{
+  if (SegTracksDirty(seg, arena)
+      && SegRankSet(seg) != RankSetEMPTY
+      && SegSummary(seg) != RefSetUNIV
+      && ArenaDirty(arena, SegBase(seg), SegLimit(seg)))
+    SegSetSummary(seg, RefSetUNIV);
+}
+
+
+/* traceFlipDirtySeg -- widen and grey a segment the mutator wrote
+ *
+ * A segment whose summary widens may now refer to the white set, so
+ * it is greyed as TraceStart would have done.  The segment may be
+ * freed if another trace has yet to reclaim it (see
+ * design.mps.trace.reclaim.lazy.other).
+ */
+
+static void traceFlipDirtySeg(Trace trace, Seg seg)
+{
+  if (SegReclaimPending(seg) && !TraceReclaimSeg(seg))
+    return;
+  SegSetSummary(seg, RefSetUNIV);
+  if (!TraceSetIsMember(SegGrey(seg), trace)
+      && ZoneSetInter(SegSummary(seg), trace->white) != ZoneSetEMPTY) {
+    PoolGrey(SegPool(seg), trace, seg);
+    if (TraceSetIsMember(SegGrey(seg), trace))
+      trace->foundation += SegSize(seg);
+  }
+}
+
+
+/* traceFlipCards -- fold the dirty cards into segment summaries
+ *
+ * Only the segments under dirty cards are visited: the cards are
+ * scanned a chunk at a time, and each dirty card leads to the segment
+ * containing it, after which the scan resumes at the segment's limit.
+ * See <design/write-barrier/#card.flip>.
+ */
+
+static void traceFlipCards(Trace trace)
+{
+  Arena arena = trace->arena;
+  Ring node, next;
+
+  RING_FOR(node, ArenaChunkRing(arena), next) {
+    Chunk chunk = RING_ELT(Chunk, arenaRing, node);
+    Addr base = PageIndexBase(chunk, chunk->allocBase);
+    Addr card;
+
+    while (base < chunk->limit
+           && ArenaCardsFirstDirty(&card, arena, chunk, base, chunk->limit)) {
+      Seg seg;
+      if (SegOfAddr(&seg, arena, card)) {
+        base = SegLimit(seg);
+        if (SegRankSet(seg) != RankSetEMPTY
+            && SegSummary(seg) != RefSetUNIV)
+          traceFlipDirtySeg(trace, seg);
+      } else {
+        base = AddrAdd(card, (Size)1 << ARENA_CARD_SHIFT);
+      }
+    }
+  }
+}
+
+
+/* traceFlipDirty -- fold all dirty memory into segment summaries
+ *
+ * TraceStart has just greyed every segment whose summary meets the
+ * white set, so only the segments whose summaries widen here need
+ * visiting.  Thread roots note whether their stacks were written, and
+ * the dirty state is then cleared: the mutator is suspended.  With
+ * soft-dirty tracking, segments are visited in address order, and
+ * nothing writes to them meanwhile, so their dirty state is read ahead
+ * (see <design/write-barrier/#soft-dirty.cost>).  Segments the
+ * collector wrote were on the write barrier, so their summaries are
+ * still good, and they come off it as the dirty state is cleared (see
+ * <design/write-barrier/#soft-dirty.written>).  See
+ * <design/root/#stack.mark>.
+ */
+
+static void traceFlipDirty(Trace trace)
+{
+  Arena arena = trace->arena;
+  Seg seg;
+
+  if (!ArenaTracksDirty(arena))
+    return;
+
+  if (ArenaCardMarking(arena)) {
+    traceFlipCards(trace);
+  } else {
+    ArenaDirtyCacheInit(arena);
+    if (SegFirst(&seg, arena)) {
+      Pool pool;
+      Ring next;
+      do {
+        pool = SegPool(seg);
+        next = RingNext(SegPoolRing(seg));
+        if (SegWritten(seg))
+          SegClearWritten(seg);
+        else if (SegRankSet(seg) != RankSetEMPTY
+                 && SegSummary(seg) != RefSetUNIV
+                 && ArenaDirtyCached(arena, SegBase(seg), SegLimit(seg)))
+          traceFlipDirtySeg(trace, seg);
+      } while (SegNextOfRing(&seg, arena, pool, next));
+    }
+  }
+
+  RootsStackDirty(ArenaGlobals(arena));
+  ArenaDirtyClear(arena);
+}
+
+
+/* traceRootBatchStruct -- a batch of roots to scan in parallel */
+
+typedef struct traceRootBatchStruct {
+  Count count;                  /* number of roots in the batch */
+  Count limit;                  /* maximum number of roots */
+  Root root[TRACE_PARALLEL_BATCH_MAX];
+  ScanStateStruct ss[TRACE_PARALLEL_BATCH_MAX];
+  Res res[TRACE_PARALLEL_BATCH_MAX];
+} traceRootBatchStruct, *traceRootBatch;
+
+
+/* traceParallelStruct -- a batch of segments to scan in parallel */
+
+typedef struct traceParallelStruct {
+  Count count;                  /* number of segments in the batch */
+  Seg seg[TRACE_PARALLEL_BATCH_MAX];
+  ScanStateStruct ss[TRACE_PARALLEL_BATCH_MAX];
+  Bool wasTotal[TRACE_PARALLEL_BATCH_MAX];
+  Res res[TRACE_PARALLEL_BATCH_MAX];
+} traceParallelStruct, *traceParallel;
+
+
+/* TraceBatchStruct -- the batches for parallel scanning
+ *
+ * The batches hold a scan state for each job, which is too big for
+ * the stack (see StackProbeDEPTH), so they are allocated with the
+ * arena's collector threads.  See <design/trace/#parallel.batch>.
+ */
+
+typedef struct TraceBatchStruct {
+  traceRootBatchStruct roots;   /* roots scanned at flip */
+  traceParallelStruct segs;     /* grey segments */
+} TraceBatchStruct;
+
+
+/* TraceBatchCreate/Destroy -- allocate the batches for parallel scanning */
+
+Res TraceBatchCreate(TraceBatch *batchReturn, Arena arena)
+{
+  void *p;
+  Res res;
+
+  AVER(batchReturn != NULL);
+  AVERT(Arena, arena);
+
+  res = ControlAlloc(&p, arena, sizeof(TraceBatchStruct));
+  if (res != ResOK)
+    return res;
+  *batchReturn = p;
+  return ResOK;
+}
+
+void TraceBatchDestroy(TraceBatch batch, Arena arena)
+{
+  AVER(batch != NULL);
+  AVERT(Arena, arena);
+
+  ControlFree(arena, batch, sizeof(TraceBatchStruct));
+}
+
+
+/* traceScanRootJob -- scan one root of a batch, on a worker */
+
+static void traceScanRootJob(void *closure, Index i, Index self)
+{
+  traceRootBatch tb = closure;
+
+  AVER(i < tb->count);
+  tb->ss[i].worker = self;
+  tb->res[i] = RootScan(&tb->ss[i], tb->root[i]);
+}
+
+
+/* traceScanRootsParallel -- scan a batch of roots in parallel
+ *
+ * Scans the roots in the batch, which must satisfy RootParallel,
+ * using the arena's collector threads, and empties the batch.  The
+ * accounting is done afterwards in batch order, and a root whose scan
+ * failed to allocate is scanned again serially in emergency mode.
+ * See <design/root/#parallel>.
+ */
+
+static Res traceScanRootsParallel(traceRootBatch tb, TraceSet ts,
+                                  Rank rank, Arena arena)
+{
+  ZoneSet white = traceSetWhiteUnion(ts, arena);
+  Res firstRes = ResOK;
+  Index i;
+
+  AVER(arena->workers != NULL);
+
+  if (tb->count == 0)
+    return ResOK;
+
+  for (i = 0; i < tb->count; ++i) {
+    AVER(RootParallel(tb->root[i]));
+    ScanStateInit(&tb->ss[i], ts, arena, rank, white);
+    tb->ss[i].fixLock = WorkersLock(arena->workers);
+  }
+
+  WorkersRun(arena->workers, traceScanRootJob, tb, tb->count);
+
+  for (i = 0; i < tb->count; ++i) {
+    Res res = tb->res[i];
+
+    ScanStateCoverHeld(&tb->ss[i]);
+    tb->ss[i].fixLock = NULL;
+    traceSetUpdateCounts(ts, arena, &tb->ss[i],
+                         traceAccountingPhaseRootScan);
+    ScanStateFinish(&tb->ss[i]);
+    if (ResIsAllocFailure(res)) {
+      /* As traceScanRoot: try again in emergency mode. */
+      ArenaSetEmergency(arena, TRUE);
+      res = traceScanRootRes(ts, rank, arena, tb->root[i]);
+      AVER(!ResIsAllocFailure(res));
+    }
+    if (res != ResOK && firstRes == ResOK)
+      firstRes = res;
+  }
+
+  tb->count = 0;
+  return firstRes;
+}
+
+
 /* traceFlip -- blacken the mutator */
 
 struct rootFlipClosureStruct {
   TraceSet ts;
   Arena arena;
   Rank rank;
+  traceRootBatch batch;         /* roots to scan in parallel, or NULL */
 };
 
 static Res rootFlip(Root root, void *p)
 {
   struct rootFlipClosureStruct *rf = (struct rootFlipClosureStruct *)p;
+  traceRootBatch tb;
   Res res;
 
   AVERT(Root, root);
@@ -503,6 +900,14 @@ static Res rootFlip(Root root, void *p)
   AVER(RootRank(root) <= RankEXACT); /* see .root.rank */
 
   if(RootRank(root) == rf->rank) {
+    tb = rf->batch;
+    if (tb != NULL && RootParallel(root)) {
+      tb->root[tb->count] = root;
+      ++tb->count;
+      if (tb->count >= tb->limit)
+        return traceScanRootsParallel(tb, rf->ts, rf->rank, rf->arena);
+      return ResOK;
+    }
     res = traceScanRoot(rf->ts, rf->rank, rf->arena, root);
     if (res != ResOK)
       return res;
@@ -544,13 +949,25 @@ static Res traceFlip(Trace trace)
   Arena arena;
   Rank rank;
   struct rootFlipClosureStruct rfc;
+  Clock start;
   Res res;
 
   AVERT(Trace, trace);
   rfc.ts = TraceSetSingle(trace);
+  start = WallClockNow();
 
   arena = trace->arena;
   rfc.arena = arena;
+  rfc.batch = NULL;
+  if (arena->workers != NULL && WorkersCount(arena->workers) > 1) {
+    /* <design/root/#parallel> */
+    traceRootBatch tb = &arena->traceBatch->roots;
+    tb->count = 0;
+    tb->limit = WorkersCount(arena->workers) * TRACE_PARALLEL_BATCH;
+    if (tb->limit > TRACE_PARALLEL_BATCH_MAX)
+      tb->limit = TRACE_PARALLEL_BATCH_MAX;
+    rfc.batch = tb;
+  }
   ShieldHold(arena);
 
   AVER(trace->state == TraceUNFLIPPED);
@@ -559,6 +976,7 @@ static Res traceFlip(Trace trace)
   EVENT2(TraceFlipBegin, trace, arena);
 
   traceFlipBuffers(ArenaGlobals(arena));
+  traceFlipDirty(trace);
 
   /* Update location dependency structures. */
   /* mayMove is a conservative approximation of the zones of objects */
@@ -576,6 +994,14 @@ static Res traceFlip(Trace trace)
   for(rank = RankMIN; rank <= RankEXACT; ++rank) {
     rfc.rank = rank;
     res = RootsIterate(ArenaGlobals(arena), rootFlip, (void *)&rfc);
+    if (rfc.batch != NULL) {
+      /* Scan the rest of the batch even if RootsIterate failed, so
+         that the batch is empty for the next rank. */
+      Res batchRes = traceScanRootsParallel(rfc.batch, rfc.ts, rank,
+                                            arena);
+      if (res == ResOK)
+        res = batchRes;
+    }
     if (res != ResOK)
       goto failRootFlip;
   }
@@ -613,6 +1039,7 @@ static Res traceFlip(Trace trace)
   EVENT2(TraceFlipEnd, trace, arena);
 
   ShieldRelease(arena);
+  ArenaPauseRecord(arena, PauseKindFLIP, start, WallClockNow());
   return ResOK;
 
 failRootFlip:
@@ -621,6 +1048,86 @@ failRootFlip:
 }
 
 
+/* traceReclaimSeg -- reclaim a segment that is white for the trace
+ *
+ * Returns TRUE if the segment still exists afterwards, FALSE if the
+ * pool freed it.
+ */
+
+static Bool traceReclaimSeg(Trace trace, Seg seg)
+{
+  Arena arena = trace->arena;
+  Addr base = SegBase(seg);
+  Pool pool = SegPool(seg);
+  Seg nonWhiteSeg = NULL;       /* prevents compiler warning */
+
+  AVER_CRITICAL(TraceSetIsMember(SegWhite(seg), trace));
+  AVER_CRITICAL(PoolHasAttr(pool, AttrGC));
+  STATISTIC(++trace->reclaimCount);
+  PoolReclaim(pool, trace, seg);
+
+  /* If the segment still exists, it should no longer be white. */
+  /* Note that the seg returned by this SegOfAddr may not be */
+  /* the same as the one above, but in that case it's new and */
+  /* still shouldn't be white for this trace. */
+
+  /* The code from the class-specific reclaim methods to */
+  /* unwhiten the segment could in fact be moved here.   */
+  if (!SegOfAddr(&nonWhiteSeg, arena, base))
+    return FALSE;
+  AVER_CRITICAL(!TraceSetIsMember(SegWhite(nonWhiteSeg), trace));
+  return nonWhiteSeg == seg;
+}
+
+
+/* traceReclaimLazy -- reclaim a segment awaiting lazy reclaim
+ *
+ * See design.mps.trace.reclaim.lazy.
+ */
+
+static Bool traceReclaimLazy(Trace trace, Seg seg)
+{
+  AVER_CRITICAL(trace->state == TraceRECLAIM);
+  AVER_CRITICAL(SegReclaimPending(seg));
+
+  RingRemove(&SegGCSeg(seg)->reclaimRing);
+  trace->lazyReclaimSize += SegSize(seg); /* see .work */
+  return traceReclaimSeg(trace, seg);
+}
+
+
+/* TraceReclaimSeg -- reclaim a segment ahead of its trace
+ *
+ * A pool class with the attribute AttrLAZY calls this from its buffer
+ * fill method when it finds a segment awaiting lazy reclaim that it
+ * could allocate from, and another trace calls it before condemning
+ * or greying such a segment.  Returns TRUE if the segment still exists
+ * afterwards, FALSE if the pool freed it.  See
+ * design.mps.trace.reclaim.lazy.fill and
+ * design.mps.trace.reclaim.lazy.other.
+ */
+
+Bool TraceReclaimSeg(Seg seg)
+{
+  Arena arena;
+  TraceId ti;
+  Trace trace;
+
+  AVERT(Seg, seg);
+  AVER(SegReclaimPending(seg));
+  AVER(PoolHasAttr(SegPool(seg), AttrLAZY));
+
+  arena = PoolArena(SegPool(seg));
+  TRACE_SET_ITER(ti, trace, SegWhite(seg), arena)
+    if (trace->state == TraceRECLAIM)
+      return traceReclaimLazy(trace, seg);
+  TRACE_SET_ITER_END(ti, trace, SegWhite(seg), arena);
+
+  NOTREACHED;
+  return TRUE;
+}
+
+
 /* TraceCreate -- create a Trace object
  *
  * Allocates and initializes a new Trace object with a TraceId which is
@@ -705,6 +1212,8 @@ found:
   trace->preservedInPlaceSize = (Size)0;  /* see .message.data */
   STATISTIC(trace->reclaimCount = (Count)0);
   STATISTIC(trace->reclaimSize = (Size)0);
+  RingInit(&trace->reclaimRing);
+  trace->lazyReclaimSize = (Size)0; /* see .work */
   trace->sig = TraceSig;
   arena->busyTraces = TraceSetAdd(arena->busyTraces, trace);
   AVERT(Trace, trace);
@@ -763,6 +1272,7 @@ static void traceDestroyCommon(Trace trace)
    * violating <code/global.c#emergency.invariant>. */
   ArenaSetEmergency(trace->arena, FALSE);
 
+  RingFinish(&trace->reclaimRing);
   trace->sig = SigInvalid;
   trace->arena->busyTraces = TraceSetDel(trace->arena->busyTraces, trace);
   trace->arena->flippedTraces = TraceSetDel(trace->arena->flippedTraces, trace);
@@ -819,22 +1329,28 @@ void TraceDestroyFinished(Trace trace)
 }
 
 
-/* traceReclaim -- reclaim the remaining objects white for this trace */
+/* traceReclaimStart -- start reclaiming the objects white for this trace
+ *
+ * Reclaims the white segments at once, except that if this is the only
+ * busy trace, segments of pools with the attribute AttrLAZY are queued
+ * to be reclaimed later.  See design.mps.trace.reclaim.lazy.
+ */
 
-static void traceReclaim(Trace trace)
+static void traceReclaimStart(Trace trace)
 {
   Arena arena;
   Seg seg;
+  Bool lazy;
 
   AVER(trace->state == TraceRECLAIM);
 
   EVENT1(TraceReclaim, trace);
   arena = trace->arena;
+  lazy = TraceSetIsSingle(arena->busyTraces);
   if(SegFirst(&seg, arena)) {
     Pool pool;
     Ring next;
     do {
-      Addr base = SegBase(seg);
       pool = SegPool(seg);
       next = RingNext(SegPoolRing(seg));
 
@@ -842,26 +1358,34 @@ static void traceReclaim(Trace trace)
       AVER_CRITICAL(!TraceSetIsMember(SegGrey(seg), trace));
 
       if(TraceSetIsMember(SegWhite(seg), trace)) {
-        AVER_CRITICAL(PoolHasAttr(pool, AttrGC));
-        STATISTIC(++trace->reclaimCount);
-        PoolReclaim(pool, trace, seg);
-
-        /* If the segment still exists, it should no longer be white. */
-        /* Note that the seg returned by this SegOfAddr may not be */
-        /* the same as the one above, but in that case it's new and */
-        /* still shouldn't be white for this trace. */
-
-        /* The code from the class-specific reclaim methods to */
-        /* unwhiten the segment could in fact be moved here.   */
-        {
-          Seg nonWhiteSeg = NULL;       /* prevents compiler warning */
-          AVER_CRITICAL(!(SegOfAddr(&nonWhiteSeg, arena, base)
-                          && TraceSetIsMember(SegWhite(nonWhiteSeg), trace)));
-          UNUSED(nonWhiteSeg); /* <code/mpm.c#check.unused> */
-        }
+        if (lazy && PoolHasAttr(pool, AttrLAZY))
+          RingAppend(&trace->reclaimRing, &SegGCSeg(seg)->reclaimRing);
+        else
+          (void)traceReclaimSeg(trace, seg);
       }
     } while(SegNextOfRing(&seg, arena, pool, next));
   }
+}
+
+
+/* traceReclaim -- reclaim the next segment awaiting lazy reclaim
+ *
+ * When no segments are left, the trace is finished.
+ */
+
+static void traceReclaim(Trace trace)
+{
+  Arena arena;
+
+  AVER(trace->state == TraceRECLAIM);
+  arena = trace->arena;
+
+  if (!RingIsSingle(&trace->reclaimRing)) {
+    Seg seg = SegOfReclaimRing(RingNext(&trace->reclaimRing));
+    (void)traceReclaimLazy(trace, seg);
+    if (!RingIsSingle(&trace->reclaimRing))
+      return;
+  }
 
   trace->state = TraceFINISHED;
 
@@ -874,12 +1398,17 @@ static void traceReclaim(Trace trace)
 
 /* TraceRankForAccess -- Returns rank to scan at if we hit a barrier.
  * 
- * We assume a single trace as otherwise we need to implement rank
- * filters on scanning.
+ * Different traces may be in different bands, so the rank is computed
+ * for one trace at a time, and a segment that is grey for several
+ * flipped traces is scanned separately for each of them. See
+ * <design/trace/#multiple.access>.
  *
  * .scan.conservative: It's safe to scan at EXACT unless the band is
  * WEAK and in that case the segment should be weak.
  * 
+ * .scan.ambig: If the trace band is AMBIG then the trace has flipped
+ * but not yet advanced, and we scan EXACT, as for the EXACT band.
+ *
  * If the trace band is EXACT then we scan EXACT. This might prevent
  * finalisation messages and may preserve objects pointed to only by weak
  * references but tough luck -- the mutator wants to look.
@@ -899,28 +1428,24 @@ static void traceReclaim(Trace trace)
  * See the message <http://info.ravenbrook.com/mail/2012/08/30/16-46-42/0.txt>
  * for a description of these semantics.
  */
-Rank TraceRankForAccess(Arena arena, Seg seg)
+Rank TraceRankForAccess(Trace trace, Seg seg)
 {
-  TraceSet ts;
-  Trace trace;
-  TraceId ti;
   Rank band;
   RankSet rankSet;
 
-  AVERT(Arena, arena);
+  AVERT(Trace, trace);
   AVERT(Seg, seg);
+  AVER(TraceSetIsMember(trace->arena->flippedTraces, trace));
 
-  band = RankLIMIT; /* initialize with invalid rank */
-  ts = arena->flippedTraces;    
-  AVER(TraceSetIsSingle(ts));
-  TRACE_SET_ITER(ti, trace, ts, arena)
-    band = traceBand(trace);
-  TRACE_SET_ITER_END(ti, trace, ts, arena);
+  band = traceBand(trace);
   rankSet = SegRankSet(seg);
   switch(band) {
   case RankAMBIG:
-    NOTREACHED;
-    break;
+    /* The trace has been started but hasn't yet looked for grey
+     * segments (for example, mps_arena_start_collect returned before
+     * the first TraceAdvance), so it's still in its initial band.
+     * Scan at EXACT, as in the exact band.  See .scan.ambig. */
+    return RankEXACT;
   case RankEXACT:
     return RankEXACT;
   case RankFINAL:
@@ -1077,6 +1602,95 @@ RefSet ScanStateSummary(ScanState ss)
 }
 
 
+/* traceScanSegFinish -- account for the scanning of a segment
+ *
+ * Called after the pool has scanned the segment and the segment has
+ * been covered, whether or not the scan succeeded.
+ */
+
+static void traceScanSegFinish(TraceSet ts, Arena arena, Seg seg,
+                               ScanState ss, Res res, Bool wasTotal,
+                               ZoneSet white)
+{
+  RefSet summary;
+
+  traceSetUpdateCounts(ts, arena, ss, traceAccountingPhaseSegScan);
+  /* Count segments scanned pointlessly */
+  STATISTIC({
+    TraceId ti; Trace trace;
+    Count whiteSegRefCount = 0;
+
+    TRACE_SET_ITER(ti, trace, ts, arena)
+      whiteSegRefCount += trace->whiteSegRefCount;
+    TRACE_SET_ITER_END(ti, trace, ts, arena);
+    if(whiteSegRefCount == 0)
+      TRACE_SET_ITER(ti, trace, ts, arena)
+        ++trace->pointlessScanCount;
+      TRACE_SET_ITER_END(ti, trace, ts, arena);
+  });
+
+  /* Following is true whether or not scan was total. */
+  /* See <design/scan/#summary.subset>. */
+  /* .verify.segsummary: were the seg contents, as found by this 
+   * scan, consistent with the recorded SegSummary?
+   */
+  AVER(RefSetSub(ScanStateUnfixedSummary(ss), SegSummary(seg))); /* <design/check/#.common> */
+
+  /* Write barrier deferral -- see design.mps.write-barrier.deferral. */
+  /* Did the segment refer to the white set? */
+  if (ZoneSetInter(ScanStateUnfixedSummary(ss), white) == ZoneSetEMPTY) {
+    /* Boring scan.  One step closer to raising the write barrier. */
+    if (seg->defer > 0)
+      --seg->defer;
+  } else {
+    /* Interesting scan. Defer raising the write barrier. */
+    if (seg->defer < WB_DEFER_DELAY)
+      seg->defer = WB_DEFER_DELAY;
+  }
+
+  /* Only apply the write barrier if it is not deferred.  Dirty
+     tracking has no barrier hits to defer. */
+  if (seg->defer == 0 || SegTracksDirty(seg, arena)) {
+    /* If we scanned every reference in the segment then we have a
+       complete summary we can set. Otherwise, we just have
+       information about more zones that the segment refers to. */
+    if (res == ResOK && wasTotal)
+      summary = ScanStateSummary(ss);
+    else
+      summary = RefSetUnion(SegSummary(seg), ScanStateSummary(ss));
+  } else {
+    summary = RefSetUNIV;
+  }
+  /* Objects being initialized in a buffer are not card marked.
+     See <design/write-barrier/#card.buffer>. */
+  if (ArenaCardMarking(arena) && SegHasBuffer(seg))
+    summary = RefSetUNIV;
+  SegSetSummary(seg, summary);
+
+  ScanStateFinish(ss);
+}
+
+
+/* traceSingleAccessScanned -- adapt single access budget after a scan
+ *
+ * Called when the collector scans a segment for its own reasons, not
+ * because of a barrier hit.  If the mutator's accesses since the last
+ * scan were handled singly, they saved a scan of the whole segment, so
+ * allow more of them.  See <design/trace/#single-access.adapt>.
+ */
+
+static void traceSingleAccessScanned(Seg seg)
+{
+  if (seg->singleAccesses > 0) {
+    if (seg->singleLimit <= SINGLE_ACCESS_MAX / 2)
+      seg->singleLimit *= 2;
+    else
+      seg->singleLimit = SINGLE_ACCESS_MAX;
+    seg->singleAccesses = 0;
+  }
+}
+
+
 /* traceScanSegRes -- scan a segment to remove greyness
  *
  * @@@@ During scanning, the segment should be write-shielded to prevent
@@ -1089,12 +1703,12 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
   Bool wasTotal;
   ZoneSet white;
   Res res;
-  RefSet summary;
 
   /* The reason for scanning a segment is that it's grey. */
   AVER(TraceSetInter(ts, SegGrey(seg)) != TraceSetEMPTY);
   EVENT4(TraceScanSeg, ts, rank, arena, seg);
 
+  traceSegDirty(arena, seg);
   white = traceSetWhiteUnion(ts, arena);
 
   /* Only scan a segment if it refers to the white set. */
@@ -1113,56 +1727,9 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
     /* Cover, regardless of result */
     ShieldCover(arena, seg);
 
-    traceSetUpdateCounts(ts, arena, ss, traceAccountingPhaseSegScan);
-    /* Count segments scanned pointlessly */
-    STATISTIC({
-      TraceId ti; Trace trace;
-      Count whiteSegRefCount = 0;
-
-      TRACE_SET_ITER(ti, trace, ts, arena)
-        whiteSegRefCount += trace->whiteSegRefCount;
-      TRACE_SET_ITER_END(ti, trace, ts, arena);
-      if(whiteSegRefCount == 0)
-        TRACE_SET_ITER(ti, trace, ts, arena)
-          ++trace->pointlessScanCount;
-        TRACE_SET_ITER_END(ti, trace, ts, arena);
-    });
-
-    /* Following is true whether or not scan was total. */
-    /* See <design/scan/#summary.subset>. */
-    /* .verify.segsummary: were the seg contents, as found by this 
-     * scan, consistent with the recorded SegSummary?
-     */
-    AVER(RefSetSub(ScanStateUnfixedSummary(ss), SegSummary(seg))); /* <design/check/#.common> */
-
-    /* Write barrier deferral -- see design.mps.write-barrier.deferral. */
-    /* Did the segment refer to the white set? */
-    if (ZoneSetInter(ScanStateUnfixedSummary(ss), white) == ZoneSetEMPTY) {
-      /* Boring scan.  One step closer to raising the write barrier. */
-      if (seg->defer > 0)
-        --seg->defer;
-    } else {
-      /* Interesting scan. Defer raising the write barrier. */
-      if (seg->defer < WB_DEFER_DELAY)
-        seg->defer = WB_DEFER_DELAY;
-    }
-
-    /* Only apply the write barrier if it is not deferred. */
-    if (seg->defer == 0) {
-      /* If we scanned every reference in the segment then we have a
-         complete summary we can set. Otherwise, we just have
-         information about more zones that the segment refers to. */
-      if (res == ResOK && wasTotal)
-        summary = ScanStateSummary(ss);
-      else
-        summary = RefSetUnion(SegSummary(seg), ScanStateSummary(ss));
-    } else {
-      summary = RefSetUNIV;
-    }
-    SegSetSummary(seg, summary);
-
-    ScanStateFinish(ss);
+    traceScanSegFinish(ts, arena, seg, ss, res, wasTotal, white);
   }
+  traceSingleAccessScanned(seg);
 
   if(res == ResOK) {
     /* The segment is now black only if scan was successful. */
@@ -1196,6 +1763,112 @@ static Res traceScanSeg(TraceSet ts, Rank rank, Arena arena, Seg seg)
 }
 
 
+/* traceSegParallel -- can a grey segment be scanned by a worker?
+ *
+ * See <design/trace/#parallel.seg>.
+ */
+
+static Bool traceSegParallel(Trace trace, Seg seg, Rank rank)
+{
+  Buffer buffer;
+
+  return rank == RankEXACT
+    && SegRankSet(seg) == RankSetSingle(RankEXACT)
+    && PoolHasAttr(SegPool(seg), AttrPARALLEL)
+    && SegWhite(seg) == TraceSetEMPTY
+    && SegNailed(seg) == TraceSetEMPTY
+    && !SegBuffer(&buffer, seg)
+    && ZoneSetInter(trace->white, SegSummary(seg)) != ZoneSetEMPTY;
+}
+
+
+/* traceScanSegJob -- scan one segment of a batch, on a worker */
+
+static void traceScanSegJob(void *closure, Index i, Index self)
+{
+  traceParallel tp = closure;
+  Seg seg;
+
+  AVER(i < tp->count);
+  seg = tp->seg[i];
+  tp->ss[i].worker = self;
+  tp->res[i] = PoolScan(&tp->wasTotal[i], &tp->ss[i], SegPool(seg), seg);
+}
+
+
+/* traceScanSegsParallel -- scan a batch of grey segments in parallel
+ *
+ * Scans the segment first, which must satisfy traceSegParallel, and
+ * other grey segments of the same rank that also satisfy it, using
+ * the arena's collector threads.  See <design/trace/#parallel>.
+ */
+
+static void traceScanSegsParallel(Trace trace, Rank rank, Seg first)
+{
+  Arena arena = trace->arena;
+  TraceSet ts = TraceSetSingle(trace);
+  ZoneSet white = traceSetWhiteUnion(ts, arena);
+  traceParallel tp = &arena->traceBatch->segs;
+  Count limit;
+  Ring node, nextNode;
+  Index i;
+
+  AVER(arena->workers != NULL);
+  AVER(traceSegParallel(trace, first, rank));
+
+  limit = WorkersCount(arena->workers) * TRACE_PARALLEL_BATCH;
+  if (limit > TRACE_PARALLEL_BATCH_MAX)
+    limit = TRACE_PARALLEL_BATCH_MAX;
+  tp->seg[0] = first;
+  tp->count = 1;
+  RING_FOR(node, ArenaGreyRing(arena, rank), nextNode) {
+    Seg seg = SegOfGreyRing(node);
+    if (tp->count >= limit)
+      break;
+    if (seg != first && TraceSetIsMember(SegGrey(seg), trace)
+        && traceSegParallel(trace, seg, rank)) {
+      tp->seg[tp->count] = seg;
+      ++tp->count;
+    }
+  }
+
+  /* The shield is not thread-safe, so expose all the segments before
+     the workers start.  <design/trace/#parallel.shield> */
+  for (i = 0; i < tp->count; ++i) {
+    EVENT4(TraceScanSeg, ts, rank, arena, tp->seg[i]);
+    traceSegDirty(arena, tp->seg[i]);
+    ScanStateInit(&tp->ss[i], ts, arena, rank, white);
+    tp->ss[i].fixLock = WorkersLock(arena->workers);
+    ShieldExpose(arena, tp->seg[i]);
+  }
+
+  WorkersRun(arena->workers, traceScanSegJob, tp, tp->count);
+
+  for (i = 0; i < tp->count; ++i) {
+    Seg seg = tp->seg[i];
+    Res res = tp->res[i];
+
+    ShieldCover(arena, seg);
+    ScanStateCoverHeld(&tp->ss[i]);
+    tp->ss[i].fixLock = NULL;
+    traceScanSegFinish(ts, arena, seg, &tp->ss[i], res, tp->wasTotal[i],
+                       white);
+    traceSingleAccessScanned(seg);
+    if (res == ResOK) {
+      SegSetGrey(seg, TraceSetDiff(SegGrey(seg), ts));
+    } else if (ResIsAllocFailure(res)) {
+      /* As traceScanSeg: try again in emergency mode. */
+      ArenaSetEmergency(arena, TRUE);
+      res = traceScanSegRes(ts, rank, arena, seg);
+      AVER(!ResIsAllocFailure(res));
+    }
+    /* Allocation failures should be handled by emergency mode, and we
+     * don't expect any other error in a normal GC trace. */
+    AVER(res == ResOK);
+  }
+}
+
+
 /* TraceSegAccess -- handle barrier hit on a segment */
 
 void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
@@ -1230,28 +1903,41 @@ void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
 
   if (readHit) {
     Rank rank;
-    TraceSet traces;
+    TraceSet traces, grey;
+    TraceId ti;
+    Trace trace;
 
     AVER(SegRankSet(seg) != RankSetEMPTY);
-    
-    /* Pick set of traces to scan for: */
-    traces = arena->flippedTraces;
-    rank = TraceRankForAccess(arena, seg);
-    res = traceScanSeg(traces, rank, arena, seg);      
-
-    /* Allocation failures should be handled my emergency mode, and we don't
-       expect any other kind of failure in a normal GC that causes access
-       faults. */
-    AVER(res == ResOK);
 
-    /* The pool should've done the job of removing the greyness that */
-    /* was causing the segment to be protected, so that the mutator */
-    /* can go ahead and access it. */
-    AVER(TraceSetInter(SegGrey(seg), traces) == TraceSetEMPTY);
+    /* The whole segment is about to be scanned.  If that's because
+       the single access budget ran out, the segment is faulting too
+       often for single accesses to pay.  See
+       <design/trace/#single-access.adapt>. */
+    if (seg->singleAccesses >= seg->singleLimit && seg->singleLimit > 1)
+      seg->singleLimit /= 2;
+    seg->singleAccesses = 0;
+
+    /* Pick set of traces to scan for, and scan for each one at its
+       own rank. Scanning for one trace may make the segment grey for
+       another (for example, if objects that are grey for the other
+       trace are copied into it), so repeat until it's not grey for
+       any flipped trace. See <design/trace/#multiple.access>. */
+    traces = TraceSetEMPTY;
+    while ((grey = TraceSetInter(SegGrey(seg), arena->flippedTraces))
+           != TraceSetEMPTY) {
+      traces = TraceSetUnion(traces, grey);
+      TRACE_SET_ITER(ti, trace, grey, arena)
+        rank = TraceRankForAccess(trace, seg);
+        res = traceScanSeg(TraceSetSingle(trace), rank, arena, seg);
+
+        /* Allocation failures should be handled my emergency mode, and
+           we don't expect any other kind of failure in a normal GC
+           that causes access faults. */
+        AVER(res == ResOK);
+      TRACE_SET_ITER_END(ti, trace, grey, arena);
+    }
 
     STATISTIC({
-      Trace trace;
-      TraceId ti;
       TRACE_SET_ITER(ti, trace, traces, arena)
         ++trace->readBarrierHitCount;
       TRACE_SET_ITER_END(ti, trace, traces, arena);
@@ -1270,22 +1956,241 @@ void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
 }
 
 
-/* _mps_fix2 (a.k.a. "TraceFix") -- second stage of fixing a reference
+/* TraceSegCanSingleAccess -- is there single access budget left?
  *
- * _mps_fix2 is on the [critical path](../design/critical-path.txt).  A
- * one-instruction difference in the early parts of this code will have a
- * significant impact on overall run time.  The priority is to eliminate
- * irrelevant references early and fast using the colour information stored
- * in the tract table.
+ * See <design/trace/#single-access.adapt>.
+ */
+
+Bool TraceSegCanSingleAccess(Seg seg)
+{
+  AVERT(Seg, seg);
+  return seg->singleAccesses < seg->singleLimit;
+}
+
+
+/* TraceSegNoteSingleAccess -- record a barrier hit handled singly */
+
+void TraceSegNoteSingleAccess(Seg seg)
+{
+  AVERT(Seg, seg);
+  AVER(TraceSegCanSingleAccess(seg));
+  ++seg->singleAccesses;
+}
+
+
+/* traceScanSingleObjectRes -- scan one object, with result code */
+
+static Res traceScanSingleObjectRes(TraceSet ts, Rank rank, Arena arena,
+                                    Seg seg, Addr object)
+{
+  Format format;
+  ZoneSet white;
+  ScanStateStruct ss;
+  Res res;
+
+  format = SegPool(seg)->format;
+  white = traceSetWhiteUnion(ts, arena);
+  ScanStateInit(&ss, ts, arena, rank, white);
+
+  res = FormatScan(format, &ss, object, (*format->skip)(object));
+
+  /* As .verify.segsummary, for the part of the segment scanned. */
+  AVER(RefSetSub(ScanStateUnfixedSummary(&ss), SegSummary(seg)));
+  /* The rest of the segment is unchanged, so the summary can only
+     gain zones. */
+  SegSetSummary(seg, RefSetUnion(SegSummary(seg), ScanStateSummary(&ss)));
+
+  traceSetUpdateCounts(ts, arena, &ss, traceAccountingPhaseSingleScan);
+  ScanStateFinish(&ss);
+  return res;
+}
+
+
+/* traceScanSingleObject -- scan one object
  *
- * The name "TraceFix" is pervasive in the MPS and its documents to describe
- * this function.  Optimisation and strict aliasing rules have meant that we
- * need to use the external name for it here.
+ * This one can't fail.  It may put the traces into emergency mode in
+ * order to achieve this.  Scanning an object twice is harmless.
  */
 
-mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
+static void traceScanSingleObject(TraceSet ts, Rank rank, Arena arena,
+                                  Seg seg, Addr object)
+{
+  Res res;
+
+  res = traceScanSingleObjectRes(ts, rank, arena, seg, object);
+  if (res != ResOK) {
+    ArenaSetEmergency(arena, TRUE);
+    res = traceScanSingleObjectRes(ts, rank, arena, seg, object);
+  }
+  AVER(res == ResOK);
+}
+
+
+/* TraceSingleAccess -- handle a read barrier hit on one object
+ *
+ * Scans the formatted object containing addr, rather than the whole
+ * segment, and emulates the faulting instruction, so that the segment
+ * stays grey and protected.  Returns ResFAIL, having done nothing, if
+ * the access can't or shouldn't be handled this way; the caller must
+ * then call TraceSegAccess.  See <design/trace/#single-access>.
+ */
+
+Res TraceSingleAccess(Arena arena, Seg seg, Addr addr, AccessSet mode,
+                      MutatorContext context)
+{
+  TraceSet traces, grey;
+  TraceId ti;
+  Trace trace;
+  Addr object;
+  Ref ref;
+  Res res;
+
+  AVERT(Arena, arena);
+  AVERT(Seg, seg);
+  AVER(SegBase(seg) <= addr);
+  AVER(addr < SegLimit(seg));
+  AVERT(AccessSet, mode);
+  AVERT(MutatorContext, context);
+
+  /* A write barrier hit on its own is cheap to handle, so only read
+     barrier hits are handled singly.  Weak and final segments need
+     the care taken in poolawl.c.  A segment that is also white may
+     contain dead objects and broken hearts. */
+  if (BS_INTER(BS_INTER(mode, SegSM(seg)), AccessREAD) == AccessSetEMPTY
+      || SegRankSet(seg) != RankSetSingle(RankEXACT)
+      || SegWhite(seg) != TraceSetEMPTY
+      || !AddrIsAligned(addr, sizeof(Word))
+      || !PoolHasAttr(SegPool(seg), AttrFMT)
+      || !TraceSegCanSingleAccess(seg)
+      || !MutatorContextCanStepInstruction(context))
+    return ResFAIL;
+
+  grey = TraceSetInter(SegGrey(seg), arena->flippedTraces);
+  AVER(grey != TraceSetEMPTY);
+
+  /* If the segment doesn't refer to the white set then TraceSegAccess
+     can blacken it without scanning, which is cheaper. */
+  traceSegDirty(arena, seg);
+  if (ZoneSetInter(traceSetWhiteUnion(grey, arena), SegSummary(seg))
+      == ZoneSetEMPTY)
+    return ResFAIL;
+
+  ShieldExpose(arena, seg);
+  res = PoolAddrObject(&object, SegPool(seg), seg, addr);
+  if (res != ResOK) {
+    ShieldCover(arena, seg);
+    return ResFAIL;
+  }
+
+  EVENT3(TraceAccess, arena, seg, mode);
+
+  /* Scanning for one trace may make the segment grey for another, as
+     in TraceSegAccess.  See <design/trace/#multiple.access>. */
+  traces = TraceSetEMPTY;
+  while ((grey = TraceSetDiff(TraceSetInter(SegGrey(seg),
+                                            arena->flippedTraces),
+                              traces))
+         != TraceSetEMPTY) {
+    traces = TraceSetUnion(traces, grey);
+    TRACE_SET_ITER(ti, trace, grey, arena)
+      traceScanSingleObject(TraceSetSingle(trace),
+                            TraceRankForAccess(trace, seg),
+                            arena, seg, object);
+    TRACE_SET_ITER_END(ti, trace, grey, arena);
+  }
+
+  res = MutatorContextStepInstruction(context);
+  AVER(res == ResOK);
+
+  /* The instruction may have stored a reference in the segment.  This
+     is conservative if it wasn't a reference. */
+  ref = *(Ref *)addr;
+  SegSetSummary(seg, RefSetAdd(arena, SegSummary(seg), ref));
+
+  ShieldCover(arena, seg);
+  TraceSegNoteSingleAccess(seg);
+
+  STATISTIC({
+    TRACE_SET_ITER(ti, trace, traces, arena)
+      ++trace->readBarrierHitCount;
+    TRACE_SET_ITER_END(ti, trace, traces, arena);
+  });
+
+  return ResOK;
+}
+
+
+/* traceChunkOfAddr -- find the chunk containing an address for a fix
+ *
+ * As ChunkOfAddr.  When the scan state is used by a collector thread,
+ * another collector thread may be adding a chunk to the arena, so the
+ * chunk tree is searched under the fix lock.  The index can be read
+ * without it.  See <design/trace/#parallel.fix.chunk>.
+ */
+
+static Bool traceChunkOfAddr(Chunk *chunkReturn, ScanState ss, Addr addr)
+{
+  Chunk chunk;
+  Bool found;
+
+  chunk = ArenaChunkIndexEntry(ss->arena, addr);
+  if (chunk == NULL)
+    return FALSE;
+  if (chunk != ArenaChunkIndexMANY) {
+    if (addr < chunk->base || addr >= chunk->limit)
+      return FALSE;
+    *chunkReturn = chunk;
+    return TRUE;
+  }
+
+  if (ss->fixLock == NULL)
+    return ChunkOfAddrSearch(chunkReturn, ss->arena, addr);
+  LockClaim(ss->fixLock);
+  found = ChunkOfAddrSearch(chunkReturn, ss->arena, addr);
+  LockRelease(ss->fixLock);
+  return found;
+}
+
+
+/* traceFixLocked -- call the fix method from a collector thread
+ *
+ * The fix method runs holding the stripe lock for the white segment,
+ * so fixes to the same segment are serialized, but fixes to different
+ * segments are not.  Unless the pool class has AttrPARALLELFIX (and
+ * the fix is not an emergency fix), the fix method also holds the fix
+ * lock for its duration.  See <design/trace/#parallel.fix>.
+ */
+
+static Res traceFixLocked(ScanState ss, Pool pool, Seg seg, Ref *refIO)
+{
+  Lock stripe = WorkersStripeLock(ss->arena->workers, SegBase(seg));
+  Res res;
+
+  LockClaim(stripe);
+  if (ss->fix == PoolFix && PoolHasAttr(pool, AttrPARALLELFIX)) {
+    res = (*ss->fix)(pool, ss, seg, refIO);
+  } else {
+    ScanStateSharedClaim(ss);
+    res = (*ss->fix)(pool, ss, seg, refIO);
+    ScanStateSharedRelease(ss);
+  }
+  AVER_CRITICAL(ss->sharedDepth == 0);
+  LockRelease(stripe);
+  return res;
+}
+
+
+/* traceFix2 -- second stage of fixing a reference
+ *
+ * This is the body of _mps_fix2 and TraceFixArea, below.
+ *
+ * .fix.chunk: chunkIO caches the chunk found for the previous
+ * reference, so that a run of references into the same chunk needs
+ * only one search of the chunk tree.  It may point to NULL.
+ */
+
+static Res traceFix2(ScanState ss, mps_addr_t *mps_ref_io, Chunk *chunkIO)
 {
-  ScanState ss = PARENT(ScanStateStruct, ss_s, mps_ss);
   Ref ref;
   Chunk chunk;
   Index i;
@@ -1298,6 +2203,7 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
   /* See <design/trace/#fix.noaver> */
   AVERT_CRITICAL(ScanState, ss);
   AVER_CRITICAL(mps_ref_io != NULL);
+  AVER_CRITICAL(chunkIO != NULL);
 
   ref = (Ref)*mps_ref_io;
 
@@ -1315,14 +2221,17 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
    * check the rank in the latter case. See
    * <design/trace/#fix.tractofaddr.inline>
    *
-   * If compilers fail to do a good job of inlining ChunkOfAddr and
-   * TreeFind then it may become necessary to inline at least the
-   * comparison against the root of the tree. See
-   * <https://info.ravenbrook.com/mail/2014/06/11/13-32-08/0/>
+   * traceChunkOfAddr usually finds the chunk in the arena's chunk
+   * index without searching the chunk tree.  See
+   * <design/arena/#chunk.index>.
    */
-  if (!ChunkOfAddr(&chunk, ss->arena, ref))
-    /* Reference points outside MPS-managed address space: ignore. */
-    goto done;
+  chunk = *chunkIO;
+  if (chunk == NULL || ref < chunk->base || ref >= chunk->limit) {
+    if (!traceChunkOfAddr(&chunk, ss, ref))
+      /* Reference points outside MPS-managed address space: ignore. */
+      goto done;
+    *chunkIO = chunk; /* .fix.chunk */
+  }
 
   i = INDEX_OF_ADDR(chunk, ref);
   if (!BTGet(chunk->allocTable, i)) {
@@ -1356,7 +2265,10 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
   EVENT1(TraceFixSeg, seg);
   EVENT0(TraceFixWhite);
   pool = TractPool(tract);
-  res = (*ss->fix)(pool, ss, seg, &ref);
+  if (ss->fixLock == NULL)
+    res = (*ss->fix)(pool, ss, seg, &ref);
+  else
+    res = traceFixLocked(ss, pool, seg, &ref);
   if (res != ResOK) {
     /* PoolFixEmergency must not fail. */
     AVER_CRITICAL(ss->fix != PoolFixEmergency);
@@ -1380,6 +2292,212 @@ done:
 }
 
 
+/* _mps_fix2 (a.k.a. "TraceFix") -- second stage of fixing a reference
+ *
+ * _mps_fix2 is on the [critical path](../design/critical-path.txt).  A
+ * one-instruction difference in the early parts of this code will have a
+ * significant impact on overall run time.  The priority is to eliminate
+ * irrelevant references early and fast using the colour information stored
+ * in the tract table.
+ *
+ * The name "TraceFix" is pervasive in the MPS and its documents to describe
+ * this function.  Optimisation and strict aliasing rules have meant that we
+ * need to use the external name for it here.
+ *
+ * When segments are being scanned by several collector threads,
+ * traceFix2 serializes fixes to the same segment.  See
+ * <design/trace/#parallel.fix>.
+ */
+
+mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
+{
+  ScanState ss = PARENT(ScanStateStruct, ss_s, mps_ss);
+  Chunk chunk = NULL;
+
+  return traceFix2(ss, mps_ref_io, &chunk);
+}
+
+
+/* traceFixAreaWord -- fix one word of an area that passed the zone test
+ *
+ * .fix.reread: The word is read again here, after the words ahead of
+ * it have been fixed.  When the collector scans its own stack
+ * ambiguously, the area includes the scan state, and those fixes may
+ * have changed the word.  So it must pass the zone test again, and it
+ * is only written back if the fix moved the reference.  See
+ * <design/scan/#fix-area.reread>.
+ */
+
+static Res traceFixAreaWord(ScanState ss, Word *p, Word mask, Chunk *chunkIO)
+{
+  Word word = *p;
+  Word tagBits = word & mask;
+  mps_addr_t ref = (mps_addr_t)(word ^ tagBits);
+  Res res;
+
+  if (ZoneSetInter(ScanStateWhite(ss),
+                   ZoneSetAddAddr(ss->arena, ZoneSetEMPTY, ref))
+      == ZoneSetEMPTY)
+    return ResOK;
+
+  res = traceFix2(ss, &ref, chunkIO);
+  if (res == ResOK && (Word)ref != (word ^ tagBits))
+    *p = (Word)ref | tagBits;
+  return res;
+}
+
+
+/* traceFixAreaPrefetch -- prefetch the page table entry for a reference
+ *
+ * The second stage reads the page table entry for the reference (to
+ * find the tract, its pool, and its segment) before it reads anything
+ * else, so that is what is prefetched.  The pool word is part of the
+ * entry.  The chunk is the one found for the previous reference if it
+ * contains this one, or the arena's chunk index entry; if neither will
+ * do, nothing is prefetched.
+ */
+
+static void traceFixAreaPrefetch(ScanState ss, Addr ref, Chunk chunk)
+{
+  if (chunk == NULL || ref < chunk->base || ref >= chunk->limit) {
+    chunk = ArenaChunkIndexEntry(ss->arena, ref);
+    if (chunk == NULL || chunk == ArenaChunkIndexMANY
+        || ref < chunk->base || ref >= chunk->limit)
+      return;
+  }
+  PREFETCH(&chunk->pageTable[INDEX_OF_ADDR(chunk, ref)]);
+}
+
+
+/* traceFixAreaQueue -- queue a word for fixing, after a prefetch
+ *
+ * .fix.prefetch: The words that pass the first stage are kept in a
+ * ring of TRACE_FIX_PREFETCH_DEPTH entries, and the page table entry
+ * of each is prefetched as it joins, so that by the time it reaches
+ * the front of the ring and is fixed, the entry is likely to be in the
+ * cache.  Empty entries are NULL.  If the arena's fixPrefetch is FALSE
+ * the ring is not used.  See <design/scan/#fix-area.prefetch>.
+ */
+
+static Res traceFixAreaQueue(ScanState ss, Word **queue, Index *nextIO,
+                             Word *p, Word mask, Chunk *chunkIO)
+{
+  Index next = *nextIO;
+
+  if (queue == NULL)
+    return traceFixAreaWord(ss, p, mask, chunkIO);
+  if (queue[next] != NULL) {
+    Res res = traceFixAreaWord(ss, queue[next], mask, chunkIO);
+    if (res != ResOK)
+      return res;
+  }
+  traceFixAreaPrefetch(ss, (Addr)(*p & ~mask), *chunkIO);
+  queue[next] = p;
+  *nextIO = (next + 1) % TRACE_FIX_PREFETCH_DEPTH;
+  return ResOK;
+}
+
+
+/* TraceFixArea -- fix the references in an area of memory
+ *
+ * Fixes each word in [base, limit) whose bits under select are equal
+ * to pattern, treating it as a reference once the bits under mask
+ * are cleared, and restoring them afterwards.  This is equivalent to
+ * applying MPS_FIX12 to each such word, but the first stage is applied
+ * to TRACE_FIX_AREA_STRIDE words at a time without branches, so that
+ * compilers can vectorize it, the second stage is delayed while the
+ * page table entry is prefetched (.fix.prefetch), and the chunk found
+ * by the second stage is kept for the next reference.  See
+ * <design/scan/#fix-area>.
+ *
+ * TraceFixArea is on the critical path.
+ */
+
+Res TraceFixArea(ScanState ss, Word *base, Word *limit,
+                 Word mask, Word select, Word pattern)
+{
+  Shift zoneShift;
+  ZoneSet white;
+  RefSet summary;
+  Chunk chunk = NULL;
+  Word *ring[TRACE_FIX_PREFETCH_DEPTH];
+  Word **queue = NULL;
+  Index next = 0;
+  Index i;
+  Word *p;
+  Res res = ResOK;
+
+  AVERT_CRITICAL(ScanState, ss);
+  AVER_CRITICAL(base != NULL);
+  AVER_CRITICAL(base <= limit);
+  AVER_CRITICAL((pattern & ~select) == 0);
+
+  zoneShift = ScanStateZoneShift(ss);
+  white = ScanStateWhite(ss);
+  summary = ScanStateUnfixedSummary(ss);
+  if (ss->arena->fixPrefetch) {
+    for (i = 0; i < TRACE_FIX_PREFETCH_DEPTH; ++i)
+      ring[i] = NULL;
+    queue = ring;
+  }
+
+  p = base;
+  while ((Size)(limit - p) >= TRACE_FIX_AREA_STRIDE) {
+    Word zones[TRACE_FIX_AREA_STRIDE];
+    Word hits = 0;
+
+    /* First stage: compute the zone of each candidate reference,
+       with zero for words that aren't candidates. */
+    for (i = 0; i < TRACE_FIX_AREA_STRIDE; ++i) {
+      Word word = p[i];
+      Word candidate = (Word)0 - (Word)((word & select) == pattern);
+      zones[i] = candidate & ((Word)1 << ((word & ~mask) >> zoneShift
+                                           & (MPS_WORD_WIDTH - 1)));
+      hits |= zones[i];
+    }
+    summary |= hits;
+
+    if ((hits & white) != 0)
+      for (i = 0; i < TRACE_FIX_AREA_STRIDE; ++i)
+        if ((zones[i] & white) != 0) {
+          res = traceFixAreaQueue(ss, queue, &next, &p[i], mask, &chunk);
+          if (res != ResOK)
+            goto done;
+        }
+
+    p += TRACE_FIX_AREA_STRIDE;
+  }
+
+  for (; p < limit; ++p) {
+    Word word = *p;
+    if ((word & select) == pattern) {
+      Word zone = (Word)1 << ((word & ~mask) >> zoneShift
+                              & (MPS_WORD_WIDTH - 1));
+      summary |= zone;
+      if ((zone & white) != 0) {
+        res = traceFixAreaQueue(ss, queue, &next, p, mask, &chunk);
+        if (res != ResOK)
+          goto done;
+      }
+    }
+  }
+
+  /* Fix the words left in the queue, oldest first. */
+  for (i = 0; queue != NULL && i < TRACE_FIX_PREFETCH_DEPTH; ++i) {
+    Word *q = queue[(next + i) % TRACE_FIX_PREFETCH_DEPTH];
+    if (q != NULL) {
+      res = traceFixAreaWord(ss, q, mask, &chunk);
+      if (res != ResOK)
+        goto done;
+    }
+  }
+
+done:
+  ScanStateSetUnfixedSummary(ss, summary);
+  return res;
+}
+
+
 /* traceScanSingleRefRes -- scan a single reference, with result code */
 
 static Res traceScanSingleRefRes(TraceSet ts, Rank rank, Arena arena,
@@ -1594,8 +2712,12 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
   /* dynamically which method to use. */
 
   if(SegFirst(&seg, arena)) {
+    Pool pool;
+    Ring next;
     do {
       Size size = SegSize(seg);
+      pool = SegPool(seg);
+      next = RingNext(SegPoolRing(seg));
       AVER(!TraceSetIsMember(SegGrey(seg), trace));
 
       /* A segment can only be grey if it contains some references. */
@@ -1607,6 +2729,11 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
         /* of references in the segment intersects with the */
         /* approximation to the white set. */
         if(ZoneSetInter(SegSummary(seg), trace->white) != ZoneSetEMPTY) {
+          /* Don't scan the dead objects of a segment that another
+             trace has yet to reclaim.  See
+             design.mps.trace.reclaim.lazy.other. */
+          if (SegReclaimPending(seg) && !TraceReclaimSeg(seg))
+            continue;
           /* Note: can a white seg get greyed as well?  At this point */
           /* we still assume it may.  (This assumption runs out in */
           /* PoolTrivGrey). */
@@ -1622,7 +2749,7 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
           trace->notCondemned += size;
         }
       }
-    } while (SegNext(&seg, arena, seg));
+    } while (SegNextOfRing(&seg, arena, pool, next));
   }
 
   res = RootsIterate(ArenaGlobals(arena), rootGrey, (void *)trace);
@@ -1668,7 +2795,8 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
  * See design.mps.type.work.
  */
 
-#define traceWork(trace) ((Work)((trace)->segScanSize + (trace)->rootScanSize))
+#define traceWork(trace) ((Work)((trace)->segScanSize + (trace)->rootScanSize \
+                                 + (trace)->lazyReclaimSize))
 
 
 /* TraceAdvance -- progress a trace by one step */
@@ -1692,13 +2820,18 @@ void TraceAdvance(Trace trace)
     Rank rank;
 
     if (traceFindGrey(&seg, &rank, arena, trace->ti)) {
-      Res res;
-      res = traceScanSeg(TraceSetSingle(trace), rank, arena, seg);
-      /* Allocation failures should be handled by emergency mode, and we
-       * don't expect any other error in a normal GC trace. */
-      AVER(res == ResOK);
+      if (arena->workers != NULL && traceSegParallel(trace, seg, rank)) {
+        traceScanSegsParallel(trace, rank, seg);
+      } else {
+        Res res;
+        res = traceScanSeg(TraceSetSingle(trace), rank, arena, seg);
+        /* Allocation failures should be handled by emergency mode, and
+         * we don't expect any other error in a normal GC trace. */
+        AVER(res == ResOK);
+      }
     } else {
       trace->state = TraceRECLAIM;
+      traceReclaimStart(trace);
     }
     break;
   }
@@ -1772,8 +2905,10 @@ failCondemn:
 
 /* TracePoll -- Check if there's any tracing work to be done
  *
- * Consider starting a trace if none is running; advance the running
- * trace (if any) by one quantum.
+ * Consider starting a trace; advance each running trace by one
+ * quantum.  A collection of the world is only considered if no trace
+ * is running, but a chain may be collected while another trace is in
+ * progress.  See <design/trace/#multiple.start>.
  *
  * The collectWorldReturn and collectWorldAllowed arguments are as for
  * PolicyStartTrace.
@@ -1786,32 +2921,38 @@ Bool TracePoll(Work *workReturn, Bool *collectWorldReturn, Globals globals,
                Bool collectWorldAllowed)
 {
   Trace trace;
+  TraceId ti;
   Arena arena;
-  Work oldWork, newWork, work, endWork;
+  Work work = 0;
 
   AVERT(Globals, globals);
   arena = GlobalsArena(globals);
 
-  if (arena->busyTraces != TraceSetEMPTY) {
-    trace = ArenaTrace(arena, (TraceId)0);
-  } else {
+  if (arena->busyTraces == TraceSetEMPTY) {
     /* No traces are running: consider starting one now. */
     if (!PolicyStartTrace(&trace, collectWorldReturn, arena,
                           collectWorldAllowed))
       return FALSE;
+  } else if (arena->busyTraces != TraceSetUNIV) {
+    /* A trace is running, but there is a free trace id: consider
+       starting a collection of some other chain. */
+    (void)PolicyStartTrace(&trace, collectWorldReturn, arena, FALSE);
   }
 
-  AVER(arena->busyTraces == TraceSetSingle(trace));
-  oldWork = traceWork(trace);
-  endWork = oldWork + trace->quantumWork;
-  do {
-    TraceAdvance(trace);
-  } while (trace->state != TraceFINISHED && traceWork(trace) < endWork);
-  newWork = traceWork(trace);
-  AVER(newWork >= oldWork);
-  work = newWork - oldWork;
-  if (trace->state == TraceFINISHED)
-    TraceDestroyFinished(trace);
+  TRACE_SET_ITER(ti, trace, arena->busyTraces, arena)
+    Work oldWork, newWork, endWork;
+    oldWork = traceWork(trace);
+    endWork = oldWork + trace->quantumWork;
+    do {
+      TraceAdvance(trace);
+    } while (trace->state != TraceFINISHED && traceWork(trace) < endWork);
+    newWork = traceWork(trace);
+    AVER(newWork >= oldWork);
+    work += newWork - oldWork;
+    if (trace->state == TraceFINISHED)
+      TraceDestroyFinished(trace);
+  TRACE_SET_ITER_END(ti, trace, arena->busyTraces, arena);
+
   *workReturn = work;
   return TRUE;
 }
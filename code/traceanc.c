@@ -119,6 +119,7 @@ static MessageClassStruct TraceStartMessageClassStruct = {
   MessageNoGCCondemnedSize,      /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize,   /* GCNotCondemnedSize */
   TraceStartMessageWhy,          /* GCStartWhy */
+  MessageNoGenRetune,            /* GenRetune */
   MessageClassSig                /* <design/message/#class.sig.double> */
 };
 
@@ -170,6 +171,10 @@ const char *TraceStartWhyToString(int why)
   case TraceStartWhyEXTENSION:
     r = "Extension: an MPS extension started the trace.";
     break;
+  case TraceStartWhyPRESSURE:
+    r = "Memory pressure: the system is short of memory,"
+        " so start full collection.";
+    break;
   default:
     NOTREACHED;
     r = "Unknown reason (internal error).";
@@ -359,6 +364,7 @@ static MessageClassStruct TraceMessageClassStruct = {
   TraceMessageCondemnedSize,     /* GCCondemnedSize */
   TraceMessageNotCondemnedSize,  /* GCNotCondemnedSize */
   MessageNoGCStartWhy,           /* GCStartWhy */
+  MessageNoGenRetune,            /* GenRetune */
   MessageClassSig                /* <design/message/#class.sig.double> */
 };
 
@@ -160,6 +160,13 @@ Bool ChunkCheck(Chunk chunk)
   CHECKL(INDEX_OF_ADDR(chunk, AddrSub(chunk->limit, 1)) < chunk->pages);
   CHECKL(chunk->pageTablePages < chunk->pages);
 
+  /* check that the cards are in the chunk overhead */
+  CHECKL(chunk->cards == NULL || ArenaCardMarking(chunk->arena));
+  CHECKL(chunk->cards == NULL || (Addr)chunk->cards >= chunk->base);
+  CHECKL(chunk->cards == NULL
+         || AddrAdd((Addr)chunk->cards, CardsSize(chunk->base, chunk->limit))
+            <= (Addr)chunk->pageTable);
+
   /* Could check the consistency of the tables, but not O(1). */
   return TRUE;
 }
@@ -204,6 +211,21 @@ Res ChunkInit(Chunk chunk, Arena arena, Addr base, Addr limit, Size reserved,
     goto failAllocTable;
   chunk->allocTable = p;
 
+  /* .overhead.cards: Chunk overhead for the card table, if the arena
+     uses card marking.  The size depends on where the chunk falls in
+     its stripes, so allocate the most it could need, which the arena
+     class can compute from the chunk size alone.  See
+     <design/write-barrier/#card.table>. */
+  chunk->cards = NULL;
+  if (ArenaCardMarking(arena)) {
+    res = BootAlloc(&p, boot,
+                    (size_t)CardsSizeMAX(AddrOffset(base, limit)),
+                    MPS_PF_ALIGN);
+    if (res != ResOK)
+      goto failCards;
+    chunk->cards = p;
+  }
+
   pageTableSize = SizeAlignUp(pages * sizeof(PageUnion), chunk->pageSize);
   chunk->pageTablePages = pageTableSize >> pageShift;
 
@@ -218,8 +240,11 @@ Res ChunkInit(Chunk chunk, Arena arena, Addr base, Addr limit, Size reserved,
   AVER(AddrIsAligned(BootAllocated(boot), chunk->pageSize));
   chunk->allocBase = (Index)(BootAllocated(boot) >> pageShift);
 
-  /* Init allocTable after class init, because it might be mapped there. */
+  /* Init allocTable and cards after class init, because they might be
+     mapped there. */
   BTResRange(chunk->allocTable, 0, pages);
+  if (chunk->cards != NULL)
+    (void)AddrSet((Addr)chunk->cards, 0, CardsSize(base, limit));
 
   /* Check that there is some usable address space remaining in the chunk. */
   allocBase = PageIndexBase(chunk, chunk->allocBase);
@@ -247,6 +272,7 @@ failLandInsert:
   /* .no-clean: No clean-ups needed past this point for boot, as we will
      discard the chunk. */
 failClassInit:
+failCards:
 failAllocTable:
   return res;
 }
@@ -318,11 +344,45 @@ TreeKey ChunkKey(Tree tree)
 }
 
 
-/* ChunkOfAddr -- return the chunk which encloses an address */
+/* ChunkOfAddr -- return the chunk which encloses an address
+ *
+ * The arena's chunk index usually answers without searching the
+ * chunk tree: if the entry for addr is a single chunk, then no other
+ * chunk overlaps addr's stripe, so addr is either in that chunk or
+ * not in any chunk.  See <design/arena/#chunk.index>.
+ */
 
 Bool ChunkOfAddr(Chunk *chunkReturn, Arena arena, Addr addr)
+{
+  Chunk chunk;
+
+  AVER_CRITICAL(chunkReturn != NULL);
+  AVERT_CRITICAL(Arena, arena);
+  /* addr is arbitrary */
+
+  chunk = ArenaChunkIndexEntry(arena, addr);
+  if (chunk == NULL)
+    return FALSE;
+  if (chunk != ArenaChunkIndexMANY) {
+    if (addr < chunk->base || addr >= chunk->limit)
+      return FALSE;
+    *chunkReturn = chunk;
+    return TRUE;
+  }
+
+  return ChunkOfAddrSearch(chunkReturn, arena, addr);
+}
+
+
+/* ChunkOfAddrSearch -- search the chunk tree for an address
+ *
+ * For when the chunk index entry for addr is ArenaChunkIndexMANY.
+ */
+
+Bool ChunkOfAddrSearch(Chunk *chunkReturn, Arena arena, Addr addr)
 {
   Tree tree;
+  Chunk chunk;
 
   AVER_CRITICAL(chunkReturn != NULL);
   AVERT_CRITICAL(Arena, arena);
@@ -332,7 +392,7 @@ Bool ChunkOfAddr(Chunk *chunkReturn, Arena arena, Addr addr)
                ChunkCompare)
       == CompareEQUAL)
   {
-    Chunk chunk = ChunkOfTree(tree);
+    chunk = ChunkOfTree(tree);
     AVER_CRITICAL(chunk->base <= addr);
     AVER_CRITICAL(addr < chunk->limit);
     *chunkReturn = chunk;
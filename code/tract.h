@@ -148,12 +148,31 @@ typedef struct ChunkStruct {
   BT allocTable;        /* page allocation table */
   Page pageTable;       /* the page table */
   Count pageTablePages; /* number of pages occupied by page table */
+  unsigned char *cards; /* card table, or NULL, <design/write-barrier/#card.table> */
   Size reserved;        /* reserved address space for chunk (including overhead
                            such as losses due to alignment): must not change
                            (or arena reserved calculation will break) */
 } ChunkStruct;
 
 
+/* CardsSize -- size of the cards for the stripes a range overlaps
+ *
+ * CardsSizeMAX is an upper bound for any range of a given size.
+ * ChunkCard is a chunk's own card for an address in it.  See
+ * <design/write-barrier/#card.table>.
+ */
+
+#define CardsSTRIPE ((Count)1 << (ARENA_CARD_STRIPE_SHIFT - ARENA_CARD_SHIFT))
+#define CardsSize(base, limit) \
+  ((Size)(((Word)AddrSub(limit, 1) >> ARENA_CARD_STRIPE_SHIFT) \
+          - ((Word)(base) >> ARENA_CARD_STRIPE_SHIFT) + 1) * CardsSTRIPE)
+#define CardsSizeMAX(size) \
+  ((Size)(((size) >> ARENA_CARD_STRIPE_SHIFT) + 2) * CardsSTRIPE)
+#define ChunkCard(chunk, addr) \
+  (&(chunk)->cards[((Word)(addr) >> ARENA_CARD_SHIFT) \
+                   - ((Word)(chunk)->base >> ARENA_CARD_STRIPE_SHIFT) \
+                     * CardsSTRIPE])
+
 #define ChunkArena(chunk) RVALUE((chunk)->arena)
 #define ChunkSize(chunk) AddrOffset((chunk)->base, (chunk)->limit)
 #define ChunkPageSize(chunk) RVALUE((chunk)->pageSize)
@@ -173,6 +192,7 @@ extern TreeKey ChunkKey(Tree tree);
 extern Bool ChunkCacheEntryCheck(ChunkCacheEntry entry);
 extern void ChunkCacheEntryInit(ChunkCacheEntry entry);
 extern Bool ChunkOfAddr(Chunk *chunkReturn, Arena arena, Addr addr);
+extern Bool ChunkOfAddrSearch(Chunk *chunkReturn, Arena arena, Addr addr);
 extern Res ChunkNodeDescribe(Tree node, mps_lib_FILE *stream);
 
 
@@ -26,6 +26,7 @@ typedef struct VMStruct {
   Addr base, limit;             /* aligned boundaries of reserved space */
   Size reserved;                /* total reserved address space */
   Size mapped;                  /* total mapped memory */
+  Bool hugePages;               /* <design/vm/#huge> */
 } VMStruct;
 
 
@@ -36,6 +37,7 @@ typedef struct VMStruct {
 #define VMMapped(vm) RVALUE((vm)->mapped)
 
 extern Size PageSize(void);
+extern Size HugePageSize(void);
 extern Size (VMPageSize)(VM vm);
 extern Bool VMCheck(VM vm);
 extern Res VMParamFromArgs(void *params, size_t paramSize, ArgList args);
@@ -49,6 +51,10 @@ extern Size (VMReserved)(VM vm);
 extern Size (VMMapped)(VM vm);
 extern void VMCopy(VM dest, VM src);
 
+/* Memory pressure -- see <design/vm/#if.pressure> */
+
+extern double VMPressure(void);
+
 
 #endif /* vm_h */
 
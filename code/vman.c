@@ -20,6 +20,17 @@ Size PageSize(void)
 }
 
 
+/* HugePageSize -- return the huge page size
+ *
+ * There are no huge pages in the ANSI VM.
+ */
+
+Size HugePageSize(void)
+{
+  return PageSize();
+}
+
+
 Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 {
   AVER(params != NULL);
@@ -71,6 +82,7 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   AVER(vm->limit < AddrAdd((Addr)vm->block, reserved));
   vm->reserved = reserved;
   vm->mapped = (Size)0;
+  vm->hugePages = FALSE;
  
   vm->sig = VMSig;
   AVERT(VM, vm);
@@ -33,6 +33,12 @@
  * get from mmap.  The others are either caused by invalid params
  * or features we don't use.  See mmap(2) for details.
  *
+ * .huge: If the client asks for huge pages, mapped memory is given
+ * to madvise(2) with MADV_HUGEPAGE, so that Linux backs it with
+ * transparent huge pages.  The arena makes its grain at least
+ * HugePageSize(), so that mapping and unmapping never split a huge
+ * page.  See <design/vm/#huge>.
+ *
  * .remap: Possibly this should use mremap to reduce the number of
  * distinct mappings.  According to our current testing, it doesn't
  * seem to be a problem.
@@ -48,6 +54,9 @@
 /* for errno(2) */
 #include <errno.h>
 
+/* for open(2) */
+#include <fcntl.h>
+
 /* for getpagesize(3) */
 #include <unistd.h>
 
@@ -75,11 +84,74 @@ Size PageSize(void)
 }
 
 
+#if defined(MADV_HUGEPAGE)
+
+/* vmixHugePageSysfs -- ask Linux for the transparent huge page size
+ *
+ * Returns the size that the kernel reports in sysfs, or zero if it
+ * can't be read.
+ */
+
+static Size vmixHugePageSysfs(void)
+{
+  char buf[32];
+  int fd;
+  ssize_t n, i;
+  Size size = 0;
+
+  fd = open("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", O_RDONLY);
+  if (fd == -1)
+    return 0;
+  n = read(fd, buf, sizeof buf);
+  (void)close(fd);
+  for (i = 0; i < n && buf[i] >= '0' && buf[i] <= '9'; ++i) {
+    if (size > ((Size)-1 - 9) / 10)
+      return 0;
+    size = size * 10 + (Size)(buf[i] - '0');
+  }
+  return size;
+}
+
+#endif /* MADV_HUGEPAGE */
+
+
+/* HugePageSize -- return the size of a transparent huge page, or the
+ * page size if there are none (see .huge)
+ *
+ * The size depends on the processor and its base page size, so it is
+ * read from sysfs, falling back to VMIX_HUGE_PAGE_SIZE if the kernel
+ * doesn't say or says something unusable.
+ */
+
+Size HugePageSize(void)
+{
+#if defined(MADV_HUGEPAGE)
+  Size size = vmixHugePageSysfs();
+  if (size <= PageSize() || !SizeIsP2(size))
+    size = VMIX_HUGE_PAGE_SIZE;
+  return size;
+#else
+  return PageSize();
+#endif
+}
+
+
+typedef struct VMParamsStruct {
+  Bool hugePages;
+} VMParamsStruct, *VMParams;
+
 Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 {
+  VMParams vmParams;
+  ArgStruct arg;
   AVER(params != NULL);
   AVERT(ArgList, args);
+  AVER(paramSize >= sizeof(VMParamsStruct));
   UNUSED(paramSize);
+  vmParams = (VMParams)params;
+  vmParams->hugePages = FALSE;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_HUGE_PAGES))
+    vmParams->hugePages = arg.val.b;
   return ResOK;
 }
 
@@ -90,6 +162,7 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
 {
   Size pageSize, reserved;
   void *vbase;
+  VMParams vmParams = params;
 
   AVER(vm != NULL);
   AVERT(ArenaGrainSize, grainSize);
@@ -130,6 +203,7 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   AVER(vm->limit <= AddrAdd((Addr)vm->block, reserved));
   vm->reserved = reserved;
   vm->mapped = 0;
+  vm->hugePages = vmParams->hugePages;
 
   vm->sig = VMSig;
   AVERT(VM, vm);
@@ -186,6 +260,13 @@ Res VMMap(VM vm, Addr base, Addr limit)
     return ResMEMORY;
   }
 
+#if defined(MADV_HUGEPAGE)
+  /* .huge: This is only advice, and fails if the kernel was built
+     without transparent huge pages, so the result is ignored. */
+  if (vm->hugePages)
+    (void)madvise((void *)base, (size_t)size, MADV_HUGEPAGE);
+#endif
+
   vm->mapped += size;
   AVER(VMMapped(vm) <= VMReserved(vm));
 
@@ -0,0 +1,247 @@
+/* vmpsli.c: MEMORY PRESSURE FOR LINUX
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: This implements VMPressure in <code/vm.h> from two
+ * sources.  Pressure stall information in /proc/pressure/memory says
+ * what percentage of the last ten seconds some task spent stalled
+ * waiting for memory.  The cgroup v2 files memory.current and
+ * memory.high (or memory.max) say how close the process's control
+ * group is to the limit at which the kernel throttles it or the OOM
+ * killer acts.  See <design/vm/#if.pressure>.
+ *
+ * .read: The files are small and are read afresh each time, because
+ * the process may move to another control group, and because an
+ * arena reads the pressure at most every ARENA_PRESSURE_INTERVAL
+ * seconds.  Either source may be missing (kernels before 4.20, cgroup
+ * v1, or no limit), and then contributes nothing.
+ */
+
+#include "mpm.h"
+#include "vm.h"
+
+#if !defined(MPS_OS_LI)
+#error "vmpsli.c is specific to MPS_OS_LI"
+#endif
+
+#include <fcntl.h> /* see .feature.li in config.h */
+#include <sys/types.h>
+#include <unistd.h>
+
+SRCID(vmpsli, "$Id$");
+
+
+#define CGROUP_ROOT "/sys/fs/cgroup"
+#define PATH_LENGTH 256         /* longest cgroup file name we read */
+
+
+/* vmPressureRead -- read a small file into a string */
+
+static Bool vmPressureRead(char *buf, size_t size, const char *path)
+{
+  int fd;
+  ssize_t n;
+
+  AVER(size > 0);
+
+  fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return FALSE;
+  n = read(fd, buf, size - 1);
+  (void)close(fd);
+  if (n < 0)
+    return FALSE;
+  buf[n] = '\0';
+  return TRUE;
+}
+
+
+/* vmPressurePrefix -- return the rest of s after prefix, or NULL */
+
+static const char *vmPressurePrefix(const char *s, const char *prefix)
+{
+  for (; *prefix != '\0'; ++s, ++prefix)
+    if (*s != *prefix)
+      return NULL;
+  return s;
+}
+
+
+/* vmPressureNumber -- parse a decimal number with optional fraction
+ *
+ * Not strtod, which depends on the locale.
+ */
+
+static Bool vmPressureNumber(double *numReturn, const char *s)
+{
+  double num = 0.0, scale = 1.0;
+  Bool digits = FALSE;
+
+  for (; *s >= '0' && *s <= '9'; ++s) {
+    num = num * 10.0 + (*s - '0');
+    digits = TRUE;
+  }
+  if (*s == '.')
+    for (++s; *s >= '0' && *s <= '9'; ++s) {
+      scale /= 10.0;
+      num += (*s - '0') * scale;
+      digits = TRUE;
+    }
+  if (!digits)
+    return FALSE;
+  *numReturn = num;
+  return TRUE;
+}
+
+
+/* vmPressureStall -- pressure from stall information
+ *
+ * The first line of /proc/pressure/memory is
+ * "some avg10=1.23 avg60=0.45 avg300=0.06 total=123456".
+ */
+
+static double vmPressureStall(void)
+{
+  char buf[256];
+  const char *p;
+  double stall;
+
+  if (!vmPressureRead(buf, sizeof buf, "/proc/pressure/memory"))
+    return 0.0;
+  p = vmPressurePrefix(buf, "some avg10=");
+  if (p == NULL || !vmPressureNumber(&stall, p))
+    return 0.0;
+  return stall / VM_PRESSURE_STALL;
+}
+
+
+/* vmPressureCgroupFile -- read a number from a cgroup file
+ *
+ * dir is the cgroup's directory, of length dirLength.  Returns FALSE
+ * if the file can't be read or says "max".
+ */
+
+static Bool vmPressureCgroupFile(double *numReturn, char *dir,
+                                 size_t dirLength, const char *name)
+{
+  char buf[64];
+  size_t i;
+
+  for (i = 0; name[i] != '\0'; ++i) {
+    if (dirLength + i + 1 >= PATH_LENGTH)
+      return FALSE;
+    dir[dirLength + i] = name[i];
+  }
+  dir[dirLength + i] = '\0';
+  return vmPressureRead(buf, sizeof buf, dir)
+    && vmPressureNumber(numReturn, buf);
+}
+
+
+/* vmPressureCgroup -- pressure from the cgroup's memory limit
+ *
+ * The cgroup v2 line of /proc/self/cgroup is "0::/path/of/cgroup".
+ * The limit is memory.high if set, otherwise memory.max.
+ */
+
+static double vmPressureCgroup(void)
+{
+  char buf[1024];               /* cgroup v1 adds a line per controller */
+  char dir[PATH_LENGTH];
+  const char *p = buf;
+  size_t length = 0;
+  double current, limit;
+
+  if (!vmPressureRead(buf, sizeof buf, "/proc/self/cgroup"))
+    return 0.0;
+  for (;;) {
+    const char *rest = vmPressurePrefix(p, "0::");
+    if (rest != NULL) {
+      p = rest;
+      break;
+    }
+    while (*p != '\0' && *p != '\n')
+      ++p;
+    if (*p == '\0')
+      return 0.0;
+    ++p;
+  }
+
+  /* dir = CGROUP_ROOT ++ path ++ "/" */
+  for (length = 0; CGROUP_ROOT[length] != '\0'; ++length)
+    dir[length] = CGROUP_ROOT[length];
+  for (; *p != '\0' && *p != '\n'; ++p) {
+    if (length + 1 >= sizeof dir)
+      return 0.0;
+    dir[length++] = *p;
+  }
+  if (length == 0 || dir[length - 1] != '/') {
+    if (length + 1 >= sizeof dir)
+      return 0.0;
+    dir[length++] = '/';
+  }
+
+  if (!vmPressureCgroupFile(&limit, dir, length, "memory.high")
+      && !vmPressureCgroupFile(&limit, dir, length, "memory.max"))
+    return 0.0;
+  if (limit <= 0.0
+      || !vmPressureCgroupFile(&current, dir, length, "memory.current"))
+    return 0.0;
+  return current / (limit * VM_PRESSURE_FRACTION);
+}
+
+
+/* VMPressure -- how short of memory is the system?
+ *
+ * Returns the greater of the two pressures.
+ */
+
+double VMPressure(void)
+{
+  double stall = vmPressureStall();
+  double cgroup = vmPressureCgroup();
+  return stall > cgroup ? stall : cgroup;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -66,6 +66,18 @@ Size PageSize(void)
 }
 
 
+/* HugePageSize -- return the huge page size
+ *
+ * Windows large pages must be locked in memory and need a privilege,
+ * so they are not used.  See <design/vm/#huge>.
+ */
+
+Size HugePageSize(void)
+{
+  return PageSize();
+}
+
+
 typedef struct VMParamsStruct {
   Bool topDown;
 } VMParamsStruct, *VMParams;
@@ -139,6 +151,7 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   AVER(vm->limit <= AddrAdd((Addr)vm->block, reserved));
   vm->reserved = reserved;
   vm->mapped = 0;
+  vm->hugePages = FALSE;
 
   vm->sig = VMSig;
   AVERT(VM, vm);
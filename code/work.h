@@ -0,0 +1,190 @@
+/* work.h: COLLECTOR WORKER THREADS
+ *
+ *  $Id$
+ *  Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ *  .purpose: Provides a set of threads that the collector can use to
+ *  run independent jobs in parallel.  See <design/trace/#parallel>.
+ *
+ *  .fork-join: WorkersRun runs a job for each index in a range,
+ *  handing out indexes to the worker threads (and the calling thread)
+ *  as they become free, and returns when all the jobs are done.  The
+ *  workers are idle between calls.
+ *
+ *  .background: A Background is a single thread that calls a step
+ *  function whenever it is woken, and keeps calling it for as long as
+ *  the step function reports that there is more to do.  The arena
+ *  uses it to do collection work while the mutator runs.  See
+ *  <design/trace/#background>.
+ */
+
+#ifndef work_h
+#define work_h
+
+#include "mpmtypes.h"
+
+
+#define WorkersSig      ((Sig)0x519C0245) /* SIGnature WORKERS */
+#define BackgroundSig   ((Sig)0x519BAC6D) /* SIGnature BACKGrounD */
+
+
+/*  WorkersJob -- the type of a job
+ *
+ *  The job is called with the closure passed to WorkersRun, an index
+ *  in the range [0, count), and the index of the thread running it in
+ *  the range [0, WorkersCount), where 0 is the thread that called
+ *  WorkersRun.  Jobs may run on any thread and concurrently with each
+ *  other, but no two jobs run on the same thread at once.
+ */
+
+typedef void (*WorkersJob)(void *closure, Index i, Index self);
+
+
+extern Bool WorkersCheck(Workers workers);
+
+
+/*  WorkersCreate/Destroy
+ *
+ *  Create a set of count threads (including the thread that calls
+ *  WorkersRun) allocated from the arena's control pool.  count must
+ *  be at least 1.  Platforms without thread support run all jobs on
+ *  the calling thread.
+ */
+
+extern Res WorkersCreate(Workers *workersReturn, Arena arena, Count count);
+extern void WorkersDestroy(Workers workers);
+
+
+/*  WorkersRun -- run a job for each index, in parallel
+ *
+ *  Must not be called from a job, or concurrently with itself.
+ */
+
+extern void WorkersRun(Workers workers, WorkersJob job, void *closure,
+                       Count count);
+
+
+/*  WorkersCount -- number of threads that run jobs */
+
+extern Count WorkersCount(Workers workers);
+
+
+/*  WorkersLock -- a lock shared by all the workers
+ *
+ *  Jobs use this to serialize access to data structures they share.
+ */
+
+extern Lock WorkersLock(Workers workers);
+
+
+/*  WorkersStripeLock -- a lock chosen by address
+ *
+ *  Returns one of a fixed set of locks, so that jobs can serialize
+ *  access to the memory in one arena grain without serializing with
+ *  jobs that work elsewhere.  Addresses in the same grain always get
+ *  the same lock.  A job may claim WorkersLock while holding a stripe
+ *  lock, but not the other way round, and may hold only one stripe
+ *  lock at a time.
+ */
+
+extern Lock WorkersStripeLock(Workers workers, Addr addr);
+
+
+/*  BackgroundStep -- the type of a background step function
+ *
+ *  Called on the background thread with the closure passed to
+ *  BackgroundCreate.  Returns TRUE if there is more to do, in which
+ *  case it is called again without waiting to be woken.
+ */
+
+typedef Bool (*BackgroundStep)(void *closure);
+
+
+extern Bool BackgroundCheck(Background background);
+
+
+/*  BackgroundCreate/Destroy
+ *
+ *  Create a background thread that calls step when woken.  Returns
+ *  ResUNIMPL on platforms without thread support.  BackgroundDestroy
+ *  waits for any step in progress to return, so it must not be called
+ *  while holding a lock that the step function claims.
+ */
+
+extern Res BackgroundCreate(Background *backgroundReturn, Arena arena,
+                            BackgroundStep step, void *closure);
+extern void BackgroundDestroy(Background background);
+
+
+/*  BackgroundCreateStatic -- create a background thread outside arenas
+ *
+ *  Like BackgroundCreate, but the state is in static memory, for
+ *  subsystems that are shared by all arenas, such as telemetry.  It
+ *  may be called only once, and the thread is never destroyed.
+ */
+
+extern Res BackgroundCreateStatic(Background *backgroundReturn,
+                                  BackgroundStep step, void *closure);
+
+
+/*  BackgroundWake -- ask the background thread to call its step
+ *
+ *  Cheap enough to call on every poll, and may be called from any
+ *  thread.
+ */
+
+extern void BackgroundWake(Background background);
+
+
+/*  BackgroundSync -- wait for the background thread to be idle
+ *
+ *  Returns when the step function has returned FALSE since the last
+ *  call to BackgroundWake.
+ */
+
+extern void BackgroundSync(Background background);
+
+
+#endif /* work_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,242 @@
+/* workan.c: COLLECTOR WORKER THREADS FOR ANSI
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: This is a trivial implementation of <code/work.h> for
+ * platforms without thread support.  All jobs run on the calling
+ * thread, one after another, so it provides the interface but no
+ * parallelism.
+ */
+
+#include "mpm.h"
+#include "work.h"
+
+SRCID(workan, "$Id$");
+
+
+typedef struct WorkersStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* owning arena */
+  Count count;                  /* threads requested */
+  Lock lock;                    /* see WorkersLock */
+  Lock stripe;                  /* see WorkersStripeLock */
+  Bool running;                 /* inside WorkersRun? */
+} WorkersStruct;
+
+
+Bool WorkersCheck(Workers workers)
+{
+  CHECKS(Workers, workers);
+  CHECKU(Arena, workers->arena);
+  CHECKL(workers->count >= 1);
+  CHECKD_NOSIG(Lock, workers->lock);
+  CHECKD_NOSIG(Lock, workers->stripe);
+  CHECKL(BoolCheck(workers->running));
+  return TRUE;
+}
+
+
+Res WorkersCreate(Workers *workersReturn, Arena arena, Count count)
+{
+  Workers workers;
+  void *p;
+  Res res;
+
+  AVER(workersReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(count >= 1);
+
+  res = ControlAlloc(&p, arena, sizeof(WorkersStruct));
+  if (res != ResOK)
+    goto failAlloc;
+  workers = p;
+
+  res = ControlAlloc(&p, arena, LockSize());
+  if (res != ResOK)
+    goto failLockAlloc;
+  workers->lock = p;
+  LockInit(workers->lock);
+
+  res = ControlAlloc(&p, arena, LockSize());
+  if (res != ResOK)
+    goto failStripeAlloc;
+  workers->stripe = p;
+  LockInit(workers->stripe);
+
+  workers->arena = arena;
+  workers->count = count;
+  workers->running = FALSE;
+  workers->sig = WorkersSig;
+  AVERT(Workers, workers);
+
+  *workersReturn = workers;
+  return ResOK;
+
+failStripeAlloc:
+  LockFinish(workers->lock);
+  ControlFree(arena, workers->lock, LockSize());
+failLockAlloc:
+  ControlFree(arena, workers, sizeof(WorkersStruct));
+failAlloc:
+  return res;
+}
+
+
+void WorkersDestroy(Workers workers)
+{
+  Arena arena;
+
+  AVERT(Workers, workers);
+  AVER(!workers->running);
+  arena = workers->arena;
+  LockFinish(workers->stripe);
+  ControlFree(arena, workers->stripe, LockSize());
+  LockFinish(workers->lock);
+  ControlFree(arena, workers->lock, LockSize());
+  workers->sig = SigInvalid;
+  ControlFree(arena, workers, sizeof(WorkersStruct));
+}
+
+
+void WorkersRun(Workers workers, WorkersJob job, void *closure, Count count)
+{
+  Index i;
+
+  AVERT(Workers, workers);
+  AVER(FUNCHECK(job));
+  AVER(!workers->running); /* not reentrant */
+
+  workers->running = TRUE;
+  for (i = 0; i < count; ++i)
+    (*job)(closure, i, 0);
+  workers->running = FALSE;
+}
+
+
+Count WorkersCount(Workers workers)
+{
+  AVERT(Workers, workers);
+  return workers->count;
+}
+
+
+Lock WorkersLock(Workers workers)
+{
+  AVERT(Workers, workers);
+  return workers->lock;
+}
+
+
+/* WorkersStripeLock -- jobs run one at a time, so one lock serves
+ * for every address */
+
+Lock WorkersStripeLock(Workers workers, Addr addr)
+{
+  AVERT_CRITICAL(Workers, workers);
+  UNUSED(addr);
+  return workers->stripe;
+}
+
+
+/* Background -- not supported
+ *
+ * BackgroundCreate fails with ResUNIMPL, and the arena does its
+ * collection work in the mutator as usual.  BackgroundCreateStatic
+ * fails too, and telemetry is written by the thread that syncs it.
+ */
+
+typedef struct BackgroundStruct {
+  Sig sig;                      /* <design/sig/> */
+} BackgroundStruct;
+
+
+Bool BackgroundCheck(Background background)
+{
+  CHECKS(Background, background);
+  return TRUE;
+}
+
+
+Res BackgroundCreate(Background *backgroundReturn, Arena arena,
+                     BackgroundStep step, void *closure)
+{
+  AVER(backgroundReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(FUNCHECK(step));
+  UNUSED(closure);
+  return ResUNIMPL;
+}
+
+
+Res BackgroundCreateStatic(Background *backgroundReturn,
+                           BackgroundStep step, void *closure)
+{
+  AVER(backgroundReturn != NULL);
+  AVER(FUNCHECK(step));
+  UNUSED(closure);
+  return ResUNIMPL;
+}
+
+
+void BackgroundDestroy(Background background)
+{
+  AVERT(Background, background);
+  NOTREACHED;
+}
+
+
+void BackgroundWake(Background background)
+{
+  AVERT(Background, background);
+  NOTREACHED;
+}
+
+
+void BackgroundSync(Background background)
+{
+  AVERT(Background, background);
+  NOTREACHED;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
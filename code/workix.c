@@ -0,0 +1,638 @@
+/* workix.c: COLLECTOR WORKER THREADS FOR POSIX SYSTEMS
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .design: See <code/work.h> and <design/trace/#parallel>.
+ *
+ * .posix: The implementation uses POSIX threads, a mutex and two
+ * condition variables, and should be reusable for many Unix-like
+ * operating systems.
+ *
+ * .generation: Each call to WorkersRun increments the generation.
+ * A worker that sees a new generation takes indexes from the shared
+ * counter until there are none left, then decrements the number of
+ * busy workers.  WorkersRun doesn't return until that number is zero,
+ * so every worker has finished with the job and its closure.
+ *
+ * .self: Each worker takes the next thread index from the started
+ * counter when it starts, so the indexes passed to jobs run from 1 to
+ * count - 1, and the thread that calls WorkersRun is 0.
+ *
+ * .background: The background thread waits on a condition variable
+ * until woken, then calls the step function with the mutex released.
+ * Between steps it yields the processor, so that client threads
+ * waiting for the locks that the step function claims get a chance
+ * to run.
+ *
+ * .signals: Workers (and the background thread) are not registered
+ * with the arena, so they are never suspended.  They block
+ * asynchronous signals so that these are delivered to client threads,
+ * but not the synchronous signals that report faults.
+ */
+
+#include "config.h"
+
+#include <pthread.h> /* see .feature.li in config.h */
+#include <sched.h>
+#include <signal.h>
+
+#include "mpm.h"
+#include "work.h"
+
+#if !defined(MPS_OS_FR) && !defined(MPS_OS_LI) && !defined(MPS_OS_XC)
+#error "workix.c is Unix specific."
+#endif
+
+SRCID(workix, "$Id$");
+
+
+typedef struct WorkersStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* owning arena */
+  Count count;                  /* threads that run jobs, including caller */
+  pthread_t *threads;           /* the count - 1 worker threads */
+  Lock lock;                    /* see WorkersLock */
+  void *stripes;                /* WORKERS_STRIPES locks, see WorkersStripeLock */
+  Shift stripeShift;            /* log2 of the arena's grain size */
+  pthread_mutex_t mut;          /* protects the fields below */
+  pthread_cond_t start;         /* signalled when there are new jobs */
+  pthread_cond_t done;          /* signalled when a worker goes idle */
+  Bool stop;                    /* workers should exit */
+  Count generation;             /* see .generation */
+  WorkersJob job;               /* current job, or NULL */
+  void *closure;                /* closure for current job */
+  Count jobs;                   /* number of indexes to run */
+  Index next;                   /* next index to run */
+  Count busy;                   /* workers not yet idle */
+  Count started;                /* workers that have started, see .self */
+} WorkersStruct;
+
+
+/* workersStripe -- the i'th stripe lock */
+
+#define workersStripe(workers, i) \
+  ((Lock)PointerAdd((workers)->stripes, (i) * LockSize()))
+
+
+Bool WorkersCheck(Workers workers)
+{
+  CHECKS(Workers, workers);
+  CHECKU(Arena, workers->arena);
+  CHECKL(workers->count >= 1);
+  CHECKL((workers->threads == NULL) == (workers->count == 1));
+  CHECKD_NOSIG(Lock, workers->lock);
+  CHECKL(workers->stripes != NULL);
+  CHECKL(BoolCheck(workers->stop));
+  CHECKL(workers->next <= workers->jobs || workers->job == NULL);
+  CHECKL(workers->busy < workers->count);
+  CHECKL(workers->started < workers->count);
+  return TRUE;
+}
+
+
+/* workersDoJobs -- run jobs until there are none left
+ *
+ * Called with the mutex held; releases it while running each job.
+ * self is the index of the calling thread (see .self).
+ */
+
+static void workersDoJobs(Workers workers, Index self)
+{
+  int res;
+
+  while (workers->next < workers->jobs) {
+    Index i = workers->next;
+    ++workers->next;
+    res = pthread_mutex_unlock(&workers->mut);
+    AVER(res == 0);
+    (*workers->job)(workers->closure, i, self);
+    res = pthread_mutex_lock(&workers->mut);
+    AVER(res == 0);
+  }
+}
+
+
+/* workerMain -- main loop of a worker thread */
+
+static void *workerMain(void *p)
+{
+  Workers workers = p;
+  Count generation = 0;
+  Index self;
+  int res;
+
+  res = pthread_mutex_lock(&workers->mut);
+  AVER(res == 0);
+  ++workers->started;
+  self = workers->started;
+  for (;;) {
+    while (!workers->stop && workers->generation == generation) {
+      res = pthread_cond_wait(&workers->start, &workers->mut);
+      AVER(res == 0);
+    }
+    if (workers->stop)
+      break;
+    generation = workers->generation;
+    workersDoJobs(workers, self);
+    AVER(workers->busy > 0);
+    --workers->busy;
+    if (workers->busy == 0) {
+      res = pthread_cond_signal(&workers->done);
+      AVER(res == 0);
+    }
+  }
+  res = pthread_mutex_unlock(&workers->mut);
+  AVER(res == 0);
+  EventSlotRelease();
+  return NULL;
+}
+
+
+/* threadsBlockSignals -- block signals in threads created from now on
+ *
+ * See .signals.  Stores the previous mask in *old.
+ */
+
+static void threadsBlockSignals(sigset_t *old)
+{
+  sigset_t block;
+  int err;
+
+  err = sigfillset(&block);
+  AVER(err == 0);
+  err = sigdelset(&block, SIGSEGV);
+  AVER(err == 0);
+  err = sigdelset(&block, SIGBUS);
+  AVER(err == 0);
+  err = sigdelset(&block, SIGFPE);
+  AVER(err == 0);
+  err = sigdelset(&block, SIGILL);
+  AVER(err == 0);
+  err = pthread_sigmask(SIG_BLOCK, &block, old);
+  AVER(err == 0);
+}
+
+
+/* workersStop -- stop and join the first count worker threads */
+
+static void workersStop(Workers workers, Count count)
+{
+  Index i;
+  int res;
+
+  res = pthread_mutex_lock(&workers->mut);
+  AVER(res == 0);
+  workers->stop = TRUE;
+  res = pthread_cond_broadcast(&workers->start);
+  AVER(res == 0);
+  res = pthread_mutex_unlock(&workers->mut);
+  AVER(res == 0);
+
+  for (i = 0; i < count; ++i) {
+    res = pthread_join(workers->threads[i], NULL);
+    AVER(res == 0);
+  }
+}
+
+
+Res WorkersCreate(Workers *workersReturn, Arena arena, Count count)
+{
+  Workers workers;
+  sigset_t old;
+  void *p;
+  Index i;
+  Res res;
+  int err;
+
+  AVER(workersReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(count >= 1);
+
+  res = ControlAlloc(&p, arena, sizeof(WorkersStruct));
+  if (res != ResOK)
+    goto failAlloc;
+  workers = p;
+
+  res = ControlAlloc(&p, arena, LockSize());
+  if (res != ResOK)
+    goto failLockAlloc;
+  workers->lock = p;
+  LockInit(workers->lock);
+
+  res = ControlAlloc(&p, arena, WORKERS_STRIPES * LockSize());
+  if (res != ResOK)
+    goto failStripesAlloc;
+  workers->stripes = p;
+  for (i = 0; i < WORKERS_STRIPES; ++i)
+    LockInit(workersStripe(workers, i));
+  workers->stripeShift = SizeLog2(ArenaGrainSize(arena));
+
+  workers->threads = NULL;
+  if (count > 1) {
+    res = ControlAlloc(&p, arena, (count - 1) * sizeof(pthread_t));
+    if (res != ResOK)
+      goto failThreadsAlloc;
+    workers->threads = p;
+  }
+
+  workers->arena = arena;
+  workers->count = count;
+  workers->stop = FALSE;
+  workers->generation = 0;
+  workers->job = NULL;
+  workers->closure = NULL;
+  workers->jobs = 0;
+  workers->next = 0;
+  workers->busy = 0;
+  workers->started = 0;
+  err = pthread_mutex_init(&workers->mut, NULL);
+  AVER(err == 0);
+  err = pthread_cond_init(&workers->start, NULL);
+  AVER(err == 0);
+  err = pthread_cond_init(&workers->done, NULL);
+  AVER(err == 0);
+  workers->sig = WorkersSig;
+  AVERT(Workers, workers);
+
+  threadsBlockSignals(&old);
+  for (i = 0; i + 1 < count; ++i) {
+    err = pthread_create(&workers->threads[i], NULL, workerMain, workers);
+    if (err != 0)
+      break;
+  }
+  err = pthread_sigmask(SIG_SETMASK, &old, NULL);
+  AVER(err == 0);
+  if (i + 1 < count) {
+    res = ResRESOURCE;
+    goto failCreate;
+  }
+
+  *workersReturn = workers;
+  return ResOK;
+
+failCreate:
+  workersStop(workers, i);
+  workers->sig = SigInvalid;
+  (void)pthread_cond_destroy(&workers->done);
+  (void)pthread_cond_destroy(&workers->start);
+  (void)pthread_mutex_destroy(&workers->mut);
+  ControlFree(arena, workers->threads, (count - 1) * sizeof(pthread_t));
+failThreadsAlloc:
+  for (i = 0; i < WORKERS_STRIPES; ++i)
+    LockFinish(workersStripe(workers, i));
+  ControlFree(arena, workers->stripes, WORKERS_STRIPES * LockSize());
+failStripesAlloc:
+  LockFinish(workers->lock);
+  ControlFree(arena, workers->lock, LockSize());
+failLockAlloc:
+  ControlFree(arena, workers, sizeof(WorkersStruct));
+failAlloc:
+  return res;
+}
+
+
+void WorkersDestroy(Workers workers)
+{
+  Arena arena;
+  Index i;
+  int res;
+
+  AVERT(Workers, workers);
+  AVER(workers->job == NULL);
+  arena = workers->arena;
+
+  if (workers->count > 1) {
+    workersStop(workers, workers->count - 1);
+    ControlFree(arena, workers->threads,
+                (workers->count - 1) * sizeof(pthread_t));
+  }
+  res = pthread_cond_destroy(&workers->done);
+  AVER(res == 0);
+  res = pthread_cond_destroy(&workers->start);
+  AVER(res == 0);
+  res = pthread_mutex_destroy(&workers->mut);
+  AVER(res == 0);
+  for (i = 0; i < WORKERS_STRIPES; ++i)
+    LockFinish(workersStripe(workers, i));
+  ControlFree(arena, workers->stripes, WORKERS_STRIPES * LockSize());
+  LockFinish(workers->lock);
+  ControlFree(arena, workers->lock, LockSize());
+  workers->sig = SigInvalid;
+  ControlFree(arena, workers, sizeof(WorkersStruct));
+}
+
+
+void WorkersRun(Workers workers, WorkersJob job, void *closure, Count count)
+{
+  int res;
+
+  AVERT(Workers, workers);
+  AVER(FUNCHECK(job));
+  AVER(workers->job == NULL); /* not reentrant */
+
+  res = pthread_mutex_lock(&workers->mut);
+  AVER(res == 0);
+  workers->job = job;
+  workers->closure = closure;
+  workers->jobs = count;
+  workers->next = 0;
+  if (workers->count > 1 && count > 1) {
+    workers->busy = workers->count - 1;
+    ++workers->generation;
+    res = pthread_cond_broadcast(&workers->start);
+    AVER(res == 0);
+  }
+  workersDoJobs(workers, 0);
+  while (workers->busy > 0) {
+    res = pthread_cond_wait(&workers->done, &workers->mut);
+    AVER(res == 0);
+  }
+  workers->job = NULL;
+  workers->closure = NULL;
+  res = pthread_mutex_unlock(&workers->mut);
+  AVER(res == 0);
+}
+
+
+Count WorkersCount(Workers workers)
+{
+  AVERT(Workers, workers);
+  return workers->count;
+}
+
+
+Lock WorkersLock(Workers workers)
+{
+  AVERT(Workers, workers);
+  return workers->lock;
+}
+
+
+Lock WorkersStripeLock(Workers workers, Addr addr)
+{
+  AVERT_CRITICAL(Workers, workers);
+  return workersStripe(workers, ((Word)addr >> workers->stripeShift)
+                                & (WORKERS_STRIPES - 1));
+}
+
+
+typedef struct BackgroundStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* owning arena */
+  BackgroundStep step;          /* step function */
+  void *closure;                /* closure for step function */
+  pthread_t thread;             /* the background thread */
+  pthread_mutex_t mut;          /* protects the fields below */
+  pthread_cond_t wake;          /* signalled by BackgroundWake */
+  pthread_cond_t idle;          /* signalled when busy becomes FALSE */
+  Bool woken;                   /* step should be called */
+  Bool busy;                    /* step is running or will be called */
+  Bool stop;                    /* thread should exit */
+} BackgroundStruct;
+
+static BackgroundStruct backgroundStatic; /* see BackgroundCreateStatic */
+static Bool backgroundStaticUsed = FALSE;
+
+
+Bool BackgroundCheck(Background background)
+{
+  CHECKS(Background, background);
+  CHECKL(background->arena == NULL || TESTT(Arena, background->arena));
+  CHECKL(FUNCHECK(background->step));
+  CHECKL(BoolCheck(background->woken));
+  CHECKL(BoolCheck(background->busy));
+  CHECKL(BoolCheck(background->stop));
+  return TRUE;
+}
+
+
+/* backgroundMain -- main loop of the background thread */
+
+static void *backgroundMain(void *p)
+{
+  Background background = p;
+  Bool more = FALSE;
+  int res;
+
+  for (;;) {
+    res = pthread_mutex_lock(&background->mut);
+    AVER(res == 0);
+    if (!more && !background->woken) {
+      background->busy = FALSE;
+      res = pthread_cond_broadcast(&background->idle);
+      AVER(res == 0);
+    }
+    while (!background->stop && !background->woken && !more) {
+      res = pthread_cond_wait(&background->wake, &background->mut);
+      AVER(res == 0);
+    }
+    background->woken = FALSE;
+    if (background->stop)
+      break;
+    res = pthread_mutex_unlock(&background->mut);
+    AVER(res == 0);
+
+    more = (*background->step)(background->closure);
+    if (more)
+      (void)sched_yield(); /* see .background */
+  }
+  res = pthread_mutex_unlock(&background->mut);
+  AVER(res == 0);
+  EventSlotRelease();
+  return NULL;
+}
+
+
+/* backgroundInit -- initialize a background and start its thread
+ *
+ * arena is NULL for the static background.
+ */
+
+static Res backgroundInit(Background background, Arena arena,
+                          BackgroundStep step, void *closure)
+{
+  sigset_t old;
+  int err;
+
+  background->arena = arena;
+  background->step = step;
+  background->closure = closure;
+  background->woken = FALSE;
+  background->busy = FALSE;
+  background->stop = FALSE;
+  err = pthread_mutex_init(&background->mut, NULL);
+  AVER(err == 0);
+  err = pthread_cond_init(&background->wake, NULL);
+  AVER(err == 0);
+  err = pthread_cond_init(&background->idle, NULL);
+  AVER(err == 0);
+  background->sig = BackgroundSig;
+  AVERT(Background, background);
+
+  threadsBlockSignals(&old);
+  err = pthread_create(&background->thread, NULL, backgroundMain,
+                       background);
+  (void)pthread_sigmask(SIG_SETMASK, &old, NULL);
+  if (err != 0) {
+    background->sig = SigInvalid;
+    (void)pthread_cond_destroy(&background->idle);
+    (void)pthread_cond_destroy(&background->wake);
+    (void)pthread_mutex_destroy(&background->mut);
+    return ResRESOURCE;
+  }
+
+  return ResOK;
+}
+
+
+Res BackgroundCreate(Background *backgroundReturn, Arena arena,
+                     BackgroundStep step, void *closure)
+{
+  Background background;
+  void *p;
+  Res res;
+
+  AVER(backgroundReturn != NULL);
+  AVERT(Arena, arena);
+  AVER(FUNCHECK(step));
+
+  res = ControlAlloc(&p, arena, sizeof(BackgroundStruct));
+  if (res != ResOK)
+    return res;
+  background = p;
+
+  res = backgroundInit(background, arena, step, closure);
+  if (res != ResOK) {
+    ControlFree(arena, background, sizeof(BackgroundStruct));
+    return res;
+  }
+
+  *backgroundReturn = background;
+  return ResOK;
+}
+
+
+Res BackgroundCreateStatic(Background *backgroundReturn,
+                           BackgroundStep step, void *closure)
+{
+  Res res;
+
+  AVER(backgroundReturn != NULL);
+  AVER(FUNCHECK(step));
+  AVER(!backgroundStaticUsed);
+
+  res = backgroundInit(&backgroundStatic, NULL, step, closure);
+  if (res != ResOK)
+    return res;
+  backgroundStaticUsed = TRUE;
+
+  *backgroundReturn = &backgroundStatic;
+  return ResOK;
+}
+
+
+void BackgroundDestroy(Background background)
+{
+  int res;
+
+  AVERT(Background, background);
+  AVER(background->arena != NULL);
+
+  res = pthread_mutex_lock(&background->mut);
+  AVER(res == 0);
+  background->stop = TRUE;
+  res = pthread_cond_signal(&background->wake);
+  AVER(res == 0);
+  res = pthread_mutex_unlock(&background->mut);
+  AVER(res == 0);
+  res = pthread_join(background->thread, NULL);
+  AVER(res == 0);
+
+  res = pthread_cond_destroy(&background->idle);
+  AVER(res == 0);
+  res = pthread_cond_destroy(&background->wake);
+  AVER(res == 0);
+  res = pthread_mutex_destroy(&background->mut);
+  AVER(res == 0);
+  background->sig = SigInvalid;
+  ControlFree(background->arena, background, sizeof(BackgroundStruct));
+}
+
+
+void BackgroundWake(Background background)
+{
+  int res;
+
+  AVERT(Background, background);
+
+  res = pthread_mutex_lock(&background->mut);
+  AVER(res == 0);
+  if (!background->woken) {
+    background->woken = TRUE;
+    background->busy = TRUE;
+    res = pthread_cond_signal(&background->wake);
+    AVER(res == 0);
+  }
+  res = pthread_mutex_unlock(&background->mut);
+  AVER(res == 0);
+}
+
+
+void BackgroundSync(Background background)
+{
+  int res;
+
+  AVERT(Background, background);
+
+  res = pthread_mutex_lock(&background->mut);
+  AVER(res == 0);
+  while (background->busy) {
+    res = pthread_cond_wait(&background->idle, &background->mut);
+    AVER(res == 0);
+  }
+  res = pthread_mutex_unlock(&background->mut);
+  AVER(res == 0);
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */